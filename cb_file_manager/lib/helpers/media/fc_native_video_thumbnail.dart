@@ -1,22 +1,43 @@
 import 'dart:async';
+import 'dart:convert';
 import 'dart:io';
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 import 'package:path/path.dart' as path;
+import 'package:cb_file_manager/helpers/core/app_path_helper.dart';
 import 'thumbnail_queue_manager.dart';
 
-/// A Flutter plugin to access Windows native video thumbnail generation
-/// This uses the Windows thumbnail cache system for efficient thumbnail extraction
+/// A Flutter plugin to access native video thumbnail generation
+/// On Windows this uses the shell thumbnail cache and FFmpeg; on Linux the
+/// runner serves the same channel with FFmpeg when it was built with it.
 class FcNativeVideoThumbnail {
   static const MethodChannel _channel =
       MethodChannel('fc_native_video_thumbnail');
 
+  /// Results of [generateBatch] arrive here as lists of result maps
+  static const EventChannel _batchEvents =
+      EventChannel('fc_native_video_thumbnail/batch');
+
+  /// One shared subscription to the batch channel; events carry their batchId
+  static Stream<dynamic>? _batchEventStream;
+
   /// Flag to indicate if this is running on Windows
   static bool get isWindows => Platform.isWindows;
 
+  /// Platforms whose runner may provide the native channel
+  static bool get isSupportedPlatform =>
+      Platform.isWindows || Platform.isLinux;
+
   /// Flag to track initialization status
   static bool _initialized = false;
 
+  /// Result of probing the Linux runner for the channel (null = not probed)
+  static bool? _linuxAvailable;
+
+  /// Disk space the Windows thumbnail cache may use before the least
+  /// recently used thumbnails are deleted
+  static const int thumbnailCacheBudgetBytes = 512 * 1024 * 1024;
+
   /// Maximum time to wait for a native operation (increased for 4K videos)
   static const Duration _operationTimeout = Duration(seconds: 30);
 
@@ -26,16 +47,26 @@ class FcNativeVideoThumbnail {
     if (_initialized) return true;
 
     try {
-      if (!isWindows) {
+      if (!isSupportedPlatform) {
         debugPrint(
-            'FcNativeVideoThumbnail: Not running on Windows, initialization skipped');
+            'FcNativeVideoThumbnail: Unsupported platform, initialization skipped');
         return false;
       }
 
-      // Nothing to initialize for now, but we could add version checking or capability testing here
+      // The Linux runner only registers the channel when built with FFmpeg
+      if (Platform.isLinux) {
+        _linuxAvailable ??= await _probeChannel();
+        if (!_linuxAvailable!) return false;
+      }
+
+      if (Platform.isWindows) {
+        await _openThumbnailIndex();
+      }
+      await _openMediaInfoCache();
+
       _initialized = true;
       debugPrint(
-          'FcNativeVideoThumbnail: Native Windows thumbnail provider initialized');
+          'FcNativeVideoThumbnail: Native thumbnail provider initialized');
       return true;
     } catch (e) {
       debugPrint('FcNativeVideoThumbnail: Failed to initialize: $e');
@@ -43,7 +74,53 @@ class FcNativeVideoThumbnail {
     }
   }
 
-  /// Generate a thumbnail for a video file using Windows native APIs
+  /// Persistent cache index kept next to the thumbnails it describes.
+  /// Without it every launch starts with a cold cache; thumbnails still work.
+  static Future<void> _openThumbnailIndex() async {
+    try {
+      final cacheDir = await AppPathHelper.getVideoCacheDir();
+      final opened = await _channel.invokeMethod<bool>('openThumbnailIndex', {
+        'path': path.join(cacheDir.path, 'thumbnail_index.bin'),
+        'budgetBytes': thumbnailCacheBudgetBytes,
+      });
+      if (opened != true) {
+        debugPrint('FcNativeVideoThumbnail: Thumbnail index unavailable');
+      }
+    } catch (e) {
+      debugPrint('FcNativeVideoThumbnail: Failed to open thumbnail index: $e');
+    }
+  }
+
+  /// Persists probe results (durations, stream info) between runs, so a
+  /// library scan only probes new or changed files
+  static Future<void> _openMediaInfoCache() async {
+    try {
+      final cacheDir = await AppPathHelper.getVideoCacheDir();
+      final opened = await _channel.invokeMethod<bool>('openMediaInfoCache', {
+        'path': path.join(cacheDir.path, 'media_info.bin'),
+      });
+      if (opened != true) {
+        debugPrint('FcNativeVideoThumbnail: Media info cache unavailable');
+      }
+    } catch (e) {
+      debugPrint(
+          'FcNativeVideoThumbnail: Failed to open media info cache: $e');
+    }
+  }
+
+  static Future<bool> _probeChannel() async {
+    try {
+      return await _channel.invokeMethod<bool>('isAvailable') ?? false;
+    } on MissingPluginException {
+      debugPrint('FcNativeVideoThumbnail: Native channel not available');
+      return false;
+    } catch (e) {
+      debugPrint('FcNativeVideoThumbnail: Failed to probe channel: $e');
+      return false;
+    }
+  }
+
+  /// Generate a thumbnail for a video file using native APIs
   ///
   /// - [videoPath]: Path to the video file
   /// - [outputPath]: Where to save the thumbnail (must be a valid path)
@@ -51,6 +128,10 @@ class FcNativeVideoThumbnail {
   /// - [format]: Image format, either 'png' or 'jpg'
   /// - [timeSeconds]: Position in the video (in seconds) to extract the thumbnail from (optional)
   /// - [quality]: Image quality for JPEG format (1-100, default 95, ignored for PNG)
+  /// - [keyframeOnly]: Use the nearest keyframe instead of the exact frame (FFmpeg only)
+  /// - [requestId]: Lets [cancelThumbnails] drop the request while it is still queued.
+  ///   A request whose ID is already in flight is answered with null, so distinct
+  ///   outputs (width, format) of one video need distinct IDs
   ///
   /// Returns the path to the generated thumbnail if successful, null otherwise
   static Future<String?> generateThumbnail({
@@ -60,10 +141,12 @@ class FcNativeVideoThumbnail {
     String format = 'png',
     int? timeSeconds,
     int quality = 95,
+    bool keyframeOnly = false,
+    String? requestId,
   }) async {
-    if (!isWindows) {
+    if (!isSupportedPlatform) {
       debugPrint(
-          'FcNativeVideoThumbnail: Not running on Windows, cannot generate native thumbnail');
+          'FcNativeVideoThumbnail: Unsupported platform, cannot generate native thumbnail');
       return null;
     }
 
@@ -113,6 +196,8 @@ class FcNativeVideoThumbnail {
           'format': format.toLowerCase() == 'png' ? 'png' : 'jpg',
           'timeSeconds': timeSeconds, // Pass the timestamp to native code
           'quality': quality, // Pass quality setting for JPEG format
+          'keyframeOnly': keyframeOnly,
+          if (requestId != null) 'requestId': requestId,
         }).timeout(_operationTimeout, onTimeout: () {
           debugPrint(
               'FcNativeVideoThumbnail: Native operation timed out for $videoPath');
@@ -170,10 +255,10 @@ class FcNativeVideoThumbnail {
     }
   }
 
-  /// Check if a video format is supported by the Windows thumbnail extractor
+  /// Check if a video format is supported by the native thumbnail extractor
   /// This is a conservative list of formats known to work well with Windows thumbnail cache
   static bool isSupportedFormat(String videoPath) {
-    if (!isWindows) return false;
+    if (!isSupportedPlatform) return false;
 
     final extension = path.extension(videoPath).toLowerCase();
     // Windows thumbnail cache supports most common video formats
@@ -278,11 +363,267 @@ class FcNativeVideoThumbnail {
     );
   }
 
+  /// Generate thumbnails for many videos with one native call.
+  ///
+  /// The native side schedules all items together and streams completions
+  /// back in chunks; the returned stream emits one result per item (in
+  /// completion order) and closes after the last one. Cancelling the
+  /// subscription cancels the items that have not started yet.
+  /// [keyframeOnly] applies to items positioned by percentage.
+  /// Runners without batch support fall back to per-item calls.
+  static Stream<NativeThumbnailBatchResult> generateBatch(
+    List<NativeThumbnailBatchItem> items, {
+    String format = 'jpg',
+    int quality = 95,
+    bool keyframeOnly = false,
+  }) {
+    late final StreamController<NativeThumbnailBatchResult> controller;
+    StreamSubscription<dynamic>? subscription;
+    int? batchId;
+    var received = 0;
+    // Results that raced ahead of the generateBatch reply
+    final early = <Map<dynamic, dynamic>>[];
+
+    void deliver(Map<dynamic, dynamic> event) {
+      if (controller.isClosed) return;
+      controller.add(NativeThumbnailBatchResult._fromMap(event, items));
+      if (++received == items.length) {
+        subscription?.cancel();
+        controller.close();
+      }
+    }
+
+    Future<void> start() async {
+      if (items.isEmpty) {
+        await controller.close();
+        return;
+      }
+      if (!isSupportedPlatform || !await initialize()) {
+        await _generateBatchFallback(
+            items, format, quality, keyframeOnly, controller);
+        return;
+      }
+
+      _batchEventStream ??= _batchEvents.receiveBroadcastStream();
+      subscription = _batchEventStream!.listen((chunk) {
+        for (final event in chunk as List<dynamic>) {
+          final map = event as Map<dynamic, dynamic>;
+          if (batchId == null) {
+            early.add(map);
+          } else if (map['batchId'] == batchId) {
+            deliver(map);
+          }
+        }
+      }, onError: (Object e) {
+        debugPrint('FcNativeVideoThumbnail: Batch event error: $e');
+      });
+
+      try {
+        batchId = await _channel.invokeMethod<int>('generateBatch', {
+          'items': items.map((item) => item._toMap()).toList(),
+          'format': format.toLowerCase() == 'png' ? 'png' : 'jpg',
+          'quality': quality,
+          'keyframeOnly': keyframeOnly,
+        });
+      } on MissingPluginException {
+        await subscription?.cancel();
+        subscription = null;
+        await _generateBatchFallback(
+            items, format, quality, keyframeOnly, controller);
+        return;
+      }
+
+      for (final map in early) {
+        if (map['batchId'] == batchId) deliver(map);
+      }
+      early.clear();
+    }
+
+    controller = StreamController<NativeThumbnailBatchResult>(
+      onListen: () {
+        start().catchError((Object e) {
+          debugPrint('FcNativeVideoThumbnail: Batch failed: $e');
+          if (!controller.isClosed) {
+            controller.addError(e);
+            controller.close();
+          }
+        });
+      },
+      onCancel: () async {
+        await subscription?.cancel();
+        if (batchId != null && received < items.length) {
+          try {
+            await _channel.invokeMethod<bool>(
+                'cancelBatch', {'batchId': batchId});
+          } catch (_) {}
+        }
+      },
+    );
+    return controller.stream;
+  }
+
+  /// Per-item generation for runners without generateBatch
+  static Future<void> _generateBatchFallback(
+    List<NativeThumbnailBatchItem> items,
+    String format,
+    int quality,
+    bool keyframeOnly,
+    StreamController<NativeThumbnailBatchResult> controller,
+  ) async {
+    const maxConcurrent = 4;
+    var next = 0;
+
+    Future<void> worker() async {
+      while (next < items.length && !controller.isClosed) {
+        final index = next++;
+        final item = items[index];
+        final path = item.percentage != null
+            ? await generateThumbnailAtPercentage(
+                videoPath: item.videoPath,
+                outputPath: item.outputPath,
+                percentage: item.percentage!,
+                width: item.width,
+                format: format,
+                quality: quality,
+                keyframeOnly: keyframeOnly,
+              )
+            : await generateThumbnail(
+                videoPath: item.videoPath,
+                outputPath: item.outputPath,
+                width: item.width,
+                format: format,
+                timeSeconds: item.timeSeconds,
+                quality: quality,
+              );
+        if (controller.isClosed) return;
+        controller.add(NativeThumbnailBatchResult(
+          index: index,
+          videoPath: item.videoPath,
+          outputPath: item.outputPath,
+          success: path != null,
+        ));
+      }
+    }
+
+    await Future.wait(List.generate(maxConcurrent, (_) => worker()));
+    if (!controller.isClosed) await controller.close();
+  }
+
+  /// Drop native requests that have not started yet, e.g. for tiles that
+  /// scrolled off-screen. Their [generateThumbnail] calls complete with null.
+  /// Returns how many were still queued.
+  static Future<int> cancelThumbnails(List<String> requestIds) async {
+    if (!isSupportedPlatform || !_initialized || requestIds.isEmpty) {
+      return 0;
+    }
+
+    try {
+      final result = await _channel.invokeMethod<int>(
+        'cancelThumbnails',
+        {'requestIds': requestIds},
+      );
+      return result ?? 0;
+    } on MissingPluginException {
+      // Runner without a cancellable queue
+      return 0;
+    } catch (e) {
+      debugPrint('FcNativeVideoThumbnail: Error cancelling thumbnails: $e');
+      return 0;
+    }
+  }
+
+  /// Move a queued native request up or down (0 = low .. 3 = urgent).
+  /// Returns false if it already started or finished.
+  static Future<bool> updateThumbnailPriority(
+      String requestId, int priority) async {
+    if (!isSupportedPlatform || !_initialized) {
+      return false;
+    }
+
+    try {
+      final result = await _channel.invokeMethod<bool>(
+        'updateThumbnailPriority',
+        {'requestId': requestId, 'priority': priority.clamp(0, 3)},
+      );
+      return result ?? false;
+    } on MissingPluginException {
+      return false;
+    } catch (e) {
+      debugPrint('FcNativeVideoThumbnail: Error updating priority: $e');
+      return false;
+    }
+  }
+
+  /// Build a hover-scrub sprite sheet: [frameCount] frames spread evenly
+  /// over the video, tiled into one image at [outputPath]. The native side
+  /// opens and probes the video once for all tiles, instead of once per
+  /// frame as with repeated [generateThumbnailAtPercentage] calls.
+  ///
+  /// The layout and tile timestamps are written next to the image as
+  /// `<outputPath>.json`, so [loadSpriteSheet] can reuse the sheet later.
+  static Future<NativeSpriteSheet?> generateSpriteSheet({
+    required String videoPath,
+    required String outputPath,
+    int frameCount = 100,
+    int tileWidth = 160,
+    int columns = 0,
+    String format = 'jpg',
+    int quality = 80,
+    bool keyframeOnly = true,
+  }) async {
+    if (!isSupportedPlatform) return null;
+    if (!_initialized && !await initialize()) return null;
+
+    try {
+      await Directory(path.dirname(outputPath)).create(recursive: true);
+      final layout = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        'generateSpriteSheet',
+        {
+          'srcFile': videoPath,
+          'destFile': outputPath,
+          'frameCount': frameCount,
+          'tileWidth': tileWidth,
+          'columns': columns,
+          'format': format.toLowerCase() == 'png' ? 'png' : 'jpg',
+          'quality': quality,
+          'keyframeOnly': keyframeOnly,
+        },
+      ).timeout(_operationTimeout * 2, onTimeout: () => null);
+      if (layout == null) return null;
+
+      final sheet = NativeSpriteSheet._fromMap(layout);
+      await File(NativeSpriteSheet._indexPath(outputPath))
+          .writeAsString(jsonEncode(sheet._toJson()));
+      return sheet;
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      debugPrint('FcNativeVideoThumbnail: Error generating sprite sheet: $e');
+      return null;
+    }
+  }
+
+  /// A sheet written earlier by [generateSpriteSheet], or null if either the
+  /// image or its index is missing
+  static Future<NativeSpriteSheet?> loadSpriteSheet(String outputPath) async {
+    try {
+      final index = File(NativeSpriteSheet._indexPath(outputPath));
+      if (!await index.exists() || !await File(outputPath).exists()) {
+        return null;
+      }
+      final json = jsonDecode(await index.readAsString());
+      return NativeSpriteSheet._fromMap(json as Map<dynamic, dynamic>);
+    } catch (e) {
+      debugPrint('FcNativeVideoThumbnail: Invalid sprite sheet index: $e');
+      return null;
+    }
+  }
+
   /// Get video duration in seconds using FFmpeg native library
   /// Returns the duration in seconds, or -1 if failed
   /// This is much faster than spawning ffprobe.exe process
   static Future<double> getVideoDuration(String videoPath) async {
-    if (!isWindows) {
+    if (!isSupportedPlatform) {
       return -1.0;
     }
 
@@ -304,6 +645,29 @@ class FcNativeVideoThumbnail {
     }
   }
 
+  /// Duration, resolution, rotation, codec and keyframe times of a video.
+  /// Results are cached natively by path, size and modification time, so
+  /// asking again about an unchanged file does not touch FFmpeg.
+  ///
+  /// Returns null if the file cannot be probed
+  static Future<NativeMediaInfo?> getMediaInfo(String videoPath) async {
+    if (!isSupportedPlatform) return null;
+    if (!_initialized && !await initialize()) return null;
+
+    try {
+      final info = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        'getMediaInfo',
+        {'srcFile': videoPath},
+      );
+      return info == null ? null : NativeMediaInfo._fromMap(info);
+    } on MissingPluginException {
+      return null;
+    } catch (e) {
+      debugPrint('FcNativeVideoThumbnail: Error getting media info: $e');
+      return null;
+    }
+  }
+
   /// Generate thumbnail at a percentage of video duration (optimized single-pass)
   ///
   /// This is the FASTEST method for custom mode thumbnail generation because it:
@@ -319,6 +683,11 @@ class FcNativeVideoThumbnail {
   /// - [width]: Width of the thumbnail (0 = use original width)
   /// - [format]: Image format, either 'png' or 'jpg'
   /// - [quality]: Image quality for JPEG format (1-100, default 95)
+  /// - [keyframeOnly]: Use the nearest keyframe instead of the exact frame;
+  ///   much faster on long-GOP videos and fine for grid thumbnails
+  /// - [representativeFrame]: Ignore [percentage] and let the native side
+  ///   pick the most detailed of a few keyframes, skipping black fades and
+  ///   flat title cards
   ///
   /// Returns the path to the generated thumbnail if successful, null otherwise
   static Future<String?> generateThumbnailAtPercentage({
@@ -328,10 +697,12 @@ class FcNativeVideoThumbnail {
     int width = 1024,
     String format = 'jpg',
     int quality = 95,
+    bool keyframeOnly = false,
+    bool representativeFrame = false,
   }) async {
-    if (!isWindows) {
+    if (!isSupportedPlatform) {
       debugPrint(
-          'FcNativeVideoThumbnail: Not running on Windows, cannot generate native thumbnail');
+          'FcNativeVideoThumbnail: Unsupported platform, cannot generate native thumbnail');
       return null;
     }
 
@@ -372,6 +743,8 @@ class FcNativeVideoThumbnail {
             'format': format.toLowerCase() == 'png' ? 'png' : 'jpg',
             'percentage': percentage,
             'quality': quality,
+            'keyframeOnly': keyframeOnly,
+            'representativeFrame': representativeFrame,
           },
         ).timeout(_operationTimeout, onTimeout: () {
           debugPrint(
@@ -407,3 +780,170 @@ class FcNativeVideoThumbnail {
     }
   }
 }
+
+/// One video for [FcNativeVideoThumbnail.generateBatch]
+class NativeThumbnailBatchItem {
+  final String videoPath;
+  final String outputPath;
+  final int width;
+
+  /// Position in seconds; null uses the platform's default thumbnail
+  final int? timeSeconds;
+
+  /// Position as a percentage (0-100) of the duration; wins over [timeSeconds]
+  final double? percentage;
+
+  const NativeThumbnailBatchItem({
+    required this.videoPath,
+    required this.outputPath,
+    this.width = 1024,
+    this.timeSeconds,
+    this.percentage,
+  });
+
+  Map<String, Object?> _toMap() => {
+        'srcFile': videoPath,
+        'destFile': outputPath,
+        'width': width,
+        if (timeSeconds != null) 'timeSeconds': timeSeconds,
+        if (percentage != null) 'percentage': percentage,
+      };
+}
+
+/// Outcome of one [NativeThumbnailBatchItem]; [index] is its position in the request
+class NativeThumbnailBatchResult {
+  final int index;
+  final String videoPath;
+  final String outputPath;
+  final bool success;
+  final String? error;
+
+  const NativeThumbnailBatchResult({
+    required this.index,
+    required this.videoPath,
+    required this.outputPath,
+    required this.success,
+    this.error,
+  });
+
+  factory NativeThumbnailBatchResult._fromMap(
+      Map<dynamic, dynamic> map, List<NativeThumbnailBatchItem> items) {
+    final index = map['index'] as int;
+    return NativeThumbnailBatchResult(
+      index: index,
+      videoPath: map['srcFile'] as String? ?? items[index].videoPath,
+      outputPath: map['destFile'] as String? ?? items[index].outputPath,
+      success: map['success'] == true,
+      error: map['error'] as String?,
+    );
+  }
+}
+
+/// Layout of a scrub-preview sprite sheet: tiles are laid out row by row and
+/// [timestamps] holds the time of each tile in seconds
+class NativeSpriteSheet {
+  final String path;
+  final int tileWidth;
+  final int tileHeight;
+  final int columns;
+  final int rows;
+  final List<double> timestamps;
+
+  const NativeSpriteSheet({
+    required this.path,
+    required this.tileWidth,
+    required this.tileHeight,
+    required this.columns,
+    required this.rows,
+    required this.timestamps,
+  });
+
+  static String _indexPath(String sheetPath) => '$sheetPath.json';
+
+  /// Tile to show while hovering at [position]: the last one at or before it
+  int tileIndexAt(Duration position) {
+    final seconds = position.inMicroseconds / Duration.microsecondsPerSecond;
+    var low = 0;
+    var high = timestamps.length - 1;
+    while (low < high) {
+      final mid = (low + high + 1) ~/ 2;
+      if (timestamps[mid] <= seconds) {
+        low = mid;
+      } else {
+        high = mid - 1;
+      }
+    }
+    return low;
+  }
+
+  /// Left edge of tile [index] in the sheet, in pixels
+  int tileX(int index) => (index % columns) * tileWidth;
+
+  /// Top edge of tile [index] in the sheet, in pixels
+  int tileY(int index) => (index ~/ columns) * tileHeight;
+
+  factory NativeSpriteSheet._fromMap(Map<dynamic, dynamic> map) {
+    return NativeSpriteSheet(
+      path: map['path'] as String,
+      tileWidth: map['tileWidth'] as int,
+      tileHeight: map['tileHeight'] as int,
+      columns: map['columns'] as int,
+      rows: map['rows'] as int,
+      timestamps: (map['timestamps'] as List<dynamic>)
+          .map((t) => (t as num).toDouble())
+          .toList(growable: false),
+    );
+  }
+
+  Map<String, Object> _toJson() => {
+        'path': path,
+        'tileWidth': tileWidth,
+        'tileHeight': tileHeight,
+        'columns': columns,
+        'rows': rows,
+        'timestamps': timestamps,
+      };
+}
+
+/// Probe result for one video, as returned by
+/// [FcNativeVideoThumbnail.getMediaInfo]
+class NativeMediaInfo {
+  /// Seconds; negative if the container does not say
+  final double duration;
+  final int width;
+  final int height;
+
+  /// Clockwise degrees (0, 90, 180 or 270) that turn the picture upright
+  final int rotation;
+  final String codec;
+
+  /// Keyframe times in seconds, thinned to a few hundred on long videos;
+  /// empty when the container has no index up front
+  final List<double> keyframes;
+
+  const NativeMediaInfo({
+    required this.duration,
+    required this.width,
+    required this.height,
+    required this.rotation,
+    required this.codec,
+    required this.keyframes,
+  });
+
+  /// Size as displayed, with [rotation] applied
+  int get displayWidth => rotation % 180 == 0 ? width : height;
+  int get displayHeight => rotation % 180 == 0 ? height : width;
+
+  factory NativeMediaInfo._fromMap(Map<dynamic, dynamic> map) {
+    return NativeMediaInfo(
+      duration: (map['duration'] as num).toDouble(),
+      width: map['width'] as int,
+      height: map['height'] as int,
+      rotation: map['rotation'] as int,
+      codec: map['codec'] as String,
+      keyframes: (map['keyframes'] as List<dynamic>)
+          .map((t) => (t as num).toDouble())
+          .toList(growable: false),
+    );
+  }
+}
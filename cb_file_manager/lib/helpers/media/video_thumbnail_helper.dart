@@ -58,14 +58,14 @@ class ThumbnailGenerationStatus {
 /// Cache for video durations to avoid repeated native calls
 final Map<String, int> _durationCache = {};
 
-/// Get actual video duration using native FFmpeg library (Windows) or estimation (other platforms)
+/// Get actual video duration using native FFmpeg library (Windows/Linux) or estimation (other platforms)
 Future<int> _getActualVideoDuration(String videoPath) async {
   // Check cache first
   if (_durationCache.containsKey(videoPath)) {
     return _durationCache[videoPath]!;
   }
 
-  if (Platform.isWindows) {
+  if (FcNativeVideoThumbnail.isSupportedPlatform) {
     try {
       // Native call runs on background thread, won't block UI
       final duration = await FcNativeVideoThumbnail.getVideoDuration(videoPath);
@@ -387,6 +387,12 @@ class VideoThumbnailHelper {
 
   static bool get _isWindows => Platform.isWindows;
 
+  /// Windows always ships the native plugin; Linux has it when the runner
+  /// was built with FFmpeg
+  static Future<bool> _useNativeGenerator() async =>
+      _isWindows ||
+      (Platform.isLinux && await FcNativeVideoThumbnail.initialize());
+
   static DateTime _lastCleanupTime = DateTime.now();
 
   static String _currentDirectory = '';
@@ -523,6 +529,11 @@ class VideoThumbnailHelper {
   /// This prevents items from being forgotten after scrolling
   static final Set<String> _attemptedPaths = {};
 
+  /// Folder generation through FcNativeVideoThumbnail.generateBatch: cache
+  /// keys still in flight, and the subscription that receives their results
+  static final Set<String> _batchPending = {};
+  static StreamSubscription<NativeThumbnailBatchResult>? _batchSubscription;
+
   // Add a static flag to check if processing should continue
   static bool _shouldStopProcessing = false;
 
@@ -714,6 +725,22 @@ class VideoThumbnailHelper {
 
     _processingQueue.removeWhere((req) => processingsToRemove.contains(req));
 
+    // A batch only ever covers one directory
+    if (_batchPending.isNotEmpty &&
+        !_batchPending.every((key) =>
+            _isSameOrWithinDirectory(dirPath, path.dirname(key)))) {
+      canceledCount += _batchPending.length;
+      _cancelBatch();
+    }
+
+    // Native requests that have not started yet would still occupy a worker
+    if (processingsToRemove.isNotEmpty) {
+      unawaited(FcNativeVideoThumbnail.cancelThumbnails(processingsToRemove
+          .map((req) => _nativeRequestId(_cacheKeyForPath(req.videoPath),
+              req.thumbnailSize ?? maxThumbnailSize, 'jpg'))
+          .toList()));
+    }
+
     // Reset flag after clearing the queues
     _shouldStopProcessing = false;
 
@@ -1020,15 +1047,15 @@ class VideoThumbnailHelper {
         return null;
       }
 
-      // On Windows, call directly without isolate because VideoThumbnail package
-      // doesn't work in isolates due to BackgroundIsolateBinaryMessenger issues
+      // With the native plugin, call directly without isolate because
+      // platform channels don't work reliably in isolates
+      // (BackgroundIsolateBinaryMessenger issues)
       String? generatedPath;
 
-      if (_isWindows) {
-        _log(
-            'VideoThumbnail: Using direct generation on Windows for $cacheKey');
+      if (await _useNativeGenerator()) {
+        _log('VideoThumbnail: Using direct native generation for $cacheKey');
         try {
-          generatedPath = await _generateThumbnailDirectWindows(
+          generatedPath = await _generateThumbnailDirectNative(
             videoPath: cacheKey,
             cacheFilename: cacheFilename,
             absoluteVideoPath: absoluteVideoPath,
@@ -1045,7 +1072,7 @@ class VideoThumbnailHelper {
           return null;
         }
       } else {
-        // On non-Windows platforms, use isolates
+        // Without the native plugin, use isolates
         final rootToken = RootIsolateToken.instance;
         if (rootToken == null) {
           _log(
@@ -1054,7 +1081,7 @@ class VideoThumbnailHelper {
           );
         }
 
-        // Emit status for non-Windows platforms
+        // Emit status for the isolate path
         final mode = _thumbnailMode;
         try {
           _generationStatusController.add(ThumbnailGenerationStatus(
@@ -1106,14 +1133,7 @@ class VideoThumbnailHelper {
       if (generatedPath != null) {
         final resultFile = File(generatedPath);
         if (await resultFile.exists() && await resultFile.length() > 0) {
-          await _addToFileCache(cacheKey, generatedPath);
-          // Update in-memory for fast subsequent access
-          _inMemoryPathCache[cacheKey] = generatedPath;
-          // Notify listeners this specific thumbnail is ready
-          try {
-            _thumbnailReadyController.add(cacheKey);
-          } catch (_) {}
-          _saveCacheToDiskThrottled();
+          await _onThumbnailGenerated(cacheKey, generatedPath);
           return generatedPath;
         } else {
           _log(
@@ -1134,10 +1154,24 @@ class VideoThumbnailHelper {
     return null;
   }
 
-  /// Generate thumbnail directly on Windows without using compute/isolates
-  /// This avoids BackgroundIsolateBinaryMessenger crashes on Windows
+  /// Record a freshly generated thumbnail and tell listeners about it
+  static Future<void> _onThumbnailGenerated(
+      String cacheKey, String thumbnailPath) async {
+    await _addToFileCache(cacheKey, thumbnailPath);
+    // Update in-memory for fast subsequent access
+    _inMemoryPathCache[cacheKey] = thumbnailPath;
+    // Notify listeners this specific thumbnail is ready
+    try {
+      _thumbnailReadyController.add(cacheKey);
+    } catch (_) {}
+    _saveCacheToDiskThrottled();
+  }
+
+  /// Generate thumbnail directly through the native plugin (Windows, or
+  /// Linux built with FFmpeg) without using compute/isolates
+  /// This avoids BackgroundIsolateBinaryMessenger crashes
   /// The native plugin already uses a C++ thread pool, so no UI blocking
-  static Future<String?> _generateThumbnailDirectWindows({
+  static Future<String?> _generateThumbnailDirectNative({
     required String videoPath,
     required String cacheFilename,
     required String absoluteVideoPath,
@@ -1172,6 +1206,36 @@ class VideoThumbnailHelper {
       String? nativePath;
       final mode = _thumbnailMode;
 
+      if (mode == ThumbnailMode.fast && forceRegenerate) {
+        // The user asked for a new thumbnail, and the shell cache would
+        // hand back the same frame: let the native side pick a keyframe
+        // with content instead. The shell thumbnail below is the fallback.
+        try {
+          nativePath =
+              await FcNativeVideoThumbnail.generateThumbnailAtPercentage(
+            videoPath: absoluteVideoPath,
+            outputPath: thumbnailPath,
+            percentage: 0,
+            width: maxSize,
+            format: 'jpg',
+            quality: quality,
+            representativeFrame: true,
+          );
+
+          if (nativePath != null) {
+            final file = File(nativePath);
+            if (await file.exists() && await file.length() > 0) {
+              _log(
+                  'VideoThumbnail: [Fast Mode] Representative frame successful for $videoPath');
+              return nativePath;
+            }
+          }
+        } catch (e) {
+          _log(
+              'VideoThumbnail: [Fast Mode] Representative frame failed for $videoPath: $e');
+        }
+      }
+
       if (mode == ThumbnailMode.fast) {
         // Fast mode: use OS shell thumbnail (Windows shell cache)
         _log(
@@ -1193,8 +1257,11 @@ class VideoThumbnailHelper {
             outputPath: thumbnailPath,
             width: maxSize,
             format: 'jpg',
-            timeSeconds: null, // Use Windows shell cache
+            timeSeconds: null, // Windows shell cache; Linux picks 1/3 in
             quality: quality,
+            keyframeOnly: true, // Grid thumbnail: latency over exact frame
+            // Cancellable via cancelThumbnailsNotInDirectory
+            requestId: _nativeRequestId(videoPath, maxSize, 'jpg'),
           );
 
           if (nativePath != null) {
@@ -1265,6 +1332,7 @@ class VideoThumbnailHelper {
               format: 'jpg',
               timeSeconds: null,
               quality: quality,
+              requestId: _nativeRequestId(videoPath, maxSize, 'jpg'),
             );
           } catch (e) {
             _log(
@@ -1290,13 +1358,19 @@ class VideoThumbnailHelper {
       return null;
     } catch (e, stackTrace) {
       _log(
-        'VideoThumbnail: Error in _generateThumbnailDirectWindows for $videoPath: $e\n$stackTrace',
+        'VideoThumbnail: Error in _generateThumbnailDirectNative for $videoPath: $e\n$stackTrace',
         forceShow: true,
       );
       return null;
     }
   }
 
+  /// ID of a native request. The plugin drops a request whose ID is already
+  /// in flight, so the ID covers everything that changes the output.
+  static String _nativeRequestId(String videoPath, int width, String format) {
+    return '$videoPath|$width|$format';
+  }
+
   static String _createCacheFilename(String videoPath) {
     final bytes = utf8.encode(videoPath);
     final digest = md5.convert(bytes);
@@ -1917,6 +1991,11 @@ class VideoThumbnailHelper {
     // Clear pending queue to prioritize new directory
     _pendingQueue.clear();
 
+    if (await _useNativeGenerator()) {
+      await _generateAllInBatch(videoPaths, directoryPath);
+      return;
+    }
+
     // Add ALL videos to queue with decreasing priority based on position
     // Priority decreases by 1 for each position, ensuring top items are processed first
     for (var i = 0; i < videoPaths.length; i++) {
@@ -1966,6 +2045,94 @@ class VideoThumbnailHelper {
     );
   }
 
+  /// Native side of [proactiveGenerateAll]: one generateBatch call for every
+  /// uncached video, in list order, instead of one channel call per tile.
+  /// Results are announced through [onThumbnailReady] as they arrive.
+  static Future<void> _generateAllInBatch(
+    List<String> videoPaths,
+    String directoryPath,
+  ) async {
+    _cancelBatch();
+
+    final tempDir = await AppPathHelper.getVideoCacheDir();
+    final fastMode = _thumbnailMode == ThumbnailMode.fast;
+    final items = <NativeThumbnailBatchItem>[];
+    final cacheKeys = <String>[];
+    for (var i = 0; i < videoPaths.length; i++) {
+      if (_currentDirectory != directoryPath) {
+        _log(
+          'VideoThumbnail: Directory changed, stopping proactive generation',
+        );
+        return;
+      }
+
+      final videoPath = videoPaths[i];
+      if (await getFromCache(videoPath) != null) {
+        continue;
+      }
+
+      final cacheKey = _cacheKeyForPath(videoPath);
+      if (!_batchPending.add(cacheKey)) {
+        continue;
+      }
+      cacheKeys.add(cacheKey);
+      items.add(NativeThumbnailBatchItem(
+        videoPath: _isWindows ? cacheKey.replaceAll('\\', '/') : cacheKey,
+        outputPath: path.join(tempDir.path, _createCacheFilename(cacheKey)),
+        width: maxThumbnailSize,
+        // Fast mode: Windows shell cache; Linux picks 1/3 in
+        percentage: fastMode ? null : _thumbnailPercentage.toInt().toDouble(),
+      ));
+
+      // Small yield every 10 items to prevent blocking
+      if (i % 10 == 9) {
+        await Future.delayed(Duration.zero);
+      }
+    }
+    if (_currentDirectory != directoryPath) {
+      _batchPending.removeAll(cacheKeys);
+      return;
+    }
+    if (items.isEmpty) return;
+
+    _log(
+      'VideoThumbnail: Generating ${items.length} thumbnails in one batch',
+    );
+    _batchSubscription = FcNativeVideoThumbnail.generateBatch(
+      items,
+      format: 'jpg',
+      quality: thumbnailQuality,
+      // Grid thumbnails: latency over exact frame
+      keyframeOnly: fastMode,
+    ).listen(
+      (result) async {
+        final cacheKey = cacheKeys[result.index];
+        if (!_batchPending.remove(cacheKey) || !result.success) {
+          return;
+        }
+        final file = File(result.outputPath);
+        if (await file.exists() && await file.length() > 0) {
+          await _onThumbnailGenerated(cacheKey, result.outputPath);
+        }
+      },
+      onError: (Object e) {
+        _log('VideoThumbnail: Batch generation failed: $e', forceShow: true);
+        _batchPending.removeAll(cacheKeys);
+      },
+      onDone: () => _batchPending.removeAll(cacheKeys),
+    );
+  }
+
+  /// Drop the folder batch; items that have not started are cancelled natively
+  static void _cancelBatch() {
+    final subscription = _batchSubscription;
+    _batchSubscription = null;
+    _batchPending.clear();
+    if (subscription != null) {
+      unawaited(subscription.cancel());
+    }
+  }
+
   /// Tối ưu việc tải nhiều thumbnail cùng một lúc với hàng đợi ưu tiên
   static Future<void> optimizedBatchPreload(
     List<String> videoPaths, {
@@ -2029,6 +2196,7 @@ class VideoThumbnailHelper {
   /// Hủy tất cả các yêu cầu đang chờ xử lý
   static void cancelPendingRequests() {
     _pendingQueue.clear();
+    _cancelBatch();
   }
 
   /// Flag to mark a thumbnail as attempted for generation
@@ -2047,7 +2215,8 @@ class VideoThumbnailHelper {
   /// which would disrupt the sort-order based generation sequence
   static bool isPathQueued(String videoPath) {
     final cacheKey = _cacheKeyForPath(videoPath);
-    return _pendingQueue.any((req) => req.videoPath == cacheKey) ||
+    return _batchPending.contains(cacheKey) ||
+        _pendingQueue.any((req) => req.videoPath == cacheKey) ||
         _processingQueue.any((req) => req.videoPath == cacheKey);
   }
 
@@ -2182,6 +2351,7 @@ class VideoThumbnailHelper {
       forceShow: true,
     );
     _shouldStopProcessing = true;
+    _cancelBatch();
 
     // Clear the processing queue
     for (final request in _processingQueue) {
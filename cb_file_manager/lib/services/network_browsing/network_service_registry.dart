@@ -5,6 +5,7 @@ import 'smb_service.dart'; // Reverted back to the original smb_service
 import 'mobile_smb_service.dart'; // Mobile SMB service for Android/iOS
 import 'ftp_service.dart';
 import 'webdav_service.dart';
+import '../streaming/smb_http_proxy_server.dart';
 
 /// Registry for managing all network service providers
 class NetworkServiceRegistry {
@@ -242,6 +243,7 @@ class NetworkServiceRegistry {
       await service.disconnect();
     }
     _activeConnections.clear();
+    await SmbHttpProxyServer.instance.stop();
   }
 
   /// Check if a path belongs to a network service
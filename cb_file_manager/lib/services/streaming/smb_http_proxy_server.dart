@@ -1,5 +1,6 @@
 import 'dart:async';
 import 'dart:convert';
+import 'dart:ffi';
 import 'dart:io';
 
 import 'package:shelf/shelf.dart';
@@ -10,6 +11,10 @@ import 'package:mobile_smb_native/mobile_smb_native.dart';
 
 /// Lightweight HTTP proxy that exposes an SMB file as an HTTP stream with Range support.
 /// Designed specifically to feed ExoPlayer during Android PiP mode.
+///
+/// URLs come from the native loopback server in mobile_smb_native when it is
+/// available: it streams from the native read-ahead buffers and keeps one
+/// session per server/share/user. The Dart server below is the fallback.
 class SmbHttpProxyServer {
   static SmbHttpProxyServer? _instance;
   static SmbHttpProxyServer get instance =>
@@ -20,8 +25,12 @@ class SmbHttpProxyServer {
   HttpServer? _server;
   int? _port;
 
-  // For simple per-request handling we do not cache connections long-term.
-  // ExoPlayer will reconnect with Range requests as needed.
+  SmbNativeFFI? _ffi;
+  bool _nativeUnavailable = false;
+  final Map<String, Pointer<Void>> _nativeContexts = {};
+
+  // The fallback handles each request on its own and does not cache
+  // connections long-term. ExoPlayer will reconnect with Range requests as needed.
 
   Future<void> _ensureStarted() async {
     if (_server != null) return;
@@ -33,11 +42,86 @@ class SmbHttpProxyServer {
 
   /// Returns a URL that ExoPlayer can consume for the given [smbUrl].
   Future<Uri> urlFor(String smbUrl) async {
+    final nativeUrl = await _nativeUrlFor(smbUrl);
+    if (nativeUrl != null) {
+      return nativeUrl;
+    }
     await _ensureStarted();
     final encoded = base64Url.encode(utf8.encode(smbUrl));
     return Uri.parse('http://127.0.0.1:$_port/stream?u=$encoded');
   }
 
+  /// Stops serving and disconnects the sessions kept for native streams.
+  /// URLs handed out earlier stop working; the next [urlFor] starts again.
+  Future<void> stop() async {
+    final ffi = _ffi;
+    if (ffi != null) {
+      for (final context in _nativeContexts.values) {
+        ffi.disconnect(context);
+      }
+      _nativeContexts.clear();
+      ffi.stopHttpProxy();
+    }
+    await _server?.close(force: true);
+    _server = null;
+    _port = null;
+  }
+
+  SmbNativeFFI? _nativeProxy() {
+    if (_nativeUnavailable) return null;
+    try {
+      final ffi = _ffi ??= SmbNativeFFI();
+      if (ffi.startHttpProxy() == null) {
+        _nativeUnavailable = true;
+        return null;
+      }
+      return ffi;
+    } catch (_) {
+      _nativeUnavailable = true;
+      return null;
+    }
+  }
+
+  Future<Uri?> _nativeUrlFor(String smbUrl) async {
+    final ffi = _nativeProxy();
+    final info = _parseSmbUrl(smbUrl);
+    if (ffi == null || info == null) return null;
+
+    // Every stream on a server/share/user shares one session. The password
+    // is part of the key so that changed credentials get a new session.
+    final user = '${info.host}\n${info.share}\n${info.username ?? ''}\n';
+    final key = '$user${info.password ?? ''}';
+    var context = _nativeContexts[key];
+    if (context != null && !ffi.isConnected(context)) {
+      ffi.disconnect(context);
+      _nativeContexts.remove(key);
+      context = null;
+    }
+    if (context == null) {
+      // Connecting blocks on the network, so it runs off this isolate
+      final connected = await ffi.connectInBackground(
+          info.host, info.share, info.username ?? '', info.password ?? '');
+      if (connected == null) return null;
+      context = _nativeContexts[key];
+      if (context != null) {
+        // Another request connected the same key while this one waited
+        ffi.disconnect(connected);
+      } else {
+        context = connected;
+        // Sessions under old credentials; URLs already issued keep theirs
+        _nativeContexts.removeWhere((other, stale) {
+          if (!other.startsWith(user)) return false;
+          ffi.disconnect(stale);
+          return true;
+        });
+        _nativeContexts[key] = context;
+      }
+    }
+
+    final url = ffi.proxyUrlFor(context, _buildClientPath(info));
+    return url == null ? null : Uri.parse(url);
+  }
+
   Future<Response> _handle(Request req) async {
     try {
       if (req.url.path != 'stream') {
@@ -0,0 +1,535 @@
+#include "fc_native_video_thumbnail_plugin.h"
+
+#include <media_info.h>
+#include <thumbnail_core.h>
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr char kChannelName[] = "fc_native_video_thumbnail";
+constexpr char kBatchChannelName[] = "fc_native_video_thumbnail/batch";
+
+// generateBatch results are sent in lists of at most this many
+constexpr guint kMaxBatchChunk = 64;
+
+enum class JobKind {
+  kThumbnail,
+  kThumbnailAtPercentage,
+  kSpriteSheet,
+  kDuration,
+  kMediaInfo,
+  kBatchItem
+};
+
+// One generateBatch call. Only the cancelled flag is read off the main loop.
+struct BatchState {
+  int64_t batch_id = 0;
+  size_t remaining = 0;
+  std::atomic<bool> cancelled{false};
+};
+
+// One method call handed to the thread pool. Holds a reference to the call
+// until the reply has been sent from the main loop. Batch items have no call
+// of their own and hold a reference to the plugin instead.
+struct ThumbnailJob {
+  FlMethodCall* method_call = nullptr;
+  JobKind kind;
+  std::string src_file;
+  std::string dest_file;
+  TcThumbnailOptions options;
+  int frame_count = 0;  // kSpriteSheet only
+  int columns = 0;
+  GObject* plugin = nullptr;  // kBatchItem only
+  std::shared_ptr<BatchState> batch;
+  int64_t index = 0;
+
+  // Filled in by the worker
+  int error_code = TC_SUCCESS;
+  double duration = -1.0;
+  TcSpriteSheet sprite_sheet = {};
+  TcMediaInfo media_info = {};
+};
+
+FlValue* lookup_arg(FlValue* args, const char* key) {
+  if (args == nullptr || fl_value_get_type(args) != FL_VALUE_TYPE_MAP) {
+    return nullptr;
+  }
+  FlValue* value = fl_value_lookup_string(args, key);
+  if (value == nullptr || fl_value_get_type(value) == FL_VALUE_TYPE_NULL) {
+    return nullptr;
+  }
+  return value;
+}
+
+std::string string_arg(FlValue* args, const char* key) {
+  FlValue* value = lookup_arg(args, key);
+  if (value == nullptr || fl_value_get_type(value) != FL_VALUE_TYPE_STRING) {
+    return std::string();
+  }
+  return fl_value_get_string(value);
+}
+
+// Dart may send whole numbers for doubles (e.g. 30 for 30.0) and vice versa
+double number_arg(FlValue* args, const char* key, double fallback) {
+  FlValue* value = lookup_arg(args, key);
+  if (value == nullptr) {
+    return fallback;
+  }
+  switch (fl_value_get_type(value)) {
+    case FL_VALUE_TYPE_INT:
+      return static_cast<double>(fl_value_get_int(value));
+    case FL_VALUE_TYPE_FLOAT:
+      return fl_value_get_float(value);
+    default:
+      return fallback;
+  }
+}
+
+int int_arg(FlValue* args, const char* key, int fallback) {
+  return static_cast<int>(number_arg(args, key, fallback));
+}
+
+bool bool_arg(FlValue* args, const char* key) {
+  FlValue* value = lookup_arg(args, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_BOOL &&
+         fl_value_get_bool(value);
+}
+
+int format_arg(FlValue* args) {
+  return string_arg(args, "format") == "png" ? TC_FORMAT_PNG : TC_FORMAT_JPEG;
+}
+
+FlValue* sprite_sheet_value(const ThumbnailJob* job) {
+  const TcSpriteSheet& sheet = job->sprite_sheet;
+  FlValue* timestamps = fl_value_new_list();
+  for (int i = 0; i < sheet.frame_count; ++i) {
+    fl_value_append_take(timestamps, fl_value_new_float(sheet.timestamps[i]));
+  }
+
+  FlValue* layout = fl_value_new_map();
+  fl_value_set_string_take(layout, "path",
+                           fl_value_new_string(job->dest_file.c_str()));
+  fl_value_set_string_take(layout, "tileWidth",
+                           fl_value_new_int(sheet.tile_width));
+  fl_value_set_string_take(layout, "tileHeight",
+                           fl_value_new_int(sheet.tile_height));
+  fl_value_set_string_take(layout, "columns", fl_value_new_int(sheet.columns));
+  fl_value_set_string_take(layout, "rows", fl_value_new_int(sheet.rows));
+  fl_value_set_string_take(layout, "timestamps", timestamps);
+  return layout;
+}
+
+FlValue* media_info_value(const TcMediaInfo& info) {
+  FlValue* keyframes = fl_value_new_list();
+  for (int i = 0; i < info.keyframe_count; ++i) {
+    fl_value_append_take(keyframes, fl_value_new_float(info.keyframes[i]));
+  }
+
+  FlValue* value = fl_value_new_map();
+  fl_value_set_string_take(value, "duration",
+                           fl_value_new_float(info.duration));
+  fl_value_set_string_take(value, "width", fl_value_new_int(info.width));
+  fl_value_set_string_take(value, "height", fl_value_new_int(info.height));
+  fl_value_set_string_take(value, "rotation",
+                           fl_value_new_int(info.rotation));
+  fl_value_set_string_take(value, "codec", fl_value_new_string(info.codec));
+  fl_value_set_string_take(value, "keyframes", keyframes);
+  return value;
+}
+
+// Defined with the plugin below
+void batch_item_done(ThumbnailJob* job);
+
+gboolean respond_on_main_loop(gpointer user_data) {
+  ThumbnailJob* job = static_cast<ThumbnailJob*>(user_data);
+  if (job->kind == JobKind::kBatchItem) {
+    batch_item_done(job);
+    g_object_unref(job->plugin);
+    delete job;
+    return G_SOURCE_REMOVE;
+  }
+
+  g_autoptr(FlValue) result = nullptr;
+  switch (job->kind) {
+    case JobKind::kThumbnail:
+      result = fl_value_new_bool(job->error_code == TC_SUCCESS);
+      break;
+    case JobKind::kThumbnailAtPercentage:
+      result = job->error_code == TC_SUCCESS
+                   ? fl_value_new_string(job->dest_file.c_str())
+                   : fl_value_new_null();
+      break;
+    case JobKind::kSpriteSheet:
+      result = job->error_code == TC_SUCCESS ? sprite_sheet_value(job)
+                                             : fl_value_new_null();
+      tc_free_sprite_sheet(&job->sprite_sheet);
+      break;
+    case JobKind::kDuration:
+      result = fl_value_new_float(job->duration);
+      break;
+    case JobKind::kMediaInfo:
+      result = job->error_code == TC_SUCCESS ? media_info_value(job->media_info)
+                                             : fl_value_new_null();
+      tc_free_media_info(&job->media_info);
+      break;
+    case JobKind::kBatchItem:
+      break;
+  }
+
+  fl_method_call_respond_success(job->method_call, result, nullptr);
+  g_object_unref(job->method_call);
+  delete job;
+  return G_SOURCE_REMOVE;
+}
+
+void run_job(gpointer data, gpointer user_data) {
+  ThumbnailJob* job = static_cast<ThumbnailJob*>(data);
+
+  if (job->kind == JobKind::kBatchItem && job->batch->cancelled) {
+    // Reports nothing, but the batch still counts it off on the main loop
+  } else if (job->kind == JobKind::kDuration) {
+    job->duration = tc_get_video_duration(job->src_file.c_str());
+  } else if (job->kind == JobKind::kMediaInfo) {
+    job->error_code =
+        tc_get_media_info(job->src_file.c_str(), &job->media_info);
+  } else if (job->kind == JobKind::kSpriteSheet) {
+    job->error_code = tc_extract_sprite_sheet(
+        job->src_file.c_str(), job->dest_file.c_str(), &job->options,
+        job->frame_count, job->columns, &job->sprite_sheet);
+  } else {
+    job->error_code = tc_extract_thumbnail_to_file(
+        job->src_file.c_str(), job->dest_file.c_str(), &job->options);
+    if (job->error_code != TC_SUCCESS) {
+      g_warning("Thumbnail for %s failed: %s", job->src_file.c_str(),
+                tc_error_message(job->error_code));
+    }
+  }
+
+  g_idle_add(respond_on_main_loop, job);
+}
+
+}  // namespace
+
+struct _FcNativeVideoThumbnailPlugin {
+  GObject parent_instance;
+  GThreadPool* pool;
+
+  // generateBatch state; main loop only
+  FlEventChannel* batch_channel;
+  gboolean batch_listening;
+  int64_t next_batch_id;
+  std::map<int64_t, std::shared_ptr<BatchState>>* batches;
+  FlValue* batch_results;  // Results not sent yet
+  guint batch_flush_source;
+};
+
+G_DEFINE_TYPE(FcNativeVideoThumbnailPlugin, fc_native_video_thumbnail_plugin,
+              g_object_get_type())
+
+// Send everything collected since the last flush. Results of items that
+// finish together share an idle pass, so they go out as one list.
+static gboolean flush_batch_results(gpointer user_data) {
+  FcNativeVideoThumbnailPlugin* self =
+      FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN(user_data);
+  self->batch_flush_source = 0;
+
+  g_autoptr(FlValue) results = self->batch_results;
+  self->batch_results = fl_value_new_list();
+  size_t count = fl_value_get_length(results);
+  if (self->batch_listening && self->batch_channel != nullptr) {
+    for (size_t start = 0; start < count; start += kMaxBatchChunk) {
+      g_autoptr(FlValue) chunk = fl_value_new_list();
+      for (size_t i = start; i < count && i < start + kMaxBatchChunk; ++i) {
+        fl_value_append(chunk, fl_value_get_list_value(results, i));
+      }
+      g_autoptr(GError) error = nullptr;
+      if (!fl_event_channel_send(self->batch_channel, chunk, nullptr,
+                                 &error)) {
+        g_warning("Failed to send batch results: %s", error->message);
+      }
+    }
+  }
+  return G_SOURCE_REMOVE;
+}
+
+namespace {
+
+void batch_item_done(ThumbnailJob* job) {
+  FcNativeVideoThumbnailPlugin* self =
+      FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN(job->plugin);
+  BatchState* batch = job->batch.get();
+
+  if (!batch->cancelled && self->batch_results != nullptr) {
+    FlValue* result = fl_value_new_map();
+    fl_value_set_string_take(result, "batchId",
+                             fl_value_new_int(batch->batch_id));
+    fl_value_set_string_take(result, "index", fl_value_new_int(job->index));
+    fl_value_set_string_take(result, "srcFile",
+                             fl_value_new_string(job->src_file.c_str()));
+    fl_value_set_string_take(result, "destFile",
+                             fl_value_new_string(job->dest_file.c_str()));
+    fl_value_set_string_take(result, "success",
+                             fl_value_new_bool(job->error_code == TC_SUCCESS));
+    if (job->error_code != TC_SUCCESS) {
+      fl_value_set_string_take(
+          result, "error",
+          fl_value_new_string(tc_error_message(job->error_code)));
+    }
+    fl_value_append_take(self->batch_results, result);
+    if (self->batch_flush_source == 0) {
+      self->batch_flush_source = g_idle_add_full(
+          G_PRIORITY_DEFAULT_IDLE, flush_batch_results, g_object_ref(self),
+          g_object_unref);
+    }
+  }
+
+  if (--batch->remaining == 0 && self->batches != nullptr) {
+    self->batches->erase(batch->batch_id);
+  }
+}
+
+}  // namespace
+
+// Queue every item of a generateBatch call. Items are {srcFile, destFile,
+// width?, timeSeconds?, percentage?}; format, quality and keyframeOnly apply
+// to all. Returns the batch ID; results follow on the batch event channel.
+static int64_t start_batch(FcNativeVideoThumbnailPlugin* self, FlValue* args) {
+  auto batch = std::make_shared<BatchState>();
+  batch->batch_id = self->next_batch_id++;
+
+  FlValue* items = lookup_arg(args, "items");
+  if (items == nullptr || fl_value_get_type(items) != FL_VALUE_TYPE_LIST ||
+      fl_value_get_length(items) == 0) {
+    return batch->batch_id;
+  }
+  size_t count = fl_value_get_length(items);
+  batch->remaining = count;
+  (*self->batches)[batch->batch_id] = batch;
+
+  for (size_t i = 0; i < count; ++i) {
+    FlValue* item = fl_value_get_list_value(items, i);
+    ThumbnailJob* job = new ThumbnailJob();
+    job->kind = JobKind::kBatchItem;
+    job->plugin = G_OBJECT(g_object_ref(self));
+    job->batch = batch;
+    job->index = static_cast<int64_t>(i);
+    job->src_file = string_arg(item, "srcFile");
+    job->dest_file = string_arg(item, "destFile");
+
+    tc_default_options(&job->options);
+    if (lookup_arg(item, "percentage") != nullptr) {
+      job->options.seek_mode = TC_SEEK_PERCENTAGE;
+      job->options.seek_value = number_arg(item, "percentage", 30.0);
+    } else {
+      job->options.seek_mode = TC_SEEK_SECONDS;
+      job->options.seek_value = number_arg(item, "timeSeconds", -1.0);
+    }
+    job->options.fast_probe = 1;
+    job->options.keyframe_only = bool_arg(args, "keyframeOnly") ? 1 : 0;
+    job->options.width = int_arg(item, "width", 0);
+    job->options.scale_mode = TC_SCALE_FAST;
+    job->options.format = format_arg(args);
+    job->options.quality = int_arg(args, "quality", 95);
+
+    if (job->src_file.empty() || job->dest_file.empty()) {
+      job->error_code = TC_ERROR_INVALID_ARGUMENT;
+      respond_on_main_loop(job);
+    } else {
+      g_thread_pool_push(self->pool, job, nullptr);
+    }
+  }
+  return batch->batch_id;
+}
+
+// Items that have not started are skipped; running ones still report
+static gboolean cancel_batch(FcNativeVideoThumbnailPlugin* self,
+                             int64_t batch_id) {
+  auto it = self->batches->find(batch_id);
+  if (it == self->batches->end()) {
+    return FALSE;
+  }
+  it->second->cancelled = true;
+  self->batches->erase(it);
+  return TRUE;
+}
+
+static void respond_bool(FlMethodCall* method_call, gboolean value) {
+  g_autoptr(FlValue) result = fl_value_new_bool(value);
+  fl_method_call_respond_success(method_call, result, nullptr);
+}
+
+static void fc_native_video_thumbnail_plugin_handle_method_call(
+    FcNativeVideoThumbnailPlugin* self, FlMethodCall* method_call) {
+  const gchar* method = fl_method_call_get_name(method_call);
+  FlValue* args = fl_method_call_get_args(method_call);
+
+  if (strcmp(method, "generateBatch") == 0) {
+    g_autoptr(FlValue) result = fl_value_new_int(start_batch(self, args));
+    fl_method_call_respond_success(method_call, result, nullptr);
+    return;
+  }
+  if (strcmp(method, "cancelBatch") == 0) {
+    FlValue* batch_id = lookup_arg(args, "batchId");
+    respond_bool(method_call,
+                 batch_id != nullptr &&
+                     fl_value_get_type(batch_id) == FL_VALUE_TYPE_INT &&
+                     cancel_batch(self, fl_value_get_int(batch_id)));
+    return;
+  }
+
+  ThumbnailJob* job = new ThumbnailJob();
+  tc_default_options(&job->options);
+  job->src_file = string_arg(args, "srcFile");
+  job->dest_file = string_arg(args, "destFile");
+
+  if (strcmp(method, "getVideoThumbnail") == 0) {
+    job->kind = JobKind::kThumbnail;
+    // No timeSeconds means 1/3 in: one keyframe, which grid tiles rely on.
+    // Choosing by content is opt-in.
+    job->options.seek_value = number_arg(args, "timeSeconds", -1.0);
+    job->options.seek_mode = bool_arg(args, "representativeFrame")
+                                 ? TC_SEEK_REPRESENTATIVE
+                                 : TC_SEEK_SECONDS;
+  } else if (strcmp(method, "generateThumbnailAtPercentage") == 0) {
+    job->kind = JobKind::kThumbnailAtPercentage;
+    job->options.seek_mode = bool_arg(args, "representativeFrame")
+                                 ? TC_SEEK_REPRESENTATIVE
+                                 : TC_SEEK_PERCENTAGE;
+    job->options.seek_value = number_arg(args, "percentage", 30.0);
+  } else if (strcmp(method, "generateSpriteSheet") == 0) {
+    job->kind = JobKind::kSpriteSheet;
+    job->frame_count = int_arg(args, "frameCount", 100);
+    job->columns = int_arg(args, "columns", 0);
+  } else if (strcmp(method, "getVideoDuration") == 0) {
+    job->kind = JobKind::kDuration;
+  } else if (strcmp(method, "getMediaInfo") == 0) {
+    job->kind = JobKind::kMediaInfo;
+  } else {
+    delete job;
+    if (strcmp(method, "openMediaInfoCache") == 0) {
+      // Probing works without it; this only makes results outlive the run
+      std::string path = string_arg(args, "path");
+      int error_code = path.empty() ? TC_ERROR_INVALID_ARGUMENT
+                                    : tc_media_info_cache_open(path.c_str());
+      respond_bool(method_call, error_code == TC_SUCCESS);
+    } else if (strcmp(method, "isAvailable") == 0 ||
+        strcmp(method, "setVisibleThumbnails") == 0 ||
+        strcmp(method, "setFocusedThumbnail") == 0) {
+      // Prioritisation hints are a no-op here: the pool is FIFO
+      respond_bool(method_call, TRUE);
+    } else {
+      fl_method_call_respond_not_implemented(method_call, nullptr);
+    }
+    return;
+  }
+
+  job->options.fast_probe = 1;
+  job->options.keyframe_only = bool_arg(args, "keyframeOnly") ? 1 : 0;
+  job->options.width = int_arg(args, "width", 0);
+  job->options.scale_mode = TC_SCALE_FAST;
+  job->options.format = format_arg(args);
+  job->options.quality = int_arg(args, "quality", 95);
+  if (job->kind == JobKind::kSpriteSheet) {
+    job->options.width = int_arg(args, "tileWidth", 160);
+    job->options.quality = int_arg(args, "quality", 80);
+  }
+
+  job->method_call = FL_METHOD_CALL(g_object_ref(method_call));
+
+  bool valid = !job->src_file.empty() &&
+               (job->kind == JobKind::kDuration ||
+                job->kind == JobKind::kMediaInfo ||
+                !job->dest_file.empty());
+  if (!valid) {
+    job->error_code = TC_ERROR_INVALID_ARGUMENT;
+    respond_on_main_loop(job);
+    return;
+  }
+
+  g_thread_pool_push(self->pool, job, nullptr);
+}
+
+static void fc_native_video_thumbnail_plugin_dispose(GObject* object) {
+  FcNativeVideoThumbnailPlugin* self = FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN(object);
+  if (self->pool != nullptr) {
+    // Let queued jobs finish; their replies are already scheduled
+    g_thread_pool_free(self->pool, FALSE, TRUE);
+    self->pool = nullptr;
+  }
+  g_clear_object(&self->batch_channel);
+  if (self->batch_flush_source != 0) {
+    g_source_remove(self->batch_flush_source);
+    self->batch_flush_source = 0;
+  }
+  g_clear_pointer(&self->batch_results, fl_value_unref);
+  delete self->batches;
+  self->batches = nullptr;
+  tc_media_info_cache_close();
+  tc_clear_decoder_pool();
+  G_OBJECT_CLASS(fc_native_video_thumbnail_plugin_parent_class)->dispose(object);
+}
+
+static void fc_native_video_thumbnail_plugin_class_init(
+    FcNativeVideoThumbnailPluginClass* klass) {
+  G_OBJECT_CLASS(klass)->dispose = fc_native_video_thumbnail_plugin_dispose;
+}
+
+static void fc_native_video_thumbnail_plugin_init(
+    FcNativeVideoThumbnailPlugin* self) {
+  // One worker per CPU; the core splits decoder threads across running jobs
+  guint threads = g_get_num_processors();
+  self->pool = g_thread_pool_new(run_job, nullptr, static_cast<gint>(threads),
+                                 FALSE, nullptr);
+  self->next_batch_id = 1;
+  self->batches = new std::map<int64_t, std::shared_ptr<BatchState>>();
+  self->batch_results = fl_value_new_list();
+}
+
+static FlMethodErrorResponse* batch_listen_cb(FlEventChannel* channel,
+                                              FlValue* args,
+                                              gpointer user_data) {
+  FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN(user_data)->batch_listening = TRUE;
+  return nullptr;
+}
+
+static FlMethodErrorResponse* batch_cancel_cb(FlEventChannel* channel,
+                                              FlValue* args,
+                                              gpointer user_data) {
+  FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN(user_data)->batch_listening = FALSE;
+  return nullptr;
+}
+
+static void method_call_cb(FlMethodChannel* channel, FlMethodCall* method_call,
+                           gpointer user_data) {
+  FcNativeVideoThumbnailPlugin* plugin =
+      FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN(user_data);
+  fc_native_video_thumbnail_plugin_handle_method_call(plugin, method_call);
+}
+
+void fc_native_video_thumbnail_plugin_register_with_registrar(
+    FlPluginRegistrar* registrar) {
+  FcNativeVideoThumbnailPlugin* plugin = FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN(
+      g_object_new(fc_native_video_thumbnail_plugin_get_type(), nullptr));
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  g_autoptr(FlMethodChannel) channel =
+      fl_method_channel_new(fl_plugin_registrar_get_messenger(registrar),
+                            kChannelName, FL_METHOD_CODEC(codec));
+  fl_method_channel_set_method_call_handler(channel, method_call_cb,
+                                            g_object_ref(plugin),
+                                            g_object_unref);
+
+  // generateBatch results stream back over this channel
+  plugin->batch_channel =
+      fl_event_channel_new(fl_plugin_registrar_get_messenger(registrar),
+                           kBatchChannelName, FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->batch_channel, batch_listen_cb,
+                                       batch_cancel_cb, plugin, nullptr);
+
+  g_object_unref(plugin);
+}
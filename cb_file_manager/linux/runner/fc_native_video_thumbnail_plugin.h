@@ -0,0 +1,22 @@
+#ifndef RUNNER_FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN_H_
+#define RUNNER_FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN_H_
+
+#include <flutter_linux/flutter_linux.h>
+
+G_DECLARE_FINAL_TYPE(FcNativeVideoThumbnailPlugin,
+                     fc_native_video_thumbnail_plugin, FC,
+                     NATIVE_VIDEO_THUMBNAIL_PLUGIN, GObject)
+
+/**
+ * fc_native_video_thumbnail_plugin_register_with_registrar:
+ *
+ * Serves the "fc_native_video_thumbnail" method channel on Linux with the
+ * portable FFmpeg thumbnail core, so video thumbnails do not need the Dart
+ * fallback. Work runs on a small thread pool; replies are posted back to the
+ * main loop. generateBatch results stream back in chunks on the
+ * "fc_native_video_thumbnail/batch" event channel.
+ */
+void fc_native_video_thumbnail_plugin_register_with_registrar(
+    FlPluginRegistrar* registrar);
+
+#endif  // RUNNER_FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN_H_
@@ -7,6 +7,10 @@
 
 #include "flutter/generated_plugin_registrant.h"
 
+#ifdef HAVE_THUMBNAIL_CORE
+#include "fc_native_video_thumbnail_plugin.h"
+#endif
+
 struct _MyApplication {
   GtkApplication parent_instance;
   char** dart_entrypoint_arguments;
@@ -58,6 +62,12 @@ static void my_application_activate(GApplication* application) {
   gtk_container_add(GTK_CONTAINER(window), GTK_WIDGET(view));
 
   fl_register_plugins(FL_PLUGIN_REGISTRY(view));
+#ifdef HAVE_THUMBNAIL_CORE
+  g_autoptr(FlPluginRegistrar) thumbnail_registrar =
+      fl_plugin_registry_get_registrar_for_plugin(
+          FL_PLUGIN_REGISTRY(view), "FcNativeVideoThumbnailPlugin");
+  fc_native_video_thumbnail_plugin_register_with_registrar(thumbnail_registrar);
+#endif
 
   gtk_widget_grab_focus(GTK_WIDGET(view));
 }
@@ -0,0 +1,42 @@
+#ifndef MEDIA_INFO_H_
+#define MEDIA_INFO_H_
+
+#include "thumbnail_core.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Probe results for one file. keyframes holds up to a few hundred
+    // keyframe times in seconds, spread over the whole file when the
+    // container indexes more; it is malloc'd, release it with
+    // tc_free_media_info.
+    typedef struct
+    {
+        double duration; // Seconds, -1 if unknown
+        int width;       // First video stream; 0 without one
+        int height;
+        int rotation;    // Clockwise degrees to display upright: 0, 90, 180 or 270
+        char codec[32];  // FFmpeg codec name, e.g. "h264"
+        int keyframe_count;
+        float *keyframes;
+    } TcMediaInfo;
+
+    // Every probe (durations, media info and thumbnail extraction) is cached
+    // process-wide, keyed by path, size and modification time, so asking
+    // again about an unchanged file costs a stat and one hash lookup.
+    //
+    // Opening loads the cache saved at path (UTF-8) and keeps it there;
+    // without it the cache only lasts for the run. Closing saves it.
+    int tc_media_info_cache_open(const char *path);
+    void tc_media_info_cache_close(void);
+
+    int tc_get_media_info(const char *path, TcMediaInfo *info);
+    void tc_free_media_info(TcMediaInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MEDIA_INFO_H_
@@ -0,0 +1,137 @@
+#ifndef THUMBNAIL_CORE_H_
+#define THUMBNAIL_CORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Error codes
+#define TC_SUCCESS 0
+#define TC_ERROR_INVALID_ARGUMENT -1
+#define TC_ERROR_OPEN_INPUT -2
+#define TC_ERROR_STREAM_INFO -3
+#define TC_ERROR_NO_VIDEO_STREAM -4
+#define TC_ERROR_DECODER -5
+#define TC_ERROR_SEEK -6
+#define TC_ERROR_NO_FRAME -7
+#define TC_ERROR_SCALE -8
+#define TC_ERROR_ENCODE -9
+#define TC_ERROR_WRITE -10
+#define TC_ERROR_MEMORY -11
+
+    typedef enum
+    {
+        TC_FORMAT_JPEG = 0,
+        TC_FORMAT_PNG = 1
+    } TcImageFormat;
+
+    typedef enum
+    {
+        // seek_value is a position in seconds; out of range picks 1/3 of the duration
+        TC_SEEK_SECONDS = 0,
+        // seek_value is a percentage of the duration, kept within 10-90%
+        // and at least 5 s away from either end
+        TC_SEEK_PERCENTAGE = 1,
+        // seek_value is ignored: a few keyframes across the video are ranked
+        // by compressed size, and the largest that is neither black, blown
+        // out nor flat by its luma is used. Costs a little more than one
+        // keyframe decode, so it is meant for explicit requests rather than
+        // grid tiles. Always a keyframe.
+        TC_SEEK_REPRESENTATIVE = 2
+    } TcSeekMode;
+
+    typedef enum
+    {
+        TC_SCALE_QUALITY = 0, // Area for large reductions, otherwise Lanczos
+        TC_SCALE_FAST = 1     // Fast bilinear
+    } TcScaleMode;
+
+    // Decode, seek and scale inputs plus the encoded output format.
+    // Start from tc_default_options() and override what you need.
+    typedef struct
+    {
+        // Decode
+        int fast_probe;   // Cap probing at 1 s / 1 MB
+        int thread_count; // Decoder threads; 0 splits the CPU across concurrent jobs
+
+        // Seek
+        int seek_mode; // TcSeekMode
+        double seek_value;
+        // Take the nearest keyframe at or before the seek point instead of
+        // decoding forward from it; much faster on long-GOP streams
+        int keyframe_only;
+
+        // Scale: width is a hard limit (never exceeded, never upscaled to);
+        // <= 0 keeps the source size. Height follows the aspect ratio. Codecs
+        // with lowres support decode at a reduced size when width allows it.
+        int width;
+        int scale_mode; // TcScaleMode
+
+        // Output
+        int format;  // TcImageFormat
+        int quality; // JPEG quality 1-100, ignored for PNG
+    } TcThumbnailOptions;
+
+    // Encoded image; data is malloc'd, release it with tc_free_image
+    typedef struct
+    {
+        uint8_t *data;
+        size_t size;
+        int width;
+        int height;
+    } TcImage;
+
+    // Layout of a sprite sheet: frame_count tiles, row by row, each
+    // tile_width x tile_height. timestamps[i] is the time of tile i in
+    // seconds and is malloc'd; release it with tc_free_sprite_sheet.
+    typedef struct
+    {
+        int tile_width;
+        int tile_height;
+        int columns;
+        int rows;
+        int frame_count;
+        double *timestamps;
+    } TcSpriteSheet;
+
+    void tc_default_options(TcThumbnailOptions *options);
+
+    // Paths are UTF-8 on every platform
+    int tc_extract_thumbnail(const char *path, const TcThumbnailOptions *options, TcImage *image);
+    int tc_extract_thumbnail_to_file(const char *path, const char *dest_path,
+                                     const TcThumbnailOptions *options);
+    void tc_free_image(TcImage *image);
+
+    // Scrub previews: frame_count frames spread evenly over the video, taken
+    // with one open input and decoder, tiled into a single image at dest_path.
+    // options->width is the tile width (required); the seek fields are
+    // ignored. columns <= 0 makes the sheet roughly square. Tiles whose frame
+    // cannot be decoded stay black.
+    int tc_extract_sprite_sheet(const char *path, const char *dest_path,
+                                const TcThumbnailOptions *options, int frame_count,
+                                int columns, TcSpriteSheet *sheet);
+    void tc_free_sprite_sheet(TcSpriteSheet *sheet);
+
+    // Decoders (with their scaler and frames) are pooled across calls, keyed by
+    // codec, resolution, pixel format and extradata. Idle ones beyond the limit
+    // are closed; 0 disables pooling.
+    void tc_set_decoder_pool_size(size_t max_idle_decoders);
+    void tc_clear_decoder_pool(void);
+
+    // Upper bound for decoders opened with thread_count 0; <= 0 removes it
+    void tc_set_decoder_thread_limit(int max_threads);
+
+    // Duration in seconds, or -1 on error
+    double tc_get_video_duration(const char *path);
+
+    const char *tc_error_message(int error_code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // THUMBNAIL_CORE_H_
@@ -0,0 +1,345 @@
+#include "media_info_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace thumbnail_core
+{
+
+    namespace
+    {
+        constexpr uint32_t kCacheMagic = 0x494d4346; // "FCMI"
+        constexpr uint32_t kCacheVersion = 1;
+
+        // Saving again once the cache has grown by this many entries (or a
+        // quarter, whichever is more) keeps a library scan's writes linear
+        constexpr size_t kMinSaveGrowth = 256;
+
+        constexpr size_t kMaxPathLength = 4096;
+        constexpr size_t kMaxCodecLength = 64;
+
+        struct CacheFileHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t count;
+        };
+
+        // Followed by the path, the codec name and the keyframe times
+        struct CacheFileEntry
+        {
+            int64_t size;
+            int64_t modified;
+            double duration;
+            int32_t width;
+            int32_t height;
+            int32_t rotation;
+            uint16_t pathLength;
+            uint8_t codecLength;
+            uint8_t reserved;
+            uint32_t keyframeCount;
+            uint32_t padding;
+        };
+
+#ifdef _WIN32
+        std::wstring Utf8ToWide(const std::string &utf8)
+        {
+            int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, nullptr, 0);
+            if (sizeNeeded <= 0)
+            {
+                return std::wstring();
+            }
+            std::wstring wide(sizeNeeded, 0);
+            MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, &wide[0], sizeNeeded);
+            wide.resize(sizeNeeded - 1); // Remove the null terminator
+            return wide;
+        }
+#endif
+
+        FILE *OpenFile(const std::string &path, bool write)
+        {
+#ifdef _WIN32
+            return _wfopen(Utf8ToWide(path).c_str(), write ? L"wb" : L"rb");
+#else
+            return fopen(path.c_str(), write ? "wb" : "rb");
+#endif
+        }
+
+        void RemoveFile(const std::string &path)
+        {
+#ifdef _WIN32
+            _wremove(Utf8ToWide(path).c_str());
+#else
+            remove(path.c_str());
+#endif
+        }
+
+        bool ReplaceFile(const std::string &from, const std::string &to)
+        {
+#ifdef _WIN32
+            return MoveFileExW(Utf8ToWide(from).c_str(), Utf8ToWide(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+            return rename(from.c_str(), to.c_str()) == 0;
+#endif
+        }
+
+        // Evenly spaced subset that keeps the first and last keyframe
+        void ThinKeyframes(std::vector<float> &keyframes, size_t maxCount)
+        {
+            if (keyframes.size() <= maxCount || maxCount < 2)
+            {
+                return;
+            }
+            std::vector<float> thinned(maxCount);
+            const size_t last = keyframes.size() - 1;
+            for (size_t i = 0; i < maxCount; ++i)
+            {
+                thinned[i] = keyframes[i * last / (maxCount - 1)];
+            }
+            keyframes.swap(thinned);
+        }
+    } // namespace
+
+    MediaInfoCache &MediaInfoCache::Instance()
+    {
+        static MediaInfoCache *cache = new MediaInfoCache();
+        return *cache;
+    }
+
+    bool MediaInfoCache::Open(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!path_.empty())
+        {
+            return path_ == path;
+        }
+        path_ = path;
+        // A missing or unreadable file just means starting empty
+        Load();
+        savedCount_ = entries_.size();
+        return true;
+    }
+
+    void MediaInfoCache::Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!path_.empty() && dirty_)
+        {
+            Save();
+        }
+        path_.clear();
+    }
+
+    bool MediaInfoCache::Stat(const char *path, FileStamp *stamp)
+    {
+#ifdef _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(Utf8ToWide(path).c_str(), GetFileExInfoStandard, &data))
+        {
+            return false;
+        }
+        stamp->size = (static_cast<int64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        stamp->modified = (static_cast<int64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                          data.ftLastWriteTime.dwLowDateTime;
+#else
+        struct stat info;
+        if (stat(path, &info) != 0)
+        {
+            return false;
+        }
+        stamp->size = static_cast<int64_t>(info.st_size);
+#ifdef __linux__
+        stamp->modified = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#else
+        stamp->modified = static_cast<int64_t>(info.st_mtime) * 1000000000;
+#endif
+#endif
+        return true;
+    }
+
+    bool MediaInfoCache::Lookup(const std::string &path, const FileStamp &stamp, MediaInfoRecord *record)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(path);
+        if (it == entries_.end() || !(it->second.stamp == stamp))
+        {
+            return false;
+        }
+        it->second.lastUsed = ++clock_;
+        if (record)
+        {
+            *record = it->second.record;
+        }
+        return true;
+    }
+
+    void MediaInfoCache::Store(const std::string &path, const FileStamp &stamp, MediaInfoRecord record)
+    {
+        if (path.size() > kMaxPathLength)
+        {
+            return;
+        }
+        ThinKeyframes(record.keyframes, kMaxKeyframes);
+        if (record.codec.size() > kMaxCodecLength)
+        {
+            record.codec.resize(kMaxCodecLength);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        Entry &entry = entries_[path];
+        entry.stamp = stamp;
+        entry.record = std::move(record);
+        entry.lastUsed = ++clock_;
+        dirty_ = true;
+
+        // Trimming in batches keeps the sort rare
+        if (entries_.size() > kMaxEntries + kMaxEntries / 8)
+        {
+            Trim(kMaxEntries);
+        }
+        if (!path_.empty() && entries_.size() >= savedCount_ + std::max(kMinSaveGrowth, savedCount_ / 4))
+        {
+            Save();
+        }
+    }
+
+    void MediaInfoCache::Trim(size_t maxEntries)
+    {
+        if (entries_.size() <= maxEntries)
+        {
+            return;
+        }
+        std::vector<uint64_t> ages;
+        ages.reserve(entries_.size());
+        for (const auto &item : entries_)
+        {
+            ages.push_back(item.second.lastUsed);
+        }
+        // Everything used before the cutoff goes
+        const size_t dropped = entries_.size() - maxEntries;
+        std::nth_element(ages.begin(), ages.begin() + dropped, ages.end());
+        const uint64_t cutoff = ages[dropped];
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            it = it->second.lastUsed < cutoff ? entries_.erase(it) : std::next(it);
+        }
+        dirty_ = true;
+    }
+
+    bool MediaInfoCache::Load()
+    {
+        FILE *input = OpenFile(path_, false);
+        if (!input)
+        {
+            return false;
+        }
+
+        CacheFileHeader header;
+        bool valid = fread(&header, sizeof(header), 1, input) == 1 && header.magic == kCacheMagic &&
+                     header.version == kCacheVersion;
+        // Stored oldest first, so the load order rebuilds the recency order
+        for (uint64_t i = 0; valid && i < header.count; ++i)
+        {
+            CacheFileEntry saved;
+            if (fread(&saved, sizeof(saved), 1, input) != 1 || saved.pathLength == 0 ||
+                saved.pathLength > kMaxPathLength || saved.codecLength > kMaxCodecLength ||
+                saved.keyframeCount > kMaxKeyframes)
+            {
+                valid = false;
+                break;
+            }
+
+            std::string path(saved.pathLength, '\0');
+            Entry entry;
+            entry.record.codec.resize(saved.codecLength);
+            entry.record.keyframes.resize(saved.keyframeCount);
+            if (fread(&path[0], 1, path.size(), input) != path.size() ||
+                fread(&entry.record.codec[0], 1, saved.codecLength, input) != saved.codecLength ||
+                (saved.keyframeCount > 0 &&
+                 fread(entry.record.keyframes.data(), sizeof(float), saved.keyframeCount, input) !=
+                     saved.keyframeCount))
+            {
+                valid = false;
+                break;
+            }
+
+            entry.stamp.size = saved.size;
+            entry.stamp.modified = saved.modified;
+            entry.record.duration = saved.duration;
+            entry.record.width = saved.width;
+            entry.record.height = saved.height;
+            entry.record.rotation = saved.rotation;
+            entry.lastUsed = ++clock_;
+            entries_[std::move(path)] = std::move(entry);
+        }
+        fclose(input);
+
+        if (!valid)
+        {
+            // A truncated tail is dropped; whatever loaded before it is kept
+            dirty_ = true;
+        }
+        return valid;
+    }
+
+    bool MediaInfoCache::Save()
+    {
+        std::vector<const std::pair<const std::string, Entry> *> ordered;
+        ordered.reserve(entries_.size());
+        for (const auto &item : entries_)
+        {
+            ordered.push_back(&item);
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const auto *a, const auto *b)
+                  { return a->second.lastUsed < b->second.lastUsed; });
+
+        const std::string temporary = path_ + ".tmp";
+        FILE *output = OpenFile(temporary, true);
+        if (!output)
+        {
+            return false;
+        }
+
+        CacheFileHeader header{kCacheMagic, kCacheVersion, ordered.size()};
+        bool written = fwrite(&header, sizeof(header), 1, output) == 1;
+        for (const auto *item : ordered)
+        {
+            const MediaInfoRecord &record = item->second.record;
+            CacheFileEntry saved = {};
+            saved.size = item->second.stamp.size;
+            saved.modified = item->second.stamp.modified;
+            saved.duration = record.duration;
+            saved.width = record.width;
+            saved.height = record.height;
+            saved.rotation = record.rotation;
+            saved.pathLength = static_cast<uint16_t>(item->first.size());
+            saved.codecLength = static_cast<uint8_t>(record.codec.size());
+            saved.keyframeCount = static_cast<uint32_t>(record.keyframes.size());
+            written = written && fwrite(&saved, sizeof(saved), 1, output) == 1 &&
+                      fwrite(item->first.data(), 1, item->first.size(), output) == item->first.size() &&
+                      fwrite(record.codec.data(), 1, record.codec.size(), output) == record.codec.size() &&
+                      (record.keyframes.empty() ||
+                       fwrite(record.keyframes.data(), sizeof(float), record.keyframes.size(), output) ==
+                           record.keyframes.size());
+        }
+        written = fclose(output) == 0 && written;
+
+        if (!written || !ReplaceFile(temporary, path_))
+        {
+            RemoveFile(temporary);
+            return false;
+        }
+        savedCount_ = entries_.size();
+        dirty_ = false;
+        return true;
+    }
+
+} // namespace thumbnail_core
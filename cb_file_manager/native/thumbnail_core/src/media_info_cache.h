@@ -0,0 +1,80 @@
+#ifndef MEDIA_INFO_CACHE_H_
+#define MEDIA_INFO_CACHE_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace thumbnail_core
+{
+
+    // What a probe result was taken from; any change means a new probe
+    struct FileStamp
+    {
+        int64_t size = 0;
+        int64_t modified = 0; // Nanoseconds (POSIX) or FILETIME ticks (Windows)
+
+        bool operator==(const FileStamp &other) const
+        {
+            return size == other.size && modified == other.modified;
+        }
+    };
+
+    struct MediaInfoRecord
+    {
+        double duration = -1.0;
+        int32_t width = 0;
+        int32_t height = 0;
+        int32_t rotation = 0;
+        std::string codec;
+        std::vector<float> keyframes;
+    };
+
+    // Probe results by path, shared by every decode in the process. Entries
+    // beyond the limit are dropped least recently used first. With a backing
+    // file the cache is loaded on Open and saved on Close, and in between
+    // whenever it has grown by a quarter, so a crash loses little.
+    class MediaInfoCache
+    {
+    public:
+        static constexpr size_t kMaxEntries = 65536;
+        static constexpr size_t kMaxKeyframes = 256;
+
+        // Process-wide cache; leaked for the same reason as the decoder pool
+        static MediaInfoCache &Instance();
+
+        bool Open(const std::string &path);
+        void Close();
+
+        static bool Stat(const char *path, FileStamp *stamp);
+
+        bool Lookup(const std::string &path, const FileStamp &stamp, MediaInfoRecord *record);
+        void Store(const std::string &path, const FileStamp &stamp, MediaInfoRecord record);
+
+    private:
+        struct Entry
+        {
+            FileStamp stamp;
+            MediaInfoRecord record;
+            uint64_t lastUsed = 0;
+        };
+
+        MediaInfoCache() = default;
+
+        bool Load();
+        bool Save();
+        void Trim(size_t maxEntries);
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, Entry> entries_;
+        std::string path_; // Empty when not backed by a file
+        uint64_t clock_ = 0;
+        size_t savedCount_ = 0;
+        bool dirty_ = false;
+    };
+
+} // namespace thumbnail_core
+
+#endif // MEDIA_INFO_CACHE_H_
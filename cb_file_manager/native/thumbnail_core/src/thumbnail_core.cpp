@@ -0,0 +1,1575 @@
+#include "thumbnail_core.h"
+#include "media_info.h"
+#include "media_info_cache.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/display.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TC_LUMA_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define TC_LUMA_NEON 1
+#endif
+
+namespace
+{
+    using thumbnail_core::FileStamp;
+    using thumbnail_core::MediaInfoCache;
+    using thumbnail_core::MediaInfoRecord;
+
+    // How far past the seek target we keep reading before giving up
+    constexpr int kMaxDecodeSlackSeconds = 10;
+
+    constexpr int kMaxSpriteFrames = 1024;
+
+    // Representative frame selection: keyframes sampled, how many of them
+    // are decoded at most, and the luma statistics below which a frame
+    // counts as black, blown out or flat
+    constexpr int kRepresentativeSamples = 5;
+    constexpr int kRepresentativeDecodes = 3;
+    constexpr double kMinMeanLuma = 24.0;
+    constexpr double kMaxMeanLuma = 232.0;
+    constexpr double kMinLumaStdDev = 12.0;
+    // Luma is read from about this many rows (and this width when converted)
+    constexpr int kLumaSampleRows = 144;
+    constexpr int kLumaSampleWidth = 256;
+
+    constexpr size_t kDefaultMaxIdleDecoders = 8;
+
+    // An opened decoder plus the packet, frame and scaler that go with it.
+    // Checked out of the DecoderPool per job so that a run of similar clips
+    // does not pay for codec/thread setup and buffer allocation every time.
+    struct DecoderContext
+    {
+        AVCodecContext *codecContext = nullptr;
+        AVPacket *packet = nullptr;
+        AVFrame *frame = nullptr;
+        SwsContext *swsContext = nullptr;
+        AVFrame *scaled = nullptr;
+
+        ~DecoderContext()
+        {
+            av_frame_free(&scaled);
+            sws_freeContext(swsContext);
+            av_frame_free(&frame);
+            av_packet_free(&packet);
+            avcodec_free_context(&codecContext);
+        }
+    };
+
+    // Streams that share a key can share a decoder. Extradata is part of it
+    // because the decoder parses parameter sets (e.g. avcC) at open time.
+    struct DecoderKey
+    {
+        int codecId = 0;
+        int width = 0;
+        int height = 0;
+        int pixelFormat = 0;
+        int threadCount = 0; // As requested; 0 = automatic
+        int lowres = 0;
+        std::string extradata;
+
+        bool operator==(const DecoderKey &other) const
+        {
+            return codecId == other.codecId && width == other.width && height == other.height &&
+                   pixelFormat == other.pixelFormat && threadCount == other.threadCount &&
+                   lowres == other.lowres && extradata == other.extradata;
+        }
+    };
+
+    class DecoderPool
+    {
+    public:
+        // Process-wide pool; leaked so that worker threads still decoding at
+        // exit never touch a destroyed pool
+        static DecoderPool &Instance()
+        {
+            static DecoderPool *pool = new DecoderPool();
+            return *pool;
+        }
+
+        // Returns an idle decoder for key, or nullptr if the caller must open one.
+        // Either way the caller now counts as an active decoder until Release.
+        std::unique_ptr<DecoderContext> Acquire(const DecoderKey &key)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_++;
+            for (auto it = idle_.begin(); it != idle_.end(); ++it)
+            {
+                if (it->first == key)
+                {
+                    std::unique_ptr<DecoderContext> decoder = std::move(it->second);
+                    idle_.erase(it);
+                    return decoder;
+                }
+            }
+            return nullptr;
+        }
+
+        // Hand a decoder back; nullptr just ends the checkout
+        void Release(const DecoderKey &key, std::unique_ptr<DecoderContext> decoder)
+        {
+            std::unique_ptr<DecoderContext> evicted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                active_--;
+                if (!decoder || maxIdle_ == 0)
+                {
+                    return;
+                }
+                idle_.emplace_front(key, std::move(decoder));
+                if (idle_.size() > maxIdle_)
+                {
+                    evicted = std::move(idle_.back().second);
+                    idle_.pop_back();
+                }
+            }
+            // evicted is freed outside the lock; closing a threaded decoder joins its threads
+        }
+
+        // Threads for a decoder opened with thread_count 0: the hardware
+        // threads split across the decoders checked out right now, so the
+        // total stays near the core count however many jobs run at once
+        int AutoThreadCount()
+        {
+            unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t threads = std::max<size_t>(1, hardwareThreads / std::max<size_t>(1, active_));
+            if (threadLimit_ > 0)
+            {
+                threads = std::min(threads, threadLimit_);
+            }
+            return static_cast<int>(threads);
+        }
+
+        void SetThreadLimit(size_t threadLimit)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threadLimit_ = threadLimit;
+        }
+
+        void SetMaxIdle(size_t maxIdle)
+        {
+            std::list<std::pair<DecoderKey, std::unique_ptr<DecoderContext>>> evicted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                maxIdle_ = maxIdle;
+                while (idle_.size() > maxIdle_)
+                {
+                    evicted.splice(evicted.begin(), idle_, std::prev(idle_.end()));
+                }
+            }
+        }
+
+        void Clear()
+        {
+            std::list<std::pair<DecoderKey, std::unique_ptr<DecoderContext>>> evicted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                evicted.swap(idle_);
+            }
+        }
+
+    private:
+        DecoderPool() : active_(0), maxIdle_(kDefaultMaxIdleDecoders), threadLimit_(0) {}
+
+        std::mutex mutex_;
+        // Most recently released first
+        std::list<std::pair<DecoderKey, std::unique_ptr<DecoderContext>>> idle_;
+        size_t active_;
+        size_t maxIdle_;
+        size_t threadLimit_; // Per automatic decoder; 0 = none
+    };
+
+    // Owns the input and the checked-out decoder for one extraction
+    struct DecodeSession
+    {
+        AVFormatContext *formatContext = nullptr;
+        int videoStreamIndex = -1;
+
+        DecoderKey key;
+        std::unique_ptr<DecoderContext> decoder;
+        bool checkedOut = false;
+
+        ~DecodeSession()
+        {
+            if (checkedOut)
+            {
+                // Only decoders that opened cleanly go back to the pool
+                if (decoder && decoder->codecContext)
+                {
+                    avcodec_flush_buffers(decoder->codecContext);
+                }
+                DecoderPool::Instance().Release(key, std::move(decoder));
+            }
+            if (formatContext)
+            {
+                avformat_close_input(&formatContext);
+            }
+        }
+    };
+
+    int OpenInput(DecodeSession &session, const char *path, bool fastProbe)
+    {
+        AVDictionary *opts = nullptr;
+        if (fastProbe)
+        {
+            av_dict_set(&opts, "analyzeduration", "1000000", 0); // 1 second max analyze
+            av_dict_set(&opts, "probesize", "1000000", 0);       // 1MB max probe size
+        }
+
+        int ret = avformat_open_input(&session.formatContext, path, nullptr, &opts);
+        av_dict_free(&opts);
+        if (ret != 0)
+        {
+            return TC_ERROR_OPEN_INPUT;
+        }
+
+        if (avformat_find_stream_info(session.formatContext, nullptr) < 0)
+        {
+            return TC_ERROR_STREAM_INFO;
+        }
+
+        // First video stream, if any
+        for (unsigned int i = 0; i < session.formatContext->nb_streams; i++)
+        {
+            if (session.formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+            {
+                session.videoStreamIndex = static_cast<int>(i);
+                break;
+            }
+        }
+        return TC_SUCCESS;
+    }
+
+    double DurationSeconds(const DecodeSession &session)
+    {
+        const AVFormatContext *formatContext = session.formatContext;
+        if (formatContext->duration != AV_NOPTS_VALUE)
+        {
+            return static_cast<double>(formatContext->duration) / AV_TIME_BASE;
+        }
+
+        // Fall back to the video stream's own duration
+        if (session.videoStreamIndex >= 0)
+        {
+            const AVStream *stream = formatContext->streams[session.videoStreamIndex];
+            if (stream->duration != AV_NOPTS_VALUE)
+            {
+                return static_cast<double>(stream->duration) * av_q2d(stream->time_base);
+            }
+        }
+        return -1.0;
+    }
+
+    // Clockwise degrees that turn the stored picture upright, from the
+    // stream's display matrix (phone recordings are often stored sideways)
+    int StreamRotation(const AVStream *stream)
+    {
+        const int32_t *matrix = nullptr;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(60, 29, 100)
+        const AVPacketSideData *sideData = av_packet_side_data_get(
+            stream->codecpar->coded_side_data, stream->codecpar->nb_coded_side_data, AV_PKT_DATA_DISPLAYMATRIX);
+        if (sideData && sideData->size >= 9 * sizeof(int32_t))
+        {
+            matrix = reinterpret_cast<const int32_t *>(sideData->data);
+        }
+#else
+        matrix = reinterpret_cast<const int32_t *>(av_stream_get_side_data(stream, AV_PKT_DATA_DISPLAYMATRIX, nullptr));
+#endif
+        if (!matrix)
+        {
+            return 0;
+        }
+        const double counterClockwise = av_display_rotation_get(matrix);
+        if (std::isnan(counterClockwise))
+        {
+            return 0;
+        }
+        // Nearest quarter turn, clockwise, in 0..270
+        const int quarterTurns = static_cast<int>(std::lround(-counterClockwise / 90.0));
+        return ((quarterTurns % 4) + 4) % 4 * 90;
+    }
+
+    // Keyframe times from the demuxer's index, in seconds from the start of
+    // the stream. Complete for containers with an up-front index (MP4, AVI);
+    // others (e.g. Matroska cues) may list only what has been read, or nothing.
+    std::vector<float> IndexedKeyframes(AVStream *stream)
+    {
+        std::vector<float> keyframes;
+        const double timeBase = av_q2d(stream->time_base);
+        const int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 76, 100)
+        const int count = avformat_index_get_entries_count(stream);
+#else
+        const int count = stream->nb_index_entries;
+#endif
+        for (int i = 0; i < count; ++i)
+        {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 76, 100)
+            const AVIndexEntry *entry = avformat_index_get_entry(stream, i);
+#else
+            const AVIndexEntry *entry = &stream->index_entries[i];
+#endif
+            if (entry && (entry->flags & AVINDEX_KEYFRAME) && entry->timestamp != AV_NOPTS_VALUE)
+            {
+                keyframes.push_back(static_cast<float>(static_cast<double>(entry->timestamp - start) * timeBase));
+            }
+        }
+        return keyframes;
+    }
+
+    MediaInfoRecord DescribeInput(const DecodeSession &session)
+    {
+        MediaInfoRecord record;
+        record.duration = DurationSeconds(session);
+        if (session.videoStreamIndex >= 0)
+        {
+            AVStream *stream = session.formatContext->streams[session.videoStreamIndex];
+            record.width = stream->codecpar->width;
+            record.height = stream->codecpar->height;
+            record.rotation = StreamRotation(stream);
+            record.codec = avcodec_get_name(stream->codecpar->codec_id);
+            record.keyframes = IndexedKeyframes(stream);
+        }
+        return record;
+    }
+
+    // Open path for decoding and get its duration. A file the cache already
+    // knows is probed only briefly, since the decoder needs the stream
+    // parameters but the duration is on hand; otherwise the probe is cached.
+    int OpenCachedInput(DecodeSession &session, const char *path, bool fastProbe, double *duration)
+    {
+        FileStamp stamp;
+        const bool stamped = MediaInfoCache::Stat(path, &stamp);
+        MediaInfoRecord cached;
+        const bool hit = stamped && MediaInfoCache::Instance().Lookup(path, stamp, &cached);
+
+        int result = OpenInput(session, path, fastProbe || hit);
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+        if (hit)
+        {
+            *duration = cached.duration;
+            return TC_SUCCESS;
+        }
+
+        *duration = DurationSeconds(session);
+        // A capped probe may have guessed the duration from the bitrate; only keep exact ones
+        if (stamped && (!fastProbe || session.formatContext->duration_estimation_method != AVFMT_DURATION_FROM_BITRATE))
+        {
+            MediaInfoCache::Instance().Store(path, stamp, DescribeInput(session));
+        }
+        return TC_SUCCESS;
+    }
+
+    // Cached probe result for path, with a full probe on a miss
+    int ProbeMediaInfo(const char *path, MediaInfoRecord *record)
+    {
+        FileStamp stamp;
+        if (!MediaInfoCache::Stat(path, &stamp))
+        {
+            return TC_ERROR_OPEN_INPUT;
+        }
+        if (MediaInfoCache::Instance().Lookup(path, stamp, record))
+        {
+            return TC_SUCCESS;
+        }
+
+        DecodeSession session;
+        int result = OpenInput(session, path, false);
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+        *record = DescribeInput(session);
+        MediaInfoCache::Instance().Store(path, stamp, *record);
+        return TC_SUCCESS;
+    }
+
+    // Largest decoder downscale (a power of two) that still leaves at least
+    // targetWidth pixels; only some codecs (e.g. MJPEG) implement lowres
+    int ChooseLowres(const AVCodec *codec, int codedWidth, int targetWidth)
+    {
+        if (!codec || targetWidth <= 0 || codedWidth <= 0)
+        {
+            return 0;
+        }
+        int lowres = 0;
+        while (lowres < codec->max_lowres && (codedWidth >> (lowres + 1)) >= targetWidth)
+        {
+            lowres++;
+        }
+        return lowres;
+    }
+
+    int OpenNewDecoder(const AVCodecParameters *codecParams, int threadCount, int lowres,
+                       std::unique_ptr<DecoderContext> *out)
+    {
+        const AVCodec *codec = avcodec_find_decoder(codecParams->codec_id);
+        if (!codec)
+        {
+            return TC_ERROR_DECODER;
+        }
+
+        std::unique_ptr<DecoderContext> decoder(new DecoderContext());
+        decoder->codecContext = avcodec_alloc_context3(codec);
+        decoder->packet = av_packet_alloc();
+        decoder->frame = av_frame_alloc();
+        if (!decoder->codecContext || !decoder->packet || !decoder->frame)
+        {
+            return TC_ERROR_MEMORY;
+        }
+
+        if (avcodec_parameters_to_context(decoder->codecContext, codecParams) < 0)
+        {
+            return TC_ERROR_DECODER;
+        }
+
+        decoder->codecContext->thread_count =
+            threadCount > 0 ? threadCount : DecoderPool::Instance().AutoThreadCount();
+        decoder->codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        decoder->codecContext->lowres = lowres;
+
+        if (avcodec_open2(decoder->codecContext, codec, nullptr) < 0)
+        {
+            return TC_ERROR_DECODER;
+        }
+
+        *out = std::move(decoder);
+        return TC_SUCCESS;
+    }
+
+    // Check a matching decoder out of the pool, opening one if none is idle
+    int OpenDecoder(DecodeSession &session, const TcThumbnailOptions &options)
+    {
+        const AVCodecParameters *codecParams =
+            session.formatContext->streams[session.videoStreamIndex]->codecpar;
+
+        session.key.codecId = codecParams->codec_id;
+        session.key.width = codecParams->width;
+        session.key.height = codecParams->height;
+        session.key.pixelFormat = codecParams->format;
+        session.key.threadCount = std::max(0, options.thread_count);
+        session.key.lowres = ChooseLowres(avcodec_find_decoder(codecParams->codec_id),
+                                          codecParams->width, options.width);
+        if (codecParams->extradata && codecParams->extradata_size > 0)
+        {
+            session.key.extradata.assign(reinterpret_cast<const char *>(codecParams->extradata),
+                                         static_cast<size_t>(codecParams->extradata_size));
+        }
+
+        session.decoder = DecoderPool::Instance().Acquire(session.key);
+        session.checkedOut = true;
+        if (session.decoder && session.key.threadCount == 0 &&
+            session.decoder->codecContext->thread_count > DecoderPool::Instance().AutoThreadCount())
+        {
+            // Opened when fewer jobs were running; reopen rather than oversubscribe
+            session.decoder.reset();
+        }
+        if (session.decoder)
+        {
+            return TC_SUCCESS;
+        }
+        return OpenNewDecoder(codecParams, session.key.threadCount, session.key.lowres, &session.decoder);
+    }
+
+    int ResolveSeekSeconds(const TcThumbnailOptions &options, double durationSeconds)
+    {
+        if (options.seek_mode == TC_SEEK_PERCENTAGE)
+        {
+            if (durationSeconds <= 0)
+            {
+                return 5; // Unknown duration: a few seconds in usually skips black intro frames
+            }
+
+            // Clamp to 10%..90% of the video to avoid black frames
+            double percentage = options.seek_value;
+            if (percentage < 10.0)
+                percentage = 10.0;
+            if (percentage > 90.0)
+                percentage = 90.0;
+
+            int timeSeconds = static_cast<int>((percentage / 100.0) * durationSeconds);
+
+            // Stay at least 5 seconds away from either end
+            int minTime = 5;
+            int maxTime = static_cast<int>(durationSeconds) - 5;
+            if (maxTime < minTime)
+                maxTime = static_cast<int>(durationSeconds / 2);
+            if (timeSeconds < minTime)
+                timeSeconds = minTime;
+            if (timeSeconds > maxTime)
+                timeSeconds = maxTime;
+            return timeSeconds;
+        }
+
+        int64_t duration = durationSeconds > 0 ? static_cast<int64_t>(durationSeconds) : 0;
+        int timeSeconds = static_cast<int>(options.seek_value);
+        if (timeSeconds < 0 || (duration > 0 && static_cast<int64_t>(timeSeconds) > duration))
+        {
+            // Default to 1/3 through the video
+            timeSeconds = duration > 0 ? static_cast<int>(duration / 3) : 0;
+        }
+        return timeSeconds;
+    }
+
+    // Seek near seconds and decode the first frame that comes out
+    // Accurate mode returns the first frame the decoder produces after the
+    // seek. Keyframe mode only feeds keyframe packets and stops after the first
+    // one, which avoids decoding a long GOP just to reach a grid thumbnail.
+    int DecodeFrameAt(DecodeSession &session, double seconds, bool keyframeOnly)
+    {
+        int64_t seekTarget = static_cast<int64_t>(seconds * AV_TIME_BASE);
+        if (av_seek_frame(session.formatContext, -1, seekTarget, AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            return TC_ERROR_SEEK;
+        }
+        AVCodecContext *codecContext = session.decoder->codecContext;
+        AVPacket *packet = session.decoder->packet;
+        AVFrame *frame = session.decoder->frame;
+        avcodec_flush_buffers(codecContext);
+        // Pooled decoders keep the previous job's setting
+        codecContext->skip_frame = keyframeOnly ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+
+        const double timeBase = av_q2d(session.formatContext->streams[session.videoStreamIndex]->time_base);
+        while (av_read_frame(session.formatContext, packet) >= 0)
+        {
+            bool decoded = false;
+            bool keyframeSent = false;
+            bool pastLimit = false;
+            if (packet->stream_index == session.videoStreamIndex)
+            {
+                if (!keyframeOnly || (packet->flags & AV_PKT_FLAG_KEY))
+                {
+                    const bool sent = avcodec_send_packet(codecContext, packet) == 0;
+                    decoded = sent && avcodec_receive_frame(codecContext, frame) == 0;
+                    keyframeSent = keyframeOnly && sent;
+                }
+                pastLimit = packet->pts != AV_NOPTS_VALUE &&
+                            timeBase * packet->pts > seconds + kMaxDecodeSlackSeconds;
+            }
+            av_packet_unref(packet);
+
+            if (decoded)
+            {
+                return TC_SUCCESS;
+            }
+            if (keyframeSent || pastLimit)
+            {
+                break;
+            }
+        }
+
+        // Frame-threaded decoders hold frames back; drain before giving up
+        avcodec_send_packet(codecContext, nullptr);
+        if (avcodec_receive_frame(codecContext, frame) == 0)
+        {
+            return TC_SUCCESS;
+        }
+        return TC_ERROR_NO_FRAME;
+    }
+
+    // Sum and sum of squares of n luma samples. The vector loops keep 32-bit
+    // lanes, which cannot overflow within one row of any real video.
+    void LumaMoments(const uint8_t *row, int n, uint64_t *sum, uint64_t *sumSquares)
+    {
+        int i = 0;
+        uint64_t total = 0;
+        uint64_t squares = 0;
+#if defined(TC_LUMA_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i totalVector = zero;
+        __m128i squaresVector = zero;
+        for (; i + 16 <= n; i += 16)
+        {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+            totalVector = _mm_add_epi64(totalVector, _mm_sad_epu8(pixels, zero));
+            const __m128i low = _mm_unpacklo_epi8(pixels, zero);
+            const __m128i high = _mm_unpackhi_epi8(pixels, zero);
+            squaresVector = _mm_add_epi32(squaresVector,
+                                          _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high)));
+        }
+        alignas(16) uint64_t totalLanes[2];
+        alignas(16) uint32_t squareLanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(totalLanes), totalVector);
+        _mm_store_si128(reinterpret_cast<__m128i *>(squareLanes), squaresVector);
+        total += totalLanes[0] + totalLanes[1];
+        squares += static_cast<uint64_t>(squareLanes[0]) + squareLanes[1] + squareLanes[2] + squareLanes[3];
+#elif defined(TC_LUMA_NEON)
+        uint32x4_t totalVector = vdupq_n_u32(0);
+        uint32x4_t squaresVector = vdupq_n_u32(0);
+        for (; i + 16 <= n; i += 16)
+        {
+            const uint8x16_t pixels = vld1q_u8(row + i);
+            totalVector = vpadalq_u16(totalVector, vpaddlq_u8(pixels));
+            squaresVector = vpadalq_u16(squaresVector, vmull_u8(vget_low_u8(pixels), vget_low_u8(pixels)));
+            squaresVector = vpadalq_u16(squaresVector, vmull_u8(vget_high_u8(pixels), vget_high_u8(pixels)));
+        }
+        uint32_t totalLanes[4];
+        uint32_t squareLanes[4];
+        vst1q_u32(totalLanes, totalVector);
+        vst1q_u32(squareLanes, squaresVector);
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            total += totalLanes[lane];
+            squares += squareLanes[lane];
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            total += row[i];
+            squares += static_cast<uint32_t>(row[i]) * row[i];
+        }
+        *sum += total;
+        *sumSquares += squares;
+    }
+
+    struct LumaStats
+    {
+        double mean = 0.0;
+        double stdDev = 0.0;
+        double entropy = 0.0; // Bits, over 64 bins
+    };
+
+    class LumaAccumulator
+    {
+    public:
+        void AddRow(const uint8_t *row, int width)
+        {
+            LumaMoments(row, width, &sum_, &sumSquares_);
+            // Four partial histograms so consecutive increments rarely hit the same counter
+            int x = 0;
+            for (; x + 4 <= width; x += 4)
+            {
+                histogram_[0][row[x] >> 2]++;
+                histogram_[1][row[x + 1] >> 2]++;
+                histogram_[2][row[x + 2] >> 2]++;
+                histogram_[3][row[x + 3] >> 2]++;
+            }
+            for (; x < width; ++x)
+            {
+                histogram_[0][row[x] >> 2]++;
+            }
+            count_ += static_cast<uint64_t>(width);
+        }
+
+        LumaStats Finish() const
+        {
+            LumaStats stats;
+            if (count_ == 0)
+            {
+                return stats;
+            }
+            const double count = static_cast<double>(count_);
+            stats.mean = static_cast<double>(sum_) / count;
+            stats.stdDev = std::sqrt(std::max(0.0, static_cast<double>(sumSquares_) / count - stats.mean * stats.mean));
+            for (int bin = 0; bin < 64; ++bin)
+            {
+                const uint64_t binCount = histogram_[0][bin] + histogram_[1][bin] + histogram_[2][bin] + histogram_[3][bin];
+                if (binCount > 0)
+                {
+                    const double p = static_cast<double>(binCount) / count;
+                    stats.entropy -= p * std::log2(p);
+                }
+            }
+            return stats;
+        }
+
+    private:
+        uint64_t sum_ = 0;
+        uint64_t sumSquares_ = 0;
+        uint64_t count_ = 0;
+        uint32_t histogram_[4][64] = {};
+    };
+
+    // Luma plane 0 can be read in place for planar 8-bit YUV and grayscale
+    bool HasDirectLuma(AVPixelFormat format)
+    {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+        return desc && !(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL)) &&
+               desc->comp[0].plane == 0 && desc->comp[0].depth == 8 && desc->comp[0].step == 1;
+    }
+
+    // Statistics over a subsample of the decoded frame's luma
+    LumaStats MeasureLuma(const AVFrame *frame)
+    {
+        LumaAccumulator accumulator;
+        const AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+        if (HasDirectLuma(format))
+        {
+            const int rowStep = std::max(1, frame->height / kLumaSampleRows);
+            for (int y = rowStep / 2; y < frame->height; y += rowStep)
+            {
+                accumulator.AddRow(frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0], frame->width);
+            }
+            return accumulator.Finish();
+        }
+
+        // RGB, high bit depth and packed formats: a small grayscale copy
+        const int width = std::min(frame->width, kLumaSampleWidth);
+        const int height = std::max(1, static_cast<int>(static_cast<int64_t>(frame->height) * width / frame->width));
+        SwsContext *context = sws_getContext(frame->width, frame->height, format, width, height, AV_PIX_FMT_GRAY8,
+                                             SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        if (!context)
+        {
+            return LumaStats();
+        }
+        std::vector<uint8_t> gray(static_cast<size_t>(width) * height);
+        uint8_t *dest[4] = {gray.data(), nullptr, nullptr, nullptr};
+        int destLinesize[4] = {width, 0, 0, 0};
+        sws_scale(context, frame->data, frame->linesize, 0, frame->height, dest, destLinesize);
+        sws_freeContext(context);
+        for (int y = 0; y < height; ++y)
+        {
+            accumulator.AddRow(gray.data() + static_cast<size_t>(y) * width, width);
+        }
+        return accumulator.Finish();
+    }
+
+    bool IsUsableFrame(const LumaStats &stats)
+    {
+        return stats.mean >= kMinMeanLuma && stats.mean <= kMaxMeanLuma && stats.stdDev >= kMinLumaStdDev;
+    }
+
+    // Detail wins; black, blown-out and flat frames (fades, plain title cards)
+    // lose to any frame that passes
+    double ScoreFrame(const LumaStats &stats)
+    {
+        double score = stats.entropy + stats.stdDev / 32.0 - std::fabs(stats.mean - 128.0) / 64.0;
+        if (!IsUsableFrame(stats))
+        {
+            score -= 100.0;
+        }
+        return score;
+    }
+
+    struct KeyframeSample
+    {
+        double seconds; // Seek target that lands on this keyframe
+        int64_t pts;
+        int size; // Compressed bytes; black and flat frames compress to little
+    };
+
+    // The keyframe a seek to seconds lands on, found by reading packets
+    // without decoding anything
+    bool ProbeKeyframe(DecodeSession &session, double seconds, KeyframeSample *sample)
+    {
+        if (av_seek_frame(session.formatContext, -1, static_cast<int64_t>(seconds * AV_TIME_BASE),
+                          AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            return false;
+        }
+
+        AVPacket *packet = session.decoder->packet;
+        const double timeBase = av_q2d(session.formatContext->streams[session.videoStreamIndex]->time_base);
+        bool found = false;
+        bool pastLimit = false;
+        while (!found && !pastLimit && av_read_frame(session.formatContext, packet) >= 0)
+        {
+            if (packet->stream_index == session.videoStreamIndex)
+            {
+                if (packet->flags & AV_PKT_FLAG_KEY)
+                {
+                    *sample = KeyframeSample{seconds, packet->pts, packet->size};
+                    found = true;
+                }
+                pastLimit = packet->pts != AV_NOPTS_VALUE &&
+                            timeBase * packet->pts > seconds + kMaxDecodeSlackSeconds;
+            }
+            av_packet_unref(packet);
+        }
+        return found;
+    }
+
+    // Rank a few keyframes spread over the video by compressed size, a proxy
+    // for detail that costs no decoding, then decode the largest (at the
+    // reduced size the decoder was opened with) until one passes the luma
+    // checks. Leaves the chosen frame in the decoder's frame.
+    int DecodeRepresentativeFrame(DecodeSession &session, double duration)
+    {
+        if (duration <= 0)
+        {
+            return DecodeFrameAt(session, 0, true);
+        }
+
+        std::vector<KeyframeSample> samples;
+        for (int i = 0; i < kRepresentativeSamples; ++i)
+        {
+            // Spread across 10-90%, clear of intros and credits
+            const double target = duration * (0.1 + 0.8 * (i + 0.5) / kRepresentativeSamples);
+            KeyframeSample sample;
+            if (!ProbeKeyframe(session, target, &sample))
+            {
+                continue;
+            }
+            // Long GOPs map several targets onto one keyframe
+            const bool seen = std::any_of(samples.begin(), samples.end(), [&sample](const KeyframeSample &other)
+                                          { return other.pts == sample.pts; });
+            if (!seen)
+            {
+                samples.push_back(sample);
+            }
+        }
+        if (samples.empty())
+        {
+            return DecodeFrameAt(session, duration / 3, true);
+        }
+        std::stable_sort(samples.begin(), samples.end(), [](const KeyframeSample &a, const KeyframeSample &b)
+                         { return a.size > b.size; });
+
+        AVFrame *best = av_frame_alloc();
+        if (!best)
+        {
+            return TC_ERROR_MEMORY;
+        }
+
+        double bestScore = 0.0;
+        bool found = false;
+        const size_t decodes = std::min(samples.size(), static_cast<size_t>(kRepresentativeDecodes));
+        for (size_t i = 0; i < decodes; ++i)
+        {
+            if (DecodeFrameAt(session, samples[i].seconds, true) != TC_SUCCESS)
+            {
+                continue;
+            }
+
+            const LumaStats stats = MeasureLuma(session.decoder->frame);
+            const double score = ScoreFrame(stats);
+            if (!found || score > bestScore)
+            {
+                // A reference, not a copy; the decoder allocates a new buffer for its next frame
+                av_frame_unref(best);
+                if (av_frame_ref(best, session.decoder->frame) < 0)
+                {
+                    continue;
+                }
+                bestScore = score;
+                found = true;
+            }
+            if (IsUsableFrame(stats))
+            {
+                break;
+            }
+        }
+
+        if (found)
+        {
+            av_frame_unref(session.decoder->frame);
+            av_frame_move_ref(session.decoder->frame, best);
+        }
+        av_frame_free(&best);
+        return found ? TC_SUCCESS : TC_ERROR_NO_FRAME;
+    }
+
+    // width is a hard limit: the output is never wider, and never upscaled
+    void ComputeOutputSize(int originalWidth, int originalHeight, int width,
+                           int *outputWidth, int *outputHeight)
+    {
+        if (width <= 0 || width >= originalWidth)
+        {
+            *outputWidth = originalWidth;
+            *outputHeight = originalHeight;
+            return;
+        }
+
+        *outputWidth = width;
+        *outputHeight = static_cast<int>(
+            (static_cast<int64_t>(originalHeight) * width + originalWidth / 2) / originalWidth);
+        if (*outputHeight <= 0)
+            *outputHeight = 1;
+    }
+
+    // Bilinear when asked to be fast. Otherwise area averaging for large
+    // reductions, where Lanczos costs more without looking better at tile
+    // size, and Lanczos for the rest.
+    int ScaleFlags(int scaleMode, int sourceWidth, int outputWidth)
+    {
+        if (scaleMode == TC_SCALE_FAST)
+        {
+            return SWS_FAST_BILINEAR;
+        }
+        return sourceWidth >= outputWidth * 2 ? SWS_AREA : SWS_LANCZOS;
+    }
+
+    // Map a 1-100 JPEG quality onto the MJPEG encoder's qscale (2 best .. 31 worst)
+    int JpegQscale(int quality)
+    {
+        if (quality < 1)
+            quality = 1;
+        if (quality > 100)
+            quality = 100;
+        return 2 + ((100 - quality) * 29 + 50) / 100;
+    }
+
+    // (Re)size the decoder's scaled frame; the buffer is kept while the
+    // output geometry stays the same
+    bool PrepareScaledFrame(DecoderContext &decoder, int width, int height, AVPixelFormat format)
+    {
+        if (!decoder.scaled)
+        {
+            decoder.scaled = av_frame_alloc();
+            if (!decoder.scaled)
+            {
+                return false;
+            }
+        }
+
+        AVFrame *scaled = decoder.scaled;
+        if (scaled->data[0] && scaled->width == width && scaled->height == height && scaled->format == format)
+        {
+            // The last encoder may still hold a reference
+            return av_frame_make_writable(scaled) >= 0;
+        }
+
+        av_frame_unref(scaled);
+        scaled->format = format;
+        scaled->width = width;
+        scaled->height = height;
+        return av_frame_get_buffer(scaled, 0) >= 0;
+    }
+
+    // Receives the encoded image; the packet is only valid during the call
+    using PacketSink = std::function<int(const AVPacket *packet, int width, int height)>;
+
+    AVPixelFormat EncoderPixelFormat(int format)
+    {
+        return format == TC_FORMAT_PNG ? AV_PIX_FMT_RGB24 : AV_PIX_FMT_YUVJ420P;
+    }
+
+    // Encode a picture that is already in EncoderPixelFormat(options.format)
+    // and hand the packet to sink
+    int EncodePicture(AVFrame *picture, const TcThumbnailOptions &options, const PacketSink &sink)
+    {
+        const bool png = options.format == TC_FORMAT_PNG;
+        const AVCodec *encoder = avcodec_find_encoder(png ? AV_CODEC_ID_PNG : AV_CODEC_ID_MJPEG);
+        if (!encoder)
+        {
+            return TC_ERROR_ENCODE;
+        }
+
+        AVCodecContext *encoderContext = avcodec_alloc_context3(encoder);
+        AVPacket *packet = av_packet_alloc();
+        int result = TC_ERROR_MEMORY;
+
+        if (encoderContext && packet)
+        {
+            encoderContext->width = picture->width;
+            encoderContext->height = picture->height;
+            encoderContext->pix_fmt = EncoderPixelFormat(options.format);
+            encoderContext->time_base = AVRational{1, 25};
+            if (!png)
+            {
+                encoderContext->flags |= AV_CODEC_FLAG_QSCALE;
+                encoderContext->global_quality = FF_QP2LAMBDA * JpegQscale(options.quality);
+            }
+
+            result = TC_ERROR_ENCODE;
+            if (avcodec_open2(encoderContext, encoder, nullptr) >= 0)
+            {
+                picture->pts = 0;
+                picture->quality = encoderContext->global_quality;
+                if (avcodec_send_frame(encoderContext, picture) >= 0 &&
+                    avcodec_send_frame(encoderContext, nullptr) >= 0 &&
+                    avcodec_receive_packet(encoderContext, packet) >= 0)
+                {
+                    result = sink(packet, picture->width, picture->height);
+                }
+            }
+        }
+
+        av_packet_free(&packet);
+        avcodec_free_context(&encoderContext);
+        return result;
+    }
+
+    // Scale the decoded frame into dest (width x height at dest's format),
+    // which may point into a larger picture. The pooled scaler is reused when
+    // the geometry matches.
+    bool ScaleFrame(DecoderContext &decoder, int scaleMode, uint8_t *const dest[], const int destLinesize[],
+                    int width, int height, AVPixelFormat format)
+    {
+        const AVFrame *frame = decoder.frame;
+        decoder.swsContext = sws_getCachedContext(
+            decoder.swsContext,
+            frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+            width, height, format,
+            ScaleFlags(scaleMode, frame->width, width), nullptr, nullptr, nullptr);
+        if (!decoder.swsContext)
+        {
+            return false;
+        }
+        sws_scale(decoder.swsContext, frame->data, frame->linesize, 0, frame->height, dest, destLinesize);
+        return true;
+    }
+
+    // Scale the frame straight into the encoder's pixel format and hand the
+    // encoded packet to sink without an intermediate copy
+    int EncodeFrame(DecoderContext &decoder, const TcThumbnailOptions &options, const PacketSink &sink)
+    {
+        int outputWidth = 0;
+        int outputHeight = 0;
+        ComputeOutputSize(decoder.frame->width, decoder.frame->height, options.width, &outputWidth, &outputHeight);
+
+        const AVPixelFormat format = EncoderPixelFormat(options.format);
+        if (!PrepareScaledFrame(decoder, outputWidth, outputHeight, format) ||
+            !ScaleFrame(decoder, options.scale_mode, decoder.scaled->data, decoder.scaled->linesize,
+                        outputWidth, outputHeight, format))
+        {
+            return TC_ERROR_SCALE;
+        }
+        return EncodePicture(decoder.scaled, options, sink);
+    }
+
+    int ExtractThumbnail(const char *path, const TcThumbnailOptions &options, const PacketSink &sink)
+    {
+        DecodeSession session;
+
+        double duration = -1.0;
+        int result = OpenCachedInput(session, path, options.fast_probe != 0, &duration);
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+        if (session.videoStreamIndex < 0)
+        {
+            return TC_ERROR_NO_VIDEO_STREAM;
+        }
+
+        result = OpenDecoder(session, options);
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+
+        if (options.seek_mode == TC_SEEK_REPRESENTATIVE)
+        {
+            result = DecodeRepresentativeFrame(session, duration);
+        }
+        else
+        {
+            int timeSeconds = ResolveSeekSeconds(options, duration);
+            result = DecodeFrameAt(session, timeSeconds, options.keyframe_only != 0);
+        }
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+
+        return EncodeFrame(*session.decoder, options, sink);
+    }
+
+    // Presentation time of the decoded frame from the start of the stream
+    double FrameSeconds(const DecodeSession &session, double fallback)
+    {
+        const AVFrame *frame = session.decoder->frame;
+        const AVStream *stream = session.formatContext->streams[session.videoStreamIndex];
+        int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        if (pts == AV_NOPTS_VALUE)
+        {
+            return fallback;
+        }
+        const int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        return static_cast<double>(pts - start) * av_q2d(stream->time_base);
+    }
+
+    // Full-range YUV black has neutral chroma; RGB black is all zero
+    void FillBlack(AVFrame *picture)
+    {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(picture->format));
+        const bool yuv = picture->format == AV_PIX_FMT_YUVJ420P;
+        for (int plane = 0; plane < 4 && picture->data[plane]; ++plane)
+        {
+            const int rows = plane == 0 ? picture->height : -((-picture->height) >> desc->log2_chroma_h);
+            memset(picture->data[plane], yuv && plane > 0 ? 128 : 0,
+                   static_cast<size_t>(picture->linesize[plane]) * rows);
+        }
+    }
+
+    // Plane pointers to pixel (x, y) of picture; x and y must be even for 4:2:0
+    void TileDestination(const AVFrame *picture, int x, int y, uint8_t *dest[4])
+    {
+        const AVPixelFormat format = static_cast<AVPixelFormat>(picture->format);
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+        for (int plane = 0; plane < 4; ++plane)
+        {
+            if (!picture->data[plane])
+            {
+                dest[plane] = nullptr;
+                continue;
+            }
+            const bool chroma = plane == 1 || plane == 2;
+            const int row = chroma ? y >> desc->log2_chroma_h : y;
+            const int offset = x > 0 ? std::max(0, av_image_get_linesize(format, x, plane)) : 0;
+            dest[plane] = picture->data[plane] + static_cast<ptrdiff_t>(row) * picture->linesize[plane] + offset;
+        }
+    }
+
+    // One input, one decoder, one seek per tile; each frame is scaled
+    // straight into its place in the sheet
+    int ExtractSpriteSheet(const char *path, const TcThumbnailOptions &options, int frameCount, int columns,
+                           TcSpriteSheet *sheet, const PacketSink &sink)
+    {
+        DecodeSession session;
+
+        double duration = -1.0;
+        int result = OpenCachedInput(session, path, options.fast_probe != 0, &duration);
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+        if (session.videoStreamIndex < 0)
+        {
+            return TC_ERROR_NO_VIDEO_STREAM;
+        }
+
+        // Lowres is chosen for the tile width
+        result = OpenDecoder(session, options);
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+
+        if (duration <= 0)
+        {
+            return TC_ERROR_SEEK;
+        }
+
+        columns = columns > 0 ? std::min(columns, frameCount)
+                              : static_cast<int>(std::ceil(std::sqrt(static_cast<double>(frameCount))));
+        const int rows = (frameCount + columns - 1) / columns;
+        const AVPixelFormat format = EncoderPixelFormat(options.format);
+
+        AVFrame *picture = av_frame_alloc();
+        if (!picture)
+        {
+            return TC_ERROR_MEMORY;
+        }
+
+        std::vector<double> timestamps(static_cast<size_t>(frameCount));
+        int tileWidth = 0;
+        int tileHeight = 0;
+        result = TC_ERROR_NO_FRAME;
+        for (int i = 0; i < frameCount; ++i)
+        {
+            // Middle of each of frameCount equal slices, so neither end lands on a fade
+            const double target = duration * (i + 0.5) / frameCount;
+            timestamps[i] = target;
+            if (DecodeFrameAt(session, target, options.keyframe_only != 0) != TC_SUCCESS)
+            {
+                continue;
+            }
+
+            if (!picture->data[0])
+            {
+                // The first frame fixes the tile size; even, for 4:2:0 chroma
+                ComputeOutputSize(session.decoder->frame->width, session.decoder->frame->height, options.width,
+                                  &tileWidth, &tileHeight);
+                tileWidth = std::max(2, tileWidth & ~1);
+                tileHeight = std::max(2, tileHeight & ~1);
+
+                picture->format = format;
+                picture->width = tileWidth * columns;
+                picture->height = tileHeight * rows;
+                if (av_frame_get_buffer(picture, 0) < 0)
+                {
+                    result = TC_ERROR_MEMORY;
+                    break;
+                }
+                FillBlack(picture);
+            }
+
+            uint8_t *dest[4];
+            TileDestination(picture, (i % columns) * tileWidth, (i / columns) * tileHeight, dest);
+            if (!ScaleFrame(*session.decoder, options.scale_mode, dest, picture->linesize, tileWidth, tileHeight,
+                            format))
+            {
+                result = TC_ERROR_SCALE;
+                break;
+            }
+            timestamps[i] = FrameSeconds(session, target);
+            result = TC_SUCCESS;
+        }
+
+        if (result == TC_SUCCESS)
+        {
+            result = EncodePicture(picture, options, sink);
+        }
+        av_frame_free(&picture);
+        if (result != TC_SUCCESS)
+        {
+            return result;
+        }
+
+        sheet->timestamps = static_cast<double *>(malloc(sizeof(double) * timestamps.size()));
+        if (!sheet->timestamps)
+        {
+            return TC_ERROR_MEMORY;
+        }
+        memcpy(sheet->timestamps, timestamps.data(), sizeof(double) * timestamps.size());
+        sheet->tile_width = tileWidth;
+        sheet->tile_height = tileHeight;
+        sheet->columns = columns;
+        sheet->rows = rows;
+        sheet->frame_count = frameCount;
+        return TC_SUCCESS;
+    }
+
+#ifdef _WIN32
+    // The C runtime takes the ANSI code page on Windows; go through UTF-16 instead
+    std::wstring Utf8ToWide(const char *utf8)
+    {
+        int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, utf8, -1, nullptr, 0);
+        if (sizeNeeded <= 0)
+        {
+            return std::wstring();
+        }
+        std::wstring wide(sizeNeeded, 0);
+        MultiByteToWideChar(CP_UTF8, 0, utf8, -1, &wide[0], sizeNeeded);
+        wide.resize(sizeNeeded - 1); // Remove the null terminator
+        return wide;
+    }
+#endif
+
+    FILE *OpenForWriting(const char *path)
+    {
+#ifdef _WIN32
+        return _wfopen(Utf8ToWide(path).c_str(), L"wb");
+#else
+        return fopen(path, "wb");
+#endif
+    }
+
+    void RemoveFile(const char *path)
+    {
+#ifdef _WIN32
+        _wremove(Utf8ToWide(path).c_str());
+#else
+        remove(path);
+#endif
+    }
+
+    // Writes the encoder's packet straight to destPath; the file is only
+    // created once there is an image to put in it
+    PacketSink FileSink(const char *destPath)
+    {
+        return [destPath](const AVPacket *packet, int, int)
+        {
+            FILE *file = OpenForWriting(destPath);
+            if (!file)
+            {
+                return TC_ERROR_WRITE;
+            }
+
+            const size_t size = static_cast<size_t>(packet->size);
+            bool written = fwrite(packet->data, 1, size, file) == size;
+            written = fclose(file) == 0 && written;
+            if (!written)
+            {
+                RemoveFile(destPath);
+                return TC_ERROR_WRITE;
+            }
+            return TC_SUCCESS;
+        };
+    }
+
+} // namespace
+
+extern "C"
+{
+    void tc_default_options(TcThumbnailOptions *options)
+    {
+        if (!options)
+        {
+            return;
+        }
+        options->fast_probe = 0;
+        options->thread_count = 0;
+        options->seek_mode = TC_SEEK_SECONDS;
+        options->seek_value = -1.0;
+        options->keyframe_only = 0;
+        options->width = 0;
+        options->scale_mode = TC_SCALE_QUALITY;
+        options->format = TC_FORMAT_JPEG;
+        options->quality = 95;
+    }
+
+    int tc_extract_thumbnail(const char *path, const TcThumbnailOptions *options, TcImage *image)
+    {
+        if (!path || !options || !image)
+        {
+            return TC_ERROR_INVALID_ARGUMENT;
+        }
+        image->data = nullptr;
+        image->size = 0;
+        image->width = 0;
+        image->height = 0;
+
+        auto copyToImage = [image](const AVPacket *packet, int width, int height)
+        {
+            image->data = static_cast<uint8_t *>(malloc(packet->size));
+            if (!image->data)
+            {
+                return TC_ERROR_MEMORY;
+            }
+            memcpy(image->data, packet->data, packet->size);
+            image->size = static_cast<size_t>(packet->size);
+            image->width = width;
+            image->height = height;
+            return TC_SUCCESS;
+        };
+
+        try
+        {
+            return ExtractThumbnail(path, *options, copyToImage);
+        }
+        catch (...)
+        {
+            tc_free_image(image);
+            return TC_ERROR_MEMORY;
+        }
+    }
+
+    int tc_extract_thumbnail_to_file(const char *path, const char *dest_path,
+                                     const TcThumbnailOptions *options)
+    {
+        if (!path || !dest_path || !options)
+        {
+            return TC_ERROR_INVALID_ARGUMENT;
+        }
+
+        try
+        {
+            return ExtractThumbnail(path, *options, FileSink(dest_path));
+        }
+        catch (...)
+        {
+            return TC_ERROR_MEMORY;
+        }
+    }
+
+    int tc_extract_sprite_sheet(const char *path, const char *dest_path,
+                                const TcThumbnailOptions *options, int frame_count,
+                                int columns, TcSpriteSheet *sheet)
+    {
+        if (!path || !dest_path || !options || !sheet || options->width <= 0 ||
+            frame_count <= 0 || frame_count > kMaxSpriteFrames)
+        {
+            return TC_ERROR_INVALID_ARGUMENT;
+        }
+        memset(sheet, 0, sizeof(*sheet));
+
+        try
+        {
+            return ExtractSpriteSheet(path, *options, frame_count, columns, sheet, FileSink(dest_path));
+        }
+        catch (...)
+        {
+            tc_free_sprite_sheet(sheet);
+            return TC_ERROR_MEMORY;
+        }
+    }
+
+    void tc_free_sprite_sheet(TcSpriteSheet *sheet)
+    {
+        if (!sheet)
+        {
+            return;
+        }
+        free(sheet->timestamps);
+        memset(sheet, 0, sizeof(*sheet));
+    }
+
+    void tc_set_decoder_pool_size(size_t max_idle_decoders)
+    {
+        DecoderPool::Instance().SetMaxIdle(max_idle_decoders);
+    }
+
+    void tc_clear_decoder_pool(void)
+    {
+        DecoderPool::Instance().Clear();
+    }
+
+    void tc_set_decoder_thread_limit(int max_threads)
+    {
+        DecoderPool::Instance().SetThreadLimit(max_threads > 0 ? static_cast<size_t>(max_threads) : 0);
+    }
+
+    void tc_free_image(TcImage *image)
+    {
+        if (!image)
+        {
+            return;
+        }
+        free(image->data);
+        image->data = nullptr;
+        image->size = 0;
+        image->width = 0;
+        image->height = 0;
+    }
+
+    double tc_get_video_duration(const char *path)
+    {
+        if (!path)
+        {
+            return -1.0;
+        }
+
+        try
+        {
+            MediaInfoRecord record;
+            if (ProbeMediaInfo(path, &record) != TC_SUCCESS)
+            {
+                return -1.0;
+            }
+            return record.duration;
+        }
+        catch (...)
+        {
+            return -1.0;
+        }
+    }
+
+    int tc_media_info_cache_open(const char *path)
+    {
+        if (!path || !*path)
+        {
+            return TC_ERROR_INVALID_ARGUMENT;
+        }
+
+        try
+        {
+            return MediaInfoCache::Instance().Open(path) ? TC_SUCCESS : TC_ERROR_OPEN_INPUT;
+        }
+        catch (...)
+        {
+            return TC_ERROR_MEMORY;
+        }
+    }
+
+    void tc_media_info_cache_close(void)
+    {
+        try
+        {
+            MediaInfoCache::Instance().Close();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    int tc_get_media_info(const char *path, TcMediaInfo *info)
+    {
+        if (!path || !info)
+        {
+            return TC_ERROR_INVALID_ARGUMENT;
+        }
+        memset(info, 0, sizeof(*info));
+        info->duration = -1.0;
+
+        try
+        {
+            MediaInfoRecord record;
+            int result = ProbeMediaInfo(path, &record);
+            if (result != TC_SUCCESS)
+            {
+                return result;
+            }
+
+            if (!record.keyframes.empty())
+            {
+                info->keyframes = static_cast<float *>(malloc(record.keyframes.size() * sizeof(float)));
+                if (!info->keyframes)
+                {
+                    return TC_ERROR_MEMORY;
+                }
+                memcpy(info->keyframes, record.keyframes.data(), record.keyframes.size() * sizeof(float));
+                info->keyframe_count = static_cast<int>(record.keyframes.size());
+            }
+            info->duration = record.duration;
+            info->width = record.width;
+            info->height = record.height;
+            info->rotation = record.rotation;
+            snprintf(info->codec, sizeof(info->codec), "%s", record.codec.c_str());
+            return TC_SUCCESS;
+        }
+        catch (...)
+        {
+            tc_free_media_info(info);
+            return TC_ERROR_MEMORY;
+        }
+    }
+
+    void tc_free_media_info(TcMediaInfo *info)
+    {
+        if (!info)
+        {
+            return;
+        }
+        free(info->keyframes);
+        info->keyframes = nullptr;
+        info->keyframe_count = 0;
+    }
+
+    const char *tc_error_message(int error_code)
+    {
+        switch (error_code)
+        {
+        case TC_SUCCESS:
+            return "Success";
+        case TC_ERROR_INVALID_ARGUMENT:
+            return "Invalid argument";
+        case TC_ERROR_OPEN_INPUT:
+            return "Failed to open input file";
+        case TC_ERROR_STREAM_INFO:
+            return "Failed to find stream info";
+        case TC_ERROR_NO_VIDEO_STREAM:
+            return "No video stream found";
+        case TC_ERROR_DECODER:
+            return "Failed to open decoder";
+        case TC_ERROR_SEEK:
+            return "Failed to seek to timestamp";
+        case TC_ERROR_NO_FRAME:
+            return "Failed to find video frame";
+        case TC_ERROR_SCALE:
+            return "Failed to create scaling context";
+        case TC_ERROR_ENCODE:
+            return "Failed to encode image";
+        case TC_ERROR_WRITE:
+            return "Failed to save image";
+        case TC_ERROR_MEMORY:
+            return "Out of memory";
+        default:
+            return "Unknown error";
+        }
+    }
+}
@@ -3,6 +3,7 @@
 // This must be included before many other Windows headers.
 #include <atlimage.h>
 #include <comdef.h>
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
@@ -18,6 +19,8 @@
 #include <mfidl.h>
 #include <mfreadwrite.h>
 #include <propvarutil.h>
+#include <media_info.h>
+#include <thumbnail_core.h>
 
 #include <codecvt>
 #include <iostream>
@@ -28,6 +31,8 @@
 #include <filesystem>
 #include <fstream>
 #include <algorithm>
+#include <iterator>
+#include <optional>
 #include <thread>
 
 const std::string kGetThumbnailFailedExtraction = "Failed extraction";
@@ -78,6 +83,25 @@ namespace fc_native_video_thumbnail
     return *val64;
   }
 
+  // Dart may send whole numbers for doubles (e.g. 30 for 30.0)
+  std::optional<double> GetDoubleValueOrNull(const flutter::EncodableMap &map, const char *key)
+  {
+    auto value = ValueOrNull(map, key);
+    if (value)
+    {
+      if (const auto *val = std::get_if<double>(value))
+      {
+        return *val;
+      }
+    }
+    auto integer = GetInt64ValueOrNull(map, key);
+    if (!integer.has_value())
+    {
+      return std::nullopt;
+    }
+    return static_cast<double>(*integer);
+  }
+
   std::wstring Utf16FromUtf8(const std::string &utf8_string)
   {
     if (utf8_string.empty())
@@ -846,7 +870,7 @@ namespace fc_native_video_thumbnail
             registrar->messenger(), "fc_native_video_thumbnail",
             &flutter::StandardMethodCodec::GetInstance());
 
-    auto plugin = std::make_unique<FcNativeVideoThumbnailPlugin>();
+    auto plugin = std::make_unique<FcNativeVideoThumbnailPlugin>(registrar);
 
     channel->SetMethodCallHandler(
         [plugin_pointer = plugin.get()](const auto &call, auto result)
@@ -854,10 +878,37 @@ namespace fc_native_video_thumbnail
           plugin_pointer->HandleMethodCall(call, std::move(result));
         });
 
+    // generateBatch results stream back over this channel
+    plugin->batchEventChannel_ =
+        std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+            registrar->messenger(), "fc_native_video_thumbnail/batch",
+            &flutter::StandardMethodCodec::GetInstance());
+    plugin->batchEventChannel_->SetStreamHandler(
+        std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+            [plugin_pointer = plugin.get()](const flutter::EncodableValue *arguments,
+                                            std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> &&events)
+                -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>>
+            {
+              plugin_pointer->batchSink_ = std::move(events);
+              return nullptr;
+            },
+            [plugin_pointer = plugin.get()](const flutter::EncodableValue *arguments)
+                -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>>
+            {
+              plugin_pointer->batchSink_.reset();
+              return nullptr;
+            }));
+
     registrar->AddPlugin(std::move(plugin));
   }
 
-  FcNativeVideoThumbnailPlugin::FcNativeVideoThumbnailPlugin() : shutdown_(false)
+  FcNativeVideoThumbnailPlugin::FcNativeVideoThumbnailPlugin(flutter::PluginRegistrarWindows *registrar)
+      : shutdown_(false),
+        registrar_(registrar),
+        windowProcDelegateId_(-1),
+        batchWindow_(nullptr),
+        batchFlushPosted_(false),
+        nextBatchId_(1)
   {
     // Initialize shared GDI+ resources
     {
@@ -876,14 +927,21 @@ namespace fc_native_video_thumbnail
     // Initialize MediaFoundation
     MFStartup(MF_VERSION);
 
-    // Create worker threads (use hardware concurrency, but limit to reasonable number)
-    const size_t numThreads = std::min(std::thread::hardware_concurrency(), 4u);
-    workers_.reserve(numThreads);
+    // One worker per hardware thread; FFmpeg jobs size their decoder
+    // threading from the load, so the machine is neither idle nor oversubscribed
+    executor_ = std::make_unique<ThumbnailExecutor>();
 
-    for (size_t i = 0; i < numThreads; ++i)
-    {
-      workers_.emplace_back(&FcNativeVideoThumbnailPlugin::WorkerThread, this);
-    }
+    // Workers post kBatchFlushMessage; deliver the collected results here, on the platform thread
+    windowProcDelegateId_ = registrar_->RegisterTopLevelWindowProcDelegate(
+        [this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) -> std::optional<LRESULT>
+        {
+          if (message != kBatchFlushMessage)
+          {
+            return std::nullopt;
+          }
+          FlushBatchResults();
+          return 0;
+        });
   }
 
   FcNativeVideoThumbnailPlugin::~FcNativeVideoThumbnailPlugin()
@@ -894,7 +952,7 @@ namespace fc_native_video_thumbnail
     // Clear all pending requests to prevent processing during shutdown
     {
       std::lock_guard<std::mutex> lock(queueMutex_);
-      requestQueue_.clear();
+      requestQueue_.Clear();
     }
 
     // Clear active requests
@@ -903,17 +961,27 @@ namespace fc_native_video_thumbnail
       activeRequests_.clear();
     }
 
-    queueCondition_.notify_all();
-
-    // Wait for all worker threads to finish
-    for (auto &worker : workers_)
+    // Stop in-flight batches from starting more work
     {
-      if (worker.joinable())
+      std::lock_guard<std::mutex> lock(batchMutex_);
+      for (auto &entry : batches_)
       {
-        worker.join();
+        entry.second->cancelled = true;
       }
     }
 
+    // Wait for running jobs; tasks still queued see shutdown_ or an empty queue
+    executor_.reset();
+
+    // Marks the index clean so the next launch keeps it
+    thumbnailIndex_.Close();
+    tc_media_info_cache_close();
+
+    if (windowProcDelegateId_ >= 0)
+    {
+      registrar_->UnregisterTopLevelWindowProcDelegate(windowProcDelegateId_);
+    }
+
     // Cleanup MediaFoundation
     MFShutdown();
 
@@ -952,7 +1020,7 @@ namespace fc_native_video_thumbnail
       assert(outType);
 
       // Check cache first - this prevents unnecessary re-rendering
-      if (IsThumbnailCached(*src_file, *dest_file))
+      if (IsThumbnailCached(*src_file, *dest_file, *width, *outType))
       {
         result->Success(flutter::EncodableValue(true));
         return;
@@ -962,7 +1030,7 @@ namespace fc_native_video_thumbnail
       if (std::filesystem::exists(PathFromUtf8(*dest_file)))
       {
         // File exists, update cache and return success to avoid re-rendering
-        UpdateCache(*src_file, *dest_file);
+        UpdateCache(*src_file, *dest_file, *width, *outType);
         result->Success(flutter::EncodableValue(true));
         return;
       }
@@ -1015,8 +1083,12 @@ namespace fc_native_video_thumbnail
         request->priority = DeterminePriority(*src_file);
       }
 
-      // Generate unique request ID for tracking
-      request->requestId = GenerateCacheKey(*src_file, *width, *outType);
+      // Dart may supply its own ID so it can cancel or reprioritise the
+      // request later; otherwise derive one for duplicate detection
+      const auto *request_id = std::get_if<std::string>(ValueOrNull(args, "requestId"));
+      request->requestId = (request_id && !request_id->empty())
+                               ? *request_id
+                               : GenerateCacheKey(*src_file, *width, *outType);
 
       // Check if request is already being processed
       {
@@ -1024,69 +1096,174 @@ namespace fc_native_video_thumbnail
         if (activeRequests_.find(request->requestId) != activeRequests_.end())
         {
           // Request already in progress, return immediately
-          result->Success(flutter::EncodableValue(false));
+          request->result->Success(flutter::EncodableValue(false));
           return;
         }
         activeRequests_.insert(request->requestId);
       }
 
       // Queue the request for async processing
+      std::vector<std::unique_ptr<ThumbnailRequest>> dropped;
       {
         std::lock_guard<std::mutex> lock(queueMutex_);
 
         // If queue is getting too large, remove low priority requests to prevent lag
         if (requestQueue_.size() >= QUEUE_CLEANUP_THRESHOLD)
         {
-          auto removeIt = std::remove_if(requestQueue_.begin(), requestQueue_.end(),
-                                         [](const std::unique_ptr<ThumbnailRequest> &req)
-                                         {
-                                           return req->priority == ThumbnailPriority::NORMAL;
-                                         });
-
-          // Cleanup active requests for removed items
-          for (auto it = removeIt; it != requestQueue_.end(); ++it)
-          {
-            std::lock_guard<std::mutex> activeLock(activeRequestsMutex_);
-            activeRequests_.erase((*it)->requestId);
-          }
-
-          requestQueue_.erase(removeIt, requestQueue_.end());
+          dropped = requestQueue_.RemoveWithPriority(ThumbnailPriority::NORMAL);
         }
 
         // Don't add if queue is at max capacity and this is low priority
         if (requestQueue_.size() >= MAX_QUEUE_SIZE && request->priority == ThumbnailPriority::NORMAL)
+        {
+          dropped.push_back(std::move(request));
+        }
+        else if (auto rejected = requestQueue_.Push(std::move(request)))
+        {
+          dropped.push_back(std::move(rejected));
+        }
+      }
+
+      // Dropped requests still get an answer so Dart does not wait for its timeout
+      for (auto &droppedRequest : dropped)
+      {
         {
           std::lock_guard<std::mutex> activeLock(activeRequestsMutex_);
-          activeRequests_.erase(request->requestId);
-          result->Success(flutter::EncodableValue(false));
-          return;
+          activeRequests_.erase(droppedRequest->requestId);
+        }
+        if (droppedRequest->result)
+        {
+          droppedRequest->result->Success(flutter::EncodableValue(false));
         }
+      }
+      // The task takes whatever is most urgent when it runs, not necessarily this request
+      executor_->Submit([this]
+                        { RunNextRequest(); });
+    }
+    else if (method_call.method_name().compare("generateBatch") == 0)
+    {
+      // Returns the batch ID right away; results follow on the batch event channel
+      result->Success(flutter::EncodableValue(StartBatch(args)));
+    }
+    else if (method_call.method_name().compare("cancelBatch") == 0)
+    {
+      auto batchId = GetInt64ValueOrNull(args, "batchId");
+      result->Success(flutter::EncodableValue(batchId.has_value() && CancelBatch(*batchId)));
+    }
+    else if (method_call.method_name().compare("openThumbnailIndex") == 0)
+    {
+      // Persistent cache index; false if it is missing, unwritable or held by another instance
+      const auto *path = std::get_if<std::string>(ValueOrNull(args, "path"));
+      bool opened = path && thumbnailIndex_.Open(NormalizeWindowsPathFromUtf8(*path));
+      if (opened)
+      {
+        auto budgetBytes = GetInt64ValueOrNull(args, "budgetBytes");
+        if (budgetBytes.has_value() && *budgetBytes > 0)
+        {
+          thumbnailIndex_.SetByteBudget(static_cast<uint64_t>(*budgetBytes));
+        }
+      }
+      result->Success(flutter::EncodableValue(opened));
+    }
+    else if (method_call.method_name().compare("openMediaInfoCache") == 0)
+    {
+      // Probing works without it; this only makes results outlive the run
+      const auto *path = std::get_if<std::string>(ValueOrNull(args, "path"));
+      const bool opened = path && !path->empty() && tc_media_info_cache_open(path->c_str()) == TC_SUCCESS;
+      result->Success(flutter::EncodableValue(opened));
+    }
+    else if (method_call.method_name().compare("generateSpriteSheet") == 0)
+    {
+      // Scrub previews: every tile from one open input and decoder
+      const auto *src_file = std::get_if<std::string>(ValueOrNull(args, "srcFile"));
+      const auto *dest_file = std::get_if<std::string>(ValueOrNull(args, "destFile"));
+      if (!src_file || !dest_file || src_file->empty() || dest_file->empty())
+      {
+        result->Success(flutter::EncodableValue());
+        return;
+      }
 
-        requestQueue_.push_back(std::move(request));
+      TcThumbnailOptions options;
+      tc_default_options(&options);
+      options.fast_probe = 1;
+      options.keyframe_only = 1;
+      if (const auto *keyframe_only = std::get_if<bool>(ValueOrNull(args, "keyframeOnly")))
+      {
+        options.keyframe_only = *keyframe_only ? 1 : 0;
+      }
+      options.width = static_cast<int>(GetInt64ValueOrNull(args, "tileWidth").value_or(160));
+      options.scale_mode = TC_SCALE_FAST;
+      const auto *format = std::get_if<std::string>(ValueOrNull(args, "format"));
+      options.format = (format && *format == "png") ? TC_FORMAT_PNG : TC_FORMAT_JPEG;
+      options.quality = std::clamp(static_cast<int>(GetInt64ValueOrNull(args, "quality").value_or(80)), 1, 100);
+      const int frameCount = static_cast<int>(GetInt64ValueOrNull(args, "frameCount").value_or(100));
+      const int columns = static_cast<int>(GetInt64ValueOrNull(args, "columns").value_or(0));
+
+      std::string srcPath = *src_file;
+      std::string destPath = *dest_file;
+      std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> result_ptr = std::move(result);
+      executor_->Submit([srcPath, destPath, options, frameCount, columns, result_ptr]()
+                        {
+        TcSpriteSheet sheet;
+        if (tc_extract_sprite_sheet(srcPath.c_str(), destPath.c_str(), &options, frameCount, columns, &sheet) != TC_SUCCESS)
+        {
+          result_ptr->Success(flutter::EncodableValue());  // null on error
+          return;
+        }
 
-        // Insert request in correct position to maintain sorted order (more efficient than full sort)
-        if (requestQueue_.size() > 1)
+        flutter::EncodableList timestamps;
+        timestamps.reserve(sheet.frame_count);
+        for (int i = 0; i < sheet.frame_count; ++i)
+        {
+          timestamps.push_back(flutter::EncodableValue(sheet.timestamps[i]));
+        }
+        flutter::EncodableMap layout{
+            {flutter::EncodableValue("path"), flutter::EncodableValue(destPath)},
+            {flutter::EncodableValue("tileWidth"), flutter::EncodableValue(sheet.tile_width)},
+            {flutter::EncodableValue("tileHeight"), flutter::EncodableValue(sheet.tile_height)},
+            {flutter::EncodableValue("columns"), flutter::EncodableValue(sheet.columns)},
+            {flutter::EncodableValue("rows"), flutter::EncodableValue(sheet.rows)},
+            {flutter::EncodableValue("timestamps"), flutter::EncodableValue(std::move(timestamps))},
+        };
+        tc_free_sprite_sheet(&sheet);
+        result_ptr->Success(flutter::EncodableValue(std::move(layout))); });
+    }
+    else if (method_call.method_name().compare("setThreadLimits") == 0)
+    {
+      // Cap on decoder threads per FFmpeg job; <= 0 leaves it to the load
+      if (const auto *max_decoder_threads = std::get_if<int>(ValueOrNull(args, "maxDecoderThreads")))
+      {
+        tc_set_decoder_thread_limit(*max_decoder_threads);
+      }
+      result->Success(flutter::EncodableValue(static_cast<int64_t>(executor_->WorkerCount())));
+    }
+    else if (method_call.method_name().compare("cancelThumbnails") == 0)
+    {
+      // Tiles that scrolled away: drop their queued requests (running ones finish)
+      std::vector<std::string> requestIds;
+      if (const auto *ids = std::get_if<std::vector<flutter::EncodableValue>>(ValueOrNull(args, "requestIds")))
+      {
+        for (const auto &id : *ids)
         {
-          auto insertPos = std::upper_bound(requestQueue_.begin(), requestQueue_.end() - 1, requestQueue_.back(),
-                                            [](const std::unique_ptr<ThumbnailRequest> &a, const std::unique_ptr<ThumbnailRequest> &b)
-                                            {
-                                              // Higher priority first
-                                              if (a->priority != b->priority)
-                                              {
-                                                return static_cast<int>(a->priority) > static_cast<int>(b->priority);
-                                              }
-                                              // If same priority, older requests first (FIFO within same priority)
-                                              return a->requestTime < b->requestTime;
-                                            });
-
-          // Move the last element to correct position
-          if (insertPos != requestQueue_.end() - 1)
+          if (const auto *str = std::get_if<std::string>(&id))
           {
-            std::rotate(insertPos, requestQueue_.end() - 1, requestQueue_.end());
+            requestIds.push_back(*str);
           }
         }
       }
-      queueCondition_.notify_one();
+      result->Success(flutter::EncodableValue(static_cast<int64_t>(CancelRequests(requestIds))));
+    }
+    else if (method_call.method_name().compare("updateThumbnailPriority") == 0)
+    {
+      const auto *request_id = std::get_if<std::string>(ValueOrNull(args, "requestId"));
+      const auto *priority_val = std::get_if<int>(ValueOrNull(args, "priority"));
+      bool updated = false;
+      if (request_id && priority_val)
+      {
+        updated = UpdateRequestPriority(
+            *request_id, static_cast<ThumbnailPriority>(std::clamp(*priority_val, 0, 3)));
+      }
+      result->Success(flutter::EncodableValue(updated));
     }
     else if (method_call.method_name().compare("setVisibleThumbnails") == 0)
     {
@@ -1119,24 +1296,62 @@ namespace fc_native_video_thumbnail
       const auto *src_file = std::get_if<std::string>(ValueOrNull(args, "srcFile"));
       if (src_file && !src_file->empty())
       {
-        // Run FFmpeg operation on background thread to avoid blocking UI
+        // Run FFmpeg operation on the worker pool to avoid blocking UI
         std::string filePath = *src_file;
-        auto result_ptr = std::move(result);
+        std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> result_ptr = std::move(result);
 
-        std::thread([filePath, result_ptr = std::move(result_ptr)]() mutable
-                    {
+        executor_->Submit([filePath, result_ptr]()
+                          {
           std::wstring widePath = Utf16FromUtf8(filePath);
           double duration = FFmpegThumbnailHelper::GetVideoDuration(widePath.c_str());
           
           // Post result back to main thread
-          result_ptr->Success(flutter::EncodableValue(duration)); })
-            .detach();
+          result_ptr->Success(flutter::EncodableValue(duration)); });
       }
       else
       {
         result->Success(flutter::EncodableValue(-1.0));
       }
     }
+    else if (method_call.method_name().compare("getMediaInfo") == 0)
+    {
+      const auto *src_file = std::get_if<std::string>(ValueOrNull(args, "srcFile"));
+      if (src_file && !src_file->empty())
+      {
+        std::string filePath = *src_file;
+        std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> result_ptr = std::move(result);
+
+        executor_->Submit([filePath, result_ptr]()
+                          {
+          TcMediaInfo info;
+          if (tc_get_media_info(filePath.c_str(), &info) != TC_SUCCESS)
+          {
+            result_ptr->Success(flutter::EncodableValue());  // null on error
+            return;
+          }
+
+          flutter::EncodableList keyframes;
+          keyframes.reserve(info.keyframe_count);
+          for (int i = 0; i < info.keyframe_count; ++i)
+          {
+            keyframes.push_back(flutter::EncodableValue(static_cast<double>(info.keyframes[i])));
+          }
+          flutter::EncodableMap value{
+              {flutter::EncodableValue("duration"), flutter::EncodableValue(info.duration)},
+              {flutter::EncodableValue("width"), flutter::EncodableValue(info.width)},
+              {flutter::EncodableValue("height"), flutter::EncodableValue(info.height)},
+              {flutter::EncodableValue("rotation"), flutter::EncodableValue(info.rotation)},
+              {flutter::EncodableValue("codec"), flutter::EncodableValue(std::string(info.codec))},
+              {flutter::EncodableValue("keyframes"), flutter::EncodableValue(std::move(keyframes))},
+          };
+          tc_free_media_info(&info);
+          result_ptr->Success(flutter::EncodableValue(std::move(value))); });
+      }
+      else
+      {
+        result->Success(flutter::EncodableValue());
+      }
+    }
     else if (method_call.method_name().compare("generateThumbnailAtPercentage") == 0)
     {
       // Fast combined method: gets duration and extracts thumbnail in one file open
@@ -1181,18 +1396,32 @@ namespace fc_native_video_thumbnail
         percentage = static_cast<double>(*pct_i64);
       }
 
+      // Grid thumbnails can take the nearest keyframe instead of an exact frame
+      bool keyframeOnly = false;
+      if (auto *keyframe_only = std::get_if<bool>(ValueOrNull(args, "keyframeOnly")))
+      {
+        keyframeOnly = *keyframe_only;
+      }
+
+      // Let the core choose the frame by content instead of by position
+      bool representativeFrame = false;
+      if (auto *representative = std::get_if<bool>(ValueOrNull(args, "representativeFrame")))
+      {
+        representativeFrame = *representative;
+      }
+
       if (src_file && dest_file && !src_file->empty() && !dest_file->empty())
       {
         std::string srcPath = *src_file;
         std::string destPath = *dest_file;
         std::string format = format_val ? *format_val : "jpg";
 
-        auto result_ptr = std::move(result);
+        std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> result_ptr = std::move(result);
 
-        // Run on background thread for non-blocking operation
-        std::thread([srcPath, destPath, width, format, percentage, quality,
-                     result_ptr = std::move(result_ptr)]() mutable
-                    {
+        // Run on the worker pool for non-blocking operation
+        executor_->Submit([srcPath, destPath, width, format, percentage, quality, keyframeOnly,
+                           representativeFrame, result_ptr]()
+                          {
           std::wstring wideSrc = Utf16FromUtf8(srcPath);
           std::wstring wideDest = Utf16FromUtf8(destPath);
 
@@ -1204,7 +1433,9 @@ namespace fc_native_video_thumbnail
               width,
               formatGuid,
               percentage,
-              quality);
+              quality,
+              keyframeOnly,
+              representativeFrame);
 
           if (error.empty())
           {
@@ -1213,8 +1444,7 @@ namespace fc_native_video_thumbnail
           else
           {
             result_ptr->Success(flutter::EncodableValue());  // null on error
-          } })
-            .detach();
+          } });
       }
       else
       {
@@ -1227,85 +1457,273 @@ namespace fc_native_video_thumbnail
     }
   }
 
-  // Worker thread function
-  void FcNativeVideoThumbnailPlugin::WorkerThread()
+  // Runs on the executor: one task per queued request, each taking the most
+  // urgent request at the time it starts
+  void FcNativeVideoThumbnailPlugin::RunNextRequest()
   {
-    const HRESULT coInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-    const bool coInitialized = (coInit == S_OK || coInit == S_FALSE);
-
-    while (!shutdown_)
+    std::unique_ptr<ThumbnailRequest> request;
     {
-      std::unique_ptr<ThumbnailRequest> request;
+      std::lock_guard<std::mutex> lock(queueMutex_);
+      if (shutdown_)
+        return;
 
-      // Wait for work
-      {
-        std::unique_lock<std::mutex> lock(queueMutex_);
-        queueCondition_.wait(lock, [this]
-                             { return !requestQueue_.empty() || shutdown_; });
+      // Highest priority, oldest first; empty if it was cancelled or dropped
+      request = requestQueue_.Pop();
+    }
 
-        if (shutdown_)
-          break;
+    if (!request)
+    {
+      return;
+    }
 
-        if (!requestQueue_.empty())
+    // Validate request before processing
+    if (!request->srcFile.empty() && !request->destFile.empty())
+    {
+      // Check if source file still exists
+      const auto normalizedSrc = NormalizeWindowsPathFromUtf8(request->srcFile);
+      if (normalizedSrc.empty())
+      {
         {
-          // Get highest priority request (first element after sorting)
-          request = std::move(requestQueue_.front());
-          requestQueue_.erase(requestQueue_.begin());
+          std::lock_guard<std::mutex> lock(activeRequestsMutex_);
+          activeRequests_.erase(request->requestId);
         }
+        if (request->result)
+        {
+          request->result->Error("InvalidRequest", "Invalid source path");
+        }
+        return;
       }
 
-      // Validate request before processing
-      if (request && !request->srcFile.empty() && !request->destFile.empty())
+      if (!FileExistsWide(normalizedSrc))
       {
-        // Check if source file still exists
-        const auto normalizedSrc = NormalizeWindowsPathFromUtf8(request->srcFile);
-        if (normalizedSrc.empty())
+        // Cleanup and skip invalid request
         {
-          {
-            std::lock_guard<std::mutex> lock(activeRequestsMutex_);
-            activeRequests_.erase(request->requestId);
-          }
-          if (request->result)
-          {
-            request->result->Error("InvalidRequest", "Invalid source path");
-          }
-          continue;
+          std::lock_guard<std::mutex> lock(activeRequestsMutex_);
+          activeRequests_.erase(request->requestId);
         }
+        if (request->result)
+        {
+          request->result->Error("FileNotFound", "Source file does not exist");
+        }
+        return;
+      }
+
+      ProcessThumbnailAsync(std::move(request));
+    }
+    else
+    {
+      // Cleanup invalid request
+      {
+        std::lock_guard<std::mutex> lock(activeRequestsMutex_);
+        activeRequests_.erase(request->requestId);
+      }
+      if (request->result)
+      {
+        request->result->Error("InvalidRequest", "Invalid request parameters");
+      }
+    }
+  }
+
+  // Schedule every item of a generateBatch call in one go. Items are
+  // {srcFile, destFile, width?, timeSeconds?, percentage?}; format, quality
+  // and keyframeOnly apply to all.
+  int64_t FcNativeVideoThumbnailPlugin::StartBatch(const flutter::EncodableMap &args)
+  {
+    if (!batchWindow_)
+    {
+      // The Flutter view is parented by now; results are posted to its top-level window
+      batchWindow_ = GetAncestor(registrar_->GetView()->GetNativeWindow(), GA_ROOT);
+    }
 
-        if (!FileExistsWide(normalizedSrc))
+    auto batch = std::make_shared<BatchState>();
+    const auto *format_val = std::get_if<std::string>(ValueOrNull(args, "format"));
+    batch->format = format_val ? *format_val : "jpg";
+    batch->quality = std::clamp(static_cast<int>(GetInt64ValueOrNull(args, "quality").value_or(95)), 1, 100);
+    const auto *keyframe_only = std::get_if<bool>(ValueOrNull(args, "keyframeOnly"));
+    batch->keyframeOnly = keyframe_only && *keyframe_only;
+
+    std::vector<BatchItem> items;
+    if (const auto *list = std::get_if<flutter::EncodableList>(ValueOrNull(args, "items")))
+    {
+      items.reserve(list->size());
+      for (size_t i = 0; i < list->size(); ++i)
+      {
+        const auto *entry = std::get_if<flutter::EncodableMap>(&(*list)[i]);
+        if (!entry)
         {
-          // Cleanup and skip invalid request
-          {
-            std::lock_guard<std::mutex> lock(activeRequestsMutex_);
-            activeRequests_.erase(request->requestId);
-          }
-          if (request->result)
-          {
-            request->result->Error("FileNotFound", "Source file does not exist");
-          }
           continue;
         }
+        const auto *src_file = std::get_if<std::string>(ValueOrNull(*entry, "srcFile"));
+        const auto *dest_file = std::get_if<std::string>(ValueOrNull(*entry, "destFile"));
+
+        BatchItem item;
+        item.index = static_cast<int64_t>(i);
+        item.srcFile = src_file ? *src_file : std::string();
+        item.destFile = dest_file ? *dest_file : std::string();
+        item.width = static_cast<int>(GetInt64ValueOrNull(*entry, "width").value_or(0));
+        item.timeSeconds = static_cast<int>(GetInt64ValueOrNull(*entry, "timeSeconds").value_or(-1));
+        item.percentage = GetDoubleValueOrNull(*entry, "percentage").value_or(-1.0);
+        items.push_back(std::move(item));
+      }
+    }
 
-        ProcessThumbnailAsync(std::move(request));
+    {
+      std::lock_guard<std::mutex> lock(batchMutex_);
+      batch->batchId = nextBatchId_++;
+      if (!items.empty())
+      {
+        batches_[batch->batchId] = batch;
       }
-      else if (request)
+    }
+    batch->remaining = items.size();
+
+    for (auto &item : items)
+    {
+      executor_->Submit([this, item = std::move(item), batch]()
+                        { ProcessBatchItem(item, batch); });
+    }
+    return batch->batchId;
+  }
+
+  // Runs on the executor; every item reports exactly one result unless its batch was cancelled
+  void FcNativeVideoThumbnailPlugin::ProcessBatchItem(const BatchItem &item, const std::shared_ptr<BatchState> &batch)
+  {
+    if (!batch->cancelled && !shutdown_)
+    {
+      bool success = false;
+      std::string error;
+      try
       {
-        // Cleanup invalid request
+        const auto normalizedSrc = NormalizeWindowsPathFromUtf8(item.srcFile);
+        const auto normalizedDest = NormalizeWindowsPathFromUtf8(item.destFile);
+        const GUID &formatGuid = batch->format == "png" ? Gdiplus::ImageFormatPNG : Gdiplus::ImageFormatJPEG;
+        if (normalizedSrc.empty() || normalizedDest.empty())
         {
-          std::lock_guard<std::mutex> lock(activeRequestsMutex_);
-          activeRequests_.erase(request->requestId);
+          error = "Invalid path";
         }
-        if (request->result)
+        else if (item.percentage >= 0)
+        {
+          // Like generateThumbnailAtPercentage, with the shell thumbnail as
+          // the fallback the grid used to request separately. The index is
+          // keyed without the position, so it is left out.
+          error = FFmpegThumbnailHelper::ExtractThumbnailAtPercentage(
+              normalizedSrc.c_str(), normalizedDest.c_str(), item.width, formatGuid,
+              item.percentage, batch->quality, batch->keyframeOnly);
+          if (!error.empty())
+          {
+            error = SaveThumbnail(normalizedSrc.c_str(), normalizedDest.c_str(), item.width, formatGuid,
+                                  nullptr, batch->quality, true);
+          }
+          success = error.empty();
+        }
+        else if (IsThumbnailCached(item.srcFile, item.destFile, item.width, batch->format))
+        {
+          success = true;
+        }
+        else if (!FileExistsWide(normalizedSrc))
         {
-          request->result->Error("InvalidRequest", "Invalid request parameters");
+          error = "Source file does not exist";
         }
+        else
+        {
+          int timeSecondsValue = item.timeSeconds;
+          int *timeSeconds = timeSecondsValue >= 0 ? &timeSecondsValue : nullptr;
+          error = SaveThumbnail(
+              normalizedSrc.c_str(),
+              normalizedDest.c_str(),
+              item.width,
+              formatGuid,
+              timeSeconds,
+              batch->quality,
+              timeSeconds == nullptr);
+          success = error.empty();
+          if (success)
+          {
+            UpdateCache(item.srcFile, item.destFile, item.width, batch->format);
+          }
+        }
+      }
+      catch (const std::exception &e)
+      {
+        error = std::string("Exception: ") + e.what();
+      }
+      catch (...)
+      {
+        error = "Unknown exception occurred";
+      }
+
+      flutter::EncodableMap resultMap{
+          {flutter::EncodableValue("batchId"), flutter::EncodableValue(batch->batchId)},
+          {flutter::EncodableValue("index"), flutter::EncodableValue(item.index)},
+          {flutter::EncodableValue("srcFile"), flutter::EncodableValue(item.srcFile)},
+          {flutter::EncodableValue("destFile"), flutter::EncodableValue(item.destFile)},
+          {flutter::EncodableValue("success"), flutter::EncodableValue(success)},
+      };
+      if (!success)
+      {
+        resultMap[flutter::EncodableValue("error")] = flutter::EncodableValue(error);
       }
+      PostBatchResult(flutter::EncodableValue(std::move(resultMap)));
+    }
+
+    if (--batch->remaining == 0)
+    {
+      std::lock_guard<std::mutex> lock(batchMutex_);
+      batches_.erase(batch->batchId);
+    }
+  }
+
+  // Queue a result; the first one since the last flush wakes the platform thread
+  void FcNativeVideoThumbnailPlugin::PostBatchResult(flutter::EncodableValue result)
+  {
+    bool post = false;
+    {
+      std::lock_guard<std::mutex> lock(batchMutex_);
+      batchResults_.push_back(std::move(result));
+      post = !batchFlushPosted_;
+      batchFlushPosted_ = true;
+    }
+    if (post && batchWindow_)
+    {
+      PostMessage(batchWindow_, kBatchFlushMessage, 0, 0);
+    }
+  }
+
+  // Platform thread: send everything collected since the last flush, as lists of up to kMaxBatchChunk
+  void FcNativeVideoThumbnailPlugin::FlushBatchResults()
+  {
+    std::vector<flutter::EncodableValue> results;
+    {
+      std::lock_guard<std::mutex> lock(batchMutex_);
+      results.swap(batchResults_);
+      batchFlushPosted_ = false;
     }
+    if (!batchSink_)
+    {
+      return; // Nobody listening; Dart has gone away
+    }
+
+    for (size_t start = 0; start < results.size(); start += kMaxBatchChunk)
+    {
+      const size_t end = std::min(results.size(), start + kMaxBatchChunk);
+      flutter::EncodableList chunk(std::make_move_iterator(results.begin() + start),
+                                   std::make_move_iterator(results.begin() + end));
+      batchSink_->Success(flutter::EncodableValue(std::move(chunk)));
+    }
+  }
 
-    if (coInitialized)
+  // Items that have not started are skipped; running ones still report
+  bool FcNativeVideoThumbnailPlugin::CancelBatch(int64_t batchId)
+  {
+    std::lock_guard<std::mutex> lock(batchMutex_);
+    auto it = batches_.find(batchId);
+    if (it == batches_.end())
     {
-      CoUninitialize();
+      return false;
     }
+    it->second->cancelled = true;
+    batches_.erase(it);
+    return true;
   }
 
   // Process thumbnail request asynchronously
@@ -1356,7 +1774,7 @@ namespace fc_native_video_thumbnail
       else
       {
         // Update cache on success
-        UpdateCache(request->srcFile, request->destFile);
+        UpdateCache(request->srcFile, request->destFile, request->width, request->format);
         request->result->Success(flutter::EncodableValue(true));
       }
     }
@@ -1374,92 +1792,41 @@ namespace fc_native_video_thumbnail
   }
 
   // Check if thumbnail is cached and valid
-  bool FcNativeVideoThumbnailPlugin::IsThumbnailCached(const std::string &srcFile, const std::string &destFile)
+  bool FcNativeVideoThumbnailPlugin::IsThumbnailCached(const std::string &srcFile, const std::string &destFile, int width, const std::string &format)
   {
-    std::lock_guard<std::mutex> lock(cacheMutex_);
-
-    // Check if thumbnail file exists
-    if (!std::filesystem::exists(PathFromUtf8(destFile)))
-    {
-      return false;
-    }
-
-    // Check cache entry using proper cache key that includes file path
-    auto cacheKey = destFile; // Use destination file path as cache key for better uniqueness
-    auto it = thumbnailCache_.find(cacheKey);
-
-    if (it == thumbnailCache_.end())
+    // The thumbnail may have been deleted behind our back
+    std::error_code ec;
+    if (!std::filesystem::exists(PathFromUtf8(destFile), ec))
     {
       return false;
     }
 
-    // Check if source file has been modified
-    try
-    {
-      auto fileTime = std::filesystem::last_write_time(PathFromUtf8(srcFile));
-      auto fileSize = std::filesystem::file_size(PathFromUtf8(srcFile));
-
-      // Convert file_time_type to system_clock::time_point for comparison
-      auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-          fileTime - std::filesystem::file_time_type::clock::now() + std::chrono::system_clock::now());
-
-      if (it->second.lastModified != std::chrono::duration_cast<std::chrono::seconds>(sctp.time_since_epoch()).count() ||
-          it->second.fileSize != static_cast<int64_t>(fileSize))
-      {
-        // File has been modified, remove from cache
-        thumbnailCache_.erase(it);
-        return false;
-      }
-
-      return true;
-    }
-    catch (const std::filesystem::filesystem_error &)
+    // Size and write time are part of the key, so a modified source simply misses
+    ThumbnailKey key{srcFile, 0, 0, width, format};
+    if (!ThumbnailIndex::StatSource(NormalizeWindowsPathFromUtf8(srcFile), &key.fileSize, &key.lastWriteTime))
     {
       return false;
     }
+    return thumbnailIndex_.Lookup(key, destFile);
   }
 
   // Update cache with new thumbnail info
-  void FcNativeVideoThumbnailPlugin::UpdateCache(const std::string &srcFile, const std::string &destFile)
+  void FcNativeVideoThumbnailPlugin::UpdateCache(const std::string &srcFile, const std::string &destFile, int width, const std::string &format)
   {
-    std::lock_guard<std::mutex> lock(cacheMutex_);
-
-    try
+    ThumbnailKey key{srcFile, 0, 0, width, format};
+    if (!ThumbnailIndex::StatSource(NormalizeWindowsPathFromUtf8(srcFile), &key.fileSize, &key.lastWriteTime))
     {
-      auto fileTime = std::filesystem::last_write_time(PathFromUtf8(srcFile));
-      auto fileSize = std::filesystem::file_size(PathFromUtf8(srcFile));
-
-      // Convert file_time_type to system_clock::time_point
-      auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-          fileTime - std::filesystem::file_time_type::clock::now() + std::chrono::system_clock::now());
-
-      CacheEntry entry;
-      entry.thumbnailPath = destFile;
-      entry.lastModified = std::chrono::duration_cast<std::chrono::seconds>(sctp.time_since_epoch()).count();
-      entry.fileSize = static_cast<int64_t>(fileSize);
-      entry.cacheTime = std::chrono::system_clock::now();
-
-      auto cacheKey = destFile; // Use destination file path as cache key for consistency
-      thumbnailCache_[cacheKey] = entry;
-
-      // Clean up old cache entries (keep only last 1000 entries)
-      if (thumbnailCache_.size() > 1000)
-      {
-        auto oldest = thumbnailCache_.begin();
-        for (auto it = thumbnailCache_.begin(); it != thumbnailCache_.end(); ++it)
-        {
-          if (it->second.cacheTime < oldest->second.cacheTime)
-          {
-            oldest = it;
-          }
-        }
-        thumbnailCache_.erase(oldest);
-      }
+      return;
     }
-    catch (const std::filesystem::filesystem_error &)
+
+    // The byte budget counts thumbnail files, not sources
+    std::error_code ec;
+    const auto thumbnailBytes = std::filesystem::file_size(PathFromUtf8(destFile), ec);
+    if (ec)
     {
-      // Ignore filesystem errors for cache updates
+      return;
     }
+    thumbnailIndex_.Insert(key, destFile, thumbnailBytes);
   }
 
   // Generate cache key for thumbnail
@@ -1470,11 +1837,40 @@ namespace fc_native_video_thumbnail
     return std::to_string(hasher(combined));
   }
 
-  // Update priority of a specific request
-  void FcNativeVideoThumbnailPlugin::UpdateRequestPriority(const std::string &requestId, ThumbnailPriority priority)
+  // Update priority of a queued request; false if it is no longer queued
+  bool FcNativeVideoThumbnailPlugin::UpdateRequestPriority(const std::string &requestId, ThumbnailPriority priority)
   {
-    std::lock_guard<std::mutex> lock(priorityMutex_);
-    requestPriorities_[requestId] = priority;
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return requestQueue_.Reprioritize(requestId, priority);
+  }
+
+  // Drop queued requests and answer them with false; returns how many were queued
+  size_t FcNativeVideoThumbnailPlugin::CancelRequests(const std::vector<std::string> &requestIds)
+  {
+    std::vector<std::unique_ptr<ThumbnailRequest>> cancelled;
+    {
+      std::lock_guard<std::mutex> lock(queueMutex_);
+      for (const auto &requestId : requestIds)
+      {
+        if (auto request = requestQueue_.Remove(requestId))
+        {
+          cancelled.push_back(std::move(request));
+        }
+      }
+    }
+
+    for (auto &request : cancelled)
+    {
+      {
+        std::lock_guard<std::mutex> lock(activeRequestsMutex_);
+        activeRequests_.erase(request->requestId);
+      }
+      if (request->result)
+      {
+        request->result->Success(flutter::EncodableValue(false));
+      }
+    }
+    return cancelled.size();
   }
 
   // Set visible thumbnails for priority management
@@ -1,13 +1,18 @@
 #ifndef FLUTTER_PLUGIN_FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN_H_
 #define FLUTTER_PLUGIN_FC_NATIVE_VIDEO_THUMBNAIL_PLUGIN_H_
 
+#include <flutter/event_channel.h>
+#include <flutter/event_sink.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <gdiplus.h>
 
+#include "thumbnail_executor.h"
+#include "thumbnail_index.h"
+#include "thumbnail_request_queue.h"
+
 #include <memory>
 #include <thread>
-#include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
@@ -21,55 +26,26 @@
 namespace fc_native_video_thumbnail
 {
 
-    // Priority levels for thumbnail requests
-    enum class ThumbnailPriority
-    {
-        LOW = 0,    // Background thumbnails not visible
-        NORMAL = 1, // Default priority
-        HIGH = 2,   // Visible on screen
-        URGENT = 3  // Currently focused/selected item
-    };
-
-    // Thumbnail request structure for async processing
-    struct ThumbnailRequest
+    // One item of a generateBatch call
+    struct BatchItem
     {
+        int64_t index;
         std::string srcFile;
         std::string destFile;
         int width;
-        std::string format;
-        int timeSeconds;
-        int quality;
-        std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result;
-        std::string requestId;
-        ThumbnailPriority priority;
-        std::chrono::steady_clock::time_point requestTime;
-
-        // Constructor
-        ThumbnailRequest() : priority(ThumbnailPriority::NORMAL), requestTime(std::chrono::steady_clock::now()) {}
+        int timeSeconds;   // < 0 uses the shell thumbnail cache
+        double percentage; // >= 0 extracts with FFmpeg at this share of the duration
     };
 
-    // Priority queue comparator for thumbnail requests
-    struct ThumbnailRequestComparator
+    // Shared by the tasks of one batch
+    struct BatchState
     {
-        bool operator()(const std::unique_ptr<ThumbnailRequest> &a, const std::unique_ptr<ThumbnailRequest> &b) const
-        {
-            // Higher priority first
-            if (a->priority != b->priority)
-            {
-                return static_cast<int>(a->priority) < static_cast<int>(b->priority);
-            }
-            // If same priority, older requests first (FIFO within same priority)
-            return a->requestTime > b->requestTime;
-        }
-    };
-
-    // Thumbnail cache entry
-    struct CacheEntry
-    {
-        std::string thumbnailPath;
-        int64_t lastModified;
-        int64_t fileSize;
-        std::chrono::system_clock::time_point cacheTime;
+        int64_t batchId;
+        std::string format;
+        int quality;
+        bool keyframeOnly;
+        std::atomic<bool> cancelled{false};
+        std::atomic<size_t> remaining{0};
     };
 
     // Helper function to get the CLSID of an image encoder
@@ -89,7 +65,7 @@ namespace fc_native_video_thumbnail
     public:
         static void RegisterWithRegistrar(flutter::PluginRegistrarWindows *registrar);
 
-        FcNativeVideoThumbnailPlugin();
+        explicit FcNativeVideoThumbnailPlugin(flutter::PluginRegistrarWindows *registrar);
 
         virtual ~FcNativeVideoThumbnailPlugin();
 
@@ -105,36 +81,53 @@ namespace fc_native_video_thumbnail
 
         // Async thumbnail processing methods
         void ProcessThumbnailAsync(std::unique_ptr<ThumbnailRequest> request);
-        void WorkerThread();
-        bool IsThumbnailCached(const std::string &srcFile, const std::string &destFile);
-        void UpdateCache(const std::string &srcFile, const std::string &destFile);
+        void RunNextRequest();
+        bool IsThumbnailCached(const std::string &srcFile, const std::string &destFile, int width, const std::string &format);
+        void UpdateCache(const std::string &srcFile, const std::string &destFile, int width, const std::string &format);
         std::string GenerateCacheKey(const std::string &srcFile, int width, const std::string &format);
 
+        // Batch generation: results are collected off-thread and delivered on
+        // the platform thread in chunks over the batch event channel
+        int64_t StartBatch(const flutter::EncodableMap &args);
+        void ProcessBatchItem(const BatchItem &item, const std::shared_ptr<BatchState> &batch);
+        void PostBatchResult(flutter::EncodableValue result);
+        void FlushBatchResults();
+        bool CancelBatch(int64_t batchId);
+
         // Priority management methods
-        void UpdateRequestPriority(const std::string &requestId, ThumbnailPriority priority);
+        bool UpdateRequestPriority(const std::string &requestId, ThumbnailPriority priority);
+        size_t CancelRequests(const std::vector<std::string> &requestIds);
         void SetVisibleThumbnails(const std::vector<std::string> &visibleFiles);
         void SetFocusedThumbnail(const std::string &focusedFile);
         ThumbnailPriority DeterminePriority(const std::string &srcFile);
 
-        // Thread pool and priority queue management
-        std::vector<std::thread> workers_;
-        std::vector<std::unique_ptr<ThumbnailRequest>> requestQueue_;
+        // Work-stealing pool and priority queue management
+        std::unique_ptr<ThumbnailExecutor> executor_;
+        ThumbnailRequestQueue requestQueue_;
         std::mutex queueMutex_;
-        std::condition_variable queueCondition_;
         std::atomic<bool> shutdown_;
 
-        // Request tracking for priority updates
-        std::unordered_map<std::string, ThumbnailPriority> requestPriorities_;
-        std::mutex priorityMutex_;
-
         // Visibility tracking for priority management
         std::unordered_set<std::string> visibleFiles_;
         std::string focusedFile_;
         std::mutex visibilityMutex_;
 
-        // Cache management
-        std::unordered_map<std::string, CacheEntry> thumbnailCache_;
-        std::mutex cacheMutex_;
+        // Batch delivery
+        flutter::PluginRegistrarWindows *registrar_;
+        int windowProcDelegateId_;
+        HWND batchWindow_;
+        std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> batchEventChannel_;
+        std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> batchSink_; // Platform thread only
+        std::unordered_map<int64_t, std::shared_ptr<BatchState>> batches_;
+        std::vector<flutter::EncodableValue> batchResults_;
+        bool batchFlushPosted_;
+        int64_t nextBatchId_;
+        std::mutex batchMutex_;
+        static constexpr UINT kBatchFlushMessage = WM_APP + 0x146;
+        static constexpr size_t kMaxBatchChunk = 64;
+
+        // Cache management; stays closed (every lookup misses) until Dart opens it
+        ThumbnailIndex thumbnailIndex_;
 
         // Active request tracking to prevent duplicates
         std::unordered_set<std::string> activeRequests_;
@@ -1,21 +1,15 @@
 #ifndef FFMPEG_THUMBNAIL_HELPER_H_
 #define FFMPEG_THUMBNAIL_HELPER_H_
 
-extern "C"
-{
-#include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
-#include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
-}
-
 #include <string>
 #include <windows.h>
-#include <gdiplus.h>
 
 namespace fc_native_video_thumbnail
 {
 
+    // Windows adapter over the portable thumbnail_core library: converts
+    // UTF-16 paths and GDI+ format GUIDs, then lets the core decode, scale,
+    // encode and write the image.
     class FFmpegThumbnailHelper
     {
     public:
@@ -26,18 +20,24 @@ namespace fc_native_video_thumbnail
             int width,
             REFGUID format,
             int timeSeconds,
-            int quality = 95);
+            int quality = 95,
+            bool keyframeOnly = false);
 
         // Extract thumbnail at a percentage of video duration (single file open)
         // This is more efficient than calling GetVideoDuration + ExtractThumbnail separately
         // percentage: 0.0 to 100.0
+        // keyframeOnly: use the nearest keyframe instead of an exact frame
+        // representativeFrame: ignore percentage and pick the keyframe with the
+        // most detail, skipping black, blown-out and flat frames
         static std::string ExtractThumbnailAtPercentage(
             const wchar_t *srcFile,
             const wchar_t *destFile,
             int width,
             REFGUID format,
             double percentage,
-            int quality = 95);
+            int quality = 95,
+            bool keyframeOnly = false,
+            bool representativeFrame = false);
 
         // Get video duration in seconds using FFmpeg
         // Returns -1 on error
@@ -46,17 +46,8 @@ namespace fc_native_video_thumbnail
     private:
         // Convert UTF-16 to UTF-8
         static std::string WideToUtf8(const wchar_t *wide);
-
-        // Convert image format in memory
-        static bool SaveImage(
-            AVFrame *frame,
-            int width,
-            int height,
-            const wchar_t *destFile,
-            REFGUID format,
-            int quality = 95);
     };
 
 } // namespace fc_native_video_thumbnail
 
-#endif // FFMPEG_THUMBNAIL_HELPER_H_
\ No newline at end of file
+#endif // FFMPEG_THUMBNAIL_HELPER_H_
@@ -0,0 +1,154 @@
+#include "thumbnail_executor.h"
+
+#include <windows.h>
+#include <objbase.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace fc_native_video_thumbnail
+{
+
+    namespace
+    {
+        // Lets Submit recognise calls made from one of this pool's workers
+        thread_local const ThumbnailExecutor *currentExecutor = nullptr;
+        thread_local size_t currentWorker = 0;
+    } // namespace
+
+    ThumbnailExecutor::ThumbnailExecutor(size_t workerCount)
+        : pending_(0), stopping_(false), nextWorker_(0), running_(0)
+    {
+        if (workerCount == 0)
+        {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        workers_.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; ++i)
+        {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+
+        threads_.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; ++i)
+        {
+            threads_.emplace_back(&ThumbnailExecutor::Run, this, i);
+        }
+    }
+
+    ThumbnailExecutor::~ThumbnailExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+
+        for (auto &thread : threads_)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+    }
+
+    void ThumbnailExecutor::Submit(Task task)
+    {
+        const size_t index = currentExecutor == this
+                                 ? currentWorker
+                                 : nextWorker_.fetch_add(1) % workers_.size();
+        {
+            std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+            workers_[index]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            pending_++;
+        }
+        wake_.notify_one();
+    }
+
+    // Newest task from our own deque, else the oldest from someone else's
+    bool ThumbnailExecutor::TryTake(size_t index, Task &task)
+    {
+        {
+            Worker &own = *workers_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < workers_.size(); ++offset)
+        {
+            Worker &victim = *workers_[(index + offset) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ThumbnailExecutor::Run(size_t index)
+    {
+        const HRESULT coInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        const bool coInitialized = (coInit == S_OK || coInit == S_FALSE);
+
+        currentExecutor = this;
+        currentWorker = index;
+
+        while (true)
+        {
+            Task task;
+            if (TryTake(index, task))
+            {
+                bool stopping = false;
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex_);
+                    pending_--;
+                    stopping = stopping_;
+                }
+                if (stopping)
+                {
+                    break;
+                }
+
+                running_++;
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    // A failing job must not take the worker down with it
+                }
+                running_--;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait(lock, [this]
+                       { return stopping_ || pending_ > 0; });
+            if (stopping_)
+            {
+                break;
+            }
+        }
+
+        currentExecutor = nullptr;
+        if (coInitialized)
+        {
+            CoUninitialize();
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
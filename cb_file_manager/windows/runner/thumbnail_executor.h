@@ -0,0 +1,67 @@
+#ifndef THUMBNAIL_EXECUTOR_H_
+#define THUMBNAIL_EXECUTOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fc_native_video_thumbnail
+{
+
+    // Work-stealing pool for thumbnail jobs. Each worker owns a deque: tasks
+    // submitted from a worker go to its own deque (LIFO, cache-warm), tasks
+    // from other threads are spread round-robin, and an idle worker steals the
+    // oldest task from a busy one. Workers join the COM MTA so MediaFoundation
+    // and the shell thumbnail cache can be used from any task.
+    class ThumbnailExecutor
+    {
+    public:
+        using Task = std::function<void()>;
+
+        // workerCount 0 = one worker per hardware thread
+        explicit ThumbnailExecutor(size_t workerCount = 0);
+
+        // Pending tasks are dropped; running ones finish first
+        ~ThumbnailExecutor();
+
+        ThumbnailExecutor(const ThumbnailExecutor &) = delete;
+        ThumbnailExecutor &operator=(const ThumbnailExecutor &) = delete;
+
+        void Submit(Task task);
+
+        size_t WorkerCount() const { return workers_.size(); }
+
+        // Tasks currently executing; callers use it to size per-job threading
+        size_t RunningCount() const { return running_.load(); }
+
+    private:
+        struct Worker
+        {
+            std::deque<Task> tasks;
+            std::mutex mutex;
+        };
+
+        void Run(size_t index);
+        bool TryTake(size_t index, Task &task);
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+
+        // Sleeping workers wait here; pending_ counts tasks in all deques
+        std::mutex wakeMutex_;
+        std::condition_variable wake_;
+        size_t pending_;
+        bool stopping_;
+
+        std::atomic<size_t> nextWorker_;
+        std::atomic<size_t> running_;
+    };
+
+} // namespace fc_native_video_thumbnail
+
+#endif // THUMBNAIL_EXECUTOR_H_
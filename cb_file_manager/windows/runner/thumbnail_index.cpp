@@ -0,0 +1,405 @@
+#include "thumbnail_index.h"
+
+#include <cstring>
+
+namespace fc_native_video_thumbnail
+{
+
+    namespace
+    {
+        constexpr uint32_t kIndexMagic = 0x49544346; // "FCTI"
+        constexpr uint32_t kIndexVersion = 2;
+        constexpr uint32_t kNoSlot = 0xFFFFFFFFu;
+        constexpr size_t kMaxDestPath = 480;
+
+        // FNV-1a; stable across runs, unlike std::hash
+        uint64_t Fnv1a(uint64_t hash, const void *data, size_t size)
+        {
+            const uint8_t *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        uint64_t HashKey(const ThumbnailKey &key)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            hash = Fnv1a(hash, key.srcPath.data(), key.srcPath.size() + 1);
+            hash = Fnv1a(hash, &key.fileSize, sizeof(key.fileSize));
+            hash = Fnv1a(hash, &key.lastWriteTime, sizeof(key.lastWriteTime));
+            hash = Fnv1a(hash, &key.width, sizeof(key.width));
+            hash = Fnv1a(hash, key.format.data(), key.format.size());
+            return hash;
+        }
+
+        uint64_t HashPath(const std::string &path)
+        {
+            const uint64_t hash = Fnv1a(14695981039346656037ull, path.data(), path.size());
+            // 0 marks a free record
+            return hash == 0 ? 1 : hash;
+        }
+
+        std::wstring WideFromUtf8(const std::string &utf8)
+        {
+            if (utf8.empty())
+            {
+                return std::wstring();
+            }
+            int size = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), static_cast<int>(utf8.size()), nullptr, 0);
+            std::wstring wide(size, 0);
+            MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), static_cast<int>(utf8.size()), &wide[0], size);
+            return wide;
+        }
+    } // namespace
+
+    struct ThumbnailIndex::Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t bucketCount;
+        uint32_t count;
+        uint32_t freeHead; // Chained through Record::hashNext
+        uint32_t lruHead;  // Most recently used
+        uint32_t lruTail;
+        uint64_t totalBytes;
+        uint32_t clean; // Set on Close, cleared while open
+        uint32_t reserved;
+    };
+
+    struct ThumbnailIndex::Record
+    {
+        uint64_t pathHash; // 0 = free
+        uint64_t keyHash;  // What the file was generated from
+        uint64_t thumbnailBytes;
+        uint32_t hashNext;
+        uint32_t lruPrev;
+        uint32_t lruNext;
+        uint32_t reserved;
+        char destPath[kMaxDestPath]; // UTF-8, NUL-terminated
+    };
+
+    ThumbnailIndex::ThumbnailIndex()
+        : file_(INVALID_HANDLE_VALUE),
+          mapping_(nullptr),
+          view_(nullptr),
+          header_(nullptr),
+          byteBudget_(kDefaultByteBudget)
+    {
+    }
+
+    ThumbnailIndex::~ThumbnailIndex()
+    {
+        Close();
+    }
+
+    bool ThumbnailIndex::Open(const std::wstring &path, uint32_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (header_ || capacity == 0)
+        {
+            return header_ != nullptr;
+        }
+
+        const uint32_t bucketCount = capacity; // Load factor <= 1
+        const uint64_t size = sizeof(Header) + sizeof(uint32_t) * static_cast<uint64_t>(bucketCount) +
+                              sizeof(Record) * static_cast<uint64_t>(capacity);
+
+        // No sharing: a second instance runs without an index rather than corrupting it
+        file_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER existingSize;
+        const bool sizeMatches = GetFileSizeEx(file_, &existingSize) &&
+                                 static_cast<uint64_t>(existingSize.QuadPart) == size;
+        if (!sizeMatches)
+        {
+            LARGE_INTEGER newSize;
+            newSize.QuadPart = static_cast<LONGLONG>(size);
+            if (!SetFilePointerEx(file_, newSize, nullptr, FILE_BEGIN) || !SetEndOfFile(file_))
+            {
+                CloseHandle(file_);
+                file_ = INVALID_HANDLE_VALUE;
+                return false;
+            }
+        }
+
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        view_ = mapping_ ? static_cast<uint8_t *>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, 0)) : nullptr;
+        if (!view_)
+        {
+            if (mapping_)
+            {
+                CloseHandle(mapping_);
+                mapping_ = nullptr;
+            }
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+            return false;
+        }
+        header_ = reinterpret_cast<Header *>(view_);
+
+        // Links may be half-updated after a crash; start over rather than trust them
+        if (!sizeMatches || header_->magic != kIndexMagic || header_->version != kIndexVersion ||
+            header_->capacity != capacity || header_->bucketCount != bucketCount || !header_->clean)
+        {
+            Reset(capacity);
+        }
+        header_->clean = 0;
+        FlushViewOfFile(view_, sizeof(Header));
+        return true;
+    }
+
+    void ThumbnailIndex::Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!header_)
+        {
+            return;
+        }
+
+        header_->clean = 1;
+        FlushViewOfFile(view_, 0);
+        UnmapViewOfFile(view_);
+        CloseHandle(mapping_);
+        CloseHandle(file_);
+        view_ = nullptr;
+        header_ = nullptr;
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+    }
+
+    bool ThumbnailIndex::IsOpen()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return header_ != nullptr;
+    }
+
+    void ThumbnailIndex::SetByteBudget(uint64_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        byteBudget_ = bytes;
+        if (header_)
+        {
+            EvictToFit(0);
+        }
+    }
+
+    bool ThumbnailIndex::Lookup(const ThumbnailKey &key, const std::string &destPath)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!header_)
+        {
+            return false;
+        }
+
+        const uint64_t pathHash = HashPath(destPath);
+        const uint32_t slot = Find(destPath, pathHash, static_cast<uint32_t>(pathHash % header_->bucketCount));
+        if (slot == kNoSlot || RecordAt(slot)->keyHash != HashKey(key))
+        {
+            return false;
+        }
+
+        Unlink(slot);
+        LinkFront(slot);
+        return true;
+    }
+
+    void ThumbnailIndex::Insert(const ThumbnailKey &key, const std::string &destPath, uint64_t thumbnailBytes)
+    {
+        if (destPath.size() >= kMaxDestPath)
+        {
+            return; // Not indexed; lookups just miss
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!header_)
+        {
+            return;
+        }
+
+        const uint64_t pathHash = HashPath(destPath);
+        const uint32_t bucket = static_cast<uint32_t>(pathHash % header_->bucketCount);
+        uint32_t slot = Find(destPath, pathHash, bucket);
+        if (slot != kNoSlot)
+        {
+            // The file was just overwritten, so the old record goes but not the file
+            Evict(slot, false);
+        }
+
+        EvictToFit(thumbnailBytes);
+        if (header_->freeHead == kNoSlot)
+        {
+            return;
+        }
+
+        slot = header_->freeHead;
+        Record *record = RecordAt(slot);
+        header_->freeHead = record->hashNext;
+
+        record->pathHash = pathHash;
+        record->keyHash = HashKey(key);
+        record->thumbnailBytes = thumbnailBytes;
+        memcpy(record->destPath, destPath.c_str(), destPath.size() + 1);
+        record->hashNext = Buckets()[bucket];
+        Buckets()[bucket] = slot;
+        LinkFront(slot);
+
+        header_->count++;
+        header_->totalBytes += thumbnailBytes;
+    }
+
+    bool ThumbnailIndex::StatSource(const std::wstring &srcPath, int64_t *fileSize, int64_t *lastWriteTime)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(srcPath.c_str(), GetFileExInfoStandard, &data))
+        {
+            return false;
+        }
+        *fileSize = (static_cast<int64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        *lastWriteTime = (static_cast<int64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                         data.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+
+    void ThumbnailIndex::Reset(uint32_t capacity)
+    {
+        memset(view_, 0, sizeof(Header) + sizeof(uint32_t) * static_cast<size_t>(capacity));
+        header_->magic = kIndexMagic;
+        header_->version = kIndexVersion;
+        header_->capacity = capacity;
+        header_->bucketCount = capacity;
+        header_->count = 0;
+        header_->lruHead = kNoSlot;
+        header_->lruTail = kNoSlot;
+        header_->totalBytes = 0;
+
+        uint32_t *buckets = Buckets();
+        for (uint32_t i = 0; i < capacity; ++i)
+        {
+            buckets[i] = kNoSlot;
+        }
+
+        // Every record starts on the free list, in order
+        for (uint32_t i = 0; i < capacity; ++i)
+        {
+            Record *record = RecordAt(i);
+            record->pathHash = 0;
+            record->keyHash = 0;
+            record->hashNext = i + 1 < capacity ? i + 1 : kNoSlot;
+            record->lruPrev = kNoSlot;
+            record->lruNext = kNoSlot;
+            record->destPath[0] = '\0';
+        }
+        header_->freeHead = 0;
+    }
+
+    uint32_t ThumbnailIndex::Find(const std::string &destPath, uint64_t pathHash, uint32_t bucket) const
+    {
+        for (uint32_t slot = Buckets()[bucket]; slot != kNoSlot; slot = RecordAt(slot)->hashNext)
+        {
+            const Record *record = RecordAt(slot);
+            if (record->pathHash == pathHash && destPath.compare(record->destPath) == 0)
+            {
+                return slot;
+            }
+        }
+        return kNoSlot;
+    }
+
+    void ThumbnailIndex::LinkFront(uint32_t slot)
+    {
+        Record *record = RecordAt(slot);
+        record->lruPrev = kNoSlot;
+        record->lruNext = header_->lruHead;
+        if (header_->lruHead != kNoSlot)
+        {
+            RecordAt(header_->lruHead)->lruPrev = slot;
+        }
+        header_->lruHead = slot;
+        if (header_->lruTail == kNoSlot)
+        {
+            header_->lruTail = slot;
+        }
+    }
+
+    void ThumbnailIndex::Unlink(uint32_t slot)
+    {
+        Record *record = RecordAt(slot);
+        if (record->lruPrev != kNoSlot)
+        {
+            RecordAt(record->lruPrev)->lruNext = record->lruNext;
+        }
+        else
+        {
+            header_->lruHead = record->lruNext;
+        }
+        if (record->lruNext != kNoSlot)
+        {
+            RecordAt(record->lruNext)->lruPrev = record->lruPrev;
+        }
+        else
+        {
+            header_->lruTail = record->lruPrev;
+        }
+        record->lruPrev = kNoSlot;
+        record->lruNext = kNoSlot;
+    }
+
+    // Drop a record (and optionally its thumbnail file) and return it to the free list
+    void ThumbnailIndex::Evict(uint32_t slot, bool deleteFile)
+    {
+        Record *record = RecordAt(slot);
+
+        // Unhook from the hash chain; chains stay short at load factor <= 1
+        uint32_t *link = &Buckets()[record->pathHash % header_->bucketCount];
+        while (*link != slot)
+        {
+            link = &RecordAt(*link)->hashNext;
+        }
+        *link = record->hashNext;
+
+        Unlink(slot);
+        if (deleteFile)
+        {
+            DeleteFileW(WideFromUtf8(record->destPath).c_str());
+        }
+
+        header_->count--;
+        header_->totalBytes -= record->thumbnailBytes;
+        record->pathHash = 0;
+        record->keyHash = 0;
+        record->thumbnailBytes = 0;
+        record->destPath[0] = '\0';
+        record->hashNext = header_->freeHead;
+        header_->freeHead = slot;
+    }
+
+    void ThumbnailIndex::EvictToFit(uint64_t incomingBytes)
+    {
+        while (header_->lruTail != kNoSlot &&
+               (header_->freeHead == kNoSlot || header_->totalBytes + incomingBytes > byteBudget_))
+        {
+            Evict(header_->lruTail, true);
+        }
+    }
+
+    ThumbnailIndex::Record *ThumbnailIndex::RecordAt(uint32_t slot) const
+    {
+        uint8_t *records = view_ + sizeof(Header) + sizeof(uint32_t) * static_cast<size_t>(header_->bucketCount);
+        return reinterpret_cast<Record *>(records) + slot;
+    }
+
+    uint32_t *ThumbnailIndex::Buckets() const
+    {
+        return reinterpret_cast<uint32_t *>(view_ + sizeof(Header));
+    }
+
+} // namespace fc_native_video_thumbnail
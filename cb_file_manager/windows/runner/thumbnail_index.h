@@ -0,0 +1,85 @@
+#ifndef THUMBNAIL_INDEX_H_
+#define THUMBNAIL_INDEX_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace fc_native_video_thumbnail
+{
+
+    // What a thumbnail was generated from; any change means a new thumbnail
+    struct ThumbnailKey
+    {
+        std::string srcPath;
+        int64_t fileSize;
+        int64_t lastWriteTime; // FILETIME ticks
+        int width;
+        std::string format;
+    };
+
+    // Persistent thumbnail index in a memory-mapped file, so a restart does
+    // not have to re-validate every thumbnail. There is one fixed-size record
+    // per thumbnail file, hashed by its path and holding the key it was
+    // generated from. Records live in a chained hash table and an intrusive
+    // LRU list (both by record number), which keeps lookup, promotion and
+    // eviction O(1). Several keys (an edited video, another width) may map
+    // to the same file, so a record only ever owns one file and evicting it
+    // deletes that file to keep the total under the byte budget.
+    //
+    // The file is opened without sharing, so a second app instance simply
+    // runs without an index. A file that was not closed cleanly is reset.
+    class ThumbnailIndex
+    {
+    public:
+        static constexpr uint32_t kDefaultCapacity = 16384;
+        static constexpr uint64_t kDefaultByteBudget = 512ull * 1024 * 1024;
+
+        ThumbnailIndex();
+        ~ThumbnailIndex();
+
+        ThumbnailIndex(const ThumbnailIndex &) = delete;
+        ThumbnailIndex &operator=(const ThumbnailIndex &) = delete;
+
+        bool Open(const std::wstring &path, uint32_t capacity = kDefaultCapacity);
+        void Close();
+        bool IsOpen();
+
+        // Evicts least recently used thumbnails until the total fits
+        void SetByteBudget(uint64_t bytes);
+
+        // True if destPath was last generated for key; marks it most recently used
+        bool Lookup(const ThumbnailKey &key, const std::string &destPath);
+
+        // Records destPath as generated for key, replacing what it held before
+        void Insert(const ThumbnailKey &key, const std::string &destPath, uint64_t thumbnailBytes);
+
+        // Read the key fields for srcPath from the file system
+        static bool StatSource(const std::wstring &srcPath, int64_t *fileSize, int64_t *lastWriteTime);
+
+    private:
+        struct Header;
+        struct Record;
+
+        void Reset(uint32_t capacity);
+        uint32_t Find(const std::string &destPath, uint64_t pathHash, uint32_t bucket) const;
+        void LinkFront(uint32_t slot);
+        void Unlink(uint32_t slot);
+        void Evict(uint32_t slot, bool deleteFile);
+        void EvictToFit(uint64_t incomingBytes);
+        Record *RecordAt(uint32_t slot) const;
+        uint32_t *Buckets() const;
+
+        std::mutex mutex_;
+        HANDLE file_;
+        HANDLE mapping_;
+        uint8_t *view_;
+        Header *header_;
+        uint64_t byteBudget_;
+    };
+
+} // namespace fc_native_video_thumbnail
+
+#endif // THUMBNAIL_INDEX_H_
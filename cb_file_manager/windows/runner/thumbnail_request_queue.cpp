@@ -0,0 +1,195 @@
+#include "thumbnail_request_queue.h"
+
+#include <utility>
+
+namespace fc_native_video_thumbnail
+{
+
+    std::unique_ptr<ThumbnailRequest> ThumbnailRequestQueue::Push(std::unique_ptr<ThumbnailRequest> request)
+    {
+        if (!request || index_.count(request->requestId) != 0)
+        {
+            return request;
+        }
+
+        heap_.push_back(Entry{nullptr, 0});
+        Place(heap_.size() - 1, Entry{std::move(request), nextSequence_++});
+        SiftUp(heap_.size() - 1);
+        return nullptr;
+    }
+
+    std::unique_ptr<ThumbnailRequest> ThumbnailRequestQueue::Pop()
+    {
+        if (heap_.empty())
+        {
+            return nullptr;
+        }
+        return RemoveAt(0);
+    }
+
+    std::unique_ptr<ThumbnailRequest> ThumbnailRequestQueue::Remove(const std::string &requestId)
+    {
+        auto it = index_.find(requestId);
+        if (it == index_.end())
+        {
+            return nullptr;
+        }
+        return RemoveAt(it->second);
+    }
+
+    bool ThumbnailRequestQueue::Reprioritize(const std::string &requestId, ThumbnailPriority priority)
+    {
+        auto it = index_.find(requestId);
+        if (it == index_.end())
+        {
+            return false;
+        }
+
+        const size_t slot = it->second;
+        const ThumbnailPriority previous = heap_[slot].request->priority;
+        heap_[slot].request->priority = priority;
+        if (priority > previous)
+        {
+            SiftUp(slot);
+        }
+        else if (priority < previous)
+        {
+            SiftDown(slot);
+        }
+        return true;
+    }
+
+    std::vector<std::unique_ptr<ThumbnailRequest>> ThumbnailRequestQueue::RemoveWithPriority(ThumbnailPriority priority)
+    {
+        std::vector<std::unique_ptr<ThumbnailRequest>> removed;
+        std::vector<Entry> kept;
+        kept.reserve(heap_.size());
+        for (auto &entry : heap_)
+        {
+            if (entry.request->priority == priority)
+            {
+                removed.push_back(std::move(entry.request));
+            }
+            else
+            {
+                kept.push_back(std::move(entry));
+            }
+        }
+
+        // Rebuild bottom-up (Floyd); cheaper than re-pushing each survivor
+        heap_.clear();
+        index_.clear();
+        heap_.resize(kept.size());
+        for (size_t slot = 0; slot < kept.size(); ++slot)
+        {
+            Place(slot, std::move(kept[slot]));
+        }
+        for (size_t slot = heap_.size() / 2; slot-- > 0;)
+        {
+            SiftDown(slot);
+        }
+        return removed;
+    }
+
+    std::vector<std::unique_ptr<ThumbnailRequest>> ThumbnailRequestQueue::Clear()
+    {
+        std::vector<std::unique_ptr<ThumbnailRequest>> removed;
+        removed.reserve(heap_.size());
+        for (auto &entry : heap_)
+        {
+            removed.push_back(std::move(entry.request));
+        }
+        heap_.clear();
+        index_.clear();
+        return removed;
+    }
+
+    // True if the request in slot a should run before the one in slot b
+    bool ThumbnailRequestQueue::Before(size_t a, size_t b) const
+    {
+        const ThumbnailRequest &left = *heap_[a].request;
+        const ThumbnailRequest &right = *heap_[b].request;
+        if (left.priority != right.priority)
+        {
+            return left.priority > right.priority;
+        }
+        return heap_[a].sequence < heap_[b].sequence;
+    }
+
+    void ThumbnailRequestQueue::Place(size_t slot, Entry entry)
+    {
+        index_[entry.request->requestId] = slot;
+        heap_[slot] = std::move(entry);
+    }
+
+    void ThumbnailRequestQueue::SiftUp(size_t slot)
+    {
+        while (slot > 0)
+        {
+            const size_t parent = (slot - 1) / 2;
+            if (!Before(slot, parent))
+            {
+                break;
+            }
+            Entry moving = std::move(heap_[slot]);
+            Place(slot, std::move(heap_[parent]));
+            Place(parent, std::move(moving));
+            slot = parent;
+        }
+    }
+
+    void ThumbnailRequestQueue::SiftDown(size_t slot)
+    {
+        const size_t count = heap_.size();
+        while (true)
+        {
+            const size_t left = slot * 2 + 1;
+            const size_t right = left + 1;
+            size_t best = slot;
+            if (left < count && Before(left, best))
+            {
+                best = left;
+            }
+            if (right < count && Before(right, best))
+            {
+                best = right;
+            }
+            if (best == slot)
+            {
+                break;
+            }
+            Entry moving = std::move(heap_[slot]);
+            Place(slot, std::move(heap_[best]));
+            Place(best, std::move(moving));
+            slot = best;
+        }
+    }
+
+    std::unique_ptr<ThumbnailRequest> ThumbnailRequestQueue::RemoveAt(size_t slot)
+    {
+        std::unique_ptr<ThumbnailRequest> removed = std::move(heap_[slot].request);
+        index_.erase(removed->requestId);
+
+        const size_t last = heap_.size() - 1;
+        if (slot != last)
+        {
+            Place(slot, std::move(heap_[last]));
+            heap_.pop_back();
+            // The moved-in entry may belong above or below this slot
+            if (slot > 0 && Before(slot, (slot - 1) / 2))
+            {
+                SiftUp(slot);
+            }
+            else
+            {
+                SiftDown(slot);
+            }
+        }
+        else
+        {
+            heap_.pop_back();
+        }
+        return removed;
+    }
+
+} // namespace fc_native_video_thumbnail
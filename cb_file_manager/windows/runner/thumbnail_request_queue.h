@@ -0,0 +1,96 @@
+#ifndef THUMBNAIL_REQUEST_QUEUE_H_
+#define THUMBNAIL_REQUEST_QUEUE_H_
+
+#include <flutter/encodable_value.h>
+#include <flutter/method_result.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fc_native_video_thumbnail
+{
+
+    // Priority levels for thumbnail requests
+    enum class ThumbnailPriority
+    {
+        LOW = 0,    // Background thumbnails not visible
+        NORMAL = 1, // Default priority
+        HIGH = 2,   // Visible on screen
+        URGENT = 3  // Currently focused/selected item
+    };
+
+    // Thumbnail request structure for async processing
+    struct ThumbnailRequest
+    {
+        std::string srcFile;
+        std::string destFile;
+        int width;
+        std::string format;
+        int timeSeconds;
+        int quality;
+        std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result;
+        std::string requestId;
+        ThumbnailPriority priority;
+        std::chrono::steady_clock::time_point requestTime;
+
+        // Constructor
+        ThumbnailRequest() : priority(ThumbnailPriority::NORMAL), requestTime(std::chrono::steady_clock::now()) {}
+    };
+
+    // Indexed binary max-heap of pending requests: highest priority first,
+    // FIFO within a priority. The requestId -> slot index makes reprioritising
+    // and cancelling a queued request O(log n) instead of a scan plus re-sort.
+    // Not synchronised; the plugin guards it with its queue mutex.
+    class ThumbnailRequestQueue
+    {
+    public:
+        ThumbnailRequestQueue() : nextSequence_(0) {}
+
+        // Takes ownership; returns the request back if its id is already queued
+        std::unique_ptr<ThumbnailRequest> Push(std::unique_ptr<ThumbnailRequest> request);
+
+        // Highest priority request, or nullptr when empty
+        std::unique_ptr<ThumbnailRequest> Pop();
+
+        // Removes a queued request; nullptr if it is not queued (already
+        // running, finished or never submitted)
+        std::unique_ptr<ThumbnailRequest> Remove(const std::string &requestId);
+
+        // Returns false if the request is not queued
+        bool Reprioritize(const std::string &requestId, ThumbnailPriority priority);
+
+        // Removes every request with the given priority (O(n), rebuilds the heap)
+        std::vector<std::unique_ptr<ThumbnailRequest>> RemoveWithPriority(ThumbnailPriority priority);
+
+        // Removes everything, in no particular order
+        std::vector<std::unique_ptr<ThumbnailRequest>> Clear();
+
+        bool Contains(const std::string &requestId) const { return index_.count(requestId) != 0; }
+        bool empty() const { return heap_.empty(); }
+        size_t size() const { return heap_.size(); }
+
+    private:
+        struct Entry
+        {
+            std::unique_ptr<ThumbnailRequest> request;
+            uint64_t sequence; // Submission order; ties on requestTime are common
+        };
+
+        bool Before(size_t a, size_t b) const;
+        void Place(size_t slot, Entry entry);
+        void SiftUp(size_t slot);
+        void SiftDown(size_t slot);
+        std::unique_ptr<ThumbnailRequest> RemoveAt(size_t slot);
+
+        std::vector<Entry> heap_;
+        std::unordered_map<std::string, size_t> index_;
+        uint64_t nextSequence_;
+    };
+
+} // namespace fc_native_video_thumbnail
+
+#endif // THUMBNAIL_REQUEST_QUEUE_H_
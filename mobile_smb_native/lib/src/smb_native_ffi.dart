@@ -1,5 +1,8 @@
+import 'dart:async';
+import 'dart:convert';
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:isolate';
 import 'dart:typed_data';
 import 'package:ffi/ffi.dart';
 
@@ -38,6 +41,30 @@ base class SmbDirectoryResult extends Struct {
   external int errorCode;
 }
 
+base class SmbDirEntry extends Struct {
+  external Pointer<Utf8> name;
+  @Uint64()
+  external int size;
+  @Uint64()
+  external int modifiedTime;
+  @Int32()
+  external int isDirectory;
+}
+
+base class SmbWalkOptions extends Struct {
+  @Uint32()
+  external int maxConnections;
+  @Uint32()
+  external int maxDepth;
+  @Uint32()
+  external int batchSize;
+  @Uint32()
+  external int reserved;
+  external Pointer<Utf8> include;
+  external Pointer<Utf8> exclude;
+  external Pointer<Int32> cancel;
+}
+
 base class ThumbnailResult extends Struct {
   external Pointer<Uint8> data;
   @Uint64()
@@ -62,6 +89,14 @@ typedef SmbDisconnectDart = void Function(Pointer<Void> context);
 typedef SmbIsConnectedNative = Int32 Function(Pointer<Void> context);
 typedef SmbIsConnectedDart = int Function(Pointer<Void> context);
 
+typedef SmbConfigureConnectionPoolNative = Int32 Function(
+    Size maxConnections, Uint32 idleTimeoutSeconds);
+typedef SmbConfigureConnectionPoolDart = int Function(
+    int maxConnections, int idleTimeoutSeconds);
+
+typedef SmbCloseIdleConnectionsNative = Void Function();
+typedef SmbCloseIdleConnectionsDart = void Function();
+
 typedef SmbOpenFileNative = Pointer<Void> Function(
     Pointer<Void> context, Pointer<Utf8> path);
 typedef SmbOpenFileDart = Pointer<Void> Function(
@@ -113,6 +148,80 @@ typedef SmbReadRangeAsyncDart = int Function(
     int endOffset,
     Pointer<Size> bytesRead);
 
+// Pipelined async range read with native completion callback
+typedef SmbReadCompleteCallbackNative = Void Function(Pointer<Void> fileHandle,
+    Int32 errorCode, Size bytesRead, Pointer<Void> userData);
+
+typedef SmbReadRangeAsyncCbNative = Int32 Function(
+    Pointer<Void> fileHandle,
+    Pointer<Uint8> buffer,
+    Size bufferSize,
+    Uint64 startOffset,
+    Uint64 endOffset,
+    Pointer<NativeFunction<SmbReadCompleteCallbackNative>> callback,
+    Pointer<Void> userData);
+typedef SmbReadRangeAsyncCbDart = int Function(
+    Pointer<Void> fileHandle,
+    Pointer<Uint8> buffer,
+    int bufferSize,
+    int startOffset,
+    int endOffset,
+    Pointer<NativeFunction<SmbReadCompleteCallbackNative>> callback,
+    Pointer<Void> userData);
+
+typedef SmbSetReadPipelineDepthNative = Int32 Function(
+    Pointer<Void> fileHandle, Size depth);
+typedef SmbSetReadPipelineDepthDart = int Function(
+    Pointer<Void> fileHandle, int depth);
+
+// Upload path with native write-behind
+typedef SmbOpenFileForWritingNative = Pointer<Void> Function(
+    Pointer<Void> context, Pointer<Utf8> path);
+typedef SmbOpenFileForWritingDart = Pointer<Void> Function(
+    Pointer<Void> context, Pointer<Utf8> path);
+
+typedef SmbWriteRangeNative = Int32 Function(Pointer<Void> fileHandle,
+    Pointer<Uint8> data, Size size, Uint64 offset, Pointer<Size> bytesWritten);
+typedef SmbWriteRangeDart = int Function(Pointer<Void> fileHandle,
+    Pointer<Uint8> data, int size, int offset, Pointer<Size> bytesWritten);
+
+typedef SmbWriteProgressCallbackNative = Void Function(Pointer<Void> fileHandle,
+    Int32 errorCode, Uint64 bytesWritten, Pointer<Void> userData);
+
+typedef SmbSetWriteProgressCallbackNative = Int32 Function(
+    Pointer<Void> fileHandle,
+    Pointer<NativeFunction<SmbWriteProgressCallbackNative>> callback,
+    Pointer<Void> userData);
+typedef SmbSetWriteProgressCallbackDart = int Function(
+    Pointer<Void> fileHandle,
+    Pointer<NativeFunction<SmbWriteProgressCallbackNative>> callback,
+    Pointer<Void> userData);
+
+typedef SmbWriteRangeAsyncNative = Int32 Function(
+    Pointer<Void> fileHandle, Pointer<Uint8> data, Size size, Uint64 offset);
+typedef SmbWriteRangeAsyncDart = int Function(
+    Pointer<Void> fileHandle, Pointer<Uint8> data, int size, int offset);
+
+typedef SmbFlushWritesNative = Int32 Function(Pointer<Void> fileHandle);
+typedef SmbFlushWritesDart = int Function(Pointer<Void> fileHandle);
+
+// Server-side copy within a share
+typedef SmbCopyProgressCallbackNative = Void Function(
+    Uint64 bytesCopied, Uint64 totalBytes, Pointer<Void> userData);
+
+typedef SmbServerCopyNative = Int32 Function(
+    Pointer<Void> context,
+    Pointer<Utf8> sourcePath,
+    Pointer<Utf8> destinationPath,
+    Pointer<NativeFunction<SmbCopyProgressCallbackNative>> callback,
+    Pointer<Void> userData);
+typedef SmbServerCopyDart = int Function(
+    Pointer<Void> context,
+    Pointer<Utf8> sourcePath,
+    Pointer<Utf8> destinationPath,
+    Pointer<NativeFunction<SmbCopyProgressCallbackNative>> callback,
+    Pointer<Void> userData);
+
 typedef SmbPrefetchRangeNative = Int32 Function(
     Pointer<Void> fileHandle, Uint64 startOffset, Uint64 endOffset);
 typedef SmbPrefetchRangeDart = int Function(
@@ -144,6 +253,20 @@ typedef SmbGetConnectionUrlNative = Pointer<Utf8> Function(
     Pointer<Void> context);
 typedef SmbGetConnectionUrlDart = Pointer<Utf8> Function(Pointer<Void> context);
 
+// Native loopback HTTP range server
+typedef SmbStartHttpProxyNative = Int32 Function(
+    Uint16 port, Pointer<Uint16> boundPort);
+typedef SmbStartHttpProxyDart = int Function(
+    int port, Pointer<Uint16> boundPort);
+
+typedef SmbStopHttpProxyNative = Void Function();
+typedef SmbStopHttpProxyDart = void Function();
+
+typedef SmbProxyUrlForNative = Pointer<Utf8> Function(
+    Pointer<Void> context, Pointer<Utf8> path);
+typedef SmbProxyUrlForDart = Pointer<Utf8> Function(
+    Pointer<Void> context, Pointer<Utf8> path);
+
 typedef SmbListDirectoryNative = SmbDirectoryResult Function(
     Pointer<Void> context, Pointer<Utf8> path);
 typedef SmbListDirectoryDart = SmbDirectoryResult Function(
@@ -154,6 +277,78 @@ typedef SmbFreeDirectoryResultNative = Void Function(
 typedef SmbFreeDirectoryResultDart = void Function(
     Pointer<SmbDirectoryResult> result);
 
+typedef SmbStatNative = Int32 Function(
+    Pointer<Void> context,
+    Pointer<Utf8> path,
+    Pointer<Uint64> size,
+    Pointer<Uint64> modifiedTime,
+    Pointer<Int32> isDirectory);
+typedef SmbStatDart = int Function(
+    Pointer<Void> context,
+    Pointer<Utf8> path,
+    Pointer<Uint64> size,
+    Pointer<Uint64> modifiedTime,
+    Pointer<Int32> isDirectory);
+
+typedef SmbSetMetadataCacheTtlNative = Int32 Function(
+    Pointer<Void> context, Uint32 ttlMs);
+typedef SmbSetMetadataCacheTtlDart = int Function(
+    Pointer<Void> context, int ttlMs);
+
+typedef SmbListDirectoryPackedNative = Int32 Function(
+    Pointer<Void> context,
+    Pointer<Utf8> path,
+    Pointer<Pointer<Uint8>> buffer,
+    Pointer<Size> size);
+typedef SmbListDirectoryPackedDart = int Function(
+    Pointer<Void> context,
+    Pointer<Utf8> path,
+    Pointer<Pointer<Uint8>> buffer,
+    Pointer<Size> size);
+
+typedef SmbFreePackedListingNative = Void Function(Pointer<Uint8> buffer);
+typedef SmbFreePackedListingDart = void Function(Pointer<Uint8> buffer);
+
+// Parallel recursive walk delivering packed batches
+typedef SmbWalkBatchCallbackNative = Void Function(
+    Pointer<Uint8> batch, Size size, Pointer<Void> userData);
+
+typedef SmbWalkTreeNative = Int32 Function(
+    Pointer<Void> context,
+    Pointer<Utf8> root,
+    Pointer<SmbWalkOptions> options,
+    Pointer<NativeFunction<SmbWalkBatchCallbackNative>> callback,
+    Pointer<Void> userData);
+typedef SmbWalkTreeDart = int Function(
+    Pointer<Void> context,
+    Pointer<Utf8> root,
+    Pointer<SmbWalkOptions> options,
+    Pointer<NativeFunction<SmbWalkBatchCallbackNative>> callback,
+    Pointer<Void> userData);
+
+typedef SmbOpenDirNative = Pointer<Void> Function(
+    Pointer<Void> context, Pointer<Utf8> path);
+typedef SmbOpenDirDart = Pointer<Void> Function(
+    Pointer<Void> context, Pointer<Utf8> path);
+
+typedef SmbReaddirBatchNative = Int32 Function(
+    Pointer<Void> dir,
+    Pointer<SmbDirEntry> entries,
+    Size maxEntries,
+    Pointer<Uint8> nameArena,
+    Size arenaSize,
+    Pointer<Size> count);
+typedef SmbReaddirBatchDart = int Function(
+    Pointer<Void> dir,
+    Pointer<SmbDirEntry> entries,
+    int maxEntries,
+    Pointer<Uint8> nameArena,
+    int arenaSize,
+    Pointer<Size> count);
+
+typedef SmbCloseDirNative = Void Function(Pointer<Void> dir);
+typedef SmbCloseDirDart = void Function(Pointer<Void> dir);
+
 typedef SmbGenerateThumbnailNative = ThumbnailResult Function(
     Pointer<Void> context, Pointer<Utf8> path, Int32 width, Int32 height);
 typedef SmbGenerateThumbnailDart = ThumbnailResult Function(
@@ -173,8 +368,11 @@ typedef SmbFreeStringDart = void Function(Pointer<Utf8> str);
 class SmbNativeFFI {
   late DynamicLibrary _dylib;
   late SmbConnectDart _smbConnect;
+  late Pointer<NativeFunction<SmbConnectNative>> _smbConnectPtr;
   late SmbDisconnectDart _smbDisconnect;
   late SmbIsConnectedDart _smbIsConnected;
+  SmbConfigureConnectionPoolDart? _smbConfigureConnectionPool;
+  SmbCloseIdleConnectionsDart? _smbCloseIdleConnections;
   late SmbOpenFileDart _smbOpenFile;
   late SmbCloseFileDart _smbCloseFile;
   late SmbReadChunkDart _smbReadChunk;
@@ -184,16 +382,39 @@ class SmbNativeFFI {
   // NEW: Enhanced read-range operations (nullable for fallback)
   SmbReadRangeDart? _smbReadRange;
   SmbReadRangeAsyncDart? _smbReadRangeAsync;
+  SmbReadRangeAsyncCbDart? _smbReadRangeAsyncCb;
+  SmbSetReadPipelineDepthDart? _smbSetReadPipelineDepth;
   SmbPrefetchRangeDart? _smbPrefetchRange;
   SmbSetStreamingOptionsDart? _smbSetStreamingOptions;
 
+  SmbOpenFileForWritingDart? _smbOpenFileForWriting;
+  SmbWriteRangeDart? _smbWriteRange;
+  SmbSetWriteProgressCallbackDart? _smbSetWriteProgressCallback;
+  SmbWriteRangeAsyncDart? _smbWriteRangeAsync;
+  SmbFlushWritesDart? _smbFlushWrites;
+  // Called from a helper isolate, which reuses the resolved symbol
+  Pointer<NativeFunction<SmbServerCopyNative>>? _smbServerCopyPtr;
+
   // NEW: SMB URL generation (nullable for fallback)
   SmbGenerateDirectUrlDart? _smbGenerateDirectUrl;
   SmbGenerateUrlWithCredentialsDart? _smbGenerateUrlWithCredentials;
   SmbGetConnectionUrlDart? _smbGetConnectionUrl;
 
+  SmbStartHttpProxyDart? _smbStartHttpProxy;
+  SmbStopHttpProxyDart? _smbStopHttpProxy;
+  SmbProxyUrlForDart? _smbProxyUrlFor;
+
   late SmbListDirectoryDart _smbListDirectory;
   late SmbFreeDirectoryResultDart _smbFreeDirectoryResult;
+  SmbStatDart? _smbStat;
+  SmbSetMetadataCacheTtlDart? _smbSetMetadataCacheTtl;
+  SmbListDirectoryPackedDart? _smbListDirectoryPacked;
+  SmbFreePackedListingDart? _smbFreePackedListing;
+  // Called from a helper isolate, which reuses the resolved symbol
+  Pointer<NativeFunction<SmbWalkTreeNative>>? _smbWalkTreePtr;
+  SmbOpenDirDart? _smbOpenDir;
+  SmbReaddirBatchDart? _smbReaddirBatch;
+  SmbCloseDirDart? _smbCloseDir;
   late SmbGenerateThumbnailDart _smbGenerateThumbnail;
   late SmbFreeThumbnailResultDart _smbFreeThumbnailResult;
   late SmbGetErrorMessageDart _smbGetErrorMessage;
@@ -225,9 +446,9 @@ class SmbNativeFFI {
   }
 
   void _bindFunctions() {
-    _smbConnect = _dylib
-        .lookup<NativeFunction<SmbConnectNative>>('smb_connect')
-        .asFunction();
+    _smbConnectPtr =
+        _dylib.lookup<NativeFunction<SmbConnectNative>>('smb_connect');
+    _smbConnect = _smbConnectPtr.asFunction();
 
     _smbDisconnect = _dylib
         .lookup<NativeFunction<SmbDisconnectNative>>('smb_disconnect')
@@ -237,6 +458,21 @@ class SmbNativeFFI {
         .lookup<NativeFunction<SmbIsConnectedNative>>('smb_is_connected')
         .asFunction();
 
+    try {
+      _smbConfigureConnectionPool = _dylib
+          .lookup<NativeFunction<SmbConfigureConnectionPoolNative>>(
+              'smb_configure_connection_pool')
+          .asFunction();
+      _smbCloseIdleConnections = _dylib
+          .lookup<NativeFunction<SmbCloseIdleConnectionsNative>>(
+              'smb_close_idle_connections')
+          .asFunction();
+    } catch (e) {
+      print('Warning: connection pool API not available, using fallback');
+      _smbConfigureConnectionPool = null;
+      _smbCloseIdleConnections = null;
+    }
+
     _smbOpenFile = _dylib
         .lookup<NativeFunction<SmbOpenFileNative>>('smb_open_file')
         .asFunction();
@@ -277,6 +513,68 @@ class SmbNativeFFI {
       _smbReadRangeAsync = null;
     }
 
+    try {
+      _smbReadRangeAsyncCb = _dylib
+          .lookup<NativeFunction<SmbReadRangeAsyncCbNative>>(
+              'smb_read_range_async_cb')
+          .asFunction();
+    } catch (e) {
+      print('Warning: smb_read_range_async_cb not available, using fallback');
+      _smbReadRangeAsyncCb = null;
+    }
+
+    try {
+      _smbSetReadPipelineDepth = _dylib
+          .lookup<NativeFunction<SmbSetReadPipelineDepthNative>>(
+              'smb_set_read_pipeline_depth')
+          .asFunction();
+    } catch (e) {
+      print(
+          'Warning: smb_set_read_pipeline_depth not available, using fallback');
+      _smbSetReadPipelineDepth = null;
+    }
+
+    try {
+      _smbOpenFileForWriting = _dylib
+          .lookup<NativeFunction<SmbOpenFileForWritingNative>>(
+              'smb_open_file_for_writing')
+          .asFunction();
+      _smbWriteRange = _dylib
+          .lookup<NativeFunction<SmbWriteRangeNative>>('smb_write_range')
+          .asFunction();
+    } catch (e) {
+      print('Warning: smb_write_range not available, using fallback');
+      _smbOpenFileForWriting = null;
+      _smbWriteRange = null;
+    }
+
+    try {
+      _smbSetWriteProgressCallback = _dylib
+          .lookup<NativeFunction<SmbSetWriteProgressCallbackNative>>(
+              'smb_set_write_progress_callback')
+          .asFunction();
+      _smbWriteRangeAsync = _dylib
+          .lookup<NativeFunction<SmbWriteRangeAsyncNative>>(
+              'smb_write_range_async')
+          .asFunction();
+      _smbFlushWrites = _dylib
+          .lookup<NativeFunction<SmbFlushWritesNative>>('smb_flush_writes')
+          .asFunction();
+    } catch (e) {
+      print('Warning: smb_write_range_async not available, using fallback');
+      _smbSetWriteProgressCallback = null;
+      _smbWriteRangeAsync = null;
+      _smbFlushWrites = null;
+    }
+
+    try {
+      _smbServerCopyPtr = _dylib
+          .lookup<NativeFunction<SmbServerCopyNative>>('smb_server_copy');
+    } catch (e) {
+      print('Warning: smb_server_copy not available, using fallback');
+      _smbServerCopyPtr = null;
+    }
+
     try {
       _smbPrefetchRange = _dylib
           .lookup<NativeFunction<SmbPrefetchRangeNative>>('smb_prefetch_range')
@@ -328,6 +626,25 @@ class SmbNativeFFI {
       _smbGetConnectionUrl = null;
     }
 
+    try {
+      _smbStartHttpProxy = _dylib
+          .lookup<NativeFunction<SmbStartHttpProxyNative>>(
+              'smb_start_http_proxy')
+          .asFunction();
+      _smbStopHttpProxy = _dylib
+          .lookup<NativeFunction<SmbStopHttpProxyNative>>(
+              'smb_stop_http_proxy')
+          .asFunction();
+      _smbProxyUrlFor = _dylib
+          .lookup<NativeFunction<SmbProxyUrlForNative>>('smb_proxy_url_for')
+          .asFunction();
+    } catch (e) {
+      print('Warning: native HTTP proxy not available, using fallback');
+      _smbStartHttpProxy = null;
+      _smbStopHttpProxy = null;
+      _smbProxyUrlFor = null;
+    }
+
     _smbListDirectory = _dylib
         .lookup<NativeFunction<SmbListDirectoryNative>>('smb_list_directory')
         .asFunction();
@@ -337,6 +654,60 @@ class SmbNativeFFI {
             'smb_free_directory_result')
         .asFunction();
 
+    try {
+      _smbStat = _dylib
+          .lookup<NativeFunction<SmbStatNative>>('smb_stat')
+          .asFunction();
+      _smbSetMetadataCacheTtl = _dylib
+          .lookup<NativeFunction<SmbSetMetadataCacheTtlNative>>(
+              'smb_set_metadata_cache_ttl')
+          .asFunction();
+    } catch (e) {
+      print('Warning: smb_stat not available, using fallback');
+      _smbStat = null;
+      _smbSetMetadataCacheTtl = null;
+    }
+
+    try {
+      _smbListDirectoryPacked = _dylib
+          .lookup<NativeFunction<SmbListDirectoryPackedNative>>(
+              'smb_list_directory_packed')
+          .asFunction();
+      _smbFreePackedListing = _dylib
+          .lookup<NativeFunction<SmbFreePackedListingNative>>(
+              'smb_free_packed_listing')
+          .asFunction();
+    } catch (e) {
+      print('Warning: packed directory listing not available, using fallback');
+      _smbListDirectoryPacked = null;
+      _smbFreePackedListing = null;
+    }
+
+    try {
+      _smbWalkTreePtr =
+          _dylib.lookup<NativeFunction<SmbWalkTreeNative>>('smb_walk_tree');
+    } catch (e) {
+      print('Warning: smb_walk_tree not available, using fallback');
+      _smbWalkTreePtr = null;
+    }
+
+    try {
+      _smbOpenDir = _dylib
+          .lookup<NativeFunction<SmbOpenDirNative>>('smb_opendir')
+          .asFunction();
+      _smbReaddirBatch = _dylib
+          .lookup<NativeFunction<SmbReaddirBatchNative>>('smb_readdir_batch')
+          .asFunction();
+      _smbCloseDir = _dylib
+          .lookup<NativeFunction<SmbCloseDirNative>>('smb_closedir')
+          .asFunction();
+    } catch (e) {
+      print('Warning: streaming directory API not available, using fallback');
+      _smbOpenDir = null;
+      _smbReaddirBatch = null;
+      _smbCloseDir = null;
+    }
+
     _smbGenerateThumbnail = _dylib
         .lookup<NativeFunction<SmbGenerateThumbnailNative>>(
             'smb_generate_thumbnail')
@@ -376,6 +747,38 @@ class SmbNativeFFI {
     }
   }
 
+  /// [connect] on a helper isolate, so the network round trips do not
+  /// block the calling isolate.
+  Future<Pointer<Void>?> connectInBackground(
+      String server, String share, String username, String password) async {
+    final address = await _connectInIsolate(
+        _smbConnectPtr.address, server, share, username, password);
+    return address == 0 ? null : Pointer<Void>.fromAddress(address);
+  }
+
+  // Kept apart from connectInBackground so the isolate closure captures only
+  // sendable values
+  static Future<int> _connectInIsolate(int connectAddress, String server,
+      String share, String username, String password) {
+    return Isolate.run(() {
+      final SmbConnectDart connect =
+          Pointer<NativeFunction<SmbConnectNative>>.fromAddress(connectAddress)
+              .asFunction();
+      final serverPtr = server.toNativeUtf8();
+      final sharePtr = share.toNativeUtf8();
+      final usernamePtr = username.toNativeUtf8();
+      final passwordPtr = password.toNativeUtf8();
+      try {
+        return connect(serverPtr, sharePtr, usernamePtr, passwordPtr).address;
+      } finally {
+        malloc.free(serverPtr);
+        malloc.free(sharePtr);
+        malloc.free(usernamePtr);
+        malloc.free(passwordPtr);
+      }
+    });
+  }
+
   void disconnect(Pointer<Void> context) {
     _smbDisconnect(context);
   }
@@ -384,6 +787,21 @@ class SmbNativeFFI {
     return _smbIsConnected(context) != 0;
   }
 
+  /// Limit pooled sessions and how long an idle one is kept warm.
+  /// [disconnect] returns a session to the pool rather than closing it.
+  bool configureConnectionPool(int maxConnections, int idleTimeoutSeconds) {
+    if (_smbConfigureConnectionPool == null) {
+      print('Warning: configureConnectionPool not available, using fallback');
+      return false;
+    }
+    return _smbConfigureConnectionPool!(maxConnections, idleTimeoutSeconds) ==
+        SmbErrorCodes.success;
+  }
+
+  void closeIdleConnections() {
+    _smbCloseIdleConnections?.call();
+  }
+
   // File operations
   Pointer<Void>? openFile(Pointer<Void> context, String path) {
     final pathPtr = path.toNativeUtf8();
@@ -480,6 +898,232 @@ class SmbNativeFFI {
     }
   }
 
+  /// Reads a range without blocking the calling isolate. The native side
+  /// keeps several requests in flight and completes from its worker thread.
+  Future<int> readRangePipelined(Pointer<Void> fileHandle, Uint8List buffer,
+      int startOffset, int endOffset) {
+    if (_smbReadRangeAsyncCb == null) {
+      return Future.value(
+          readRangeAsync(fileHandle, buffer, startOffset, endOffset));
+    }
+
+    final completer = Completer<int>();
+    final bufferPtr = malloc<Uint8>(buffer.length);
+    late final NativeCallable<SmbReadCompleteCallbackNative> callback;
+
+    void onComplete(Pointer<Void> handle, int errorCode, int bytesRead,
+        Pointer<Void> userData) {
+      if (errorCode == SmbErrorCodes.success) {
+        buffer.setRange(0, bytesRead, bufferPtr.asTypedList(bytesRead));
+        completer.complete(bytesRead);
+      } else {
+        completer.complete(0);
+      }
+      malloc.free(bufferPtr);
+      callback.close();
+    }
+
+    callback =
+        NativeCallable<SmbReadCompleteCallbackNative>.listener(onComplete);
+    final errorCode = _smbReadRangeAsyncCb!(fileHandle, bufferPtr, buffer.length,
+        startOffset, endOffset, callback.nativeFunction, nullptr);
+    if (errorCode != SmbErrorCodes.success) {
+      malloc.free(bufferPtr);
+      callback.close();
+      return Future.value(0);
+    }
+    return completer.future;
+  }
+
+  bool setReadPipelineDepth(Pointer<Void> fileHandle, int depth) {
+    if (_smbSetReadPipelineDepth == null) {
+      print('Warning: setReadPipelineDepth not available, using fallback');
+      return false;
+    }
+    return _smbSetReadPipelineDepth!(fileHandle, depth) ==
+        SmbErrorCodes.success;
+  }
+
+  /// Opens [path] for writing, creating or truncating it.
+  Pointer<Void>? openFileForWriting(Pointer<Void> context, String path) {
+    if (_smbOpenFileForWriting == null) {
+      print('Warning: openFileForWriting not available, using fallback');
+      return null;
+    }
+
+    final pathPtr = path.toNativeUtf8();
+    try {
+      final result = _smbOpenFileForWriting!(context, pathPtr);
+      return result.address == 0 ? null : result;
+    } finally {
+      malloc.free(pathPtr);
+    }
+  }
+
+  /// Writes [data] at [offset], blocking until it is on the server.
+  /// Returns the bytes written, or -1 on error.
+  int writeRange(Pointer<Void> fileHandle, Uint8List data, int offset) {
+    if (_smbWriteRange == null) {
+      print('Warning: writeRange not available, using fallback');
+      return -1;
+    }
+
+    final dataPtr = malloc<Uint8>(data.length);
+    final bytesWrittenPtr = malloc<Size>();
+    try {
+      dataPtr.asTypedList(data.length).setAll(0, data);
+      final errorCode = _smbWriteRange!(
+          fileHandle, dataPtr, data.length, offset, bytesWrittenPtr);
+      return errorCode == SmbErrorCodes.success ? bytesWrittenPtr.value : -1;
+    } finally {
+      malloc.free(dataPtr);
+      malloc.free(bytesWrittenPtr);
+    }
+  }
+
+  static const int _uploadChunkSize = 4 * 1024 * 1024;
+  static const int _maxUploadAhead = 32 * 1024 * 1024;
+
+  /// Uploads [localPath] to [remotePath], creating or replacing it. Chunks
+  /// go to the native write-behind queue, so reading the next one from disk
+  /// overlaps with the network. [onProgress] reports bytes on the server.
+  Future<bool> uploadFile(
+      Pointer<Void> context, String localPath, String remotePath,
+      {void Function(int bytesWritten, int totalBytes)? onProgress}) async {
+    if (_smbWriteRangeAsync == null || _smbOpenFileForWriting == null) {
+      print('Warning: uploadFile not available, using fallback');
+      return false;
+    }
+
+    final file = File(localPath);
+    final total = await file.length();
+    final input = await file.open();
+    final fileHandle = openFileForWriting(context, remotePath);
+    if (fileHandle == null) {
+      await input.close();
+      return false;
+    }
+
+    var written = 0;
+    var failed = false;
+    Completer<void>? progressed;
+
+    void onNativeProgress(Pointer<Void> handle, int errorCode,
+        int bytesWritten, Pointer<Void> userData) {
+      written = bytesWritten;
+      failed = failed || errorCode != SmbErrorCodes.success;
+      onProgress?.call(bytesWritten, total);
+      progressed?.complete();
+      progressed = null;
+    }
+
+    Future<void> nextProgress() {
+      progressed = Completer<void>();
+      return progressed!.future;
+    }
+
+    final callback = NativeCallable<SmbWriteProgressCallbackNative>.listener(
+        onNativeProgress);
+    final buffer = malloc<Uint8>(_uploadChunkSize);
+    var offset = 0;
+    try {
+      _smbSetWriteProgressCallback!(
+          fileHandle, callback.nativeFunction, nullptr);
+
+      while (offset < total && !failed) {
+        // Stay a few chunks ahead of the network rather than queueing the
+        // whole file natively
+        while (offset - written > _maxUploadAhead && !failed) {
+          await nextProgress();
+        }
+
+        final count =
+            await input.readInto(buffer.asTypedList(_uploadChunkSize));
+        if (count == 0) {
+          break;
+        }
+        if (_smbWriteRangeAsync!(fileHandle, buffer, count, offset) !=
+            SmbErrorCodes.success) {
+          failed = true;
+          break;
+        }
+        offset += count;
+      }
+
+      final flushed = _smbFlushWrites!(fileHandle) == SmbErrorCodes.success;
+      // Progress is posted to this isolate; let the last report arrive
+      while (flushed && !failed && written < offset) {
+        await nextProgress();
+      }
+      return flushed && !failed && offset == total;
+    } finally {
+      _smbSetWriteProgressCallback!(fileHandle, nullptr, nullptr);
+      closeFile(fileHandle);
+      malloc.free(buffer);
+      callback.close();
+      await input.close();
+    }
+  }
+
+  /// Copies [sourcePath] to [destinationPath] on the context's share. The
+  /// server moves the data itself when it supports server-side copy. The
+  /// blocking native call runs on a helper isolate; [onProgress] reports
+  /// bytes copied.
+  Future<bool> serverCopy(
+      Pointer<Void> context, String sourcePath, String destinationPath,
+      {void Function(int bytesCopied, int totalBytes)? onProgress}) async {
+    if (_smbServerCopyPtr == null) {
+      print('Warning: serverCopy not available, using fallback');
+      return false;
+    }
+
+    void onNativeProgress(
+        int bytesCopied, int totalBytes, Pointer<Void> userData) {
+      onProgress?.call(bytesCopied, totalBytes);
+    }
+
+    final callback = NativeCallable<SmbCopyProgressCallbackNative>.listener(
+        onNativeProgress);
+    try {
+      final errorCode = await _serverCopyInIsolate(
+          _smbServerCopyPtr!.address,
+          context.address,
+          sourcePath,
+          destinationPath,
+          callback.nativeFunction.address);
+      return errorCode == SmbErrorCodes.success;
+    } finally {
+      callback.close();
+    }
+  }
+
+  // Kept apart from serverCopy so the isolate closure captures only
+  // sendable values
+  static Future<int> _serverCopyInIsolate(int serverCopyAddress,
+      int contextAddress, String sourcePath, String destinationPath,
+      int callbackAddress) {
+    return Isolate.run(() {
+      final SmbServerCopyDart serverCopy =
+          Pointer<NativeFunction<SmbServerCopyNative>>.fromAddress(
+                  serverCopyAddress)
+              .asFunction();
+      final sourcePtr = sourcePath.toNativeUtf8();
+      final destinationPtr = destinationPath.toNativeUtf8();
+      try {
+        return serverCopy(
+            Pointer<Void>.fromAddress(contextAddress),
+            sourcePtr,
+            destinationPtr,
+            Pointer<NativeFunction<SmbCopyProgressCallbackNative>>.fromAddress(
+                callbackAddress),
+            nullptr);
+      } finally {
+        malloc.free(sourcePtr);
+        malloc.free(destinationPtr);
+      }
+    });
+  }
+
   bool prefetchRange(Pointer<Void> fileHandle, int startOffset, int endOffset) {
     if (_smbPrefetchRange == null) {
       print('Warning: prefetchRange not available, using fallback');
@@ -567,6 +1211,49 @@ class SmbNativeFFI {
     return null;
   }
 
+  /// Start the native loopback HTTP server that streams SMB files to media
+  /// players with Range support. Returns its port, or null if unavailable.
+  /// Calling it again returns the port of the running server.
+  int? startHttpProxy({int port = 0}) {
+    if (_smbStartHttpProxy == null) {
+      return null;
+    }
+
+    final boundPortPtr = malloc<Uint16>();
+    try {
+      final errorCode = _smbStartHttpProxy!(port, boundPortPtr);
+      return errorCode == SmbErrorCodes.success ? boundPortPtr.value : null;
+    } finally {
+      malloc.free(boundPortPtr);
+    }
+  }
+
+  /// Closes player connections; URLs from [proxyUrlFor] stop working.
+  void stopHttpProxy() {
+    _smbStopHttpProxy?.call();
+  }
+
+  /// Loopback URL serving [path] through [context]'s session. The session
+  /// stays open for the URL after [disconnect].
+  String? proxyUrlFor(Pointer<Void> context, String path) {
+    if (_smbProxyUrlFor == null) {
+      return null;
+    }
+
+    final pathPtr = path.toNativeUtf8();
+    try {
+      final urlPtr = _smbProxyUrlFor!(context, pathPtr);
+      if (urlPtr.address == 0) {
+        return null;
+      }
+      final url = urlPtr.toDartString();
+      _smbFreeString(urlPtr);
+      return url;
+    } finally {
+      malloc.free(pathPtr);
+    }
+  }
+
   // Directory operations
   List<Map<String, dynamic>> listDirectory(Pointer<Void> context, String path) {
     final pathPtr = path.toNativeUtf8();
@@ -600,6 +1287,277 @@ class SmbNativeFFI {
     return files;
   }
 
+  /// Stat a path; null if it does not exist. Paths in recently listed
+  /// folders are answered from the native metadata cache.
+  Map<String, dynamic>? stat(Pointer<Void> context, String path) {
+    if (_smbStat == null) {
+      print('Warning: stat not available, using fallback');
+      return null;
+    }
+
+    final pathPtr = path.toNativeUtf8();
+    final sizePtr = malloc<Uint64>();
+    final modifiedTimePtr = malloc<Uint64>();
+    final isDirectoryPtr = malloc<Int32>();
+
+    try {
+      final errorCode = _smbStat!(
+          context, pathPtr, sizePtr, modifiedTimePtr, isDirectoryPtr);
+      if (errorCode != SmbErrorCodes.success) {
+        return null;
+      }
+      return {
+        'path': path,
+        'size': sizePtr.value,
+        'modifiedTime': modifiedTimePtr.value,
+        'isDirectory': isDirectoryPtr.value != 0,
+      };
+    } finally {
+      malloc.free(pathPtr);
+      malloc.free(sizePtr);
+      malloc.free(modifiedTimePtr);
+      malloc.free(isDirectoryPtr);
+    }
+  }
+
+  /// How long cached metadata stays valid; 0 disables the cache.
+  bool setMetadataCacheTtl(Pointer<Void> context, Duration ttl) {
+    if (_smbSetMetadataCacheTtl == null) {
+      return false;
+    }
+    return _smbSetMetadataCacheTtl!(context, ttl.inMilliseconds) ==
+        SmbErrorCodes.success;
+  }
+
+  /// Same result as [listDirectory], read from a single packed native buffer
+  /// (see SmbPackedListingHeader in smb_bridge.h) instead of two native
+  /// strings per entry.
+  List<Map<String, dynamic>> listDirectoryPacked(
+      Pointer<Void> context, String path) {
+    if (_smbListDirectoryPacked == null) {
+      print('Warning: listDirectoryPacked not available, using fallback');
+      return listDirectory(context, path);
+    }
+
+    final pathPtr = path.toNativeUtf8();
+    final bufferPtr = malloc<Pointer<Uint8>>();
+    final sizePtr = malloc<Size>();
+    final List<Map<String, dynamic>> files = [];
+    bufferPtr.value = nullptr;
+
+    try {
+      final errorCode =
+          _smbListDirectoryPacked!(context, pathPtr, bufferPtr, sizePtr);
+      if (errorCode != SmbErrorCodes.success) {
+        return files;
+      }
+
+      files.addAll(
+          _readPackedListing(bufferPtr.value.asTypedList(sizePtr.value), path));
+    } finally {
+      if (bufferPtr.value != nullptr) {
+        _smbFreePackedListing!(bufferPtr.value);
+      }
+      malloc.free(pathPtr);
+      malloc.free(bufferPtr);
+      malloc.free(sizePtr);
+    }
+
+    return files;
+  }
+
+  // Entries of a packed listing; names may be paths relative to parent
+  static List<Map<String, dynamic>> _readPackedListing(
+      Uint8List bytes, String parent) {
+    final data = ByteData.sublistView(bytes);
+    final count = data.getUint32(4, Endian.host);
+    final recordSize = data.getUint32(8, Endian.host);
+    final recordsOffset = data.getUint32(12, Endian.host);
+    final List<Map<String, dynamic>> files = [];
+
+    for (int i = 0; i < count; i++) {
+      final record = recordsOffset + i * recordSize;
+      final nameOffset = data.getUint32(record + 16, Endian.host);
+      final nameLength = data.getUint32(record + 20, Endian.host);
+      final relativePath = utf8.decode(
+          Uint8List.sublistView(bytes, nameOffset, nameOffset + nameLength));
+      files.add({
+        'name': relativePath.substring(relativePath.lastIndexOf('/') + 1),
+        'path': '$parent/$relativePath',
+        'size': data.getUint64(record, Endian.host),
+        'modifiedTime': data.getUint64(record + 8, Endian.host),
+        'isDirectory': (data.getUint32(record + 24, Endian.host) & 1) != 0,
+      });
+    }
+    return files;
+  }
+
+  /// Lists everything under [root] recursively. Several directories are
+  /// listed at once across pooled sessions and entries arrive in batches.
+  /// [include] and [exclude] globs are evaluated natively (see SmbWalkOptions
+  /// in smb_bridge.h). Cancelling the subscription stops the walk.
+  Stream<List<Map<String, dynamic>>> walkTree(Pointer<Void> context,
+      String root,
+      {List<String> include = const [],
+      List<String> exclude = const [],
+      int maxDepth = 0,
+      int maxConnections = 0,
+      int batchSize = 0}) {
+    if (_smbWalkTreePtr == null) {
+      print('Warning: walkTree not available, using fallback');
+      return const Stream.empty();
+    }
+
+    // The subscription may be cancelled after the walk ended and the flag
+    // was freed, so onCancel only writes it while the walk is running
+    final cancel = malloc<Int32>()..value = 0;
+    var walking = true;
+    final controller = StreamController<List<Map<String, dynamic>>>(
+        onCancel: () {
+      if (walking) {
+        cancel.value = 1;
+      }
+    });
+
+    void onBatch(Pointer<Uint8> batch, int size, Pointer<Void> userData) {
+      try {
+        if (!controller.isClosed) {
+          controller.add(_readPackedListing(batch.asTypedList(size), root));
+        }
+      } finally {
+        _smbFreePackedListing!(batch);
+      }
+    }
+
+    final callback =
+        NativeCallable<SmbWalkBatchCallbackNative>.listener(onBatch);
+    _walkTreeInIsolate(
+            _smbWalkTreePtr!.address,
+            context.address,
+            root,
+            include.join('\n'),
+            exclude.join('\n'),
+            maxDepth,
+            maxConnections,
+            batchSize,
+            cancel.address,
+            callback.nativeFunction.address)
+        .then((errorCode) {
+      // Batches were posted to this isolate before the walk returned, so
+      // they have all been delivered by now
+      if (errorCode != SmbErrorCodes.success && cancel.value == 0) {
+        controller.addError(Exception(getErrorMessage(errorCode)));
+      }
+    }).whenComplete(() {
+      walking = false;
+      callback.close();
+      malloc.free(cancel);
+      controller.close();
+    });
+    return controller.stream;
+  }
+
+  // Kept apart from walkTree so the isolate closure captures only sendable
+  // values
+  static Future<int> _walkTreeInIsolate(
+      int walkTreeAddress,
+      int contextAddress,
+      String root,
+      String include,
+      String exclude,
+      int maxDepth,
+      int maxConnections,
+      int batchSize,
+      int cancelAddress,
+      int callbackAddress) {
+    return Isolate.run(() {
+      final SmbWalkTreeDart walkTree =
+          Pointer<NativeFunction<SmbWalkTreeNative>>.fromAddress(
+                  walkTreeAddress)
+              .asFunction();
+      final rootPtr = root.toNativeUtf8();
+      final includePtr = include.toNativeUtf8();
+      final excludePtr = exclude.toNativeUtf8();
+      final options = calloc<SmbWalkOptions>();
+      try {
+        options.ref
+          ..maxConnections = maxConnections
+          ..maxDepth = maxDepth
+          ..batchSize = batchSize
+          ..include = includePtr
+          ..exclude = excludePtr
+          ..cancel = Pointer<Int32>.fromAddress(cancelAddress);
+        return walkTree(
+            Pointer<Void>.fromAddress(contextAddress),
+            rootPtr,
+            options,
+            Pointer<NativeFunction<SmbWalkBatchCallbackNative>>.fromAddress(
+                callbackAddress),
+            nullptr);
+      } finally {
+        malloc.free(rootPtr);
+        malloc.free(includePtr);
+        malloc.free(excludePtr);
+        calloc.free(options);
+      }
+    });
+  }
+
+  /// Enumerate a directory in batches of up to [batchSize] entries so the
+  /// first entries of a huge folder can be shown before the rest arrive.
+  /// Native memory is one reused arena, independent of the folder size.
+  Stream<List<Map<String, dynamic>>> listDirectoryBatched(
+      Pointer<Void> context, String path,
+      {int batchSize = 500}) async* {
+    if (_smbOpenDir == null) {
+      print('Warning: listDirectoryBatched not available, using fallback');
+      yield listDirectory(context, path);
+      return;
+    }
+
+    final pathPtr = path.toNativeUtf8();
+    final dir = _smbOpenDir!(context, pathPtr);
+    malloc.free(pathPtr);
+    if (dir.address == 0) {
+      return;
+    }
+
+    // SMB names are at most 255 UTF-16 units, i.e. 765 UTF-8 bytes
+    final arenaSize = batchSize * 256 + 1024;
+    final entries = malloc<SmbDirEntry>(batchSize);
+    final arena = malloc<Uint8>(arenaSize);
+    final count = malloc<Size>();
+
+    try {
+      while (true) {
+        final errorCode = _smbReaddirBatch!(
+            dir, entries, batchSize, arena, arenaSize, count);
+        if (errorCode != SmbErrorCodes.success || count.value == 0) {
+          break;
+        }
+
+        final batch = <Map<String, dynamic>>[];
+        for (int i = 0; i < count.value; i++) {
+          final entry = entries[i];
+          final name = entry.name.toDartString();
+          batch.add({
+            'name': name,
+            'path': '$path/$name',
+            'size': entry.size,
+            'modifiedTime': entry.modifiedTime,
+            'isDirectory': entry.isDirectory != 0,
+          });
+        }
+        yield batch;
+      }
+    } finally {
+      _smbCloseDir!(dir);
+      malloc.free(entries);
+      malloc.free(arena);
+      malloc.free(count);
+    }
+  }
+
   // Thumbnail generation
   Uint8List? generateThumbnail(
       Pointer<Void> context, String path, int width, int height) {
@@ -12,6 +12,8 @@ class SmbNativeService {
   late SmbNativeFFI _ffi;
   Pointer<Void>? _context;
   bool _isConnected = false;
+  // Set by setStreamingOptions, applied to each handle opened for the path
+  final Map<String, _StreamingOptions> _streamingOptions = {};
 
   SmbNativeService._() {
     try {
@@ -52,6 +54,18 @@ class SmbNativeService {
       _context = null;
     }
     _isConnected = false;
+    _streamingOptions.clear();
+  }
+
+  // Opens path for reading with the streaming options recorded for it
+  Pointer<Void>? _openFile(String path) {
+    final fileHandle = _ffi.openFile(_context!, path);
+    final options = _streamingOptions[path];
+    if (fileHandle != null && options != null) {
+      _ffi.setStreamingOptions(fileHandle, options.chunkSize,
+          options.bufferSize, options.enableCaching);
+    }
+    return fileHandle;
   }
 
   /// Check if connected to SMB server
@@ -97,7 +111,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         throw Exception('Failed to open file: $path');
       }
@@ -143,7 +157,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         throw Exception('Failed to open file: $path');
       }
@@ -197,7 +211,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         return null;
       }
@@ -323,7 +337,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         throw Exception('Failed to open file: $path');
       }
@@ -393,7 +407,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         return null;
       }
@@ -458,7 +472,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         return null;
       }
@@ -511,7 +525,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         return null;
       }
@@ -562,7 +576,7 @@ class SmbNativeService {
 
     Pointer<Void>? fileHandle;
     try {
-      fileHandle = _ffi.openFile(_context!, path);
+      fileHandle = _openFile(path);
       if (fileHandle == null) {
         return false;
       }
@@ -578,10 +592,13 @@ class SmbNativeService {
     }
   }
 
-  /// Set streaming options for optimized video playback
+  /// Set streaming options for optimized video playback. They apply to the
+  /// reads of [path] made through this service; a [chunkSize] of 0 lets the
+  /// native side size read requests from the measured round trip and
+  /// throughput.
   Future<bool> setStreamingOptions(
     String path, {
-    int chunkSize = 64 * 1024, // 64KB chunks
+    int chunkSize = 0, // Adaptive
     int bufferSize = 2 * 1024 * 1024, // 2MB buffer
     bool enableCaching = true,
   }) async {
@@ -596,8 +613,13 @@ class SmbNativeService {
         return false;
       }
 
-      return _ffi.setStreamingOptions(
-          fileHandle, chunkSize, bufferSize, enableCaching);
+      if (!_ffi.setStreamingOptions(
+          fileHandle, chunkSize, bufferSize, enableCaching)) {
+        return false;
+      }
+      _streamingOptions[path] =
+          _StreamingOptions(chunkSize, bufferSize, enableCaching);
+      return true;
     } catch (e) {
       debugPrint('Error setting streaming options: $e');
       return false;
@@ -833,3 +855,11 @@ class SmbStreamChunk {
     return 'SmbStreamChunk(dataSize: ${data.length}, progress: ${(progress * 100).toStringAsFixed(1)}%, bytesRead: $bytesRead, totalSize: $totalSize)';
   }
 }
+
+class _StreamingOptions {
+  final int chunkSize;
+  final int bufferSize;
+  final bool enableCaching;
+
+  const _StreamingOptions(this.chunkSize, this.bufferSize, this.enableCaching);
+}
@@ -23,6 +23,7 @@ extern "C"
     // Forward declarations
     typedef struct SmbContext SmbContext;
     typedef struct SmbFileHandle SmbFileHandle;
+    typedef struct SmbDirectory SmbDirectory;
 
     // Thumbnail result structure
     typedef struct
@@ -45,6 +46,43 @@ extern "C"
         int error_code;
     } SmbFileInfo;
 
+    // Entry filled by smb_readdir_batch; name points into the caller's arena
+    typedef struct
+    {
+        const char *name;
+        uint64_t size;
+        uint64_t modified_time;
+        int32_t is_directory;
+    } SmbDirEntry;
+
+    // Packed directory listing: one malloc'd buffer holding this header, then
+    // `count` records of `record_size` bytes, then a pool of NUL-terminated
+    // UTF-8 names. Offsets are from the start of the buffer, so it can be read
+    // in place (e.g. as a Dart Uint8List view) and freed with one call.
+#define SMB_PACKED_LISTING_VERSION 1
+#define SMB_PACKED_ENTRY_DIRECTORY 0x1
+
+    typedef struct
+    {
+        uint32_t version;
+        uint32_t count;
+        uint32_t record_size;
+        uint32_t records_offset;
+        uint32_t strings_offset;
+        uint32_t reserved;
+        uint64_t total_size;
+    } SmbPackedListingHeader;
+
+    typedef struct
+    {
+        uint64_t size;
+        uint64_t modified_time;
+        uint32_t name_offset;
+        uint32_t name_length;
+        uint32_t flags;
+        uint32_t reserved;
+    } SmbPackedEntry;
+
     // Directory listing result
     typedef struct
     {
@@ -58,6 +96,15 @@ extern "C"
     void smb_disconnect(SmbContext *context);
     int smb_is_connected(SmbContext *context);
 
+    // Connection pool. smb_connect leases a pooled session per server/share/user
+    // and smb_disconnect returns it; idle sessions close after idle_timeout_seconds
+    // (0 closes them as soon as they are released). Once max_connections are
+    // busy, contexts for the same server/share/user share a session, and with
+    // it the session settings below (such as the metadata cache TTL); they
+    // return to their defaults when the last context sharing it disconnects.
+    int smb_configure_connection_pool(size_t max_connections, uint32_t idle_timeout_seconds);
+    void smb_close_idle_connections(void);
+
     // SMB version and connection info
     char *smb_get_version(SmbContext *context);
     char *smb_get_connection_info(SmbContext *context);
@@ -80,18 +127,123 @@ extern "C"
     int smb_read_range_async(SmbFileHandle *file_handle, uint8_t *buffer, size_t buffer_size,
                              uint64_t start_offset, uint64_t end_offset, size_t *bytes_read);
     int smb_prefetch_range(SmbFileHandle *file_handle, uint64_t start_offset, uint64_t end_offset);
+
+    // Pipelined async range read. Returns immediately; the callback runs on a
+    // native worker thread once the range is read. buffer must stay valid until then.
+    typedef void (*SmbReadCompleteCallback)(SmbFileHandle *file_handle, int error_code,
+                                            size_t bytes_read, void *user_data);
+    int smb_read_range_async_cb(SmbFileHandle *file_handle, uint8_t *buffer, size_t buffer_size,
+                                uint64_t start_offset, uint64_t end_offset,
+                                SmbReadCompleteCallback callback, void *user_data);
+    int smb_set_read_pipeline_depth(SmbFileHandle *file_handle, size_t depth);
+    // Applies to this handle only. chunk_size fixes the size of its read
+    // requests (capped at the server's MaxReadSize); 0 sizes them from the
+    // connection's measured round trip and throughput, between 64 KB and
+    // 8 MB. buffer_size is its read-ahead window; enable_caching 0 turns the
+    // read-ahead off.
     int smb_set_streaming_options(SmbFileHandle *file_handle, size_t chunk_size, size_t buffer_size, int enable_caching);
 
+    // Upload path. The file is created or truncated. smb_write_range blocks
+    // until the data is on the server, keeping several writes in flight.
+    SmbFileHandle *smb_open_file_for_writing(SmbContext *context, const char *path);
+    int smb_write_range(SmbFileHandle *file_handle, const uint8_t *data, size_t size,
+                        uint64_t offset, size_t *bytes_written);
+
+    // Write-behind: smb_write_range_async copies data and returns at once,
+    // blocking only while too much is already queued. Once a queued write
+    // fails the handle takes no more and smb_flush_writes returns the error.
+    // The progress callback runs on a native worker thread with the bytes
+    // written so far; pass NULL to remove it. smb_close_file flushes first.
+    typedef void (*SmbWriteProgressCallback)(SmbFileHandle *file_handle, int error_code,
+                                             uint64_t bytes_written, void *user_data);
+    int smb_set_write_progress_callback(SmbFileHandle *file_handle, SmbWriteProgressCallback callback,
+                                        void *user_data);
+    int smb_write_range_async(SmbFileHandle *file_handle, const uint8_t *data, size_t size, uint64_t offset);
+    int smb_flush_writes(SmbFileHandle *file_handle);
+
+    // Copy a file within the context's share, replacing destination. Servers
+    // that support FSCTL_SRV_COPYCHUNK copy the data themselves, so it never
+    // crosses the network; otherwise it is read and written back through the
+    // client. Blocks until done; the callback (may be NULL) runs on the
+    // calling thread as the copy advances. A failed copy removes destination.
+    typedef void (*SmbCopyProgressCallback)(uint64_t bytes_copied, uint64_t total_bytes, void *user_data);
+    int smb_server_copy(SmbContext *context, const char *source_path, const char *destination_path,
+                        SmbCopyProgressCallback callback, void *user_data);
+
     // NEW: SMB URL generation for direct VLC streaming
     char *smb_generate_direct_url(SmbContext *context, const char *path);
     char *smb_generate_url_with_credentials(SmbContext *context, const char *path,
                                             const char *username, const char *password);
     char *smb_get_connection_url(SmbContext *context);
 
+    // Loopback HTTP/1.1 server streaming SMB files to media players with Range
+    // support, reading through the native read-ahead instead of copying via Dart.
+    // port 0 picks a free port; *bound_port (may be NULL) receives the port.
+    // Stopping closes open player connections and invalidates every URL.
+    int smb_start_http_proxy(uint16_t port, uint16_t *bound_port);
+    void smb_stop_http_proxy(void);
+    // http://127.0.0.1:<port>/... URL for path on the context's session. It
+    // keeps working after smb_disconnect: a URL unused for the pool's idle
+    // timeout gives the session back and connects again on its next request.
+    // NULL if the proxy is not running. Free with smb_free_string.
+    char *smb_proxy_url_for(SmbContext *context, const char *path);
+
     // Directory operations
     SmbDirectoryResult smb_list_directory(SmbContext *context, const char *path);
     void smb_free_directory_result(SmbDirectoryResult *result);
 
+    // Stat a path. Answered from the connection's metadata cache when the path
+    // or its directory was seen recently; returns SMB_ERROR_FILE_NOT_FOUND if
+    // it does not exist. Any output pointer may be NULL.
+    int smb_stat(SmbContext *context, const char *path, uint64_t *size, uint64_t *modified_time,
+                 int *is_directory);
+    // Metadata cache lifetime in milliseconds; 0 disables caching. Applies to
+    // the context's session, so also to contexts sharing it at the pool cap.
+    int smb_set_metadata_cache_ttl(SmbContext *context, uint32_t ttl_ms);
+
+    // Packed variant of smb_list_directory; free *buffer with smb_free_packed_listing
+    int smb_list_directory_packed(SmbContext *context, const char *path, uint8_t **buffer, size_t *size);
+    void smb_free_packed_listing(uint8_t *buffer);
+
+    // Streaming directory enumeration. Each call fills up to max_entries entries
+    // and copies their NUL-terminated names into name_arena; nothing is allocated
+    // per entry. *count is 0 once the directory is exhausted. An entry whose
+    // name does not fit is returned by the next call.
+    SmbDirectory *smb_opendir(SmbContext *context, const char *path);
+    int smb_readdir_batch(SmbDirectory *dir, SmbDirEntry *entries, size_t max_entries,
+                          char *name_arena, size_t arena_size, size_t *count);
+    void smb_closedir(SmbDirectory *dir);
+
+    // Recursive listing for scans, search and folder sizes. Directories are
+    // listed by up to max_connections pooled sessions at once (the context's
+    // plus idle or new ones for the same server/share/user), each with
+    // several requests in flight.
+    typedef struct
+    {
+        uint32_t max_connections; // 0 for 4
+        uint32_t max_depth;       // 0 walks the whole tree; 1 lists root only
+        uint32_t batch_size;      // Entries per callback; 0 for 1024
+        uint32_t reserved;
+        // Newline-separated globs (may be NULL), matched case-insensitively
+        // against the path relative to root, or against the name when the
+        // pattern has no '/'. '*' and '?' stay within a component, '**'
+        // spans components. Excluded directories are not entered.
+        const char *include;
+        const char *exclude;
+        // The walk stops soon after *cancel becomes nonzero (may be NULL)
+        const volatile int32_t *cancel;
+    } SmbWalkOptions;
+
+    // Each batch is a packed listing (see SmbPackedListingHeader) whose names
+    // are paths relative to root. The callback owns it and frees it with
+    // smb_free_packed_listing, so it may hand it to another thread.
+    typedef void (*SmbWalkBatchCallback)(uint8_t *batch, size_t size, void *user_data);
+    // Blocks until the walk ends, delivering batches on the calling thread.
+    // Returns the error listing root itself; unreadable subdirectories are
+    // skipped. options may be NULL.
+    int smb_walk_tree(SmbContext *context, const char *root, const SmbWalkOptions *options,
+                      SmbWalkBatchCallback callback, void *user_data);
+
     // Thumbnail generation
     ThumbnailResult smb_generate_thumbnail(SmbContext *context, const char *path, int width, int height);
     void smb_free_thumbnail_result(ThumbnailResult *result);
@@ -0,0 +1,375 @@
+// Pooled SMB sessions shared by the C bridge
+
+#include "connection_pool.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+ConnectionPool &ConnectionPool::instance()
+{
+    // Never destroyed: joining the reaper from a static destructor can
+    // deadlock while the library is being unloaded.
+    static ConnectionPool *pool = new ConnectionPool();
+    return *pool;
+}
+
+ConnectionPool::ConnectionPool()
+    : entry_count_(0), pending_connects_(0), max_connections_(kDefaultMaxConnections),
+      idle_timeout_(kDefaultIdleTimeoutSeconds), stopping_(false)
+{
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    reaper_cv_.notify_all();
+    if (reaper_.joinable())
+    {
+        reaper_.join();
+    }
+}
+
+std::string ConnectionPool::makeKey(const std::string &server, const std::string &share,
+                                    const std::string &username)
+{
+    std::string key;
+    key.reserve(server.size() + share.size() + username.size() + 2);
+    key.append(server).append(1, '\n').append(share).append(1, '\n').append(username);
+    return key;
+}
+
+std::shared_ptr<Smb2ClientWrapper> ConnectionPool::acquire(const std::string &server, const std::string &share,
+                                                           const std::string &username, const std::string &password)
+{
+    std::string key = makeKey(server, share, username);
+    std::vector<std::shared_ptr<Entry>> dropped;
+    bool pooled = true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Prefer a warm idle session; sessions that died while idle are dropped
+        auto it = entries_.find(key);
+        if (it != entries_.end())
+        {
+            std::vector<std::shared_ptr<Entry>> candidates = it->second;
+            for (auto &entry : candidates)
+            {
+                if (entry->leases != 0 || entry->password != password)
+                {
+                    continue;
+                }
+                if (!entry->client->isConnected())
+                {
+                    removeEntry(entry);
+                    dropped.push_back(entry);
+                    continue;
+                }
+                return lease(entry);
+            }
+        }
+
+        if (totalConnections() >= max_connections_)
+        {
+            std::shared_ptr<Entry> victim = takeOldestIdle();
+            if (victim)
+            {
+                dropped.push_back(victim);
+            }
+            else
+            {
+                // At the cap with everything busy: share the least-leased
+                // session, or connect outside the pool if this key has none
+                std::shared_ptr<Entry> shared;
+                it = entries_.find(key);
+                if (it != entries_.end())
+                {
+                    for (auto &entry : it->second)
+                    {
+                        if (entry->password == password && entry->client->isConnected() &&
+                            (!shared || entry->leases < shared->leases))
+                        {
+                            shared = entry;
+                        }
+                    }
+                }
+                if (shared)
+                {
+                    return lease(shared);
+                }
+                pooled = false;
+            }
+        }
+        if (pooled)
+        {
+            pending_connects_++;
+        }
+    }
+
+    // Disconnect evicted sessions and connect outside the lock; both block on the network
+    dropped.clear();
+    if (!pooled)
+    {
+        return connectUnpooled(server, share, username, password);
+    }
+    return connectEntry(key, server, share, username, password);
+}
+
+// A session that is disconnected when its last reference goes
+std::shared_ptr<Smb2ClientWrapper> ConnectionPool::connectUnpooled(const std::string &server,
+                                                                   const std::string &share,
+                                                                   const std::string &username,
+                                                                   const std::string &password)
+{
+    try
+    {
+        auto client = std::make_shared<Smb2ClientWrapper>();
+        if (client->connect(server, share, username, password))
+        {
+            return client;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "SMB connect error: " << e.what() << std::endl;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Smb2ClientWrapper> ConnectionPool::acquireAnother(const std::shared_ptr<Smb2ClientWrapper> &existing)
+{
+    std::shared_ptr<Entry> source;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &pair : entries_)
+        {
+            for (auto &entry : pair.second)
+            {
+                if (entry->client.get() == existing.get())
+                {
+                    source = entry;
+                }
+            }
+        }
+        if (!source)
+        {
+            return nullptr;
+        }
+
+        for (auto &entry : entries_[source->key])
+        {
+            if (entry->leases == 0 && entry->password == source->password && entry->client->isConnected())
+            {
+                return lease(entry);
+            }
+        }
+        if (totalConnections() >= max_connections_)
+        {
+            return nullptr;
+        }
+        pending_connects_++;
+    }
+
+    return connectEntry(source->key, source->server, source->share, source->username, source->password);
+}
+
+// Connects without holding the lock; the caller has counted the connect in pending_connects_
+std::shared_ptr<Smb2ClientWrapper> ConnectionPool::connectEntry(const std::string &key, const std::string &server,
+                                                                const std::string &share, const std::string &username,
+                                                                const std::string &password)
+{
+    std::shared_ptr<Smb2ClientWrapper> client;
+    try
+    {
+        client = std::make_shared<Smb2ClientWrapper>();
+        if (!client->connect(server, share, username, password))
+        {
+            client.reset();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "SMB pool connect error: " << e.what() << std::endl;
+        client.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_connects_--;
+    if (!client)
+    {
+        return nullptr;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->server = server;
+    entry->share = share;
+    entry->username = username;
+    entry->password = password;
+    entry->client = client;
+    entry->leases = 0;
+    entry->idle_since = std::chrono::steady_clock::now();
+    entries_[key].push_back(entry);
+    entry_count_++;
+    return lease(entry);
+}
+
+// Caller must hold mutex_
+std::shared_ptr<Smb2ClientWrapper> ConnectionPool::lease(const std::shared_ptr<Entry> &entry)
+{
+    entry->leases++;
+    return std::shared_ptr<Smb2ClientWrapper>(entry->client.get(), [this, entry](Smb2ClientWrapper *)
+                                              { release(entry); });
+}
+
+void ConnectionPool::release(const std::shared_ptr<Entry> &entry)
+{
+    std::shared_ptr<Entry> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--entry->leases != 0)
+        {
+            return;
+        }
+
+        if (!entry->client->isConnected() || idle_timeout_.count() == 0)
+        {
+            removeEntry(entry);
+            dropped = entry;
+        }
+        else
+        {
+            // The next lease must not inherit this one's settings
+            entry->client->resetSessionOptions();
+            entry->idle_since = std::chrono::steady_clock::now();
+            startReaper();
+        }
+    }
+}
+
+// Caller must hold mutex_
+void ConnectionPool::removeEntry(const std::shared_ptr<Entry> &entry)
+{
+    auto it = entries_.find(entry->key);
+    if (it == entries_.end())
+    {
+        return;
+    }
+
+    auto &list = it->second;
+    auto pos = std::find(list.begin(), list.end(), entry);
+    if (pos != list.end())
+    {
+        list.erase(pos);
+        entry_count_--;
+    }
+    if (list.empty())
+    {
+        entries_.erase(it);
+    }
+}
+
+// Caller must hold mutex_
+std::shared_ptr<ConnectionPool::Entry> ConnectionPool::takeOldestIdle()
+{
+    std::shared_ptr<Entry> oldest;
+    for (auto &pair : entries_)
+    {
+        for (auto &entry : pair.second)
+        {
+            if (entry->leases == 0 && (!oldest || entry->idle_since < oldest->idle_since))
+            {
+                oldest = entry;
+            }
+        }
+    }
+    if (oldest)
+    {
+        removeEntry(oldest);
+    }
+    return oldest;
+}
+
+void ConnectionPool::configure(size_t max_connections, uint32_t idle_timeout_seconds)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_connections_ = std::max<size_t>(1, max_connections);
+        idle_timeout_ = std::chrono::seconds(idle_timeout_seconds);
+    }
+    reaper_cv_.notify_all();
+}
+
+std::chrono::seconds ConnectionPool::idleTimeout()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_timeout_;
+}
+
+void ConnectionPool::closeIdle()
+{
+    std::vector<std::shared_ptr<Entry>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (std::shared_ptr<Entry> entry = takeOldestIdle())
+        {
+            dropped.push_back(entry);
+        }
+    }
+}
+
+size_t ConnectionPool::connectionCount()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entry_count_;
+}
+
+// Caller must hold mutex_
+void ConnectionPool::startReaper()
+{
+    if (!reaper_.joinable() && !stopping_)
+    {
+        reaper_ = std::thread(&ConnectionPool::reaperLoop, this);
+    }
+}
+
+void ConnectionPool::reaperLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        // Check twice per timeout period, at least once a second
+        auto interval = std::max(std::chrono::seconds(1), idle_timeout_ / 2);
+        reaper_cv_.wait_for(lock, interval);
+        if (stopping_)
+        {
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<Entry>> expired;
+        for (auto &pair : entries_)
+        {
+            for (auto &entry : pair.second)
+            {
+                if (entry->leases == 0 &&
+                    (now - entry->idle_since >= idle_timeout_ || !entry->client->isConnected()))
+                {
+                    expired.push_back(entry);
+                }
+            }
+        }
+        for (auto &entry : expired)
+        {
+            removeEntry(entry);
+        }
+
+        // Disconnect without holding the lock
+        lock.unlock();
+        expired.clear();
+        lock.lock();
+    }
+}
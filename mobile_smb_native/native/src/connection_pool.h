@@ -0,0 +1,95 @@
+#pragma once
+
+#include "smb_client.h"
+#include <string>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+// Pool of authenticated SMB sessions keyed by server/share/user.
+//
+// acquire() hands out a lease: a shared_ptr whose deleter returns the
+// session to the pool instead of disconnecting it, so repeated smb_connect
+// calls reuse a warm session. Idle sessions are closed by a reaper thread
+// after the idle timeout, and a session's settings are reset whenever its
+// last lease is returned. Once the cap is reached, leases for a key that
+// already has a session share the least-leased one (the wrapper serializes
+// its own I/O), settings included, until its last lease goes; a key with no
+// session gets a connection outside the pool.
+// Leases must not outlive the pool.
+class ConnectionPool
+{
+public:
+    static constexpr size_t kDefaultMaxConnections = 8;
+    static constexpr uint32_t kDefaultIdleTimeoutSeconds = 60;
+
+    // Process-wide pool used by the C bridge
+    static ConnectionPool &instance();
+
+    ConnectionPool();
+    ~ConnectionPool();
+
+    // Returns nullptr if the connection fails
+    std::shared_ptr<Smb2ClientWrapper> acquire(const std::string &server, const std::string &share,
+                                               const std::string &username, const std::string &password);
+
+    // Another session to the same server/share/user as an existing lease, for
+    // work that fans out. Unlike acquire() it never shares a busy session or
+    // evicts one: nullptr unless an idle session or spare capacity exists.
+    std::shared_ptr<Smb2ClientWrapper> acquireAnother(const std::shared_ptr<Smb2ClientWrapper> &existing);
+
+    void configure(size_t max_connections, uint32_t idle_timeout_seconds);
+    std::chrono::seconds idleTimeout();
+
+    // Disconnect every session that has no lease
+    void closeIdle();
+
+    size_t connectionCount();
+
+private:
+    struct Entry
+    {
+        std::string key;
+        std::string server;
+        std::string share;
+        std::string username;
+        std::string password;
+        std::shared_ptr<Smb2ClientWrapper> client;
+        size_t leases;
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+    static std::string makeKey(const std::string &server, const std::string &share,
+                               const std::string &username);
+
+    std::shared_ptr<Smb2ClientWrapper> connectEntry(const std::string &key, const std::string &server,
+                                                    const std::string &share, const std::string &username,
+                                                    const std::string &password);
+    static std::shared_ptr<Smb2ClientWrapper> connectUnpooled(const std::string &server, const std::string &share,
+                                                              const std::string &username,
+                                                              const std::string &password);
+    std::shared_ptr<Smb2ClientWrapper> lease(const std::shared_ptr<Entry> &entry);
+    void release(const std::shared_ptr<Entry> &entry);
+    void removeEntry(const std::shared_ptr<Entry> &entry);
+    std::shared_ptr<Entry> takeOldestIdle();
+    size_t totalConnections() const { return entry_count_ + pending_connects_; }
+
+    void startReaper();
+    void reaperLoop();
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Entry>>> entries_;
+    size_t entry_count_;
+    size_t pending_connects_;
+    size_t max_connections_;
+    std::chrono::seconds idle_timeout_;
+
+    std::thread reaper_;
+    std::condition_variable reaper_cv_;
+    bool stopping_;
+};
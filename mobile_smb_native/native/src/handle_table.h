@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+
+// Generation-checked slot map used to hand out opaque handles across FFI.
+// A handle packs a slot index and the slot's generation, so lookups are O(1)
+// and a stale or forged handle is rejected instead of aliasing a reused slot.
+// Values are copied out under a shared lock; store shared_ptrs to keep the
+// referenced object alive while a call is using it.
+template <typename T>
+class HandleTable
+{
+public:
+    // Returns 0 when the table is full
+    uintptr_t insert(T value)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+
+        size_t index;
+        if (!free_slots_.empty())
+        {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+        else
+        {
+            if (slots_.size() >= kMaxSlots)
+            {
+                return 0;
+            }
+            index = slots_.size();
+            slots_.emplace_back();
+        }
+
+        Slot &slot = slots_[index];
+        slot.value = std::move(value);
+        slot.occupied = true;
+        return encode(index, slot.generation);
+    }
+
+    bool get(uintptr_t handle, T *out) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const Slot *slot = find(handle);
+        if (!slot)
+        {
+            return false;
+        }
+        *out = slot->value;
+        return true;
+    }
+
+    // Remove a handle, optionally returning its value. The slot's generation
+    // is bumped so the old handle never resolves again.
+    bool remove(uintptr_t handle, T *out = nullptr)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        Slot *slot = const_cast<Slot *>(find(handle));
+        if (!slot)
+        {
+            return false;
+        }
+        if (out)
+        {
+            *out = std::move(slot->value);
+        }
+        slot->value = T();
+        slot->occupied = false;
+        slot->generation = (slot->generation + 1) & kGenerationMask;
+
+        size_t index = static_cast<size_t>(slot - slots_.data());
+        free_slots_.push_back(index);
+        return true;
+    }
+
+private:
+    // 32-bit targets (armv7 Android) split the handle 16/16, 64-bit ones 32/32
+    static constexpr unsigned kIndexBits = sizeof(uintptr_t) >= 8 ? 32 : 16;
+    static constexpr uintptr_t kIndexMask = (uintptr_t(1) << kIndexBits) - 1;
+    static constexpr uintptr_t kGenerationMask = kIndexMask;
+    static constexpr size_t kMaxSlots = static_cast<size_t>(kIndexMask) - 1;
+
+    struct Slot
+    {
+        T value;
+        uintptr_t generation;
+        bool occupied;
+
+        Slot() : value(), generation(0), occupied(false) {}
+    };
+
+    // Index is stored +1 so that no valid handle is ever 0 (NULL)
+    static uintptr_t encode(size_t index, uintptr_t generation)
+    {
+        return (generation << kIndexBits) | (static_cast<uintptr_t>(index) + 1);
+    }
+
+    const Slot *find(uintptr_t handle) const
+    {
+        uintptr_t encoded_index = handle & kIndexMask;
+        if (encoded_index == 0 || encoded_index > slots_.size())
+        {
+            return nullptr;
+        }
+
+        const Slot &slot = slots_[encoded_index - 1];
+        if (!slot.occupied || slot.generation != (handle >> kIndexBits))
+        {
+            return nullptr;
+        }
+        return &slot;
+    }
+
+    mutable std::shared_mutex mutex_;
+    std::vector<Slot> slots_;
+    std::vector<size_t> free_slots_;
+};
@@ -0,0 +1,940 @@
+// Loopback HTTP range server for SMB streams
+
+#include "http_proxy.h"
+#include "connection_pool.h"
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <system_error>
+#include <vector>
+
+// Bytes read from SMB and written to the socket per step. Large enough that
+// one read keeps the wrapper's pipeline full on a cache miss.
+static const size_t kSendChunkSize = 512 * 1024;
+
+// Read-ahead window per player connection: about 1.5 s of an 80 Mbps remux
+static const size_t kStreamReadAhead = 16 * 1024 * 1024;
+
+static const size_t kMaxHeaderBytes = 16 * 1024;
+
+// A keep-alive connection idle this long, or a player that stops reading
+// for this long, is closed; players reconnect with a Range request.
+static const int kIdleTimeoutMs = 60000;
+static const int kAcceptPollMs = 250;
+
+#ifdef _WIN32
+static const ProxySocket kInvalidSocket = INVALID_SOCKET;
+static const int kSendFlags = 0;
+#else
+static const ProxySocket kInvalidSocket = -1;
+#ifdef MSG_NOSIGNAL
+static const int kSendFlags = MSG_NOSIGNAL;
+#else
+static const int kSendFlags = 0;
+#endif
+#endif
+
+struct MimeType
+{
+    const char *extension;
+    const char *type;
+};
+
+static const MimeType kMimeTypes[] = {
+    {".mp4", "video/mp4"},
+    {".m4v", "video/mp4"},
+    {".mkv", "video/x-matroska"},
+    {".webm", "video/webm"},
+    {".mov", "video/quicktime"},
+    {".avi", "video/x-msvideo"},
+    {".ts", "video/mp2t"},
+    {".m2ts", "video/mp2t"},
+    {".mpg", "video/mpeg"},
+    {".mpeg", "video/mpeg"},
+    {".wmv", "video/x-ms-wmv"},
+    {".flv", "video/x-flv"},
+    {".mp3", "audio/mpeg"},
+    {".m4a", "audio/mp4"},
+    {".flac", "audio/flac"},
+    {".wav", "audio/wav"},
+    {".ogg", "audio/ogg"},
+    {".opus", "audio/ogg"},
+};
+
+static void closeSocket(ProxySocket socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+// Wakes a thread blocked in recv or send on the socket
+static void shutdownSocket(ProxySocket socket)
+{
+#ifdef _WIN32
+    shutdown(socket, SD_BOTH);
+#else
+    shutdown(socket, SHUT_RDWR);
+#endif
+}
+
+static void configureSocket(ProxySocket socket)
+{
+    int one = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+#ifdef _WIN32
+    DWORD timeout = kIdleTimeoutMs;
+#else
+    struct timeval timeout;
+    timeout.tv_sec = kIdleTimeoutMs / 1000;
+    timeout.tv_usec = (kIdleTimeoutMs % 1000) * 1000;
+#endif
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char *>(&timeout), sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+}
+
+// Returns 1 if readable, 0 on timeout and -1 on error
+static int waitReadable(ProxySocket socket, int timeout_ms)
+{
+    struct pollfd pfd;
+    pfd.fd = socket;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+#ifdef _WIN32
+    int rc = WSAPoll(&pfd, 1, timeout_ms);
+#else
+    int rc;
+    do
+    {
+        rc = poll(&pfd, 1, timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+#endif
+    return rc < 0 ? -1 : (rc > 0 ? 1 : 0);
+}
+
+static bool sendAll(ProxySocket socket, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        int chunk = static_cast<int>(std::min<size_t>(size, 1 << 20));
+        int sent = send(socket, data, chunk, kSendFlags);
+        if (sent <= 0)
+        {
+#ifndef _WIN32
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+#endif
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool sendAll(ProxySocket socket, const std::string &text)
+{
+    return sendAll(socket, text.data(), text.size());
+}
+
+static bool sendStatus(ProxySocket socket, const char *status, bool keep_alive,
+                       const std::string &extra_headers = std::string())
+{
+    std::string response = std::string("HTTP/1.1 ") + status + "\r\n";
+    response += extra_headers;
+    response += "Content-Length: 0\r\n";
+    response += keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    return sendAll(socket, response) && keep_alive;
+}
+
+static bool equalsIgnoreCase(const std::string &a, const char *b)
+{
+    size_t length = strlen(b);
+    if (a.size() != length)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c)
+                   { return static_cast<char>(tolower(c)); });
+    return text;
+}
+
+static std::string trim(const std::string &text)
+{
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+    {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+static bool parseUnsigned(const std::string &text, uint64_t *value)
+{
+    if (text.empty() || text.size() > 19)
+    {
+        return false;
+    }
+    uint64_t result = 0;
+    for (char c : text)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        result = result * 10 + static_cast<uint64_t>(c - '0');
+    }
+    *value = result;
+    return true;
+}
+
+enum RangeKind
+{
+    kRangeNone, // Absent, malformed or multi-range: serve the whole file
+    kRangeSatisfiable,
+    kRangeUnsatisfiable
+};
+
+// Single "bytes=first-last", "bytes=first-" or "bytes=-suffix" range
+static RangeKind parseRange(const std::string &header, uint64_t size, uint64_t *first, uint64_t *last)
+{
+    std::string spec = trim(header);
+    if (spec.size() < 6 || !equalsIgnoreCase(spec.substr(0, 6), "bytes=") ||
+        spec.find(',') != std::string::npos)
+    {
+        return kRangeNone;
+    }
+    spec = trim(spec.substr(6));
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos)
+    {
+        return kRangeNone;
+    }
+
+    std::string from = trim(spec.substr(0, dash));
+    std::string to = trim(spec.substr(dash + 1));
+    uint64_t start = 0;
+    uint64_t end = 0;
+
+    if (from.empty())
+    {
+        // Suffix range: the last `end` bytes
+        if (!parseUnsigned(to, &end))
+        {
+            return kRangeNone;
+        }
+        if (end == 0 || size == 0)
+        {
+            return kRangeUnsatisfiable;
+        }
+        *first = end < size ? size - end : 0;
+        *last = size - 1;
+        return kRangeSatisfiable;
+    }
+
+    if (!parseUnsigned(from, &start) || (!to.empty() && !parseUnsigned(to, &end)) ||
+        (!to.empty() && end < start))
+    {
+        return kRangeNone;
+    }
+    if (start >= size)
+    {
+        return kRangeUnsatisfiable;
+    }
+    *first = start;
+    *last = to.empty() ? size - 1 : std::min(end, size - 1);
+    return kRangeSatisfiable;
+}
+
+static std::string makeToken()
+{
+    static const char kHex[] = "0123456789abcdef";
+    std::random_device random;
+    std::string token;
+    for (int i = 0; i < 8; i++)
+    {
+        uint32_t bits = random();
+        for (int j = 0; j < 4; j++)
+        {
+            token += kHex[bits & 0xf];
+            bits >>= 4;
+        }
+    }
+    return token;
+}
+
+// Percent-encode everything but RFC 3986 unreserved characters
+static std::string encodePathSegment(const std::string &segment)
+{
+    static const char kHex[] = "0123456789ABCDEF";
+    std::string encoded;
+    for (unsigned char c : segment)
+    {
+        if (isalnum(c) || c == '-' || c == '.' || c == '_' || c == '~')
+        {
+            encoded += static_cast<char>(c);
+        }
+        else
+        {
+            encoded += '%';
+            encoded += kHex[c >> 4];
+            encoded += kHex[c & 0xf];
+        }
+    }
+    return encoded;
+}
+
+static std::string baseName(const std::string &path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static const char *mimeTypeFor(const std::string &path)
+{
+    std::string lower = toLower(path);
+    for (const MimeType &mime : kMimeTypes)
+    {
+        size_t length = strlen(mime.extension);
+        if (lower.size() >= length && lower.compare(lower.size() - length, length, mime.extension) == 0)
+        {
+            return mime.type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+struct HttpProxyServer::Request
+{
+    std::string method;
+    std::string target;
+    std::string range;
+    bool keep_alive;
+};
+
+// One player connection and the streaming handle it reads through
+struct HttpProxyServer::Connection
+{
+    ProxySocket socket;
+    std::string received; // Bytes read past the previous request
+    std::shared_ptr<Stream> stream;
+    std::shared_ptr<Smb2ClientWrapper> client; // The stream's session while open
+    smb2fh *handle;
+    uint64_t file_size;
+    uint64_t position; // Where the previous response ended
+    std::vector<uint8_t> buffer;
+
+    Connection() : socket(kInvalidSocket), handle(nullptr), file_size(0), position(0) {}
+};
+
+HttpProxyServer &HttpProxyServer::instance()
+{
+    // Never destroyed, like the connection pool: connection threads are
+    // detached and may still be unwinding when the library unloads.
+    static HttpProxyServer *server = new HttpProxyServer();
+    return *server;
+}
+
+HttpProxyServer::HttpProxyServer()
+    : clock_(0), listener_(kInvalidSocket), port_(0), stopping_(false)
+{
+}
+
+HttpProxyServer::~HttpProxyServer()
+{
+    stop();
+}
+
+bool HttpProxyServer::start(uint16_t port, uint16_t *bound_port)
+{
+    std::lock_guard<std::mutex> lifecycle(lifecycle_mutex_);
+    if (listener_ != kInvalidSocket)
+    {
+        if (bound_port)
+        {
+            *bound_port = port_;
+        }
+        return true;
+    }
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        return false;
+    }
+#endif
+
+    ProxySocket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == kInvalidSocket)
+    {
+        std::cerr << "SMB proxy: failed to create socket" << std::endl;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+
+#ifndef _WIN32
+    // Lets a fixed port be reused right after a restart
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+#endif
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    socklen_t address_length = sizeof(address);
+    if (bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0 ||
+        getsockname(listener, reinterpret_cast<struct sockaddr *>(&address), &address_length) != 0)
+    {
+        std::cerr << "SMB proxy: failed to listen on port " << port << std::endl;
+        closeSocket(listener);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listener_ = listener;
+        port_ = ntohs(address.sin_port);
+        stopping_ = false;
+    }
+    accept_thread_ = std::thread(&HttpProxyServer::acceptLoop, this);
+
+    if (bound_port)
+    {
+        *bound_port = port_;
+    }
+    return true;
+}
+
+void HttpProxyServer::stop()
+{
+    std::lock_guard<std::mutex> lifecycle(lifecycle_mutex_);
+    std::unordered_map<std::string, std::shared_ptr<Stream>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (listener_ == kInvalidSocket)
+        {
+            return;
+        }
+        stopping_ = true;
+        for (ProxySocket socket : connections_)
+        {
+            shutdownSocket(socket);
+        }
+    }
+
+    if (accept_thread_.joinable())
+    {
+        accept_thread_.join();
+    }
+
+    {
+        // A connection in the middle of an SMB read finishes that read first
+        std::unique_lock<std::mutex> lock(mutex_);
+        drained_cv_.wait(lock, [this]
+                         { return connections_.empty(); });
+        closeSocket(listener_);
+        listener_ = kInvalidSocket;
+        port_ = 0;
+        dropped.swap(streams_);
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    // Dropping the streams returns their sessions to the pool
+}
+
+std::string HttpProxyServer::urlFor(const std::shared_ptr<Smb2ClientWrapper> &client, const std::string &path)
+{
+    if (!client || path.empty())
+    {
+        return "";
+    }
+    std::string server, share, username, password;
+    client->getConnectionParameters(&server, &share, &username, &password);
+
+    // Declared before the lock so an evicted session is released after unlocking
+    std::shared_ptr<Stream> evicted;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (listener_ == kInvalidSocket || stopping_)
+    {
+        return "";
+    }
+
+    std::shared_ptr<Stream> stream;
+    for (auto &pair : streams_)
+    {
+        Stream &candidate = *pair.second;
+        if (candidate.path != path)
+        {
+            continue;
+        }
+        if (candidate.client.get() == client.get())
+        {
+            stream = pair.second;
+            break;
+        }
+        // Idle stream that gave its lease back: take this one instead
+        if (!candidate.client && candidate.server == server && candidate.share == share &&
+            candidate.username == username && candidate.password == password)
+        {
+            candidate.client = client;
+            stream = pair.second;
+            break;
+        }
+    }
+
+    if (!stream)
+    {
+        if (streams_.size() >= kMaxStreams)
+        {
+            evicted = takeIdleStream();
+        }
+
+        stream = std::make_shared<Stream>();
+        do
+        {
+            stream->token = makeToken();
+        } while (streams_.count(stream->token));
+        stream->client = client;
+        stream->server = server;
+        stream->share = share;
+        stream->username = username;
+        stream->password = password;
+        stream->path = path;
+        stream->connections = 0;
+        stream->idle_since = std::chrono::steady_clock::now();
+        streams_[stream->token] = stream;
+    }
+    stream->last_used = ++clock_;
+
+    // The file name lets players that sniff extensions pick a demuxer
+    return "http://127.0.0.1:" + std::to_string(port_) + "/" + stream->token + "/" +
+           encodePathSegment(baseName(path));
+}
+
+// Caller must hold mutex_. Returns the least recently used stream without
+// connections, removed from the table; nullptr if every stream is playing.
+std::shared_ptr<HttpProxyServer::Stream> HttpProxyServer::takeIdleStream()
+{
+    auto oldest = streams_.end();
+    for (auto it = streams_.begin(); it != streams_.end(); ++it)
+    {
+        if (it->second->connections == 0 &&
+            (oldest == streams_.end() || it->second->last_used < oldest->second->last_used))
+        {
+            oldest = it;
+        }
+    }
+    if (oldest == streams_.end())
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<Stream> stream = oldest->second;
+    streams_.erase(oldest);
+    return stream;
+}
+
+std::shared_ptr<HttpProxyServer::Stream> HttpProxyServer::acquireStream(const std::string &token)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = streams_.find(token);
+    if (it == streams_.end())
+    {
+        return nullptr;
+    }
+    it->second->connections++;
+    it->second->last_used = ++clock_;
+    return it->second;
+}
+
+void HttpProxyServer::releaseStream(const std::shared_ptr<Stream> &stream)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--stream->connections == 0)
+    {
+        stream->idle_since = std::chrono::steady_clock::now();
+    }
+}
+
+// The stream's session, leased from the pool again if it was given back
+std::shared_ptr<Smb2ClientWrapper> HttpProxyServer::streamClient(const std::shared_ptr<Stream> &stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stream->client)
+        {
+            return stream->client;
+        }
+    }
+
+    // May connect, so not under the lock. Another connection to the stream
+    // can get there first; this lease is then released after unlocking.
+    std::shared_ptr<Smb2ClientWrapper> client =
+        ConnectionPool::instance().acquire(stream->server, stream->share, stream->username, stream->password);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!stream->client)
+    {
+        stream->client = client;
+    }
+    return stream->client;
+}
+
+// Give back the leases of streams nobody has played for the pool's idle
+// timeout, so the pool can close their sessions
+void HttpProxyServer::releaseIdleLeases()
+{
+    std::chrono::seconds timeout = ConnectionPool::instance().idleTimeout();
+    // Declared before the lock so the leases are returned after unlocking
+    std::vector<std::shared_ptr<Smb2ClientWrapper>> released;
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (auto &pair : streams_)
+    {
+        Stream &stream = *pair.second;
+        if (stream.client && stream.connections == 0 && now - stream.idle_since >= timeout)
+        {
+            released.push_back(std::move(stream.client));
+        }
+    }
+}
+
+void HttpProxyServer::acceptLoop()
+{
+    while (!stopping_)
+    {
+        int ready = waitReadable(listener_, kAcceptPollMs);
+        if (ready < 0)
+        {
+            std::cerr << "SMB proxy: listener failed" << std::endl;
+            break;
+        }
+        releaseIdleLeases();
+        if (ready == 0)
+        {
+            continue;
+        }
+
+        ProxySocket socket = accept(listener_, nullptr, nullptr);
+        if (socket == kInvalidSocket)
+        {
+            continue;
+        }
+        configureSocket(socket);
+
+        bool accepted = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!stopping_ && connections_.size() < kMaxConnections)
+            {
+                connections_.insert(socket);
+                accepted = true;
+            }
+        }
+        if (!accepted)
+        {
+            sendStatus(socket, "503 Service Unavailable", false);
+            closeSocket(socket);
+            continue;
+        }
+
+        try
+        {
+            std::thread(&HttpProxyServer::serveConnection, this, socket).detach();
+        }
+        catch (const std::system_error &e)
+        {
+            std::cerr << "SMB proxy: failed to start connection thread: " << e.what() << std::endl;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                connections_.erase(socket);
+            }
+            closeSocket(socket);
+            drained_cv_.notify_all();
+        }
+    }
+}
+
+void HttpProxyServer::serveConnection(ProxySocket socket)
+{
+    Connection connection;
+    connection.socket = socket;
+
+    Request request;
+    while (!stopping_ && readRequest(connection, &request) && serveRequest(connection, request))
+    {
+    }
+    closeStream(connection);
+
+    // Unregister before closing so stop() never shuts down a reused descriptor
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.erase(socket);
+    }
+    closeSocket(socket);
+    drained_cv_.notify_all();
+}
+
+// Read one request head. False when the peer closes, times out or sends
+// something that is not HTTP.
+bool HttpProxyServer::readRequest(Connection &connection, Request *request)
+{
+    size_t head_end;
+    while ((head_end = connection.received.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (connection.received.size() > kMaxHeaderBytes)
+        {
+            return false;
+        }
+        char chunk[4096];
+        int received = recv(connection.socket, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        connection.received.append(chunk, static_cast<size_t>(received));
+    }
+
+    std::string head = connection.received.substr(0, head_end);
+    connection.received.erase(0, head_end + 4);
+
+    // Request line: METHOD SP target SP version (stray leading CRLFs are allowed)
+    size_t begin = head.find_first_not_of("\r\n");
+    size_t line_end = head.find("\r\n", begin == std::string::npos ? 0 : begin);
+    std::string line = head.substr(begin == std::string::npos ? 0 : begin,
+                                   line_end == std::string::npos ? std::string::npos : line_end - begin);
+    size_t first_space = line.find(' ');
+    size_t second_space = line.find(' ', first_space == std::string::npos ? 0 : first_space + 1);
+    if (first_space == std::string::npos || second_space == std::string::npos)
+    {
+        return false;
+    }
+
+    request->method = line.substr(0, first_space);
+    request->target = line.substr(first_space + 1, second_space - first_space - 1);
+    request->range.clear();
+    request->keep_alive = line.compare(second_space + 1, std::string::npos, "HTTP/1.1") == 0;
+
+    while (line_end != std::string::npos)
+    {
+        size_t next = head.find("\r\n", line_end + 2);
+        std::string header = head.substr(line_end + 2, next == std::string::npos ? std::string::npos
+                                                                                  : next - line_end - 2);
+        line_end = next;
+
+        size_t colon = header.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+        std::string name = trim(header.substr(0, colon));
+        std::string value = trim(header.substr(colon + 1));
+        if (equalsIgnoreCase(name, "range"))
+        {
+            request->range = value;
+        }
+        else if (equalsIgnoreCase(name, "connection"))
+        {
+            std::string options = toLower(value);
+            if (options.find("close") != std::string::npos)
+            {
+                request->keep_alive = false;
+            }
+            else if (options.find("keep-alive") != std::string::npos)
+            {
+                request->keep_alive = true;
+            }
+        }
+        else if (equalsIgnoreCase(name, "content-length") && value != "0")
+        {
+            // GET and HEAD have no body; do not try to find the next request after one
+            request->keep_alive = false;
+        }
+    }
+    return true;
+}
+
+// Open the streaming handle for token on this connection, replacing any
+// other. On failure *status is the HTTP status to answer with.
+bool HttpProxyServer::openStream(Connection &connection, const std::string &token, int *status)
+{
+    if (connection.stream && connection.stream->token == token)
+    {
+        return true;
+    }
+    closeStream(connection);
+
+    std::shared_ptr<Stream> stream = acquireStream(token);
+    if (!stream)
+    {
+        *status = 404;
+        return false;
+    }
+
+    std::shared_ptr<Smb2ClientWrapper> client = streamClient(stream);
+    smb2fh *handle = client ? client->openFileForStreaming(stream->path) : nullptr;
+    if (!handle)
+    {
+        *status = client && client->isConnected() ? 404 : 502;
+        releaseStream(stream);
+        return false;
+    }
+    client->setReadAhead(handle, kStreamReadAhead);
+
+    connection.stream = stream;
+    connection.client = client;
+    connection.handle = handle;
+    connection.file_size = client->getFileSize(handle);
+    connection.position = 0;
+    return true;
+}
+
+void HttpProxyServer::closeStream(Connection &connection)
+{
+    if (!connection.stream)
+    {
+        return;
+    }
+    connection.client->closeFile(connection.handle);
+    releaseStream(connection.stream);
+    connection.stream.reset();
+    connection.client.reset();
+    connection.handle = nullptr;
+}
+
+// Answer one request. Returns true to keep the connection open.
+bool HttpProxyServer::serveRequest(Connection &connection, const Request &request)
+{
+    bool head_only = request.method == "HEAD";
+    if (!head_only && request.method != "GET")
+    {
+        return sendStatus(connection.socket, "405 Method Not Allowed", request.keep_alive, "Allow: GET, HEAD\r\n");
+    }
+
+    // Target is /<token>/<file name>
+    size_t token_begin = request.target.find_first_not_of('/');
+    size_t token_end = request.target.find_first_of("/?", token_begin == std::string::npos ? 0 : token_begin);
+    std::string token = token_begin == std::string::npos
+                            ? std::string()
+                            : request.target.substr(token_begin, token_end == std::string::npos
+                                                                     ? std::string::npos
+                                                                     : token_end - token_begin);
+
+    int status = 0;
+    if (!openStream(connection, token, &status))
+    {
+        return sendStatus(connection.socket, status == 404 ? "404 Not Found" : "502 Bad Gateway",
+                          request.keep_alive);
+    }
+
+    const uint64_t size = connection.file_size;
+    uint64_t first = 0;
+    uint64_t last = size > 0 ? size - 1 : 0;
+    RangeKind range = request.range.empty() ? kRangeNone : parseRange(request.range, size, &first, &last);
+    if (range == kRangeUnsatisfiable)
+    {
+        return sendStatus(connection.socket, "416 Range Not Satisfiable", request.keep_alive,
+                          "Content-Range: bytes */" + std::to_string(size) + "\r\n");
+    }
+    uint64_t length = size > 0 ? last - first + 1 : 0;
+
+    std::string response = range == kRangeSatisfiable ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+    response += std::string("Content-Type: ") + mimeTypeFor(connection.stream->path) + "\r\n";
+    response += "Accept-Ranges: bytes\r\n";
+    if (range == kRangeSatisfiable)
+    {
+        response += "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" +
+                    std::to_string(size) + "\r\n";
+    }
+    response += "Content-Length: " + std::to_string(length) + "\r\n";
+    response += request.keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    if (!sendAll(connection.socket, response))
+    {
+        return false;
+    }
+    if (head_only || length == 0)
+    {
+        return request.keep_alive;
+    }
+
+    Smb2ClientWrapper &client = *connection.client;
+    if (first != connection.position)
+    {
+        // A seek: start refilling the read-ahead window at the new position
+        client.prefetchRange(connection.handle, first, last + 1);
+    }
+
+    if (connection.buffer.empty())
+    {
+        connection.buffer.resize(kSendChunkSize);
+    }
+
+    uint64_t offset = first;
+    const uint64_t end = last + 1;
+    while (offset < end)
+    {
+        size_t wanted = static_cast<size_t>(std::min<uint64_t>(connection.buffer.size(), end - offset));
+        size_t bytes_read = client.readRange(connection.handle, connection.buffer.data(), wanted, offset,
+                                             offset + wanted);
+        if (bytes_read == 0)
+        {
+            // The headers are out, so the only way to report this is to close
+            std::cerr << "SMB proxy: read failed at " << offset << " in " << connection.stream->path << std::endl;
+            return false;
+        }
+        if (!sendAll(connection.socket, reinterpret_cast<const char *>(connection.buffer.data()), bytes_read))
+        {
+            // Players drop the connection when they seek
+            return false;
+        }
+        offset += bytes_read;
+        connection.position = offset;
+    }
+    return request.keep_alive;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "smb_client.h"
+#include <string>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+#ifdef _WIN32
+typedef uintptr_t ProxySocket; // SOCKET
+#else
+typedef int ProxySocket;
+#endif
+
+// Loopback HTTP/1.1 server that lets media players stream SMB files with
+// Range requests. Bytes go from the wrapper's read-ahead window straight to
+// the socket, and every stream reuses the session it was registered with.
+//
+// Each player connection opens its own streaming handle, kept across
+// keep-alive requests, so a player probing the end of a file on a second
+// connection does not reset the read-ahead of the first. URLs carry a random
+// token and stay valid until evicted or the server stops. A stream with no
+// connections for the pool's idle timeout gives its session's lease back, so
+// the pool can close it, and leases the session again on its next request.
+class HttpProxyServer
+{
+public:
+    static constexpr size_t kMaxStreams = 64;
+    static constexpr size_t kMaxConnections = 32;
+
+    // Process-wide server used by the C bridge
+    static HttpProxyServer &instance();
+
+    HttpProxyServer();
+    ~HttpProxyServer();
+
+    // Listens on 127.0.0.1; port 0 picks a free one. Starting a running
+    // server succeeds and reports the port it already has.
+    bool start(uint16_t port, uint16_t *bound_port);
+    // Closes every connection and forgets registered streams
+    void stop();
+
+    // URL serving path through client; empty if the server is not running.
+    // Registering the same path on the same session again returns the same URL.
+    std::string urlFor(const std::shared_ptr<Smb2ClientWrapper> &client, const std::string &path);
+
+private:
+    struct Stream
+    {
+        std::string token;
+        // Null while idle; the parameters below lease the session again
+        std::shared_ptr<Smb2ClientWrapper> client;
+        std::string server;
+        std::string share;
+        std::string username;
+        std::string password;
+        std::string path;
+        size_t connections;
+        uint64_t last_used;
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+    struct Request;
+    struct Connection;
+
+    void acceptLoop();
+    void serveConnection(ProxySocket socket);
+    static bool readRequest(Connection &connection, Request *request);
+    bool serveRequest(Connection &connection, const Request &request);
+    bool openStream(Connection &connection, const std::string &token, int *status);
+    void closeStream(Connection &connection);
+
+    std::shared_ptr<Stream> acquireStream(const std::string &token);
+    void releaseStream(const std::shared_ptr<Stream> &stream);
+    std::shared_ptr<Smb2ClientWrapper> streamClient(const std::shared_ptr<Stream> &stream);
+    std::shared_ptr<Stream> takeIdleStream();
+    void releaseIdleLeases();
+
+    // Serializes start and stop; mutex_ guards the state below
+    std::mutex lifecycle_mutex_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Stream>> streams_;
+    std::unordered_set<ProxySocket> connections_;
+    std::condition_variable drained_cv_;
+    uint64_t clock_;
+
+    ProxySocket listener_;
+    uint16_t port_;
+    std::thread accept_thread_;
+    std::atomic<bool> stopping_;
+};
@@ -0,0 +1,208 @@
+// TTL-based stat cache used by Smb2ClientWrapper
+
+#include "metadata_cache.h"
+#include <algorithm>
+
+MetadataCache::MetadataCache() : ttl_(kDefaultTtlMs), generation_(0) {}
+
+void MetadataCache::setTtl(uint32_t ttl_ms)
+{
+    ttl_ = std::chrono::milliseconds(ttl_ms);
+    if (ttl_.count() == 0)
+    {
+        clear();
+    }
+}
+
+std::string MetadataCache::normalize(const std::string &path)
+{
+    std::string result;
+    result.reserve(path.size());
+    for (char c : path)
+    {
+        if (c == '\\')
+        {
+            c = '/';
+        }
+        if (c == '/' && (result.empty() || result.back() == '/'))
+        {
+            continue;
+        }
+        // Shares compare names without regard to case
+        if (c >= 'A' && c <= 'Z')
+        {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        result.push_back(c);
+    }
+    if (!result.empty() && result.back() == '/')
+    {
+        result.pop_back();
+    }
+    return result;
+}
+
+std::string MetadataCache::parentOf(const std::string &normalized)
+{
+    size_t slash = normalized.rfind('/');
+    return slash == std::string::npos ? std::string() : normalized.substr(0, slash);
+}
+
+bool MetadataCache::lookup(const std::string &path, CachedStat *out)
+{
+    if (!enabled())
+    {
+        return false;
+    }
+
+    std::string key = normalize(path);
+    Clock::time_point now = Clock::now();
+
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+    {
+        if (it->second.expires > now)
+        {
+            *out = it->second.stat;
+            return true;
+        }
+        erase(it);
+    }
+
+    // A fresh full listing of the parent that did not contain the name.
+    // Keys only fold ASCII case, so a name with other characters may have
+    // been listed under another case and is not known to be missing.
+    if (!key.empty() && std::all_of(key.begin() + parentOf(key).size(), key.end(),
+                                    [](char c) { return static_cast<unsigned char>(c) < 0x80; }))
+    {
+        auto dir = listed_dirs_.find(parentOf(key));
+        if (dir != listed_dirs_.end())
+        {
+            if (dir->second > now)
+            {
+                out->exists = false;
+                out->size = 0;
+                out->modified_time = 0;
+                out->is_directory = false;
+                return true;
+            }
+            listed_dirs_.erase(dir);
+        }
+    }
+    return false;
+}
+
+void MetadataCache::store(const std::string &path, const CachedStat &stat)
+{
+    if (!enabled())
+    {
+        return;
+    }
+    auto inserted = entries_.emplace(normalize(path), Entry());
+    Entry &entry = inserted.first->second;
+    if (inserted.second)
+    {
+        entry.order = store_order_.insert(store_order_.end(), &inserted.first->first);
+        makeRoom();
+    }
+    else
+    {
+        store_order_.splice(store_order_.end(), store_order_, entry.order);
+    }
+    entry.stat = stat;
+    entry.expires = Clock::now() + ttl_;
+}
+
+void MetadataCache::storeMissing(const std::string &path)
+{
+    CachedStat stat;
+    stat.exists = false;
+    stat.size = 0;
+    stat.modified_time = 0;
+    stat.is_directory = false;
+    store(path, stat);
+}
+
+MetadataCache::ListingToken MetadataCache::beginListing() const
+{
+    ListingToken token;
+    token.started = Clock::now();
+    token.generation = generation_;
+    return token;
+}
+
+void MetadataCache::markListed(const std::string &dir, const ListingToken &token)
+{
+    // A clear or invalidation during the listing may have dropped children
+    if (!enabled() || token.generation != generation_)
+    {
+        return;
+    }
+    listed_dirs_[normalize(dir)] = token.started + ttl_;
+}
+
+void MetadataCache::invalidate(const std::string &path)
+{
+    std::string key = normalize(path);
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+    {
+        erase(it);
+    }
+    listed_dirs_.erase(parentOf(key));
+    generation_++;
+}
+
+void MetadataCache::invalidateDirectory(const std::string &dir)
+{
+    std::string key = normalize(dir);
+    listed_dirs_.erase(key);
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+    {
+        erase(it);
+    }
+    generation_++;
+
+    // Change notifications are rare next to lookups, so a scan is fine here
+    for (auto it = entries_.begin(); it != entries_.end();)
+    {
+        if (parentOf(it->first) == key)
+        {
+            it = erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void MetadataCache::clear()
+{
+    entries_.clear();
+    store_order_.clear();
+    listed_dirs_.clear();
+    generation_++;
+}
+
+MetadataCache::EntryMap::iterator MetadataCache::erase(EntryMap::iterator it)
+{
+    store_order_.erase(it->second.order);
+    return entries_.erase(it);
+}
+
+// Called after inserting a new entry
+void MetadataCache::makeRoom()
+{
+    // Drop the oldest entries first; they are the next to expire anyway
+    while (entries_.size() > kMaxEntries)
+    {
+        auto it = entries_.find(*store_order_.front());
+        // Neither the listing of its directory nor one still being taken
+        // can answer for missing names any more
+        listed_dirs_.erase(parentOf(it->first));
+        generation_++;
+        erase(it);
+    }
+}
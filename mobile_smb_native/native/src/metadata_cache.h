@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <chrono>
+#include <list>
+#include <unordered_map>
+
+// Cached result of a stat
+struct CachedStat
+{
+    bool exists;
+    uint64_t size;
+    uint64_t modified_time;
+    bool is_directory;
+};
+
+// Per-connection path -> stat cache with a TTL. Directory listings fill it;
+// a directory listed in full also answers "does not exist" for names it did
+// not contain. Not thread-safe: Smb2ClientWrapper serializes access.
+class MetadataCache
+{
+    typedef std::chrono::steady_clock Clock;
+
+public:
+    // Taken before enumerating a directory. The listing expires relative to
+    // its start, so it never outlives the child entries it vouches for.
+    struct ListingToken
+    {
+        Clock::time_point started;
+        uint64_t generation;
+    };
+
+    static constexpr uint32_t kDefaultTtlMs = 10000;
+    // Bound memory for connections that browse very large trees
+    static constexpr size_t kMaxEntries = 100000;
+
+    MetadataCache();
+
+    void setTtl(uint32_t ttl_ms);
+    bool enabled() const { return ttl_.count() > 0; }
+
+    bool lookup(const std::string &path, CachedStat *out);
+    void store(const std::string &path, const CachedStat &stat);
+    void storeMissing(const std::string &path);
+
+    ListingToken beginListing() const;
+    // Record that every child of dir was stored since beginListing
+    void markListed(const std::string &dir, const ListingToken &token);
+
+    // Drop a path and the listing of its parent directory
+    void invalidate(const std::string &path);
+    // Drop a directory, its listing and all of its direct children
+    void invalidateDirectory(const std::string &dir);
+    void clear();
+    size_t size() const { return entries_.size(); }
+
+    // "/a//B/" and "a\\b" both become "a/b"
+    static std::string normalize(const std::string &path);
+    static std::string parentOf(const std::string &normalized);
+
+private:
+    struct Entry
+    {
+        CachedStat stat;
+        Clock::time_point expires;
+        // Position in store_order_
+        std::list<const std::string *>::iterator order;
+    };
+    typedef std::unordered_map<std::string, Entry> EntryMap;
+
+    EntryMap::iterator erase(EntryMap::iterator it);
+    void makeRoom();
+
+    std::chrono::milliseconds ttl_;
+    uint64_t generation_;
+    EntryMap entries_;
+    // Keys of entries_, least recently stored first. With one TTL for every
+    // entry this is also the order they expire in.
+    std::list<const std::string *> store_order_;
+    std::unordered_map<std::string, Clock::time_point> listed_dirs_;
+};
@@ -0,0 +1,230 @@
+// Page ring backing the per-handle read-ahead of Smb2ClientWrapper
+
+#include "read_ahead_cache.h"
+#include <algorithm>
+#include <cstring>
+
+ReadAheadCache::ReadAheadCache(size_t page_size, size_t page_count)
+    : page_size_(page_size), pages_(page_count), tick_(0), position_(0),
+      end_of_file_(UINT64_MAX), sequential_hits_(0)
+{
+    for (auto &page : pages_)
+    {
+        page.offset = 0;
+        page.length = 0;
+        page.last_use = 0;
+        page.valid = false;
+        page.filling = false;
+    }
+}
+
+const ReadAheadCache::Page *ReadAheadCache::findPage(uint64_t page_offset) const
+{
+    auto it = index_.find(page_offset);
+    if (it == index_.end())
+    {
+        return nullptr;
+    }
+    const Page &page = pages_[it->second];
+    return page.valid ? &page : nullptr;
+}
+
+size_t ReadAheadCache::read(uint64_t offset, uint8_t *buffer, size_t size)
+{
+    size_t served = 0;
+
+    while (served < size)
+    {
+        uint64_t current = offset + served;
+        uint64_t page_offset = current - (current % page_size_);
+        auto it = index_.find(page_offset);
+        if (it == index_.end())
+        {
+            break;
+        }
+
+        Page &page = pages_[it->second];
+        if (!page.valid)
+        {
+            break;
+        }
+
+        size_t in_page = static_cast<size_t>(current - page_offset);
+        if (in_page >= page.length)
+        {
+            break;
+        }
+
+        size_t count = std::min(size - served, page.length - in_page);
+        memcpy(buffer + served, page.data.data() + in_page, count);
+        page.last_use = ++tick_;
+        served += count;
+
+        // A short page marks end of file
+        if (page.length < page_size_)
+        {
+            break;
+        }
+    }
+
+    return served;
+}
+
+void ReadAheadCache::noteAccess(uint64_t offset, size_t size)
+{
+    // Allow small gaps so containers that skip a few bytes still count
+    if (offset >= position_ && offset - position_ <= page_size_)
+    {
+        if (sequential_hits_ < kSequentialThreshold)
+        {
+            sequential_hits_++;
+        }
+    }
+    else
+    {
+        sequential_hits_ = 0;
+    }
+    position_ = offset + size;
+}
+
+void ReadAheadCache::noteSeek(uint64_t offset)
+{
+    position_ = offset;
+}
+
+uint64_t ReadAheadCache::firstMissing(uint64_t offset) const
+{
+    uint64_t page_offset = offset - (offset % page_size_);
+    while (page_offset < end_of_file_)
+    {
+        const Page *page = findPage(page_offset);
+        if (!page)
+        {
+            return page_offset;
+        }
+        if (page->length < page_size_)
+        {
+            return end_of_file_;
+        }
+        page_offset += page_size_;
+    }
+    return end_of_file_;
+}
+
+bool ReadAheadCache::isEvictable(const Page &page) const
+{
+    if (page.filling)
+    {
+        return false;
+    }
+    if (!page.valid)
+    {
+        return true;
+    }
+
+    // Keep pages inside the reader's window; anything behind it or far
+    // ahead of it (left over from an earlier seek) can be reused.
+    uint64_t window_start = position_ - (position_ % page_size_);
+    uint64_t window_end = window_start + capacityBytes();
+    return page.offset + page.length <= position_ || page.offset < window_start ||
+           page.offset >= window_end;
+}
+
+uint8_t *ReadAheadCache::reservePage(uint64_t page_offset)
+{
+    if (index_.count(page_offset))
+    {
+        return nullptr;
+    }
+
+    Page *victim = nullptr;
+    for (auto &page : pages_)
+    {
+        if (!isEvictable(page))
+        {
+            continue;
+        }
+        if (!page.valid)
+        {
+            victim = &page;
+            break;
+        }
+        if (!victim || page.last_use < victim->last_use)
+        {
+            victim = &page;
+        }
+    }
+
+    if (!victim)
+    {
+        return nullptr;
+    }
+
+    if (victim->valid)
+    {
+        index_.erase(victim->offset);
+    }
+    if (victim->data.size() != page_size_)
+    {
+        victim->data.resize(page_size_);
+    }
+
+    victim->offset = page_offset;
+    victim->length = 0;
+    victim->valid = false;
+    victim->filling = true;
+    index_[page_offset] = static_cast<size_t>(victim - pages_.data());
+    return victim->data.data();
+}
+
+void ReadAheadCache::commitPage(uint64_t page_offset, size_t length)
+{
+    auto it = index_.find(page_offset);
+    if (it == index_.end())
+    {
+        return;
+    }
+
+    Page &page = pages_[it->second];
+    page.filling = false;
+    if (length == 0)
+    {
+        index_.erase(it);
+        return;
+    }
+
+    page.length = std::min(length, page_size_);
+    page.valid = true;
+    page.last_use = ++tick_;
+}
+
+void ReadAheadCache::releasePage(uint64_t page_offset)
+{
+    auto it = index_.find(page_offset);
+    if (it == index_.end())
+    {
+        return;
+    }
+
+    Page &page = pages_[it->second];
+    page.filling = false;
+    page.valid = false;
+    index_.erase(it);
+}
+
+void ReadAheadCache::setEndOfFile(uint64_t offset)
+{
+    end_of_file_ = std::min(end_of_file_, offset);
+}
+
+void ReadAheadCache::clear()
+{
+    for (auto &page : pages_)
+    {
+        page.valid = false;
+        page.filling = false;
+    }
+    index_.clear();
+    end_of_file_ = UINT64_MAX;
+    sequential_hits_ = 0;
+}
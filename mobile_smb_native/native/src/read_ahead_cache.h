@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+// Bounded ring of file pages filled ahead of a sequential reader.
+// Not thread-safe: the owning Smb2ClientWrapper serializes access.
+class ReadAheadCache
+{
+public:
+    ReadAheadCache(size_t page_size, size_t page_count);
+
+    size_t pageSize() const { return page_size_; }
+    size_t capacityBytes() const { return page_size_ * pages_.size(); }
+
+    // Copy cached bytes starting at offset. Returns the number of bytes
+    // served from contiguous cached pages (0 on a miss).
+    size_t read(uint64_t offset, uint8_t *buffer, size_t size);
+
+    // Record a read by the consumer and update sequential-access detection
+    void noteAccess(uint64_t offset, size_t size);
+    // Move the reader position without counting it as a sequential read
+    void noteSeek(uint64_t offset);
+    bool isSequential() const { return sequential_hits_ >= kSequentialThreshold; }
+    uint64_t position() const { return position_; }
+
+    // First page-aligned offset at or after `offset` that is not cached
+    uint64_t firstMissing(uint64_t offset) const;
+
+    // Get the buffer for the page starting at page_offset, evicting a page
+    // that is behind the reader or outside its window. Returns nullptr when
+    // every page is still ahead of the reader (the window is full).
+    uint8_t *reservePage(uint64_t page_offset);
+    void commitPage(uint64_t page_offset, size_t length);
+    void releasePage(uint64_t page_offset);
+
+    void setEndOfFile(uint64_t offset);
+    uint64_t endOfFile() const { return end_of_file_; }
+
+    void clear();
+
+private:
+    static const int kSequentialThreshold = 2;
+
+    struct Page
+    {
+        uint64_t offset;
+        size_t length;
+        uint64_t last_use;
+        bool valid;
+        bool filling;
+        std::vector<uint8_t> data;
+    };
+
+    const Page *findPage(uint64_t page_offset) const;
+    bool isEvictable(const Page &page) const;
+
+    size_t page_size_;
+    std::vector<Page> pages_;
+    std::unordered_map<uint64_t, size_t> index_;
+    uint64_t tick_;
+    uint64_t position_;
+    uint64_t end_of_file_;
+    int sequential_hits_;
+};
@@ -0,0 +1,64 @@
+// Adaptive read request sizing for Smb2ClientWrapper
+
+#include "read_size_tuner.h"
+#include <algorithm>
+
+// Weight of a new measurement in the smoothed throughput and round trip
+static const double kSmoothing = 0.25;
+
+ReadSizeTuner::ReadSizeTuner()
+    : request_size_(kInitialRequestSize), server_limit_(0), throughput_(0), round_trip_us_(0)
+{
+}
+
+void ReadSizeTuner::setServerLimit(uint32_t max_read_size)
+{
+    server_limit_ = max_read_size;
+}
+
+size_t ReadSizeTuner::limit() const
+{
+    return server_limit_ > 0 ? std::min<size_t>(kMaxRequestSize, server_limit_) : kMaxRequestSize;
+}
+
+size_t ReadSizeTuner::clamp(size_t size) const
+{
+    size_t upper = limit();
+    return std::min(std::max(size, std::min(kMinRequestSize, upper)), upper);
+}
+
+size_t ReadSizeTuner::requestSize() const
+{
+    return clamp(request_size_);
+}
+
+void ReadSizeTuner::noteTransfer(size_t request_size, size_t depth, size_t bytes, uint64_t first_us,
+                                 uint64_t elapsed_us)
+{
+    // Needs a second request: the spacing of completions after the first
+    // gives the bandwidth without the round trip folded in
+    if (bytes <= request_size || elapsed_us <= first_us)
+    {
+        return;
+    }
+
+    double throughput = static_cast<double>(bytes - request_size) * 1e6 / static_cast<double>(elapsed_us - first_us);
+    double round_trip = std::max(0.0, static_cast<double>(first_us) - static_cast<double>(request_size) * 1e6 / throughput);
+    throughput_ = throughput_ > 0 ? throughput_ + kSmoothing * (throughput - throughput_) : throughput;
+    round_trip_us_ = round_trip_us_ > 0 ? round_trip_us_ + kSmoothing * (round_trip - round_trip_us_) : round_trip;
+
+    double target = throughput_ * kTargetRequestMs / 1000.0;
+    double pipeline_share = throughput_ * round_trip_us_ / 1e6 / static_cast<double>(std::max<size_t>(1, depth));
+    target = std::max(target, pipeline_share);
+
+    // Move one power of two at a time, with a dead band around the current size
+    size_t current = requestSize();
+    if (target >= 2.0 * static_cast<double>(current))
+    {
+        request_size_ = clamp(current * 2);
+    }
+    else if (target < static_cast<double>(current) / 2.0)
+    {
+        request_size_ = clamp(current / 2);
+    }
+}
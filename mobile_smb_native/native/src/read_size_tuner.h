@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Size of the read requests a connection puts on the wire, tuned from what
+// its pipelined reads achieve. A request should keep the link busy for
+// about kTargetRequestMs, and the requests of one pipeline should together
+// cover the bandwidth-delay product, so fast links move to large
+// multi-credit reads while slow ones keep requests small enough to stay
+// responsive. Never exceeds the server's MaxReadSize.
+// Not thread-safe: the owning Smb2ClientWrapper serializes access.
+class ReadSizeTuner
+{
+public:
+    static constexpr size_t kMinRequestSize = 64 * 1024;
+    static constexpr size_t kMaxRequestSize = 8 * 1024 * 1024;
+    static constexpr size_t kInitialRequestSize = 1024 * 1024;
+
+    ReadSizeTuner();
+
+    // MaxReadSize negotiated with the server; 0 if unknown
+    void setServerLimit(uint32_t max_read_size);
+    size_t limit() const;
+
+    // Current request size, within [kMinRequestSize, limit()] unless the
+    // server allows less than kMinRequestSize
+    size_t requestSize() const;
+    // Clamp a requested size to what this connection can send
+    size_t clamp(size_t size) const;
+
+    // One pipelined read finished: bytes moved with requests of
+    // request_size and up to depth in flight. first_us and elapsed_us are
+    // the times from the first request going out to the first and the last
+    // completion.
+    void noteTransfer(size_t request_size, size_t depth, size_t bytes, uint64_t first_us,
+                      uint64_t elapsed_us);
+
+private:
+    static constexpr int kTargetRequestMs = 25;
+
+    size_t request_size_;
+    uint32_t server_limit_;
+    double throughput_;    // Bytes per second, smoothed; 0 until measured
+    double round_trip_us_; // Smoothed
+};
@@ -3,19 +3,74 @@
 
 #include "smb_bridge.h"
 #include "smb_client.h"
+#include "connection_pool.h"
+#include "handle_table.h"
+#include "http_proxy.h"
+#include "tree_walker.h"
 #include "../include/thumbnail_generator.h"
 #include <memory>
-#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 #include <cstring>
 #include <cstdlib>
+#include <cerrno>
 #include <iostream>
 
-// Global context and file handle management
-static std::map<void *, std::unique_ptr<Smb2ClientWrapper>> g_contexts;
-static std::map<void *, smb2fh *> g_file_handles;
-static int g_next_context_id = 1;
-static int g_next_handle_id = 1;
+// An open file remembers the connection it was opened on. Holding the
+// wrapper by shared_ptr keeps it alive until its last file is closed.
+struct OpenFile
+{
+    std::shared_ptr<Smb2ClientWrapper> client;
+    smb2fh *handle;
+
+    OpenFile() : handle(nullptr) {}
+};
+
+// Open directory cursor. The mutex serializes batches on one cursor; the
+// pending entry is one that did not fit in the previous caller arena.
+struct DirectoryCursor
+{
+    std::shared_ptr<Smb2ClientWrapper> client;
+    smb2dir *dir;
+    std::mutex mutex;
+    bool has_pending;
+    DirEntryRef pending;
+
+    DirectoryCursor() : dir(nullptr), has_pending(false), pending() {}
+};
+
+// Global context and file handle management. Handles given to Dart are
+// slot-map keys, safe to use concurrently from several isolates.
+static HandleTable<std::shared_ptr<Smb2ClientWrapper>> g_contexts;
+static HandleTable<OpenFile> g_file_handles;
+static HandleTable<std::shared_ptr<DirectoryCursor>> g_directories;
+
+static std::shared_ptr<Smb2ClientWrapper> lookup_context(SmbContext *context)
+{
+    std::shared_ptr<Smb2ClientWrapper> client;
+    g_contexts.get(reinterpret_cast<uintptr_t>(context), &client);
+    return client;
+}
+
+static bool lookup_file(SmbFileHandle *file_handle, OpenFile *out)
+{
+    return g_file_handles.get(reinterpret_cast<uintptr_t>(file_handle), out);
+}
+
+static SmbFileHandle *register_file(const std::shared_ptr<Smb2ClientWrapper> &client, smb2fh *handle)
+{
+    OpenFile file;
+    file.client = client;
+    file.handle = handle;
+    uintptr_t handle_id = g_file_handles.insert(file);
+    if (!handle_id)
+    {
+        client->closeFile(handle);
+        return nullptr;
+    }
+    return reinterpret_cast<SmbFileHandle *>(handle_id);
+}
 
 // Helper function to allocate and copy string
 char *allocate_string(const std::string &str)
@@ -28,6 +83,109 @@ char *allocate_string(const std::string &str)
     return result;
 }
 
+// Lay out a packed listing (see SmbPackedListingHeader) in one malloc'd
+// block. Record name offsets are relative to names on entry. Returns nullptr
+// if the listing is too large or allocation fails.
+static uint8_t *pack_listing(std::vector<SmbPackedEntry> &records, const std::string &names, size_t *size)
+{
+    size_t records_offset = sizeof(SmbPackedListingHeader);
+    size_t strings_offset = records_offset + records.size() * sizeof(SmbPackedEntry);
+    size_t total_size = strings_offset + names.size();
+    if (total_size > UINT32_MAX)
+    {
+        return nullptr;
+    }
+
+    uint8_t *block = static_cast<uint8_t *>(malloc(total_size));
+    if (!block)
+    {
+        return nullptr;
+    }
+
+    SmbPackedListingHeader header;
+    header.version = SMB_PACKED_LISTING_VERSION;
+    header.count = static_cast<uint32_t>(records.size());
+    header.record_size = sizeof(SmbPackedEntry);
+    header.records_offset = static_cast<uint32_t>(records_offset);
+    header.strings_offset = static_cast<uint32_t>(strings_offset);
+    header.reserved = 0;
+    header.total_size = total_size;
+    memcpy(block, &header, sizeof(header));
+
+    // Name offsets were relative to the pool; make them relative to the buffer
+    for (auto &record : records)
+    {
+        record.name_offset += static_cast<uint32_t>(strings_offset);
+    }
+    if (!records.empty())
+    {
+        memcpy(block + records_offset, records.data(), records.size() * sizeof(SmbPackedEntry));
+    }
+    if (!names.empty())
+    {
+        memcpy(block + strings_offset, names.data(), names.size());
+    }
+
+    *size = total_size;
+    return block;
+}
+
+static std::vector<std::string> split_patterns(const char *patterns)
+{
+    std::vector<std::string> result;
+    if (!patterns)
+    {
+        return result;
+    }
+
+    const char *start = patterns;
+    while (true)
+    {
+        const char *end = strchr(start, '\n');
+        std::string pattern = end ? std::string(start, end) : std::string(start);
+        if (!pattern.empty() && pattern.back() == '\r')
+        {
+            pattern.pop_back();
+        }
+        if (!pattern.empty())
+        {
+            result.push_back(std::move(pattern));
+        }
+        if (!end)
+        {
+            return result;
+        }
+        start = end + 1;
+    }
+}
+
+// Map a negative errno from libsmb2 to a bridge error code
+static int errno_to_smb_error(int status)
+{
+    switch (-status)
+    {
+    case 0:
+        return SMB_SUCCESS;
+    case ENOENT:
+        return SMB_ERROR_FILE_NOT_FOUND;
+    case EACCES:
+    case EPERM:
+        return SMB_ERROR_PERMISSION_DENIED;
+    case ENOMEM:
+        return SMB_ERROR_MEMORY_ALLOCATION;
+    case EINVAL:
+    case EBADF:
+        return SMB_ERROR_INVALID_PARAMETER;
+    case ECONNRESET:
+    case ENOTCONN:
+    case ETIMEDOUT:
+    case EIO:
+        return SMB_ERROR_CONNECTION;
+    default:
+        return SMB_ERROR_UNKNOWN;
+    }
+}
+
 extern "C"
 {
 
@@ -41,19 +199,16 @@ extern "C"
 
         try
         {
-            auto client = std::make_unique<Smb2ClientWrapper>();
-
-            // Attempt to connect
-            bool success = client->connect(server, share, username, password);
-            if (!success)
+            // Lease a session from the pool; connects only if no warm one is idle
+            std::shared_ptr<Smb2ClientWrapper> client =
+                ConnectionPool::instance().acquire(server, share, username, password);
+            if (!client)
             {
                 return nullptr;
             }
 
             // Create context ID
-            void *context_id = reinterpret_cast<void *>(g_next_context_id++);
-            g_contexts[context_id] = std::move(client);
-
+            uintptr_t context_id = g_contexts.insert(std::move(client));
             return reinterpret_cast<SmbContext *>(context_id);
         }
         catch (const std::exception &e)
@@ -68,13 +223,25 @@ extern "C"
         if (!context)
             return;
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it != g_contexts.end())
+        // Dropping the lease returns the session to the pool. Files still
+        // open on it hold the lease until smb_close_file.
+        g_contexts.remove(reinterpret_cast<uintptr_t>(context));
+    }
+
+    int smb_configure_connection_pool(size_t max_connections, uint32_t idle_timeout_seconds)
+    {
+        if (max_connections == 0)
         {
-            it->second->disconnect();
-            g_contexts.erase(it);
+            return SMB_ERROR_INVALID_PARAMETER;
         }
+
+        ConnectionPool::instance().configure(max_connections, idle_timeout_seconds);
+        return SMB_SUCCESS;
+    }
+
+    void smb_close_idle_connections(void)
+    {
+        ConnectionPool::instance().closeIdle();
     }
 
     int smb_is_connected(SmbContext *context)
@@ -82,11 +249,10 @@ extern "C"
         if (!context)
             return 0;
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it != g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (client)
         {
-            return it->second->isConnected() ? 1 : 0;
+            return client->isConnected() ? 1 : 0;
         }
         return 0;
     }
@@ -99,24 +265,20 @@ extern "C"
             return nullptr;
         }
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it == g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
         {
             return nullptr;
         }
 
-        smb2fh *file_handle = it->second->openFile(path);
+        smb2fh *file_handle = client->openFile(path);
         if (!file_handle)
         {
             return nullptr;
         }
 
         // Store file handle
-        void *handle_id = reinterpret_cast<void *>(g_next_handle_id++);
-        g_file_handles[handle_id] = file_handle;
-
-        return reinterpret_cast<SmbFileHandle *>(handle_id);
+        return register_file(client, file_handle);
     }
 
     void smb_close_file(SmbFileHandle *file_handle)
@@ -124,17 +286,11 @@ extern "C"
         if (!file_handle)
             return;
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it != g_file_handles.end())
+        // Unregister first so no other thread can resolve the handle while it closes
+        OpenFile file;
+        if (g_file_handles.remove(reinterpret_cast<uintptr_t>(file_handle), &file))
         {
-            // Find the context that owns this file handle
-            for (auto &ctx_pair : g_contexts)
-            {
-                ctx_pair.second->closeFile(it->second);
-                break;
-            }
-            g_file_handles.erase(it);
+            file.client->closeFile(file.handle);
         }
     }
 
@@ -145,22 +301,15 @@ extern "C"
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
-        {
-            size_t read_bytes = ctx_pair.second->readFile(it->second, buffer, buffer_size);
-            *bytes_read = read_bytes;
-            return SMB_SUCCESS;
-        }
-
-        return SMB_ERROR_UNKNOWN;
+        size_t read_bytes = file.client->readFile(file.handle, buffer, buffer_size);
+        *bytes_read = read_bytes;
+        return SMB_SUCCESS;
     }
 
     int smb_seek_file(SmbFileHandle *file_handle, uint64_t offset)
@@ -170,21 +319,14 @@ extern "C"
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
-        {
-            bool success = ctx_pair.second->seekFile(it->second, offset);
-            return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
-        }
-
-        return SMB_ERROR_UNKNOWN;
+        bool success = file.client->seekFile(file.handle, offset);
+        return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
     }
 
     uint64_t smb_get_file_size(SmbFileHandle *file_handle)
@@ -194,20 +336,13 @@ extern "C"
             return 0;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return 0;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
-        {
-            return ctx_pair.second->getFileSize(it->second);
-        }
-
-        return 0;
+        return file.client->getFileSize(file.handle);
     }
 
     // Optimized streaming operations
@@ -218,24 +353,20 @@ extern "C"
             return nullptr;
         }
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it == g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
         {
             return nullptr;
         }
 
-        smb2fh *file_handle = it->second->openFileForStreaming(path);
+        smb2fh *file_handle = client->openFileForStreaming(path);
         if (!file_handle)
         {
             return nullptr;
         }
 
         // Store file handle
-        void *handle_id = reinterpret_cast<void *>(g_next_handle_id++);
-        g_file_handles[handle_id] = file_handle;
-
-        return reinterpret_cast<SmbFileHandle *>(handle_id);
+        return register_file(client, file_handle);
     }
 
     int smb_read_chunk_optimized(SmbFileHandle *file_handle, uint8_t *buffer, size_t buffer_size, size_t *bytes_read, uint64_t offset)
@@ -245,22 +376,15 @@ extern "C"
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
-        {
-            size_t read_bytes = ctx_pair.second->readFileOptimized(it->second, buffer, buffer_size, offset);
-            *bytes_read = read_bytes;
-            return SMB_SUCCESS;
-        }
-
-        return SMB_ERROR_UNKNOWN;
+        size_t read_bytes = file.client->readFileOptimized(file.handle, buffer, buffer_size, offset);
+        *bytes_read = read_bytes;
+        return SMB_SUCCESS;
     }
 
     int smb_set_read_ahead(SmbFileHandle *file_handle, size_t read_ahead_size)
@@ -270,21 +394,14 @@ extern "C"
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
-        {
-            bool success = ctx_pair.second->setReadAhead(it->second, read_ahead_size);
-            return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
-        }
-
-        return SMB_ERROR_UNKNOWN;
+        bool success = file.client->setReadAhead(file.handle, read_ahead_size);
+        return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
     }
 
     // NEW: Enhanced read-range operations for VLC-style streaming
@@ -296,22 +413,15 @@ extern "C"
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
-        {
-            size_t read_bytes = ctx_pair.second->readRange(it->second, buffer, buffer_size, start_offset, end_offset);
-            *bytes_read = read_bytes;
-            return SMB_SUCCESS;
-        }
-
-        return SMB_ERROR_UNKNOWN;
+        size_t read_bytes = file.client->readRange(file.handle, buffer, buffer_size, start_offset, end_offset);
+        *bytes_read = read_bytes;
+        return SMB_SUCCESS;
     }
 
     int smb_read_range_async(SmbFileHandle *file_handle, uint8_t *buffer, size_t buffer_size,
@@ -322,70 +432,221 @@ extern "C"
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
+        size_t read_bytes = file.client->readRangeAsync(file.handle, buffer, buffer_size, start_offset, end_offset);
+        *bytes_read = read_bytes;
+        return SMB_SUCCESS;
+    }
+
+    int smb_read_range_async_cb(SmbFileHandle *file_handle, uint8_t *buffer, size_t buffer_size,
+                                uint64_t start_offset, uint64_t end_offset,
+                                SmbReadCompleteCallback callback, void *user_data)
+    {
+        if (!file_handle || !buffer || !callback || end_offset <= start_offset)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
-            size_t read_bytes = ctx_pair.second->readRangeAsync(it->second, buffer, buffer_size, start_offset, end_offset);
-            *bytes_read = read_bytes;
-            return SMB_SUCCESS;
+            return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        return SMB_ERROR_UNKNOWN;
+        bool queued = file.client->readRangeAsync(
+            file.handle, buffer, buffer_size, start_offset, end_offset,
+            [file_handle, callback, user_data](int status, size_t bytes_read)
+            {
+                callback(file_handle, errno_to_smb_error(status), bytes_read, user_data);
+            });
+        return queued ? SMB_SUCCESS : SMB_ERROR_CONNECTION;
     }
 
-    int smb_prefetch_range(SmbFileHandle *file_handle, uint64_t start_offset, uint64_t end_offset)
+    int smb_set_read_pipeline_depth(SmbFileHandle *file_handle, size_t depth)
+    {
+        if (!file_handle || depth == 0)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
+        {
+            return SMB_ERROR_FILE_NOT_FOUND;
+        }
+
+        bool success = file.client->setPipelineDepth(file.handle, depth);
+        return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
+    }
+
+    // Upload path
+    SmbFileHandle *smb_open_file_for_writing(SmbContext *context, const char *path)
+    {
+        if (!context || !path)
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
+        {
+            return nullptr;
+        }
+
+        smb2fh *file_handle = client->openFileForWriting(path);
+        if (!file_handle)
+        {
+            return nullptr;
+        }
+
+        return register_file(client, file_handle);
+    }
+
+    int smb_write_range(SmbFileHandle *file_handle, const uint8_t *data, size_t size,
+                        uint64_t offset, size_t *bytes_written)
+    {
+        if (!file_handle || !data || !bytes_written)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
+        {
+            return SMB_ERROR_FILE_NOT_FOUND;
+        }
+
+        int status = 0;
+        *bytes_written = file.client->writeRange(file.handle, data, size, offset, &status);
+        return errno_to_smb_error(status);
+    }
+
+    int smb_set_write_progress_callback(SmbFileHandle *file_handle, SmbWriteProgressCallback callback,
+                                        void *user_data)
     {
         if (!file_handle)
         {
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
+        WriteProgressCallback on_progress;
+        if (callback)
         {
-            bool success = ctx_pair.second->prefetchRange(it->second, start_offset, end_offset);
-            return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
+            on_progress = [file_handle, callback, user_data](int status, uint64_t bytes_written)
+            {
+                callback(file_handle, errno_to_smb_error(status), bytes_written, user_data);
+            };
         }
+        bool success = file.client->setWriteProgressCallback(file.handle, on_progress);
+        return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
+    }
 
-        return SMB_ERROR_UNKNOWN;
+    int smb_write_range_async(SmbFileHandle *file_handle, const uint8_t *data, size_t size, uint64_t offset)
+    {
+        if (!file_handle || !data || size == 0)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
+        {
+            return SMB_ERROR_FILE_NOT_FOUND;
+        }
+
+        if (file.client->writeRangeAsync(file.handle, data, size, offset))
+        {
+            return SMB_SUCCESS;
+        }
+        // Refused because an earlier write failed: report that failure
+        int status = file.client->flushWrites(file.handle);
+        return status < 0 ? errno_to_smb_error(status) : SMB_ERROR_CONNECTION;
     }
 
-    int smb_set_streaming_options(SmbFileHandle *file_handle, size_t chunk_size, size_t buffer_size, int enable_caching)
+    int smb_flush_writes(SmbFileHandle *file_handle)
     {
         if (!file_handle)
         {
             return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        void *handle_id = reinterpret_cast<void *>(file_handle);
-        auto it = g_file_handles.find(handle_id);
-        if (it == g_file_handles.end())
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
         {
             return SMB_ERROR_FILE_NOT_FOUND;
         }
 
-        // Find the context that owns this file handle
-        for (auto &ctx_pair : g_contexts)
+        return errno_to_smb_error(file.client->flushWrites(file.handle));
+    }
+
+    int smb_server_copy(SmbContext *context, const char *source_path, const char *destination_path,
+                        SmbCopyProgressCallback callback, void *user_data)
+    {
+        if (!context || !source_path || !destination_path)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
         {
-            bool success = ctx_pair.second->setStreamingOptions(it->second, chunk_size, buffer_size, enable_caching != 0);
-            return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
+            return SMB_ERROR_INVALID_PARAMETER;
         }
 
-        return SMB_ERROR_UNKNOWN;
+        CopyProgressCallback on_progress;
+        if (callback)
+        {
+            on_progress = [callback, user_data](uint64_t bytes_copied, uint64_t total_bytes)
+            {
+                callback(bytes_copied, total_bytes, user_data);
+            };
+        }
+        return errno_to_smb_error(client->serverCopy(source_path, destination_path, on_progress));
+    }
+
+    int smb_prefetch_range(SmbFileHandle *file_handle, uint64_t start_offset, uint64_t end_offset)
+    {
+        if (!file_handle)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
+        {
+            return SMB_ERROR_FILE_NOT_FOUND;
+        }
+
+        bool success = file.client->prefetchRange(file.handle, start_offset, end_offset);
+        return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
+    }
+
+    int smb_set_streaming_options(SmbFileHandle *file_handle, size_t chunk_size, size_t buffer_size, int enable_caching)
+    {
+        if (!file_handle)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        OpenFile file;
+        if (!lookup_file(file_handle, &file))
+        {
+            return SMB_ERROR_FILE_NOT_FOUND;
+        }
+
+        bool success = file.client->setStreamingOptions(file.handle, chunk_size, buffer_size, enable_caching != 0);
+        return success ? SMB_SUCCESS : SMB_ERROR_UNKNOWN;
     }
 
     // NEW: SMB URL generation for direct VLC streaming
@@ -396,14 +657,13 @@ extern "C"
             return nullptr;
         }
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it == g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
         {
             return nullptr;
         }
 
-        std::string url = it->second->generateDirectUrl(path);
+        std::string url = client->generateDirectUrl(path);
         return allocate_string(url);
     }
 
@@ -415,14 +675,13 @@ extern "C"
             return nullptr;
         }
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it == g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
         {
             return nullptr;
         }
 
-        std::string url = it->second->generateUrlWithCredentials(path, username, password);
+        std::string url = client->generateUrlWithCredentials(path, username, password);
         return allocate_string(url);
     }
 
@@ -433,17 +692,43 @@ extern "C"
             return nullptr;
         }
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it == g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
         {
             return nullptr;
         }
 
-        std::string url = it->second->getConnectionUrl();
+        std::string url = client->getConnectionUrl();
         return allocate_string(url);
     }
 
+    int smb_start_http_proxy(uint16_t port, uint16_t *bound_port)
+    {
+        return HttpProxyServer::instance().start(port, bound_port) ? SMB_SUCCESS : SMB_ERROR_CONNECTION;
+    }
+
+    void smb_stop_http_proxy(void)
+    {
+        HttpProxyServer::instance().stop();
+    }
+
+    char *smb_proxy_url_for(SmbContext *context, const char *path)
+    {
+        if (!context || !path)
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client || !client->isConnected())
+        {
+            return nullptr;
+        }
+
+        std::string url = HttpProxyServer::instance().urlFor(client, path);
+        return url.empty() ? nullptr : allocate_string(url);
+    }
+
     // Directory operations
     SmbDirectoryResult smb_list_directory(SmbContext *context, const char *path)
     {
@@ -454,9 +739,8 @@ extern "C"
             return result;
         }
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it == g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
         {
             result.error_code = SMB_ERROR_CONNECTION;
             return result;
@@ -464,7 +748,7 @@ extern "C"
 
         try
         {
-            std::vector<FileInfo> files = it->second->listDirectory(path);
+            std::vector<FileInfo> files = client->listDirectory(path);
 
             if (files.empty())
             {
@@ -504,6 +788,280 @@ extern "C"
         return result;
     }
 
+    int smb_stat(SmbContext *context, const char *path, uint64_t *size, uint64_t *modified_time,
+                 int *is_directory)
+    {
+        if (!context || !path)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
+        {
+            return SMB_ERROR_CONNECTION;
+        }
+
+        FileInfo info;
+        if (!client->statPath(path, &info))
+        {
+            return client->isConnected() ? SMB_ERROR_FILE_NOT_FOUND : SMB_ERROR_CONNECTION;
+        }
+
+        if (size)
+            *size = info.size;
+        if (modified_time)
+            *modified_time = info.modified_time;
+        if (is_directory)
+            *is_directory = info.is_directory ? 1 : 0;
+        return SMB_SUCCESS;
+    }
+
+    int smb_set_metadata_cache_ttl(SmbContext *context, uint32_t ttl_ms)
+    {
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        client->setMetadataCacheTtl(ttl_ms);
+        return SMB_SUCCESS;
+    }
+
+    int smb_list_directory_packed(SmbContext *context, const char *path, uint8_t **buffer, size_t *size)
+    {
+        if (!context || !path || !buffer || !size)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+        *buffer = nullptr;
+        *size = 0;
+
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
+        {
+            return SMB_ERROR_CONNECTION;
+        }
+
+        smb2dir *dir = client->openDirectory(path);
+        if (!dir)
+        {
+            return SMB_ERROR_FILE_NOT_FOUND;
+        }
+
+        // Collect records and names separately, then lay them out in one block
+        std::vector<SmbPackedEntry> records;
+        std::string names;
+        DirEntryRef entry;
+        while (client->readDirectory(dir, &entry))
+        {
+            size_t name_length = strlen(entry.name);
+            SmbPackedEntry record;
+            record.size = entry.size;
+            record.modified_time = entry.modified_time;
+            record.name_offset = static_cast<uint32_t>(names.size());
+            record.name_length = static_cast<uint32_t>(name_length);
+            record.flags = entry.is_directory ? SMB_PACKED_ENTRY_DIRECTORY : 0;
+            record.reserved = 0;
+            records.push_back(record);
+            names.append(entry.name, name_length + 1);
+        }
+        client->closeDirectory(dir);
+
+        uint8_t *block = pack_listing(records, names, size);
+        if (!block)
+        {
+            return SMB_ERROR_MEMORY_ALLOCATION;
+        }
+
+        *buffer = block;
+        return SMB_SUCCESS;
+    }
+
+    void smb_free_packed_listing(uint8_t *buffer)
+    {
+        free(buffer);
+    }
+
+    int smb_walk_tree(SmbContext *context, const char *root, const SmbWalkOptions *options,
+                      SmbWalkBatchCallback callback, void *user_data)
+    {
+        if (!context || !root || !callback)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
+        {
+            return SMB_ERROR_CONNECTION;
+        }
+
+        TreeWalker::Options walk_options;
+        if (options)
+        {
+            if (options->max_connections > 0)
+            {
+                walk_options.max_sessions = options->max_connections;
+            }
+            if (options->batch_size > 0)
+            {
+                walk_options.batch_size = options->batch_size;
+            }
+            walk_options.max_depth = options->max_depth;
+            walk_options.include = split_patterns(options->include);
+            walk_options.exclude = split_patterns(options->exclude);
+            walk_options.cancel = options->cancel;
+        }
+
+        bool out_of_memory = false;
+        std::vector<SmbPackedEntry> records;
+        std::string names;
+        TreeWalker walker(walk_options);
+        int status = walker.run(
+            client, root,
+            [&client]
+            { return ConnectionPool::instance().acquireAnother(client); },
+            [&](std::vector<WalkEntry> &batch)
+            {
+                records.clear();
+                names.clear();
+                for (const auto &entry : batch)
+                {
+                    SmbPackedEntry record;
+                    record.size = entry.size;
+                    record.modified_time = entry.modified_time;
+                    record.name_offset = static_cast<uint32_t>(names.size());
+                    record.name_length = static_cast<uint32_t>(entry.path.size());
+                    record.flags = entry.is_directory ? SMB_PACKED_ENTRY_DIRECTORY : 0;
+                    record.reserved = 0;
+                    records.push_back(record);
+                    names.append(entry.path.c_str(), entry.path.size() + 1);
+                }
+
+                size_t size = 0;
+                uint8_t *block = pack_listing(records, names, &size);
+                if (!block)
+                {
+                    out_of_memory = true;
+                    return;
+                }
+                callback(block, size, user_data);
+            });
+
+        if (status == 0 && out_of_memory)
+        {
+            return SMB_ERROR_MEMORY_ALLOCATION;
+        }
+        return errno_to_smb_error(status);
+    }
+
+    SmbDirectory *smb_opendir(SmbContext *context, const char *path)
+    {
+        if (!context || !path)
+        {
+            return nullptr;
+        }
+
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client)
+        {
+            return nullptr;
+        }
+
+        smb2dir *dir = client->openDirectory(path);
+        if (!dir)
+        {
+            return nullptr;
+        }
+
+        auto cursor = std::make_shared<DirectoryCursor>();
+        cursor->client = client;
+        cursor->dir = dir;
+        uintptr_t dir_id = g_directories.insert(cursor);
+        if (!dir_id)
+        {
+            client->closeDirectory(dir);
+            return nullptr;
+        }
+        return reinterpret_cast<SmbDirectory *>(dir_id);
+    }
+
+    int smb_readdir_batch(SmbDirectory *dir, SmbDirEntry *entries, size_t max_entries,
+                          char *name_arena, size_t arena_size, size_t *count)
+    {
+        if (!dir || !entries || !name_arena || !count || max_entries == 0)
+        {
+            return SMB_ERROR_INVALID_PARAMETER;
+        }
+        *count = 0;
+
+        std::shared_ptr<DirectoryCursor> cursor;
+        if (!g_directories.get(reinterpret_cast<uintptr_t>(dir), &cursor))
+        {
+            return SMB_ERROR_FILE_NOT_FOUND;
+        }
+
+        std::lock_guard<std::mutex> lock(cursor->mutex);
+        size_t arena_used = 0;
+        size_t filled = 0;
+
+        while (filled < max_entries)
+        {
+            DirEntryRef entry;
+            if (cursor->has_pending)
+            {
+                entry = cursor->pending;
+                cursor->has_pending = false;
+            }
+            else if (!cursor->client->readDirectory(cursor->dir, &entry))
+            {
+                break;
+            }
+
+            size_t name_size = strlen(entry.name) + 1;
+            if (name_size > arena_size - arena_used)
+            {
+                // Keep it for the next batch; an arena too small for even one name is an error
+                cursor->pending = entry;
+                cursor->has_pending = true;
+                if (filled == 0)
+                {
+                    return SMB_ERROR_MEMORY_ALLOCATION;
+                }
+                break;
+            }
+
+            char *name = name_arena + arena_used;
+            memcpy(name, entry.name, name_size);
+            arena_used += name_size;
+
+            SmbDirEntry &out = entries[filled++];
+            out.name = name;
+            out.size = entry.size;
+            out.modified_time = entry.modified_time;
+            out.is_directory = entry.is_directory ? 1 : 0;
+        }
+
+        *count = filled;
+        return SMB_SUCCESS;
+    }
+
+    void smb_closedir(SmbDirectory *dir)
+    {
+        if (!dir)
+            return;
+
+        std::shared_ptr<DirectoryCursor> cursor;
+        if (g_directories.remove(reinterpret_cast<uintptr_t>(dir), &cursor))
+        {
+            std::lock_guard<std::mutex> lock(cursor->mutex);
+            cursor->client->closeDirectory(cursor->dir);
+            cursor->dir = nullptr;
+        }
+    }
+
     void smb_free_directory_result(SmbDirectoryResult *result)
     {
         if (!result || !result->files)
@@ -532,9 +1090,35 @@ extern "C"
             return result;
         }
 
-        // For now, return stub result
-        // TODO: Implement actual thumbnail generation
+#ifdef SMB_BRIDGE_WITH_FFMPEG
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (!client || !client->isConnected())
+        {
+            result.error_code = SMB_ERROR_CONNECTION;
+            return result;
+        }
+
+        // Decodes through a custom AVIO context, reading only what FFmpeg asks for
+        ThumbnailGenerator generator;
+        ThumbnailData thumbnail = generator.generateFromSmbFile(client.get(), path, width, height);
+        if (!thumbnail.data)
+        {
+            result.error_code = SMB_ERROR_THUMBNAIL_GENERATION;
+            return result;
+        }
+
+        result.data = thumbnail.data;
+        result.size = thumbnail.size;
+        result.width = thumbnail.width;
+        result.height = thumbnail.height;
+        result.error_code = SMB_SUCCESS;
+        thumbnail.data = nullptr;
+#else
+        // Built without FFmpeg (BUILD_WITH_FFMPEG=OFF)
+        (void)width;
+        (void)height;
         result.error_code = SMB_ERROR_THUMBNAIL_GENERATION;
+#endif
         return result;
     }
 
@@ -598,12 +1182,11 @@ extern "C"
             return nullptr;
         }
 
-        void *context_id = reinterpret_cast<void *>(context);
-        auto it = g_contexts.find(context_id);
-        if (it != g_contexts.end())
+        std::shared_ptr<Smb2ClientWrapper> client = lookup_context(context);
+        if (client)
         {
             // Return the native context pointer
-            return it->second.get();
+            return client.get();
         }
 
         return nullptr;
@@ -2,8 +2,18 @@
 // This file provides SMB functionality using libsmb2 library
 
 #include "smb_client.h"
+#include "read_ahead_cache.h"
+#include "metadata_cache.h"
+#include "read_size_tuner.h"
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
 #include <smb2/libsmb2.h>
 #include <smb2/smb2.h>
+#include <smb2/libsmb2-raw.h>
+#include <cerrno>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
@@ -13,26 +23,391 @@
 #include <sstream>
 #include <thread>
 #include <future>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+
+// Number of read requests kept in flight by the pipelined read path
+static const size_t kDefaultPipelineDepth = 8;
+static const size_t kMaxPipelineDepth = 64;
+// Bytes a pipelined read keeps in flight at most; with large requests the
+// depth shrinks to stay within it
+static const size_t kMaxReadBytesInFlight = 64 * 1024 * 1024;
+
+// Poll interval and no-progress timeout for the async event loop
+static const int kPollIntervalMs = 100;
+static const int kAsyncIoTimeoutMs = 30000;
+
+// Read-ahead window geometry. The worker fills at most one batch of pages
+// per turn, a few read requests' worth, so a foreground read never waits
+// long for io_mutex.
+static const size_t kReadAheadPageSize = 256 * 1024;
+static const size_t kMaxReadAheadBytes = 64 * 1024 * 1024;
+static const size_t kReadAheadBatchPages = 4;
+static const size_t kReadAheadBatchRequests = 4;
+// Read-ahead window of streaming handles unless setStreamingOptions says otherwise
+static const size_t kDefaultReadAheadBytes = 2 * 1024 * 1024;
+
+// Write-behind queue: a batch takes up to kWriteBatchBytes of queued writes
+// onto the wire together; writeRangeAsync blocks once kMaxQueuedWriteBytes
+// are waiting. Single write requests are capped at kMaxWriteRequestSize or
+// the server's MaxWriteSize, whichever is smaller.
+static const size_t kWriteBatchBytes = 16 * 1024 * 1024;
+static const size_t kMaxQueuedWriteBytes = 64 * 1024 * 1024;
+static const size_t kMaxWriteRequestSize = 1024 * 1024;
+
+// Server-side copy (MS-SMB2 3.3.5.15.6). Requests start at 16 chunks of
+// 1 MB, the limits Windows and Samba ship with, and use smaller chunks if
+// the server rejects them; a few requests are kept in flight.
+static const uint32_t kFsctlSrvRequestResumeKey = 0x00140078;
+static const uint32_t kFsctlSrvCopyChunkWrite = 0x001480F2;
+static const uint32_t kNtStatusInvalidParameter = 0xC000000D;
+static const size_t kResumeKeySize = 24;
+static const size_t kCopyChunksPerRequest = 16;
+static const uint32_t kCopyChunkSize = 1024 * 1024;
+static const uint32_t kMinCopyChunkSize = 64 * 1024;
+static const size_t kCopyRequestDepth = 4;
+// Window of the client-side fallback copy
+static const size_t kCopyBufferSize = 8 * 1024 * 1024;
+
+// One-shot CHANGE_NOTIFY watches kept on recently listed directories
+static const size_t kMaxChangeWatches = 16;
+static const uint32_t kChangeNotifyFilter =
+    SMB2_CHANGE_NOTIFY_FILE_NOTIFY_CHANGE_FILE_NAME | SMB2_CHANGE_NOTIFY_FILE_NOTIFY_CHANGE_DIR_NAME |
+    SMB2_CHANGE_NOTIFY_FILE_NOTIFY_CHANGE_SIZE | SMB2_CHANGE_NOTIFY_FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+static int pollSocket(struct pollfd *pfd, int timeout_ms)
+{
+#ifdef _WIN32
+    return WSAPoll(pfd, 1, timeout_ms);
+#else
+    int rc;
+    do
+    {
+        rc = poll(pfd, 1, timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+    return rc;
+#endif
+}
+
+// State shared by all in-flight requests of one pipelined read
+struct PipelinedRead;
+
+struct ReadSlot
+{
+    PipelinedRead *op;
+    uint64_t offset;
+    uint32_t count;
+};
+
+struct PipelinedRead
+{
+    uint64_t base_offset;
+    size_t length;
+    size_t issued;
+    size_t in_flight;
+    uint64_t eof_offset;
+    int status;
+    std::vector<ReadSlot> slots;
+    std::vector<ReadSlot *> free_slots;
+    // For the read size tuner
+    bool completed_any;
+    std::chrono::steady_clock::time_point first_completion;
+};
+
+static void pipelinedReadCallback(struct smb2_context * /*smb2*/, int status,
+                                  void * /*command_data*/, void *cb_data)
+{
+    ReadSlot *slot = static_cast<ReadSlot *>(cb_data);
+    PipelinedRead *op = slot->op;
+
+    op->in_flight--;
+    if (!op->completed_any)
+    {
+        op->completed_any = true;
+        op->first_completion = std::chrono::steady_clock::now();
+    }
+    if (status < 0)
+    {
+        if (op->status == 0)
+        {
+            op->status = status;
+        }
+    }
+    else if (static_cast<uint32_t>(status) < slot->count)
+    {
+        // Short read: the server hit end of file inside this chunk
+        uint64_t end = slot->offset + static_cast<uint32_t>(status);
+        if (end < op->eof_offset)
+        {
+            op->eof_offset = end;
+        }
+    }
+    op->free_slots.push_back(slot);
+}
+
+// One contiguous write of a pipelined write. status and written are filled
+// in as its requests complete.
+struct WriteSegment
+{
+    smb2fh *handle;
+    const uint8_t *data;
+    uint64_t offset;
+    size_t length;
+    size_t written;
+    int status;
+};
+
+struct PipelinedWrite;
+
+struct WriteSlot
+{
+    PipelinedWrite *op;
+    WriteSegment *segment;
+    uint32_t count;
+};
+
+struct PipelinedWrite
+{
+    size_t in_flight;
+    std::vector<WriteSlot> slots;
+    std::vector<WriteSlot *> free_slots;
+};
+
+static void pipelinedWriteCallback(struct smb2_context * /*smb2*/, int status,
+                                   void * /*command_data*/, void *cb_data)
+{
+    WriteSlot *slot = static_cast<WriteSlot *>(cb_data);
+    WriteSegment *segment = slot->segment;
+
+    slot->op->in_flight--;
+    if (status < 0)
+    {
+        if (segment->status == 0)
+        {
+            segment->status = status;
+        }
+    }
+    else if (static_cast<uint32_t>(status) < slot->count)
+    {
+        // Servers only write short when the volume is full
+        if (segment->status == 0)
+        {
+            segment->status = -ENOSPC;
+        }
+    }
+    else
+    {
+        segment->written += slot->count;
+    }
+    slot->op->free_slots.push_back(slot);
+}
+
+// State shared by the smb2_opendir_async requests of one listDirectories call
+struct PipelinedListing;
+
+struct ListingSlot
+{
+    PipelinedListing *op;
+    size_t index;
+};
+
+struct CompletedListing
+{
+    size_t index;
+    int status;
+    smb2dir *dir;
+};
+
+struct PipelinedListing
+{
+    size_t in_flight;
+    std::vector<ListingSlot> slots;
+    std::vector<ListingSlot *> free_slots;
+    std::vector<CompletedListing> completed;
+};
+
+static void pipelinedListingCallback(struct smb2_context * /*smb2*/, int status,
+                                     void *command_data, void *cb_data)
+{
+    ListingSlot *slot = static_cast<ListingSlot *>(cb_data);
+    PipelinedListing *op = slot->op;
+
+    op->in_flight--;
+    CompletedListing listing;
+    listing.index = slot->index;
+    listing.status = status < 0 ? status : 0;
+    listing.dir = status < 0 ? nullptr : static_cast<smb2dir *>(command_data);
+    op->completed.push_back(listing);
+    op->free_slots.push_back(slot);
+}
+
+// One FSCTL of a batch sent with runIoctls. status is the NT status of the
+// reply; output holds up to max_output bytes of it.
+struct IoctlRequest
+{
+    std::vector<uint8_t> input;
+    uint32_t max_output;
+    bool done;
+    uint32_t status;
+    std::vector<uint8_t> output;
+    size_t *in_flight;
+};
+
+static void ioctlCallback(struct smb2_context * /*smb2*/, int status,
+                          void *command_data, void *cb_data)
+{
+    IoctlRequest *request = static_cast<IoctlRequest *>(cb_data);
+    struct smb2_ioctl_reply *reply = static_cast<struct smb2_ioctl_reply *>(command_data);
+
+    (*request->in_flight)--;
+    request->done = true;
+    request->status = static_cast<uint32_t>(status);
+    if (request->status == SMB2_STATUS_SUCCESS && reply && reply->output)
+    {
+        const uint8_t *output = static_cast<const uint8_t *>(reply->output);
+        request->output.assign(output, output + reply->output_count);
+    }
+}
+
+static void appendLe32(std::vector<uint8_t> &buffer, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static void appendLe64(std::vector<uint8_t> &buffer, uint64_t value)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static uint32_t readLe32(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+           static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
 
 // PIMPL implementation for libsmb2
 class Smb2ClientWrapper::Impl
 {
 public:
+    // Per-handle streaming state
+    struct HandleState
+    {
+        std::string path;
+        size_t pipeline_depth;
+        bool writable;
+
+        // Read-ahead window, enabled by setReadAhead
+        std::unique_ptr<ReadAheadCache> read_ahead;
+        uint64_t prefetch_from;
+        uint64_t prefetch_until;
+        bool prefetch_queued;
+        std::vector<uint8_t> prefetch_buffer;
+
+        // Streaming options. request_size 0 leaves read requests to
+        // read_sizer; prefetchRange opens a read-ahead window of
+        // read_ahead_bytes unless caching is off.
+        size_t request_size;
+        size_t read_ahead_bytes;
+        bool caching;
+
+        HandleState()
+            : pipeline_depth(kDefaultPipelineDepth), writable(false), prefetch_from(0), prefetch_until(0),
+              prefetch_queued(false), request_size(0), read_ahead_bytes(kDefaultReadAheadBytes), caching(true) {}
+    };
+
+    // Directory being enumerated through openDirectory/readDirectory
+    struct DirectoryState
+    {
+        std::string path;
+        MetadataCache::ListingToken listing;
+    };
+
+    // Context for a pending CHANGE_NOTIFY
+    struct ChangeWatch
+    {
+        Impl *impl;
+        std::string dir;
+    };
+
+    // Read queued for the async worker. A job without a buffer is a
+    // read-ahead fill for the handle's cache.
+    struct AsyncReadJob
+    {
+        smb2fh *handle;
+        uint8_t *buffer;
+        uint64_t offset;
+        size_t length;
+        ReadCompletionCallback on_complete;
+    };
+
+    // Write queued by writeRangeAsync; owns a copy of the caller's data
+    struct AsyncWriteJob
+    {
+        smb2fh *handle;
+        std::vector<uint8_t> data;
+        uint64_t offset;
+    };
+
+    // Write-behind accounting for one handle, guarded by async_mutex
+    struct WriteQueue
+    {
+        size_t pending_jobs;
+        int status;
+        uint64_t bytes_written;
+        WriteProgressCallback on_progress;
+
+        WriteQueue() : pending_jobs(0), status(0), bytes_written(0) {}
+    };
+
     smb2_context *context;
     std::string server;
     std::string share;
     std::string username;
     std::string password;
     std::string domain;
-    bool connected;
+    // Written under io_mutex, but read without it by the pool and the fast paths
+    std::atomic<bool> connected;
     std::string share_url;
 
-    // Streaming options
-    size_t chunk_size;
-    size_t buffer_size;
-    bool enable_caching;
-
-    Impl() : context(nullptr), connected(false), chunk_size(64 * 1024), buffer_size(2 * 1024 * 1024), enable_caching(true)
+    // Read request sizing, learned from this connection's reads
+    ReadSizeTuner read_sizer;
+
+    // libsmb2 contexts are not thread-safe; every call into the context
+    // (sync or async) happens with this mutex held.
+    std::recursive_mutex io_mutex;
+    std::unordered_map<smb2fh *, HandleState> handles;
+    std::unordered_map<smb2dir *, DirectoryState> directories;
+
+    // Stat cache, filled by listings and invalidated by CHANGE_NOTIFY
+    MetadataCache metadata;
+    std::unordered_set<std::string> watched_dirs;
+
+    // Async read worker, started on first use
+    std::thread async_worker;
+    std::mutex async_mutex;
+    std::condition_variable async_cv;
+    std::deque<AsyncReadJob> async_jobs;
+    bool async_stop;
+
+    // Write-behind queue, serviced by the same worker in turns with reads
+    std::deque<AsyncWriteJob> write_jobs;
+    std::unordered_map<smb2fh *, WriteQueue> write_queues;
+    size_t queued_write_bytes;
+    std::condition_variable write_cv;
+
+    Impl() : context(nullptr), connected(false), async_stop(false), queued_write_bytes(0)
     {
         // Initialize libsmb2 context
         context = smb2_init_context();
@@ -44,6 +419,7 @@ public:
 
     ~Impl()
     {
+        stopAsyncWorker();
         disconnect();
     }
 
@@ -90,8 +466,8 @@ public:
         url_stream << "smb://" << server << "/" << share;
         share_url = url_stream.str();
 
-        // Connect to the share
-        int result = smb2_connect_share(context, share_url.c_str(), nullptr);
+        // Connect to the share (user comes from smb2_set_user above)
+        int result = smb2_connect_share(context, server.c_str(), share.c_str(), nullptr);
         if (result < 0)
         {
             std::cerr << "Failed to connect to SMB share: " << smb2_get_error(context) << std::endl;
@@ -99,8 +475,949 @@ public:
         }
 
         connected = true;
+        // Requests up to MaxReadSize; libsmb2 charges the extra credits of
+        // reads past 64 KB on SMB 2.1 and later
+        read_sizer.setServerLimit(smb2_get_max_read_size(context));
         return true;
     }
+
+    HandleState *stateFor(smb2fh *handle)
+    {
+        auto it = handles.find(handle);
+        return it != handles.end() ? &it->second : nullptr;
+    }
+
+    static CachedStat toCachedStat(const struct smb2_stat_64 &st)
+    {
+        CachedStat stat;
+        stat.exists = true;
+        stat.size = st.smb2_size;
+        stat.modified_time = st.smb2_mtime;
+        stat.is_directory = (st.smb2_type == SMB2_TYPE_DIRECTORY);
+        return stat;
+    }
+
+    void cacheDirEntry(const std::string &dir, const struct smb2dirent *entry)
+    {
+        if (strcmp(entry->name, ".") == 0 || strcmp(entry->name, "..") == 0)
+        {
+            return;
+        }
+        metadata.store(dir + "/" + entry->name, toCachedStat(entry->st));
+    }
+
+    // Stat through the cache. Returns false on errors other than "not found".
+    bool statPath(const std::string &path, CachedStat *out)
+    {
+        if (metadata.lookup(path, out))
+        {
+            return true;
+        }
+
+        struct smb2_stat_64 st;
+        int result = smb2_stat(context, path.c_str(), &st);
+        if (result == -ENOENT)
+        {
+            out->exists = false;
+            out->size = 0;
+            out->modified_time = 0;
+            out->is_directory = false;
+            metadata.storeMissing(path);
+            return true;
+        }
+        if (result < 0)
+        {
+            return false;
+        }
+
+        *out = toCachedStat(st);
+        metadata.store(path, *out);
+        return true;
+    }
+
+    static void changeNotifyCallback(struct smb2_context * /*smb2*/, int /*status*/,
+                                     void * /*command_data*/, void *cb_data)
+    {
+        // Any outcome, including cancellation on disconnect, drops what we knew
+        ChangeWatch *watch = static_cast<ChangeWatch *>(cb_data);
+        watch->impl->metadata.invalidateDirectory(watch->dir);
+        watch->impl->watched_dirs.erase(watch->dir);
+        delete watch;
+    }
+
+    // Arm a one-shot change notification so a cached listing is dropped
+    // as soon as the server reports a change. Callbacks run from whichever
+    // call next services the socket, always under io_mutex.
+    void watchDirectory(const std::string &dir)
+    {
+        std::string key = MetadataCache::normalize(dir);
+        if (!metadata.enabled() || watched_dirs.count(key) || watched_dirs.size() >= kMaxChangeWatches)
+        {
+            return;
+        }
+
+        ChangeWatch *watch = new ChangeWatch{this, key};
+        if (smb2_notify_change_async(context, key.c_str(), 0, kChangeNotifyFilter, 0,
+                                     changeNotifyCallback, watch) < 0)
+        {
+            delete watch;
+            return;
+        }
+        watched_dirs.insert(key);
+    }
+
+    // Drop a broken connection. Destroying the context fails every pending
+    // PDU, which runs the outstanding completion callbacks.
+    void abortConnection()
+    {
+        connected = false;
+        if (context)
+        {
+            smb2_destroy_context(context);
+            context = nullptr;
+        }
+    }
+
+    // Wait for socket readiness and let libsmb2 process it.
+    bool serviceSocket(int timeout_ms)
+    {
+        struct pollfd pfd;
+        pfd.fd = smb2_get_fd(context);
+        pfd.events = static_cast<short>(smb2_which_events(context));
+        pfd.revents = 0;
+
+        int rc = pollSocket(&pfd, timeout_ms);
+        if (rc < 0)
+        {
+            return false;
+        }
+        if (rc == 0)
+        {
+            return true;
+        }
+        return smb2_service(context, pfd.revents) >= 0;
+    }
+
+    // One turn of the event loop for a pipelined operation with in_flight
+    // requests outstanding. Drops the connection and returns false if the
+    // socket fails or nothing has completed for kAsyncIoTimeoutMs.
+    bool awaitCompletions(const size_t &in_flight, std::chrono::steady_clock::time_point *last_progress,
+                          const char *operation)
+    {
+        size_t pending = in_flight;
+        if (!serviceSocket(kPollIntervalMs))
+        {
+            std::cerr << "SMB connection lost during async " << operation << std::endl;
+            abortConnection();
+            return false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (in_flight < pending)
+        {
+            *last_progress = now;
+        }
+        else if (now - *last_progress > std::chrono::milliseconds(kAsyncIoTimeoutMs))
+        {
+            std::cerr << "SMB async " << operation << " timed out" << std::endl;
+            abortConnection();
+            return false;
+        }
+        return true;
+    }
+
+    // Read [offset, offset + length) keeping up to `depth` smb2_pread_async
+    // requests in flight, fewer when requests are large. Requests are sized
+    // by readRequestSize and each read feeds read_sizer. Must be called with
+    // io_mutex held.
+    size_t pipelinedRead(smb2fh *handle, uint8_t *buffer, uint64_t offset, size_t length,
+                         size_t depth, int *status_out)
+    {
+        PipelinedRead op;
+        op.base_offset = offset;
+        op.length = length;
+        op.issued = 0;
+        op.in_flight = 0;
+        op.eof_offset = UINT64_MAX;
+        op.status = 0;
+        op.completed_any = false;
+
+        size_t request_size = readRequestSize(stateFor(handle));
+        depth = std::min(depth, std::max<size_t>(1, kMaxReadBytesInFlight / request_size));
+        op.slots.resize(std::max<size_t>(1, depth));
+        for (auto &slot : op.slots)
+        {
+            op.free_slots.push_back(&slot);
+        }
+
+        auto started = std::chrono::steady_clock::now();
+        auto last_progress = started;
+
+        while (true)
+        {
+            while (op.status == 0 && !op.free_slots.empty() && op.issued < op.length &&
+                   op.base_offset + op.issued < op.eof_offset)
+            {
+                ReadSlot *slot = op.free_slots.back();
+                op.free_slots.pop_back();
+                slot->op = &op;
+                slot->offset = op.base_offset + op.issued;
+                slot->count = static_cast<uint32_t>(std::min(request_size, op.length - op.issued));
+
+                if (smb2_pread_async(context, handle, buffer + op.issued, slot->count, slot->offset,
+                                     pipelinedReadCallback, slot) < 0)
+                {
+                    std::cerr << "Failed to queue async read: " << smb2_get_error(context) << std::endl;
+                    op.free_slots.push_back(slot);
+                    op.status = -EIO;
+                    break;
+                }
+
+                op.issued += slot->count;
+                op.in_flight++;
+            }
+
+            if (op.in_flight == 0 || !awaitCompletions(op.in_flight, &last_progress, "read"))
+            {
+                break;
+            }
+        }
+
+        if (op.in_flight > 0 && op.status == 0)
+        {
+            op.status = -ECONNRESET;
+        }
+
+        if (status_out)
+        {
+            *status_out = op.status;
+        }
+        if (op.status < 0)
+        {
+            return 0;
+        }
+
+        uint64_t end = std::min<uint64_t>(op.base_offset + op.length, op.eof_offset);
+        size_t bytes_read = end > op.base_offset ? static_cast<size_t>(end - op.base_offset) : 0;
+        if (op.completed_any)
+        {
+            auto micros = [started](std::chrono::steady_clock::time_point at)
+            {
+                return static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(at - started).count());
+            };
+            read_sizer.noteTransfer(request_size, op.slots.size(), bytes_read, micros(op.first_completion),
+                                    micros(std::chrono::steady_clock::now()));
+        }
+        return bytes_read;
+    }
+
+    // Size of the read requests pipelinedRead issues for a handle
+    size_t readRequestSize(const HandleState *state) const
+    {
+        return state && state->request_size > 0 ? read_sizer.clamp(state->request_size) : read_sizer.requestSize();
+    }
+
+    // Read at the file position, bypassing the read-ahead window. smb2_read
+    // stops at one request, so anything larger is pipelined. Caller must
+    // hold io_mutex.
+    size_t uncachedRead(smb2fh *handle, HandleState *state, uint8_t *buffer, size_t size)
+    {
+        if (!state || !connected || size <= readRequestSize(state))
+        {
+            int bytes_read = smb2_read(context, handle, buffer, static_cast<uint32_t>(size));
+            return bytes_read > 0 ? static_cast<size_t>(bytes_read) : 0;
+        }
+
+        uint64_t position = 0;
+        if (smb2_lseek(context, handle, 0, SEEK_CUR, &position) < 0)
+        {
+            return 0;
+        }
+        int status = 0;
+        size_t bytes_read = pipelinedRead(handle, buffer, position, size, state->pipeline_depth, &status);
+        if (status < 0)
+        {
+            return 0;
+        }
+        if (context)
+        {
+            smb2_lseek(context, handle, position + bytes_read, SEEK_SET, nullptr);
+        }
+        return bytes_read;
+    }
+
+    // Write every segment keeping up to `depth` smb2_pwrite_async requests in
+    // flight across all of them. Segments that already carry an error are
+    // skipped. Must be called with io_mutex held.
+    void pipelinedWrite(std::vector<WriteSegment> &segments, size_t depth)
+    {
+        PipelinedWrite op;
+        op.in_flight = 0;
+        op.slots.resize(std::max<size_t>(1, depth));
+        for (auto &slot : op.slots)
+        {
+            op.free_slots.push_back(&slot);
+        }
+
+        size_t request_size = kMaxWriteRequestSize;
+        uint32_t max_write = smb2_get_max_write_size(context);
+        if (max_write > 0 && request_size > max_write)
+        {
+            request_size = max_write;
+        }
+
+        size_t current = 0;
+        size_t issued = 0;
+        bool queue_failed = false;
+        auto last_progress = std::chrono::steady_clock::now();
+
+        while (true)
+        {
+            while (!queue_failed && !op.free_slots.empty() && current < segments.size())
+            {
+                WriteSegment &segment = segments[current];
+                if (segment.status < 0 || issued >= segment.length)
+                {
+                    current++;
+                    issued = 0;
+                    continue;
+                }
+
+                WriteSlot *slot = op.free_slots.back();
+                op.free_slots.pop_back();
+                slot->op = &op;
+                slot->segment = &segment;
+                slot->count = static_cast<uint32_t>(std::min(request_size, segment.length - issued));
+
+                // Older libsmb2 releases take a non-const buffer
+                if (smb2_pwrite_async(context, segment.handle, const_cast<uint8_t *>(segment.data + issued),
+                                      slot->count, segment.offset + issued, pipelinedWriteCallback, slot) < 0)
+                {
+                    std::cerr << "Failed to queue async write: " << smb2_get_error(context) << std::endl;
+                    op.free_slots.push_back(slot);
+                    queue_failed = true;
+                    break;
+                }
+
+                issued += slot->count;
+                op.in_flight++;
+            }
+
+            if (op.in_flight == 0 || !awaitCompletions(op.in_flight, &last_progress, "write"))
+            {
+                break;
+            }
+        }
+
+        // Whatever was never issued or never completed failed
+        for (auto &segment : segments)
+        {
+            if (segment.status == 0 && segment.written < segment.length)
+            {
+                segment.status = op.in_flight > 0 ? -ECONNRESET : -EIO;
+            }
+        }
+    }
+
+    // Put a batch of queued writes on the wire together and report progress
+    // for the handles involved. Runs on the async worker.
+    void runWriteBatch()
+    {
+        std::vector<AsyncWriteJob> batch;
+        std::vector<WriteSegment> segments;
+        {
+            std::lock_guard<std::recursive_mutex> io_lock(io_mutex);
+            {
+                std::lock_guard<std::mutex> lock(async_mutex);
+                size_t batch_bytes = 0;
+                while (!write_jobs.empty() &&
+                       (batch.empty() || batch_bytes + write_jobs.front().data.size() <= kWriteBatchBytes))
+                {
+                    batch_bytes += write_jobs.front().data.size();
+                    batch.push_back(std::move(write_jobs.front()));
+                    write_jobs.pop_front();
+                }
+
+                // After a failure the rest of a handle's queue is dropped, not written around
+                for (auto &job : batch)
+                {
+                    WriteSegment segment = {job.handle, job.data.data(), job.offset, job.data.size(), 0, 0};
+                    auto queue = write_queues.find(job.handle);
+                    if (queue != write_queues.end() && queue->second.status < 0)
+                    {
+                        segment.status = -ECANCELED;
+                    }
+                    segments.push_back(segment);
+                }
+            }
+            if (batch.empty())
+            {
+                return;
+            }
+
+            size_t depth = 1;
+            for (auto &segment : segments)
+            {
+                HandleState *state = stateFor(segment.handle);
+                if (!context || !connected || !state)
+                {
+                    if (segment.status == 0)
+                    {
+                        segment.status = -EBADF;
+                    }
+                    continue;
+                }
+                depth = std::max(depth, state->pipeline_depth);
+            }
+            if (context && connected)
+            {
+                pipelinedWrite(segments, depth);
+            }
+
+            for (auto &segment : segments)
+            {
+                HandleState *state = stateFor(segment.handle);
+                if (state)
+                {
+                    metadata.invalidate(state->path);
+                }
+            }
+        }
+
+        struct ProgressNotice
+        {
+            WriteProgressCallback on_progress;
+            int status;
+            uint64_t bytes_written;
+        };
+        std::vector<ProgressNotice> notices;
+        {
+            std::lock_guard<std::mutex> lock(async_mutex);
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                auto queue = write_queues.find(batch[i].handle);
+                if (queue == write_queues.end())
+                {
+                    continue;
+                }
+                queue->second.bytes_written += segments[i].written;
+                if (segments[i].status < 0 && queue->second.status == 0)
+                {
+                    queue->second.status = segments[i].status;
+                }
+            }
+
+            std::unordered_set<smb2fh *> reported;
+            for (auto &job : batch)
+            {
+                auto queue = write_queues.find(job.handle);
+                if (queue != write_queues.end() && queue->second.on_progress && reported.insert(job.handle).second)
+                {
+                    notices.push_back({queue->second.on_progress, queue->second.status, queue->second.bytes_written});
+                }
+            }
+        }
+
+        // The jobs stay pending until reported, so a flush also waits for the
+        // last progress callback
+        for (auto &notice : notices)
+        {
+            notice.on_progress(notice.status, notice.bytes_written);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(async_mutex);
+            for (auto &job : batch)
+            {
+                queued_write_bytes -= job.data.size();
+                auto queue = write_queues.find(job.handle);
+                if (queue != write_queues.end())
+                {
+                    queue->second.pending_jobs--;
+                }
+            }
+        }
+        write_cv.notify_all();
+    }
+
+    // Send every request as an FSCTL on handle and wait for the replies.
+    // Returns false if any of them could not be sent or the connection was
+    // lost waiting. Must be called with io_mutex held.
+    bool runIoctls(smb2fh *handle, uint32_t ctl_code, std::vector<IoctlRequest> &requests)
+    {
+        size_t in_flight = 0;
+        bool queued_all = true;
+        for (auto &request : requests)
+        {
+            request.done = false;
+            request.status = 0;
+            request.output.clear();
+            request.in_flight = &in_flight;
+
+            struct smb2_ioctl_request req;
+            memset(&req, 0, sizeof(req));
+            req.ctl_code = ctl_code;
+            memcpy(req.file_id, *smb2_get_file_id(handle), SMB2_FD_SIZE);
+            req.input_count = static_cast<uint32_t>(request.input.size());
+            req.input = request.input.empty() ? nullptr : request.input.data();
+            req.max_output_response = request.max_output;
+            req.flags = SMB2_0_IOCTL_IS_FSCTL;
+
+            struct smb2_pdu *pdu = smb2_cmd_ioctl_async(context, &req, ioctlCallback, &request);
+            if (!pdu)
+            {
+                std::cerr << "Failed to queue ioctl: " << smb2_get_error(context) << std::endl;
+                queued_all = false;
+                break;
+            }
+            smb2_queue_pdu(context, pdu);
+            in_flight++;
+        }
+
+        auto last_progress = std::chrono::steady_clock::now();
+        while (in_flight > 0)
+        {
+            if (!awaitCompletions(in_flight, &last_progress, "ioctl"))
+            {
+                return false;
+            }
+        }
+        return queued_all;
+    }
+
+    // Copy [*copied, size) with FSCTL_SRV_COPYCHUNK_WRITE, advancing *copied
+    // as requests complete in order. Returns -EOPNOTSUPP when the server
+    // refuses, so the caller can carry on through the client from *copied.
+    int copyChunks(smb2fh *source, smb2fh *destination, uint64_t size, uint64_t *copied,
+                   const CopyProgressCallback &on_progress)
+    {
+        std::vector<uint8_t> resume_key;
+        {
+            std::lock_guard<std::recursive_mutex> lock(io_mutex);
+            if (!context || !connected)
+            {
+                return -ENOTCONN;
+            }
+            std::vector<IoctlRequest> requests(1);
+            requests[0].max_output = 32;
+            if (!runIoctls(source, kFsctlSrvRequestResumeKey, requests))
+            {
+                return -ECONNRESET;
+            }
+            if (requests[0].status != SMB2_STATUS_SUCCESS || requests[0].output.size() < kResumeKeySize)
+            {
+                return -EOPNOTSUPP;
+            }
+            resume_key.assign(requests[0].output.begin(), requests[0].output.begin() + kResumeKeySize);
+        }
+
+        uint32_t chunk_size = kCopyChunkSize;
+        while (*copied < size)
+        {
+            // A round of consecutive requests, each SRV_COPYCHUNK_COPY with
+            // the source key and its chunk list
+            std::vector<IoctlRequest> requests;
+            std::vector<uint64_t> request_ends;
+            uint64_t offset = *copied;
+            while (requests.size() < kCopyRequestDepth && offset < size)
+            {
+                IoctlRequest request;
+                request.input = resume_key;
+                appendLe32(request.input, 0); // ChunkCount, set below
+                appendLe32(request.input, 0);
+
+                uint32_t chunk_count = 0;
+                while (chunk_count < kCopyChunksPerRequest && offset < size)
+                {
+                    uint32_t length = static_cast<uint32_t>(std::min<uint64_t>(chunk_size, size - offset));
+                    appendLe64(request.input, offset);
+                    appendLe64(request.input, offset);
+                    appendLe32(request.input, length);
+                    appendLe32(request.input, 0);
+                    offset += length;
+                    chunk_count++;
+                }
+                for (int i = 0; i < 4; i++)
+                {
+                    request.input[kResumeKeySize + i] = static_cast<uint8_t>(chunk_count >> (8 * i));
+                }
+                request.max_output = 12;
+                requests.push_back(std::move(request));
+                request_ends.push_back(offset);
+            }
+
+            {
+                std::lock_guard<std::recursive_mutex> lock(io_mutex);
+                if (!context || !connected)
+                {
+                    return -ENOTCONN;
+                }
+                if (!runIoctls(destination, kFsctlSrvCopyChunkWrite, requests))
+                {
+                    return -ECONNRESET;
+                }
+            }
+
+            // Progress only counts the requests that succeeded in order; a
+            // later one that succeeded after a failure is simply sent again
+            uint64_t start = *copied;
+            bool rejected = false;
+            for (size_t i = 0; i < requests.size(); i++)
+            {
+                const IoctlRequest &request = requests[i];
+                uint64_t expected = request_ends[i] - (i == 0 ? start : request_ends[i - 1]);
+                if (request.status == SMB2_STATUS_SUCCESS && request.output.size() >= 12 &&
+                    readLe32(request.output.data() + 8) == expected)
+                {
+                    *copied = request_ends[i];
+                    continue;
+                }
+                rejected = true;
+                if (request.status == kNtStatusInvalidParameter && chunk_size > kMinCopyChunkSize)
+                {
+                    // Over the server's chunk limits; its reply carries them, but
+                    // libsmb2 does not pass error bodies through
+                    chunk_size /= 4;
+                    break;
+                }
+                return -EOPNOTSUPP;
+            }
+
+            if (!rejected || *copied > start)
+            {
+                if (on_progress)
+                {
+                    on_progress(*copied, size);
+                }
+            }
+        }
+        return 0;
+    }
+
+    // Copy [offset, size) by reading into a window and writing it back, both
+    // pipelined. io_mutex is held per window only.
+    int copyThroughClient(smb2fh *source, smb2fh *destination, uint64_t size, uint64_t offset,
+                          const CopyProgressCallback &on_progress)
+    {
+        std::vector<uint8_t> buffer(static_cast<size_t>(std::min<uint64_t>(kCopyBufferSize, size - offset)));
+        while (offset < size)
+        {
+            size_t length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), size - offset));
+            {
+                std::lock_guard<std::recursive_mutex> lock(io_mutex);
+                if (!context || !connected)
+                {
+                    return -ENOTCONN;
+                }
+
+                int status = 0;
+                size_t bytes_read = pipelinedRead(source, buffer.data(), offset, length, kDefaultPipelineDepth, &status);
+                if (status < 0)
+                {
+                    return status;
+                }
+                if (bytes_read < length)
+                {
+                    // The source shrank while being copied
+                    return -EIO;
+                }
+
+                std::vector<WriteSegment> segments(1);
+                segments[0] = {destination, buffer.data(), offset, length, 0, 0};
+                pipelinedWrite(segments, kDefaultPipelineDepth);
+                if (segments[0].status < 0)
+                {
+                    return segments[0].status;
+                }
+            }
+
+            offset += length;
+            if (on_progress)
+            {
+                on_progress(offset, size);
+            }
+        }
+        return 0;
+    }
+
+    void startAsyncWorker()
+    {
+        if (async_worker.joinable())
+        {
+            return;
+        }
+        async_worker = std::thread(&Impl::asyncWorkerLoop, this);
+    }
+
+    void asyncWorkerLoop()
+    {
+        bool wrote_last = false;
+        while (true)
+        {
+            bool write_turn;
+            {
+                std::unique_lock<std::mutex> lock(async_mutex);
+                async_cv.wait(lock, [this]
+                              { return async_stop || !async_jobs.empty() || !write_jobs.empty(); });
+                if (async_stop)
+                {
+                    return;
+                }
+                // Alternate so neither a long upload nor a read-ahead starves the other
+                write_turn = !write_jobs.empty() && (async_jobs.empty() || !wrote_last);
+            }
+
+            wrote_last = write_turn;
+            if (write_turn)
+            {
+                runWriteBatch();
+                continue;
+            }
+
+            AsyncReadJob job;
+            int status = 0;
+            size_t bytes_read = 0;
+            {
+                // Lock order is io_mutex before async_mutex so that closeFile
+                // can never run between dequeuing a job and servicing it.
+                std::lock_guard<std::recursive_mutex> io_lock(io_mutex);
+                {
+                    std::lock_guard<std::mutex> lock(async_mutex);
+                    if (async_jobs.empty())
+                    {
+                        continue;
+                    }
+                    job = std::move(async_jobs.front());
+                    async_jobs.pop_front();
+                }
+
+                HandleState *state = stateFor(job.handle);
+                if (!job.buffer)
+                {
+                    if (state && state->read_ahead && context && connected &&
+                        fillReadAhead(job.handle, state))
+                    {
+                        // More to fetch: go to the back so other reads interleave
+                        std::lock_guard<std::mutex> lock(async_mutex);
+                        async_jobs.push_back(std::move(job));
+                    }
+                    else if (state)
+                    {
+                        state->prefetch_queued = false;
+                    }
+                    continue;
+                }
+
+                if (!context || !connected || !state)
+                {
+                    status = -EBADF;
+                }
+                else
+                {
+                    bytes_read = pipelinedRead(job.handle, job.buffer, job.offset, job.length,
+                                               state->pipeline_depth, &status);
+                    if (status == 0 && context)
+                    {
+                        smb2_lseek(context, job.handle, job.offset + bytes_read, SEEK_SET, nullptr);
+                    }
+                }
+            }
+
+            job.on_complete(status, bytes_read);
+        }
+    }
+
+    // Queue a read-ahead fill of [from, until). Caller must hold io_mutex.
+    void scheduleReadAhead(smb2fh *handle, HandleState *state, uint64_t from, uint64_t until)
+    {
+        state->prefetch_from = from;
+        state->prefetch_until = until;
+        if (state->prefetch_queued)
+        {
+            return;
+        }
+
+        AsyncReadJob job;
+        job.handle = handle;
+        job.buffer = nullptr;
+        job.offset = from;
+        job.length = 0;
+        {
+            std::lock_guard<std::mutex> lock(async_mutex);
+            if (async_stop)
+            {
+                return;
+            }
+            async_jobs.push_back(std::move(job));
+        }
+        state->prefetch_queued = true;
+        startAsyncWorker();
+        async_cv.notify_one();
+    }
+
+    // Fetch one batch of missing pages. Returns true if more remain.
+    bool fillReadAhead(smb2fh *handle, HandleState *state)
+    {
+        ReadAheadCache &cache = *state->read_ahead;
+        size_t page_size = cache.pageSize();
+        uint64_t until = std::min(state->prefetch_until, cache.endOfFile());
+        uint64_t from = cache.firstMissing(state->prefetch_from);
+
+        // Reserve a run of contiguous missing pages so one pipelined read fills them
+        size_t batch_pages = std::max(kReadAheadBatchPages, kReadAheadBatchRequests * readRequestSize(state) / page_size);
+        std::vector<uint8_t *> pages;
+        uint64_t next = from;
+        while (pages.size() < batch_pages && next < until && cache.firstMissing(next) == next)
+        {
+            uint8_t *page = cache.reservePage(next);
+            if (!page)
+            {
+                break;
+            }
+            pages.push_back(page);
+            next += page_size;
+        }
+        if (pages.empty())
+        {
+            return false;
+        }
+
+        size_t length = pages.size() * page_size;
+        state->prefetch_buffer.resize(length);
+        int status = 0;
+        size_t bytes_read = pipelinedRead(handle, state->prefetch_buffer.data(), from, length,
+                                          state->pipeline_depth, &status);
+        if (status < 0)
+        {
+            for (size_t i = 0; i < pages.size(); i++)
+            {
+                cache.releasePage(from + i * page_size);
+            }
+            return false;
+        }
+
+        for (size_t i = 0; i < pages.size(); i++)
+        {
+            size_t start = i * page_size;
+            size_t count = bytes_read > start ? std::min(page_size, bytes_read - start) : 0;
+            memcpy(pages[i], state->prefetch_buffer.data() + start, count);
+            cache.commitPage(from + start, count);
+        }
+
+        if (bytes_read < length)
+        {
+            cache.setEndOfFile(from + bytes_read);
+            return false;
+        }
+        state->prefetch_from = next;
+        return next < until;
+    }
+
+    // Keep the window ahead of a sequential reader filled
+    void extendReadAhead(smb2fh *handle, HandleState *state)
+    {
+        ReadAheadCache &cache = *state->read_ahead;
+        if (!cache.isSequential())
+        {
+            return;
+        }
+
+        uint64_t until = cache.position() + cache.capacityBytes();
+        uint64_t from = cache.firstMissing(cache.position());
+        if (from < until && from < cache.endOfFile())
+        {
+            scheduleReadAhead(handle, state, from, until);
+        }
+    }
+
+    // Serve a read from the read-ahead cache, fetching whatever is missing
+    // directly. Caller must hold io_mutex and updates the file position.
+    size_t cachedRead(smb2fh *handle, HandleState *state, uint8_t *buffer, uint64_t offset, size_t size)
+    {
+        ReadAheadCache &cache = *state->read_ahead;
+        size_t served = cache.read(offset, buffer, size);
+
+        if (served < size && offset + served < cache.endOfFile())
+        {
+            int status = 0;
+            size_t bytes_read = pipelinedRead(handle, buffer + served, offset + served, size - served,
+                                              state->pipeline_depth, &status);
+            if (status < 0 && served == 0)
+            {
+                return 0;
+            }
+            if (status == 0 && bytes_read < size - served)
+            {
+                cache.setEndOfFile(offset + served + bytes_read);
+            }
+            served += bytes_read;
+        }
+
+        cache.noteAccess(offset, served);
+        if (context && connected)
+        {
+            extendReadAhead(handle, state);
+        }
+        return served;
+    }
+
+    // Remove queued (not yet started) reads. Caller must hold io_mutex.
+    std::deque<AsyncReadJob> takeQueuedJobs(smb2fh *handle)
+    {
+        std::deque<AsyncReadJob> taken;
+        std::lock_guard<std::mutex> lock(async_mutex);
+        for (auto it = async_jobs.begin(); it != async_jobs.end();)
+        {
+            if (!handle || it->handle == handle)
+            {
+                taken.push_back(std::move(*it));
+                it = async_jobs.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return taken;
+    }
+
+    void stopAsyncWorker()
+    {
+        std::deque<AsyncReadJob> cancelled;
+        {
+            std::lock_guard<std::recursive_mutex> io_lock(io_mutex);
+            cancelled = takeQueuedJobs(nullptr);
+            std::lock_guard<std::mutex> lock(async_mutex);
+            async_stop = true;
+
+            // Queued writes are lost; flushWrites reports it
+            for (auto &job : write_jobs)
+            {
+                WriteQueue &queue = write_queues[job.handle];
+                queue.pending_jobs--;
+                if (queue.status == 0)
+                {
+                    queue.status = -ECANCELED;
+                }
+                queued_write_bytes -= job.data.size();
+            }
+            write_jobs.clear();
+        }
+        async_cv.notify_all();
+        write_cv.notify_all();
+        if (async_worker.joinable())
+        {
+            async_worker.join();
+        }
+        for (auto &job : cancelled)
+        {
+            if (job.on_complete)
+            {
+                job.on_complete(-ECANCELED, 0);
+            }
+        }
+    }
 };
 
 // Constructor and Destructor
@@ -118,6 +1435,7 @@ bool Smb2ClientWrapper::connect(const std::string &server, const std::string &sh
 
 void Smb2ClientWrapper::disconnect()
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     pImpl->disconnect();
 }
 
@@ -126,9 +1444,19 @@ bool Smb2ClientWrapper::isConnected() const
     return pImpl->connected;
 }
 
+void Smb2ClientWrapper::getConnectionParameters(std::string *server, std::string *share, std::string *username,
+                                                std::string *password) const
+{
+    *server = pImpl->server;
+    *share = pImpl->share;
+    *username = pImpl->username;
+    *password = pImpl->password;
+}
+
 // File operations
 smb2fh *Smb2ClientWrapper::openFile(const std::string &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!pImpl->context || !pImpl->connected)
     {
         return nullptr;
@@ -138,31 +1466,77 @@ smb2fh *Smb2ClientWrapper::openFile(const std::string &path)
     if (!file_handle)
     {
         std::cerr << "Failed to open file: " << path << " - " << smb2_get_error(pImpl->context) << std::endl;
+        return nullptr;
     }
+    pImpl->handles[file_handle] = Impl::HandleState();
+    pImpl->handles[file_handle].path = path;
     return file_handle;
 }
 
 void Smb2ClientWrapper::closeFile(smb2fh *handle)
 {
-    if (handle && pImpl->context)
+    // Write-behind data must reach the server before the handle goes away
+    flushWrites(handle);
     {
-        smb2_close(pImpl->context, handle);
+        std::lock_guard<std::mutex> lock(pImpl->async_mutex);
+        pImpl->write_queues.erase(handle);
+    }
+
+    std::deque<Impl::AsyncReadJob> cancelled;
+    {
+        std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+        cancelled = pImpl->takeQueuedJobs(handle);
+        Impl::HandleState *state = pImpl->stateFor(handle);
+        if (state && state->writable)
+        {
+            pImpl->metadata.invalidate(state->path);
+        }
+        pImpl->handles.erase(handle);
+        if (handle && pImpl->context)
+        {
+            smb2_close(pImpl->context, handle);
+        }
+    }
+
+    for (auto &job : cancelled)
+    {
+        if (job.on_complete)
+        {
+            job.on_complete(-ECANCELED, 0);
+        }
     }
 }
 
 size_t Smb2ClientWrapper::readFile(smb2fh *handle, uint8_t *buffer, size_t size)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !buffer || !pImpl->context)
     {
         return 0;
     }
 
-    int bytes_read = smb2_read(pImpl->context, handle, buffer, size);
-    return bytes_read > 0 ? static_cast<size_t>(bytes_read) : 0;
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (state && state->read_ahead && pImpl->connected)
+    {
+        uint64_t position = 0;
+        if (smb2_lseek(pImpl->context, handle, 0, SEEK_CUR, &position) < 0)
+        {
+            return 0;
+        }
+        size_t bytes_read = pImpl->cachedRead(handle, state, buffer, position, size);
+        if (pImpl->context)
+        {
+            smb2_lseek(pImpl->context, handle, position + bytes_read, SEEK_SET, nullptr);
+        }
+        return bytes_read;
+    }
+
+    return pImpl->uncachedRead(handle, state, buffer, size);
 }
 
 bool Smb2ClientWrapper::seekFile(smb2fh *handle, uint64_t offset)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !pImpl->context)
     {
         return false;
@@ -174,11 +1548,19 @@ bool Smb2ClientWrapper::seekFile(smb2fh *handle, uint64_t offset)
 
 uint64_t Smb2ClientWrapper::getFileSize(smb2fh *handle)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !pImpl->context)
     {
         return 0;
     }
 
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    CachedStat cached;
+    if (state && pImpl->metadata.lookup(state->path, &cached) && cached.exists)
+    {
+        return cached.size;
+    }
+
     struct smb2_stat_64 st;
     int result = smb2_fstat(pImpl->context, handle, &st);
     if (result < 0)
@@ -186,41 +1568,86 @@ uint64_t Smb2ClientWrapper::getFileSize(smb2fh *handle)
         return 0;
     }
 
+    if (state)
+    {
+        pImpl->metadata.store(state->path, Impl::toCachedStat(st));
+    }
     return st.smb2_size;
 }
 
 bool Smb2ClientWrapper::fileExists(const std::string &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!pImpl->context || !pImpl->connected)
     {
         return false;
     }
 
-    struct smb2_stat_64 st;
-    int result = smb2_stat(pImpl->context, path.c_str(), &st);
-    return result >= 0;
+    CachedStat stat;
+    return pImpl->statPath(path, &stat) && stat.exists;
 }
 
 bool Smb2ClientWrapper::isDirectory(const std::string &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!pImpl->context || !pImpl->connected)
     {
         return false;
     }
 
-    struct smb2_stat_64 st;
-    int result = smb2_stat(pImpl->context, path.c_str(), &st);
-    if (result < 0)
+    CachedStat stat;
+    return pImpl->statPath(path, &stat) && stat.exists && stat.is_directory;
+}
+
+bool Smb2ClientWrapper::statPath(const std::string &path, FileInfo *info)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    if (!info || !pImpl->context || !pImpl->connected)
+    {
+        return false;
+    }
+
+    CachedStat stat;
+    if (!pImpl->statPath(path, &stat) || !stat.exists)
     {
         return false;
     }
 
-    return (st.smb2_type == SMB2_TYPE_DIRECTORY);
+    // The cache key is case-folded, so the name comes from the caller's path
+    size_t end = path.find_last_not_of("/\\");
+    std::string trimmed = end == std::string::npos ? std::string() : path.substr(0, end + 1);
+    size_t slash = trimmed.find_last_of("/\\");
+    info->name = slash == std::string::npos ? trimmed : trimmed.substr(slash + 1);
+    info->path = path;
+    info->size = stat.size;
+    info->modified_time = stat.modified_time;
+    info->is_directory = stat.is_directory;
+    return true;
+}
+
+void Smb2ClientWrapper::setMetadataCacheTtl(uint32_t ttl_ms)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    pImpl->metadata.setTtl(ttl_ms);
+}
+
+void Smb2ClientWrapper::resetSessionOptions()
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    pImpl->metadata.setTtl(MetadataCache::kDefaultTtlMs);
+}
+
+// Called for changes made through this connection
+void Smb2ClientWrapper::invalidateMetadata(const std::string &path)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    pImpl->metadata.invalidate(path);
 }
 
 // Directory operations
 std::vector<FileInfo> Smb2ClientWrapper::listDirectory(const std::string &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     std::vector<FileInfo> files;
 
     if (!pImpl->context || !pImpl->connected)
@@ -228,6 +1655,7 @@ std::vector<FileInfo> Smb2ClientWrapper::listDirectory(const std::string &path)
         return files;
     }
 
+    MetadataCache::ListingToken listing = pImpl->metadata.beginListing();
     smb2dir *dir = smb2_opendir(pImpl->context, path.c_str());
     if (!dir)
     {
@@ -237,6 +1665,8 @@ std::vector<FileInfo> Smb2ClientWrapper::listDirectory(const std::string &path)
     struct smb2dirent *entry;
     while ((entry = smb2_readdir(pImpl->context, dir)) != nullptr)
     {
+        pImpl->cacheDirEntry(path, entry);
+
         FileInfo file_info;
         file_info.name = entry->name;
         file_info.path = path + "/" + entry->name;
@@ -247,12 +1677,171 @@ std::vector<FileInfo> Smb2ClientWrapper::listDirectory(const std::string &path)
     }
 
     smb2_closedir(pImpl->context, dir);
+    pImpl->metadata.markListed(path, listing);
+    pImpl->watchDirectory(path);
     return files;
 }
 
+// Cursor-style enumeration without copying entries into a vector
+smb2dir *Smb2ClientWrapper::openDirectory(const std::string &path)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    if (!pImpl->context || !pImpl->connected)
+    {
+        return nullptr;
+    }
+
+    MetadataCache::ListingToken listing = pImpl->metadata.beginListing();
+    smb2dir *dir = smb2_opendir(pImpl->context, path.c_str());
+    if (!dir)
+    {
+        std::cerr << "Failed to open directory: " << path << " - " << smb2_get_error(pImpl->context) << std::endl;
+        return nullptr;
+    }
+
+    Impl::DirectoryState &state = pImpl->directories[dir];
+    state.path = path;
+    state.listing = listing;
+    return dir;
+}
+
+bool Smb2ClientWrapper::readDirectory(smb2dir *dir, DirEntryRef *entry)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    if (!dir || !entry || !pImpl->context)
+    {
+        return false;
+    }
+
+    auto state = pImpl->directories.find(dir);
+    struct smb2dirent *dirent = smb2_readdir(pImpl->context, dir);
+    if (!dirent)
+    {
+        // Enumerated to the end: the cache now holds the whole listing
+        if (state != pImpl->directories.end())
+        {
+            pImpl->metadata.markListed(state->second.path, state->second.listing);
+            pImpl->watchDirectory(state->second.path);
+        }
+        return false;
+    }
+    if (state != pImpl->directories.end())
+    {
+        pImpl->cacheDirEntry(state->second.path, dirent);
+    }
+
+    entry->name = dirent->name;
+    entry->size = dirent->st.smb2_size;
+    entry->modified_time = dirent->st.smb2_mtime;
+    entry->is_directory = (dirent->st.smb2_type == SMB2_TYPE_DIRECTORY);
+    return true;
+}
+
+void Smb2ClientWrapper::closeDirectory(smb2dir *dir)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    pImpl->directories.erase(dir);
+    // A destroyed context has already released its directories
+    if (dir && pImpl->context)
+    {
+        smb2_closedir(pImpl->context, dir);
+    }
+}
+
+void Smb2ClientWrapper::listDirectories(const std::vector<std::string> &paths, size_t depth,
+                                        const DirectoryListingCallback &on_listing)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+
+    PipelinedListing op;
+    op.in_flight = 0;
+    op.slots.resize(std::max<size_t>(1, std::min(depth, kMaxPipelineDepth)));
+    for (auto &slot : op.slots)
+    {
+        op.free_slots.push_back(&slot);
+    }
+
+    std::vector<bool> delivered(paths.size(), false);
+    std::vector<DirEntryRef> entries;
+    size_t next = 0;
+    size_t remaining = paths.size();
+    bool failed = !pImpl->context || !pImpl->connected;
+    auto last_progress = std::chrono::steady_clock::now();
+
+    while (!failed && remaining > 0)
+    {
+        while (!op.free_slots.empty() && next < paths.size())
+        {
+            ListingSlot *slot = op.free_slots.back();
+            op.free_slots.pop_back();
+            slot->op = &op;
+            slot->index = next++;
+
+            if (smb2_opendir_async(pImpl->context, paths[slot->index].c_str(), pipelinedListingCallback, slot) < 0)
+            {
+                std::cerr << "Failed to queue directory listing: " << smb2_get_error(pImpl->context) << std::endl;
+                op.free_slots.push_back(slot);
+                op.completed.push_back({slot->index, -EIO, nullptr});
+                continue;
+            }
+            op.in_flight++;
+        }
+
+        if (op.in_flight > 0 && !pImpl->awaitCompletions(op.in_flight, &last_progress, "listing"))
+        {
+            failed = true;
+        }
+
+        std::vector<CompletedListing> completed;
+        completed.swap(op.completed);
+        for (auto &listing : completed)
+        {
+            entries.clear();
+            int status = listing.status;
+            if (listing.dir && pImpl->context)
+            {
+                struct smb2dirent *dirent;
+                while ((dirent = smb2_readdir(pImpl->context, listing.dir)) != nullptr)
+                {
+                    DirEntryRef entry;
+                    entry.name = dirent->name;
+                    entry.size = dirent->st.smb2_size;
+                    entry.modified_time = dirent->st.smb2_mtime;
+                    entry.is_directory = (dirent->st.smb2_type == SMB2_TYPE_DIRECTORY);
+                    entries.push_back(entry);
+                }
+            }
+            else if (status == 0)
+            {
+                status = -ECONNRESET;
+            }
+
+            on_listing(listing.index, status, entries);
+            if (listing.dir && pImpl->context)
+            {
+                smb2_closedir(pImpl->context, listing.dir);
+            }
+            delivered[listing.index] = true;
+            remaining--;
+        }
+    }
+
+    // The connection is gone; nothing else will complete
+    entries.clear();
+    for (size_t i = 0; i < paths.size() && remaining > 0; i++)
+    {
+        if (!delivered[i])
+        {
+            on_listing(i, -ENOTCONN, entries);
+            remaining--;
+        }
+    }
+}
+
 // Get SMB version information
 std::string Smb2ClientWrapper::getSmbVersion() const
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!pImpl->context || !pImpl->connected)
     {
         return "Unknown";
@@ -298,6 +1887,7 @@ std::string Smb2ClientWrapper::getConnectionInfo() const
 // Open file optimized for streaming
 smb2fh *Smb2ClientWrapper::openFileForStreaming(const std::string &path)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!pImpl->context || !pImpl->connected)
     {
         return nullptr;
@@ -310,16 +1900,41 @@ smb2fh *Smb2ClientWrapper::openFileForStreaming(const std::string &path)
         std::cerr << "Failed to open file for streaming: " << path << " - " << smb2_get_error(pImpl->context) << std::endl;
         return nullptr;
     }
+    pImpl->handles[file_handle] = Impl::HandleState();
+    pImpl->handles[file_handle].path = path;
 
     // Set read ahead for better streaming performance
-    setReadAhead(file_handle, 2 * 1024 * 1024); // 2MB read ahead for better performance
+    setReadAhead(file_handle, kDefaultReadAheadBytes);
+
+    return file_handle;
+}
 
+// Open for writing; the file is created or truncated
+smb2fh *Smb2ClientWrapper::openFileForWriting(const std::string &path)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    if (!pImpl->context || !pImpl->connected)
+    {
+        return nullptr;
+    }
+
+    smb2fh *file_handle = smb2_open(pImpl->context, path.c_str(), O_WRONLY | O_CREAT | O_TRUNC);
+    if (!file_handle)
+    {
+        std::cerr << "Failed to open file for writing: " << path << " - " << smb2_get_error(pImpl->context) << std::endl;
+        return nullptr;
+    }
+    pImpl->handles[file_handle] = Impl::HandleState();
+    pImpl->handles[file_handle].path = path;
+    pImpl->handles[file_handle].writable = true;
+    pImpl->metadata.invalidate(path);
     return file_handle;
 }
 
 // Read file with offset optimization
 size_t Smb2ClientWrapper::readFileOptimized(smb2fh *handle, uint8_t *buffer, size_t size, uint64_t offset)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !buffer || !pImpl->context)
     {
         return 0;
@@ -331,23 +1946,47 @@ size_t Smb2ClientWrapper::readFileOptimized(smb2fh *handle, uint8_t *buffer, siz
         return 0;
     }
 
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (state && state->read_ahead && pImpl->connected)
+    {
+        size_t bytes_read = pImpl->cachedRead(handle, state, buffer, offset, size);
+        if (pImpl->context)
+        {
+            smb2_lseek(pImpl->context, handle, offset + bytes_read, SEEK_SET, nullptr);
+        }
+        return bytes_read;
+    }
+
     // Read the data
-    int bytes_read = smb2_read(pImpl->context, handle, buffer, size);
-    return bytes_read > 0 ? static_cast<size_t>(bytes_read) : 0;
+    return pImpl->uncachedRead(handle, state, buffer, size);
 }
 
 // Set read ahead buffer size
 bool Smb2ClientWrapper::setReadAhead(smb2fh *handle, size_t read_ahead_size)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !pImpl->context)
     {
         return false;
     }
 
-    // Note: libsmb2 doesn't have direct read-ahead control
-    // This is a placeholder for future optimization
-    // For now, we'll rely on the OS and network layer optimizations
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (!state)
+    {
+        return false;
+    }
+
+    // libsmb2 has no read-ahead of its own; keep a window of pages that the
+    // async worker fills while the reader is sequential. 0 disables it.
+    if (read_ahead_size == 0)
+    {
+        state->read_ahead.reset();
+        return true;
+    }
 
+    size_t page_count = (read_ahead_size + kReadAheadPageSize - 1) / kReadAheadPageSize;
+    page_count = std::min(std::max<size_t>(2, page_count), kMaxReadAheadBytes / kReadAheadPageSize);
+    state->read_ahead.reset(new ReadAheadCache(kReadAheadPageSize, page_count));
     return true;
 }
 
@@ -355,6 +1994,7 @@ bool Smb2ClientWrapper::setReadAhead(smb2fh *handle, size_t read_ahead_size)
 size_t Smb2ClientWrapper::readRange(smb2fh *handle, uint8_t *buffer, size_t buffer_size,
                                     uint64_t start_offset, uint64_t end_offset)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !buffer || !pImpl->context)
     {
         return 0;
@@ -373,46 +2013,343 @@ size_t Smb2ClientWrapper::readRange(smb2fh *handle, uint8_t *buffer, size_t buff
         return 0;
     }
 
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (state && state->read_ahead && pImpl->connected)
+    {
+        size_t bytes_read = pImpl->cachedRead(handle, state, buffer, start_offset,
+                                              static_cast<size_t>(range_size));
+        if (pImpl->context)
+        {
+            smb2_lseek(pImpl->context, handle, start_offset + bytes_read, SEEK_SET, nullptr);
+        }
+        return bytes_read;
+    }
+
     // Read the range
-    int bytes_read = smb2_read(pImpl->context, handle, buffer, range_size);
-    return bytes_read > 0 ? static_cast<size_t>(bytes_read) : 0;
+    return pImpl->uncachedRead(handle, state, buffer, static_cast<size_t>(range_size));
 }
 
+// Pipelined range read: blocks until done but keeps several requests on the wire
 size_t Smb2ClientWrapper::readRangeAsync(smb2fh *handle, uint8_t *buffer, size_t buffer_size,
                                          uint64_t start_offset, uint64_t end_offset)
 {
-    // For now, implement as synchronous read
-    // In a real implementation, this would use async I/O
-    return readRange(handle, buffer, buffer_size, start_offset, end_offset);
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (!handle || !buffer || !pImpl->context || !pImpl->connected || !state || end_offset <= start_offset)
+    {
+        return 0;
+    }
+
+    size_t range_size = static_cast<size_t>(std::min<uint64_t>(end_offset - start_offset, buffer_size));
+    int status = 0;
+    size_t bytes_read = pImpl->pipelinedRead(handle, buffer, start_offset, range_size,
+                                             state->pipeline_depth, &status);
+    if (status < 0)
+    {
+        return 0;
+    }
+
+    if (pImpl->context)
+    {
+        smb2_lseek(pImpl->context, handle, start_offset + bytes_read, SEEK_SET, nullptr);
+    }
+    return bytes_read;
+}
+
+// Queue a pipelined range read; on_complete runs on the wrapper's async worker thread
+bool Smb2ClientWrapper::readRangeAsync(smb2fh *handle, uint8_t *buffer, size_t buffer_size,
+                                       uint64_t start_offset, uint64_t end_offset,
+                                       ReadCompletionCallback on_complete)
+{
+    if (!handle || !buffer || !on_complete || end_offset <= start_offset)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    if (!pImpl->context || !pImpl->connected || !pImpl->stateFor(handle))
+    {
+        return false;
+    }
+
+    Impl::AsyncReadJob job;
+    job.handle = handle;
+    job.buffer = buffer;
+    job.offset = start_offset;
+    job.length = static_cast<size_t>(std::min<uint64_t>(end_offset - start_offset, buffer_size));
+    job.on_complete = std::move(on_complete);
+
+    {
+        std::lock_guard<std::mutex> async_lock(pImpl->async_mutex);
+        if (pImpl->async_stop)
+        {
+            return false;
+        }
+        pImpl->async_jobs.push_back(std::move(job));
+    }
+    pImpl->startAsyncWorker();
+    pImpl->async_cv.notify_one();
+    return true;
+}
+
+bool Smb2ClientWrapper::setPipelineDepth(smb2fh *handle, size_t depth)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (!state)
+    {
+        return false;
+    }
+
+    state->pipeline_depth = std::min(std::max<size_t>(1, depth), kMaxPipelineDepth);
+    return true;
 }
 
 bool Smb2ClientWrapper::prefetchRange(smb2fh *handle, uint64_t start_offset, uint64_t end_offset)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !pImpl->context)
     {
         return false;
     }
 
-    // For now, just seek to the start offset to prepare for reading
-    // In a real implementation, this would trigger background prefetching
-    return seekFile(handle, start_offset);
+    if (!seekFile(handle, start_offset))
+    {
+        return false;
+    }
+
+    // Start filling the read-ahead window at the new position in the background
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (!state || !pImpl->connected || end_offset <= start_offset || !state->caching)
+    {
+        return true;
+    }
+    if (!state->read_ahead)
+    {
+        setReadAhead(handle, state->read_ahead_bytes);
+    }
+
+    ReadAheadCache &cache = *state->read_ahead;
+    cache.noteSeek(start_offset);
+    uint64_t until = std::min<uint64_t>(end_offset, start_offset + cache.capacityBytes());
+    pImpl->scheduleReadAhead(handle, state, start_offset, until);
+    return true;
 }
 
 bool Smb2ClientWrapper::setStreamingOptions(smb2fh *handle, size_t chunk_size, size_t buffer_size, bool enable_caching)
 {
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
     if (!handle || !pImpl->context)
     {
         return false;
     }
 
-    // Store streaming options
-    pImpl->chunk_size = chunk_size;
-    pImpl->buffer_size = buffer_size;
-    pImpl->enable_caching = enable_caching;
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (!state)
+    {
+        return false;
+    }
+
+    // Only this handle: other handles on the session keep their own options
+    state->request_size = chunk_size;
+    state->caching = enable_caching && buffer_size > 0;
+    if (!state->caching)
+    {
+        state->read_ahead.reset();
+        return true;
+    }
+    state->read_ahead_bytes = buffer_size;
+    if (!state->read_ahead || state->read_ahead->capacityBytes() < buffer_size)
+    {
+        setReadAhead(handle, buffer_size);
+    }
+    return true;
+}
+
+// Pipelined synchronous write
+size_t Smb2ClientWrapper::writeRange(smb2fh *handle, const uint8_t *data, size_t size, uint64_t offset,
+                                     int *status)
+{
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    Impl::HandleState *state = pImpl->stateFor(handle);
+    if (!handle || !data || !pImpl->context || !pImpl->connected || !state)
+    {
+        if (status)
+        {
+            *status = -EBADF;
+        }
+        return 0;
+    }
+
+    std::vector<WriteSegment> segments(1);
+    segments[0] = {handle, data, offset, size, 0, 0};
+    pImpl->pipelinedWrite(segments, state->pipeline_depth);
+    pImpl->metadata.invalidate(state->path);
+
+    if (segments[0].status == 0 && pImpl->context)
+    {
+        smb2_lseek(pImpl->context, handle, offset + size, SEEK_SET, nullptr);
+    }
+    if (status)
+    {
+        *status = segments[0].status;
+    }
+    return segments[0].written;
+}
+
+// Queue a write for the async worker; returns false if the handle's earlier
+// queued writes failed or the wrapper is shutting down
+bool Smb2ClientWrapper::writeRangeAsync(smb2fh *handle, const uint8_t *data, size_t size, uint64_t offset)
+{
+    if (!handle || !data || size == 0)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+        if (!pImpl->context || !pImpl->connected || !pImpl->stateFor(handle))
+        {
+            return false;
+        }
+    }
+
+    Impl::AsyncWriteJob job;
+    job.handle = handle;
+    job.data.assign(data, data + size);
+    job.offset = offset;
+
+    {
+        // Past the limit the caller waits for the worker; a write larger than
+        // the whole limit goes through once the queue is empty
+        std::unique_lock<std::mutex> lock(pImpl->async_mutex);
+        pImpl->write_cv.wait(lock, [this, size]
+                             { return pImpl->async_stop || pImpl->queued_write_bytes == 0 ||
+                                      pImpl->queued_write_bytes + size <= kMaxQueuedWriteBytes; });
+        Impl::WriteQueue &queue = pImpl->write_queues[handle];
+        if (pImpl->async_stop || queue.status < 0)
+        {
+            return false;
+        }
+        queue.pending_jobs++;
+        pImpl->queued_write_bytes += size;
+        pImpl->write_jobs.push_back(std::move(job));
+    }
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+        pImpl->startAsyncWorker();
+    }
+    pImpl->async_cv.notify_one();
+    return true;
+}
+
+bool Smb2ClientWrapper::setWriteProgressCallback(smb2fh *handle, WriteProgressCallback on_progress)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+        if (!pImpl->stateFor(handle))
+        {
+            return false;
+        }
+    }
 
+    std::lock_guard<std::mutex> lock(pImpl->async_mutex);
+    pImpl->write_queues[handle].on_progress = std::move(on_progress);
     return true;
 }
 
+int Smb2ClientWrapper::flushWrites(smb2fh *handle)
+{
+    std::unique_lock<std::mutex> lock(pImpl->async_mutex);
+    auto queue = pImpl->write_queues.find(handle);
+    if (queue == pImpl->write_queues.end())
+    {
+        return 0;
+    }
+
+    pImpl->write_cv.wait(lock, [this, handle]
+                         {
+                             auto it = pImpl->write_queues.find(handle);
+                             return it == pImpl->write_queues.end() || it->second.pending_jobs == 0; });
+    queue = pImpl->write_queues.find(handle);
+    return queue == pImpl->write_queues.end() ? 0 : queue->second.status;
+}
+
+int Smb2ClientWrapper::serverCopy(const std::string &source, const std::string &destination,
+                                  CopyProgressCallback on_progress)
+{
+    // Truncating the destination would destroy the source
+    if (MetadataCache::normalize(source) == MetadataCache::normalize(destination))
+    {
+        return -EINVAL;
+    }
+
+    smb2fh *source_handle = nullptr;
+    smb2fh *destination_handle = nullptr;
+    uint64_t size = 0;
+    {
+        std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+        if (!pImpl->context || !pImpl->connected)
+        {
+            return -ENOTCONN;
+        }
+
+        source_handle = smb2_open(pImpl->context, source.c_str(), O_RDONLY);
+        if (!source_handle)
+        {
+            std::cerr << "Failed to open copy source: " << source << " - " << smb2_get_error(pImpl->context) << std::endl;
+            return -ENOENT;
+        }
+
+        struct smb2_stat_64 st;
+        if (smb2_fstat(pImpl->context, source_handle, &st) < 0)
+        {
+            smb2_close(pImpl->context, source_handle);
+            return -EIO;
+        }
+        size = st.smb2_size;
+
+        destination_handle = smb2_open(pImpl->context, destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC);
+        if (!destination_handle)
+        {
+            std::cerr << "Failed to open copy destination: " << destination << " - " << smb2_get_error(pImpl->context) << std::endl;
+            smb2_close(pImpl->context, source_handle);
+            return -EACCES;
+        }
+        pImpl->metadata.invalidate(destination);
+    }
+
+    uint64_t copied = 0;
+    int status = 0;
+    if (size > 0)
+    {
+        status = pImpl->copyChunks(source_handle, destination_handle, size, &copied, on_progress);
+        if (status == -EOPNOTSUPP)
+        {
+            std::cerr << "Server-side copy refused, copying " << destination << " through the client" << std::endl;
+            status = pImpl->copyThroughClient(source_handle, destination_handle, size, copied, on_progress);
+        }
+    }
+    else if (on_progress)
+    {
+        on_progress(0, 0);
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(pImpl->io_mutex);
+    if (pImpl->context)
+    {
+        smb2_close(pImpl->context, source_handle);
+        smb2_close(pImpl->context, destination_handle);
+        if (status < 0)
+        {
+            smb2_unlink(pImpl->context, destination.c_str());
+        }
+    }
+    pImpl->metadata.invalidate(destination);
+    return status;
+}
+
 // NEW: SMB URL generation for direct VLC streaming
 std::string Smb2ClientWrapper::generateDirectUrl(const std::string &path)
 {
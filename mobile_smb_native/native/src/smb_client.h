@@ -3,11 +3,13 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <cstdint>
 
 // Forward declarations for libsmb2
 struct smb2_context;
 struct smb2fh;
+struct smb2dir;
 
 // File information structure
 struct FileInfo
@@ -19,6 +21,32 @@ struct FileInfo
     bool is_directory;
 };
 
+// Directory entry borrowed from an open smb2dir; name stays valid until
+// the directory is closed
+struct DirEntryRef
+{
+    const char *name;
+    uint64_t size;
+    uint64_t modified_time;
+    bool is_directory;
+};
+
+// Completion callback for asynchronous range reads.
+// status is 0 on success or a negative errno value on failure.
+using ReadCompletionCallback = std::function<void(int status, size_t bytes_read)>;
+
+// Progress of queued writes on one handle. bytes_written is the total
+// written through the queue so far; status is 0 or the first negative errno.
+using WriteProgressCallback = std::function<void(int status, uint64_t bytes_written)>;
+
+// One listing of listDirectories. index is into the requested paths; status
+// is 0 or a negative errno. Names are borrowed and valid only during the call.
+using DirectoryListingCallback =
+    std::function<void(size_t index, int status, const std::vector<DirEntryRef> &entries)>;
+
+// Progress of a copy, called on the copying thread after each step
+using CopyProgressCallback = std::function<void(uint64_t bytes_copied, uint64_t total_bytes)>;
+
 // PIMPL pattern for libsmb2 client
 class Smb2ClientWrapper
 {
@@ -32,19 +60,43 @@ public:
                  const std::string &domain = "");
     void disconnect();
     bool isConnected() const;
+    // Parameters of the last connect, for asking the pool for this session again
+    void getConnectionParameters(std::string *server, std::string *share, std::string *username,
+                                 std::string *password) const;
 
     // File operations
     smb2fh *openFile(const std::string &path);
     smb2fh *openFileForStreaming(const std::string &path);
+    // Creates the file, or truncates an existing one
+    smb2fh *openFileForWriting(const std::string &path);
+    // Waits for queued writes on the handle before closing it
     void closeFile(smb2fh *handle);
     size_t readFile(smb2fh *handle, uint8_t *buffer, size_t size);
     bool seekFile(smb2fh *handle, uint64_t offset);
     uint64_t getFileSize(smb2fh *handle);
     bool fileExists(const std::string &path);
     bool isDirectory(const std::string &path);
+    // Stat a path through the metadata cache; false if it does not exist
+    bool statPath(const std::string &path, FileInfo *info);
+
+    // Metadata cache: entries expire after ttl_ms (0 disables the cache)
+    void setMetadataCacheTtl(uint32_t ttl_ms);
+    void invalidateMetadata(const std::string &path);
+    // Restore session-wide settings to their defaults, for a pooled session
+    // going back to the pool
+    void resetSessionOptions();
 
     // Directory operations
     std::vector<FileInfo> listDirectory(const std::string &path);
+    smb2dir *openDirectory(const std::string &path);
+    bool readDirectory(smb2dir *dir, DirEntryRef *entry);
+    void closeDirectory(smb2dir *dir);
+    // List several directories with up to `depth` smb2_opendir_async
+    // requests in flight. on_listing runs on the calling thread once per path
+    // as each listing completes. Bypasses the metadata cache, which a tree
+    // walk would only flush.
+    void listDirectories(const std::vector<std::string> &paths, size_t depth,
+                         const DirectoryListingCallback &on_listing);
 
     // Optimized streaming operations
     size_t readFileOptimized(smb2fh *handle, uint8_t *buffer, size_t size, uint64_t offset);
@@ -55,9 +107,34 @@ public:
                      uint64_t start_offset, uint64_t end_offset);
     size_t readRangeAsync(smb2fh *handle, uint8_t *buffer, size_t buffer_size,
                           uint64_t start_offset, uint64_t end_offset);
+    bool readRangeAsync(smb2fh *handle, uint8_t *buffer, size_t buffer_size,
+                        uint64_t start_offset, uint64_t end_offset,
+                        ReadCompletionCallback on_complete);
+    bool setPipelineDepth(smb2fh *handle, size_t depth);
     bool prefetchRange(smb2fh *handle, uint64_t start_offset, uint64_t end_offset);
     bool setStreamingOptions(smb2fh *handle, size_t chunk_size, size_t buffer_size, bool enable_caching);
 
+    // Write path. writeRange blocks until the data is on the server, keeping
+    // several write requests in flight; it returns the bytes written and sets
+    // status to 0 or a negative errno.
+    size_t writeRange(smb2fh *handle, const uint8_t *data, size_t size, uint64_t offset,
+                      int *status = nullptr);
+    // Write-behind: data is copied and written by the async worker, batched
+    // with other queued writes. Blocks only while the queue is full.
+    bool writeRangeAsync(smb2fh *handle, const uint8_t *data, size_t size, uint64_t offset);
+    // Called on the async worker thread after each batch of queued writes
+    bool setWriteProgressCallback(smb2fh *handle, WriteProgressCallback on_progress);
+    // Wait until every queued write on the handle has completed. Returns 0 or
+    // the first error any of them hit.
+    int flushWrites(smb2fh *handle);
+
+    // Copy a file within the share, creating or truncating destination. The
+    // server copies the data itself (FSCTL_SRV_COPYCHUNK_WRITE) when it can;
+    // otherwise it goes through the client with pipelined reads and writes.
+    // Returns 0 or a negative errno; a failed copy removes the destination.
+    int serverCopy(const std::string &source, const std::string &destination,
+                   CopyProgressCallback on_progress);
+
     // NEW: SMB URL generation for direct VLC streaming
     std::string generateDirectUrl(const std::string &path);
     std::string generateUrlWithCredentials(const std::string &path,
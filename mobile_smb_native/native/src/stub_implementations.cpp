@@ -3,6 +3,7 @@
 // Replace with real implementations when libraries are available
 
 #include "../include/smb_bridge.h"
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
@@ -10,6 +11,10 @@
 #include <string>
 #include <memory>
 
+#ifndef _WIN32
+#define _strdup strdup
+#endif
+
 // Stub SmbClient implementation
 class SmbClientStub {
 public:
@@ -90,6 +95,30 @@ private:
     uint64_t size_;
 };
 
+class SmbDirectoryStub {
+public:
+    explicit SmbDirectoryStub(std::vector<SmbFileInfo> files) : files_(std::move(files)), next_(0) {}
+
+    ~SmbDirectoryStub() {
+        for (auto& file : files_) {
+            free(file.name);
+            free(file.path);
+        }
+    }
+
+    const SmbFileInfo* peek() const {
+        return next_ < files_.size() ? &files_[next_] : nullptr;
+    }
+
+    void advance() {
+        ++next_;
+    }
+
+private:
+    std::vector<SmbFileInfo> files_;
+    size_t next_;
+};
+
 class ThumbnailGeneratorStub {
 public:
     struct ThumbnailDataStub {
@@ -322,4 +351,280 @@ void smb_free_string(char* str) {
     }
 }
 
+char* smb_get_version(SmbContext* context) {
+    return context ? _strdup("STUB") : nullptr;
+}
+
+char* smb_get_connection_info(SmbContext* context) {
+    return context ? _strdup("Stub connection") : nullptr;
+}
+
+char* smb_get_connection_url(SmbContext* context) {
+    return context ? _strdup("smb://stub/") : nullptr;
+}
+
+char* smb_generate_direct_url(SmbContext* context, const char* path) {
+    if (!context || !path) {
+        return nullptr;
+    }
+    return _strdup((std::string("smb://stub/") + path).c_str());
+}
+
+char* smb_generate_url_with_credentials(SmbContext* context, const char* path,
+                                        const char* username, const char* password) {
+    return smb_generate_direct_url(context, path);
+}
+
+void* smb_get_native_context(SmbContext* context) {
+    return nullptr;
+}
+
+SmbFileHandle* smb_open_file_for_streaming(SmbContext* context, const char* path) {
+    return smb_open_file(context, path);
+}
+
+int smb_read_chunk_optimized(SmbFileHandle* file_handle, uint8_t* buffer, size_t buffer_size, size_t* bytes_read, uint64_t offset) {
+    int result = smb_seek_file(file_handle, offset);
+    if (result != SMB_SUCCESS) {
+        return result;
+    }
+    return smb_read_chunk(file_handle, buffer, buffer_size, bytes_read);
+}
+
+int smb_read_range(SmbFileHandle* file_handle, uint8_t* buffer, size_t buffer_size,
+                   uint64_t start_offset, uint64_t end_offset, size_t* bytes_read) {
+    if (!buffer || !bytes_read || end_offset < start_offset) {
+        return SMB_ERROR_INVALID_PARAMETER;
+    }
+    size_t size = static_cast<size_t>(std::min<uint64_t>(buffer_size, end_offset - start_offset));
+    return smb_read_chunk_optimized(file_handle, buffer, size, bytes_read, start_offset);
+}
+
+int smb_read_range_async(SmbFileHandle* file_handle, uint8_t* buffer, size_t buffer_size,
+                         uint64_t start_offset, uint64_t end_offset, size_t* bytes_read) {
+    return smb_read_range(file_handle, buffer, buffer_size, start_offset, end_offset, bytes_read);
+}
+
+int smb_read_range_async_cb(SmbFileHandle* file_handle, uint8_t* buffer, size_t buffer_size,
+                            uint64_t start_offset, uint64_t end_offset,
+                            SmbReadCompleteCallback callback, void* user_data) {
+    if (!callback) {
+        return SMB_ERROR_INVALID_PARAMETER;
+    }
+    // No worker thread in the stub; complete inline
+    size_t bytes_read = 0;
+    int result = smb_read_range(file_handle, buffer, buffer_size, start_offset, end_offset, &bytes_read);
+    if (result == SMB_SUCCESS) {
+        callback(file_handle, result, bytes_read, user_data);
+    }
+    return result;
+}
+
+int smb_set_read_pipeline_depth(SmbFileHandle* file_handle, size_t depth) {
+    return file_handle && depth > 0 ? SMB_SUCCESS : SMB_ERROR_INVALID_PARAMETER;
+}
+
+int smb_set_read_ahead(SmbFileHandle* file_handle, size_t read_ahead_size) {
+    return file_handle ? SMB_SUCCESS : SMB_ERROR_INVALID_PARAMETER;
+}
+
+int smb_prefetch_range(SmbFileHandle* file_handle, uint64_t start_offset, uint64_t end_offset) {
+    return file_handle ? SMB_SUCCESS : SMB_ERROR_INVALID_PARAMETER;
+}
+
+int smb_configure_connection_pool(size_t max_connections, uint32_t idle_timeout_seconds) {
+    return max_connections > 0 ? SMB_SUCCESS : SMB_ERROR_INVALID_PARAMETER;
+}
+
+void smb_close_idle_connections(void) {
+}
+
+SmbDirectory* smb_opendir(SmbContext* context, const char* path) {
+    if (!context || !path || !g_client) {
+        return nullptr;
+    }
+    return reinterpret_cast<SmbDirectory*>(new SmbDirectoryStub(g_client->listDirectory(path)));
+}
+
+int smb_readdir_batch(SmbDirectory* dir, SmbDirEntry* entries, size_t max_entries,
+                      char* name_arena, size_t arena_size, size_t* count) {
+    if (!dir || !entries || !name_arena || !count || max_entries == 0) {
+        return SMB_ERROR_INVALID_PARAMETER;
+    }
+
+    SmbDirectoryStub* stub = reinterpret_cast<SmbDirectoryStub*>(dir);
+    size_t used = 0;
+    *count = 0;
+    while (*count < max_entries) {
+        const SmbFileInfo* file = stub->peek();
+        if (!file) {
+            break;
+        }
+        size_t length = strlen(file->name) + 1;
+        if (used + length > arena_size) {
+            // Returned by the next call; an arena too small for one name is an error
+            if (*count == 0) {
+                return SMB_ERROR_MEMORY_ALLOCATION;
+            }
+            break;
+        }
+        memcpy(name_arena + used, file->name, length);
+        entries[*count].name = name_arena + used;
+        entries[*count].size = file->size;
+        entries[*count].modified_time = file->modified_time;
+        entries[*count].is_directory = file->is_directory;
+        used += length;
+        ++*count;
+        stub->advance();
+    }
+    return SMB_SUCCESS;
+}
+
+void smb_closedir(SmbDirectory* dir) {
+    delete reinterpret_cast<SmbDirectoryStub*>(dir);
+}
+
+int smb_list_directory_packed(SmbContext* context, const char* path, uint8_t** buffer, size_t* size) {
+    if (!context || !path || !buffer || !size || !g_client) {
+        return SMB_ERROR_INVALID_PARAMETER;
+    }
+
+    auto files = g_client->listDirectory(path);
+
+    size_t strings_size = 0;
+    for (const auto& file : files) {
+        strings_size += strlen(file.name) + 1;
+    }
+    size_t records_offset = sizeof(SmbPackedListingHeader);
+    size_t strings_offset = records_offset + files.size() * sizeof(SmbPackedEntry);
+    size_t total_size = strings_offset + strings_size;
+
+    uint8_t* packed = static_cast<uint8_t*>(malloc(total_size));
+    if (!packed) {
+        for (auto& file : files) {
+            free(file.name);
+            free(file.path);
+        }
+        return SMB_ERROR_MEMORY_ALLOCATION;
+    }
+
+    SmbPackedListingHeader* header = reinterpret_cast<SmbPackedListingHeader*>(packed);
+    header->version = SMB_PACKED_LISTING_VERSION;
+    header->count = static_cast<uint32_t>(files.size());
+    header->record_size = sizeof(SmbPackedEntry);
+    header->records_offset = static_cast<uint32_t>(records_offset);
+    header->strings_offset = static_cast<uint32_t>(strings_offset);
+    header->reserved = 0;
+    header->total_size = total_size;
+
+    SmbPackedEntry* records = reinterpret_cast<SmbPackedEntry*>(packed + records_offset);
+    size_t name_offset = strings_offset;
+    for (size_t i = 0; i < files.size(); ++i) {
+        size_t length = strlen(files[i].name);
+        memcpy(packed + name_offset, files[i].name, length + 1);
+        records[i].size = files[i].size;
+        records[i].modified_time = files[i].modified_time;
+        records[i].name_offset = static_cast<uint32_t>(name_offset);
+        records[i].name_length = static_cast<uint32_t>(length);
+        records[i].flags = files[i].is_directory ? SMB_PACKED_ENTRY_DIRECTORY : 0;
+        records[i].reserved = 0;
+        name_offset += length + 1;
+        free(files[i].name);
+        free(files[i].path);
+    }
+
+    *buffer = packed;
+    *size = total_size;
+    return SMB_SUCCESS;
+}
+
+void smb_free_packed_listing(uint8_t* buffer) {
+    free(buffer);
+}
+
+int smb_stat(SmbContext* context, const char* path, uint64_t* size, uint64_t* modified_time,
+             int* is_directory) {
+    if (!context || !path || !g_client) {
+        return SMB_ERROR_INVALID_PARAMETER;
+    }
+    if (size) {
+        *size = 1024;
+    }
+    if (modified_time) {
+        *modified_time = 1640995200;
+    }
+    if (is_directory) {
+        *is_directory = 0;
+    }
+    return SMB_SUCCESS;
+}
+
+int smb_set_metadata_cache_ttl(SmbContext* context, uint32_t ttl_ms) {
+    return context ? SMB_SUCCESS : SMB_ERROR_INVALID_PARAMETER;
+}
+
+int smb_start_http_proxy(uint16_t port, uint16_t* bound_port) {
+    return SMB_ERROR_UNKNOWN;
+}
+
+void smb_stop_http_proxy(void) {
+}
+
+char* smb_proxy_url_for(SmbContext* context, const char* path) {
+    return nullptr;
+}
+
+SmbFileHandle* smb_open_file_for_writing(SmbContext* context, const char* path) {
+    std::cout << "[STUB] Writing is not supported: " << (path ? path : "") << std::endl;
+    return nullptr;
+}
+
+int smb_write_range(SmbFileHandle* file_handle, const uint8_t* data, size_t size,
+                    uint64_t offset, size_t* bytes_written) {
+    if (bytes_written) {
+        *bytes_written = 0;
+    }
+    return SMB_ERROR_PERMISSION_DENIED;
+}
+
+int smb_set_write_progress_callback(SmbFileHandle* file_handle, SmbWriteProgressCallback callback,
+                                    void* user_data) {
+    return SMB_ERROR_PERMISSION_DENIED;
+}
+
+int smb_write_range_async(SmbFileHandle* file_handle, const uint8_t* data, size_t size, uint64_t offset) {
+    return SMB_ERROR_PERMISSION_DENIED;
+}
+
+int smb_flush_writes(SmbFileHandle* file_handle) {
+    return SMB_ERROR_PERMISSION_DENIED;
+}
+
+int smb_server_copy(SmbContext* context, const char* source_path, const char* destination_path,
+                    SmbCopyProgressCallback callback, void* user_data) {
+    if (!context || !source_path || !destination_path) {
+        return SMB_ERROR_INVALID_PARAMETER;
+    }
+    return SMB_ERROR_PERMISSION_DENIED;
+}
+
+int smb_walk_tree(SmbContext* context, const char* root, const SmbWalkOptions* options,
+                  SmbWalkBatchCallback callback, void* user_data) {
+    if (!context || !root || !callback || !g_client) {
+        return SMB_ERROR_INVALID_PARAMETER;
+    }
+    // Root only; the stub has no subdirectory contents to descend into
+    uint8_t* batch = nullptr;
+    size_t size = 0;
+    int result = smb_list_directory_packed(context, root, &batch, &size);
+    if (result == SMB_SUCCESS) {
+        callback(batch, size, user_data);
+    }
+    return result;
+}
+
+int smb_set_streaming_options(SmbFileHandle* file_handle, size_t chunk_size, size_t buffer_size, int enable_caching) {
+    return file_handle ? SMB_SUCCESS : SMB_ERROR_INVALID_PARAMETER;
+}
+
 } // extern "C"
\ No newline at end of file
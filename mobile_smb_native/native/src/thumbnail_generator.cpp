@@ -1,13 +1,26 @@
 #include "../include/thumbnail_generator.h"
-#include "../include/smb_client.h"
+#include "smb_client.h"
 #include <iostream>
 #include <algorithm>
 #include <cstring>
 #include <cctype>
 #include <cstdlib>
+#include <cstdio>
 
-// For now, we'll use a stub implementation until FFmpeg is properly integrated
-// TODO: Replace with actual FFmpeg implementation when libraries are available
+#ifdef SMB_BRIDGE_WITH_FFMPEG
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/dict.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+// Without SMB_BRIDGE_WITH_FFMPEG (CMake option BUILD_WITH_FFMPEG) thumbnails
+// are placeholder RGB24 patterns; with it they are JPEG-encoded frames.
 
 class ThumbnailGenerator::Impl
 {
@@ -16,14 +29,14 @@ public:
 
     Impl() : initialized(false)
     {
-        // Initialize FFmpeg (stub)
+#ifndef SMB_BRIDGE_WITH_FFMPEG
         std::cout << "[STUB] ThumbnailGenerator initialized" << std::endl;
+#endif
         initialized = true;
     }
 
     ~Impl()
     {
-        // Cleanup FFmpeg (stub)
     }
 
     bool isImageFile(const std::string &path)
@@ -52,12 +65,424 @@ public:
         std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
         return ext;
     }
+
+#ifdef SMB_BRIDGE_WITH_FFMPEG
+    // AVIO buffer; each refill is one SMB read, so this bounds round trips
+    // without pulling much more than the demuxer asks for
+    static constexpr int kIoBufferSize = 256 * 1024;
+    // Keep probing cheap: thumbnails only need the video stream's codec
+    static constexpr const char *kProbeSize = "1048576";
+    static constexpr const char *kAnalyzeDuration = "1000000";
+    // Seek to 10% of the duration, but never further than this into the file
+    static constexpr int64_t kMaxSeekSeconds = 30;
+    static constexpr int kMaxPacketsToRead = 1024;
+    static constexpr int kJpegQuality = 3; // MJPEG qscale, 2 (best) .. 31
+
+    // Custom IO context for SMB streaming: FFmpeg pulls bytes through
+    // smbReadPacket/smbSeek, so only the ranges the demuxer touches are read
+    struct SmbIOContext
+    {
+        SmbClient *client;
+        smb2fh *file_handle;
+        uint64_t position;
+        uint64_t file_size;
+    };
+
+    static int smbReadPacket(void *opaque, uint8_t *buf, int buf_size)
+    {
+        SmbIOContext *io = static_cast<SmbIOContext *>(opaque);
+        if (buf_size <= 0)
+        {
+            return 0;
+        }
+        if (io->position >= io->file_size)
+        {
+            return AVERROR_EOF;
+        }
+
+        uint64_t end = std::min<uint64_t>(io->position + static_cast<uint64_t>(buf_size), io->file_size);
+        size_t bytes_read = io->client->readRange(io->file_handle, buf, static_cast<size_t>(buf_size),
+                                                  io->position, end);
+        if (bytes_read == 0)
+        {
+            return AVERROR(EIO);
+        }
+
+        io->position += bytes_read;
+        return static_cast<int>(bytes_read);
+    }
+
+    static int64_t smbSeek(void *opaque, int64_t offset, int whence)
+    {
+        SmbIOContext *io = static_cast<SmbIOContext *>(opaque);
+        whence &= ~AVSEEK_FORCE;
+
+        if (whence == AVSEEK_SIZE)
+        {
+            return static_cast<int64_t>(io->file_size);
+        }
+
+        int64_t base;
+        switch (whence)
+        {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = static_cast<int64_t>(io->position);
+            break;
+        case SEEK_END:
+            base = static_cast<int64_t>(io->file_size);
+            break;
+        default:
+            return AVERROR(EINVAL);
+        }
+
+        int64_t target = base + offset;
+        if (target < 0)
+        {
+            return AVERROR(EINVAL);
+        }
+
+        // Reads are positional, so a seek is only bookkeeping
+        io->position = static_cast<uint64_t>(target);
+        return target;
+    }
+
+    AVIOContext *createSmbIOContext(SmbClient *client, const std::string &path, SmbIOContext *io)
+    {
+        io->client = client;
+        io->position = 0;
+        io->file_handle = client->openFile(path);
+        if (!io->file_handle)
+        {
+            return nullptr;
+        }
+        io->file_size = client->getFileSize(io->file_handle);
+
+        unsigned char *buffer = static_cast<unsigned char *>(av_malloc(kIoBufferSize));
+        AVIOContext *avio = buffer ? avio_alloc_context(buffer, kIoBufferSize, 0, io,
+                                                        &smbReadPacket, nullptr, &smbSeek)
+                                   : nullptr;
+        if (!avio)
+        {
+            av_free(buffer);
+            client->closeFile(io->file_handle);
+            io->file_handle = nullptr;
+            return nullptr;
+        }
+        return avio;
+    }
+
+    void freeSmbIOContext(AVIOContext *avio, SmbIOContext *io)
+    {
+        if (avio)
+        {
+            // FFmpeg may have replaced the buffer, so free whatever it holds now
+            av_freep(&avio->buffer);
+            avio_context_free(&avio);
+        }
+        if (io->file_handle)
+        {
+            io->client->closeFile(io->file_handle);
+            io->file_handle = nullptr;
+        }
+    }
+
+    // Opens format_ctx (custom IO already attached, or a plain path) and
+    // turns its first decodable video frame into a JPEG
+    ThumbnailData generate(AVFormatContext *format_ctx, const std::string &path,
+                           int target_width, int target_height)
+    {
+        AVDictionary *options = nullptr;
+        av_dict_set(&options, "probesize", kProbeSize, 0);
+        av_dict_set(&options, "analyzeduration", kAnalyzeDuration, 0);
+
+        // On failure avformat_open_input frees format_ctx (but not a custom pb)
+        int ret = avformat_open_input(&format_ctx, path.c_str(), nullptr, &options);
+        av_dict_free(&options);
+        if (ret < 0)
+        {
+            std::cerr << "Thumbnail: cannot open " << path << std::endl;
+            return ThumbnailData();
+        }
+
+        ThumbnailData result;
+        AVFrame *frame = av_frame_alloc();
+        if (frame && decodeFrame(format_ctx, frame))
+        {
+            result = convertFrameToJpeg(frame, target_width, target_height);
+        }
+        else
+        {
+            std::cerr << "Thumbnail: no decodable video frame in " << path << std::endl;
+        }
+
+        av_frame_free(&frame);
+        avformat_close_input(&format_ctx);
+        return result;
+    }
+
+    bool decodeFrame(AVFormatContext *format_ctx, AVFrame *frame)
+    {
+        if (avformat_find_stream_info(format_ctx, nullptr) < 0)
+        {
+            return false;
+        }
+
+        int stream_index = av_find_best_stream(format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream_index < 0)
+        {
+            return false;
+        }
+
+        AVStream *stream = format_ctx->streams[stream_index];
+        const AVCodec *decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+        if (!decoder)
+        {
+            return false;
+        }
+
+        AVCodecContext *codec_ctx = avcodec_alloc_context3(decoder);
+        if (!codec_ctx)
+        {
+            return false;
+        }
+
+        // Slice threads only: frame threading holds back output until several
+        // packets are queued, which costs extra reads for a single frame
+        codec_ctx->thread_count = 0;
+        codec_ctx->thread_type = FF_THREAD_SLICE;
+
+        bool decoded = false;
+        if (avcodec_parameters_to_context(codec_ctx, stream->codecpar) >= 0 &&
+            avcodec_open2(codec_ctx, decoder, nullptr) >= 0)
+        {
+            seekToRepresentativeFrame(format_ctx, codec_ctx, stream);
+            decoded = readFirstFrame(format_ctx, codec_ctx, stream_index, frame);
+        }
+
+        avcodec_free_context(&codec_ctx);
+        return decoded;
+    }
+
+    void seekToRepresentativeFrame(AVFormatContext *format_ctx, AVCodecContext *codec_ctx,
+                                   AVStream *stream)
+    {
+        // Still images and cover art have nothing to seek past
+        if ((stream->disposition & AV_DISPOSITION_ATTACHED_PIC) || format_ctx->duration <= 0)
+        {
+            return;
+        }
+
+        int64_t target = std::min<int64_t>(format_ctx->duration / 10, kMaxSeekSeconds * AV_TIME_BASE);
+        if (format_ctx->start_time != AV_NOPTS_VALUE)
+        {
+            target += format_ctx->start_time;
+        }
+
+        if (av_seek_frame(format_ctx, -1, target, AVSEEK_FLAG_BACKWARD) >= 0)
+        {
+            avcodec_flush_buffers(codec_ctx);
+        }
+    }
+
+    bool readFirstFrame(AVFormatContext *format_ctx, AVCodecContext *codec_ctx, int stream_index,
+                        AVFrame *frame)
+    {
+        AVPacket *packet = av_packet_alloc();
+        if (!packet)
+        {
+            return false;
+        }
+
+        bool decoded = false;
+        bool draining = false;
+        for (int packets = 0; !decoded && packets < kMaxPacketsToRead; ++packets)
+        {
+            if (!draining)
+            {
+                int ret = av_read_frame(format_ctx, packet);
+                if (ret < 0)
+                {
+                    // End of input: flush whatever the decoder still holds
+                    avcodec_send_packet(codec_ctx, nullptr);
+                    draining = true;
+                }
+                else
+                {
+                    if (packet->stream_index == stream_index)
+                    {
+                        avcodec_send_packet(codec_ctx, packet);
+                    }
+                    av_packet_unref(packet);
+                }
+            }
+
+            int ret = avcodec_receive_frame(codec_ctx, frame);
+            if (ret >= 0)
+            {
+                decoded = true;
+            }
+            else if (ret != AVERROR(EAGAIN))
+            {
+                break;
+            }
+        }
+
+        av_packet_free(&packet);
+        return decoded;
+    }
+
+    // Fit source dimensions inside the target box, keeping the aspect ratio.
+    // A non-positive target dimension leaves that side unconstrained.
+    static void fitSize(int src_width, int src_height, int target_width, int target_height,
+                        int *out_width, int *out_height)
+    {
+        double scale = 1.0;
+        if (target_width > 0 && target_height > 0)
+        {
+            scale = std::min(static_cast<double>(target_width) / src_width,
+                             static_cast<double>(target_height) / src_height);
+        }
+        else if (target_width > 0)
+        {
+            scale = static_cast<double>(target_width) / src_width;
+        }
+        else if (target_height > 0)
+        {
+            scale = static_cast<double>(target_height) / src_height;
+        }
+
+        *out_width = std::max(1, static_cast<int>(src_width * scale + 0.5));
+        *out_height = std::max(1, static_cast<int>(src_height * scale + 0.5));
+    }
+
+    ThumbnailData convertFrameToJpeg(AVFrame *frame, int target_width, int target_height)
+    {
+        if (frame->width <= 0 || frame->height <= 0)
+        {
+            return ThumbnailData();
+        }
+
+        int width = 0;
+        int height = 0;
+        fitSize(frame->width, frame->height, target_width, target_height, &width, &height);
+
+        const AVCodec *encoder = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+        if (!encoder)
+        {
+            return ThumbnailData();
+        }
+
+        ThumbnailData result;
+        AVCodecContext *encoder_ctx = avcodec_alloc_context3(encoder);
+        AVFrame *scaled = av_frame_alloc();
+        AVPacket *packet = av_packet_alloc();
+        SwsContext *sws_ctx = nullptr;
+
+        if (encoder_ctx && scaled && packet)
+        {
+            encoder_ctx->width = width;
+            encoder_ctx->height = height;
+            encoder_ctx->pix_fmt = AV_PIX_FMT_YUVJ420P;
+            encoder_ctx->time_base = AVRational{1, 25};
+            encoder_ctx->flags |= AV_CODEC_FLAG_QSCALE;
+            encoder_ctx->global_quality = FF_QP2LAMBDA * kJpegQuality;
+
+            scaled->format = encoder_ctx->pix_fmt;
+            scaled->width = width;
+            scaled->height = height;
+
+            sws_ctx = sws_getContext(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                     width, height, encoder_ctx->pix_fmt, SWS_BICUBIC,
+                                     nullptr, nullptr, nullptr);
+
+            if (sws_ctx && avcodec_open2(encoder_ctx, encoder, nullptr) >= 0 &&
+                av_frame_get_buffer(scaled, 0) >= 0)
+            {
+                sws_scale(sws_ctx, frame->data, frame->linesize, 0, frame->height,
+                          scaled->data, scaled->linesize);
+                scaled->pts = 0;
+                scaled->quality = encoder_ctx->global_quality;
+
+                if (avcodec_send_frame(encoder_ctx, scaled) >= 0 &&
+                    avcodec_send_frame(encoder_ctx, nullptr) >= 0 &&
+                    avcodec_receive_packet(encoder_ctx, packet) >= 0)
+                {
+                    result.data = static_cast<uint8_t *>(malloc(packet->size));
+                    if (result.data)
+                    {
+                        memcpy(result.data, packet->data, packet->size);
+                        result.size = static_cast<size_t>(packet->size);
+                        result.width = width;
+                        result.height = height;
+                    }
+                }
+            }
+        }
+
+        sws_freeContext(sws_ctx);
+        av_packet_free(&packet);
+        av_frame_free(&scaled);
+        avcodec_free_context(&encoder_ctx);
+        return result;
+    }
+#endif
 };
 
 ThumbnailGenerator::ThumbnailGenerator() : pImpl(std::make_unique<Impl>()) {}
 
 ThumbnailGenerator::~ThumbnailGenerator() = default;
 
+#ifdef SMB_BRIDGE_WITH_FFMPEG
+
+ThumbnailData ThumbnailGenerator::generateFromSmbFile(SmbClient *client, const std::string &path,
+                                                      int target_width, int target_height)
+{
+    if (!client || !pImpl->initialized)
+    {
+        return ThumbnailData();
+    }
+
+    Impl::SmbIOContext io = {};
+    AVIOContext *avio = pImpl->createSmbIOContext(client, path, &io);
+    if (!avio)
+    {
+        return ThumbnailData();
+    }
+
+    ThumbnailData result;
+    AVFormatContext *format_ctx = avformat_alloc_context();
+    if (format_ctx)
+    {
+        format_ctx->pb = avio;
+        format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+        result = pImpl->generate(format_ctx, path, target_width, target_height);
+    }
+
+    pImpl->freeSmbIOContext(avio, &io);
+    return result;
+}
+
+ThumbnailData ThumbnailGenerator::generateFromLocalFile(const std::string &path,
+                                                        int target_width, int target_height)
+{
+    if (!pImpl->initialized)
+    {
+        return ThumbnailData();
+    }
+
+    AVFormatContext *format_ctx = avformat_alloc_context();
+    if (!format_ctx)
+    {
+        return ThumbnailData();
+    }
+    return pImpl->generate(format_ctx, path, target_width, target_height);
+}
+
+#else
+
 ThumbnailData ThumbnailGenerator::generateFromSmbFile(SmbClient *client, const std::string &path,
                                                       int target_width, int target_height)
 {
@@ -127,9 +552,9 @@ ThumbnailData ThumbnailGenerator::generateFromLocalFile(const std::string &path,
     return result;
 }
 
+#endif
+
 bool ThumbnailGenerator::isSupported(const std::string &file_extension)
 {
     return pImpl->isImageFile(file_extension) || pImpl->isVideoFile(file_extension);
 }
-
-// End of file - all methods implemented above
\ No newline at end of file
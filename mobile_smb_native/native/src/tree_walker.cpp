@@ -0,0 +1,339 @@
+// Parallel recursive directory walk over pooled SMB sessions
+
+#include "tree_walker.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// How often run() looks at the cancel flag while waiting for entries
+static const int kCancelPollMs = 50;
+
+// Entries that may wait for the caller, in batches, before workers pause
+static const size_t kBufferedBatches = 8;
+
+static bool matchFrom(const char *pattern, const char *text)
+{
+    while (*pattern)
+    {
+        if (pattern[0] == '*' && pattern[1] == '*')
+        {
+            // '**/' may also match no directories at all
+            pattern += 2;
+            if (*pattern == '/' && matchFrom(pattern + 1, text))
+            {
+                return true;
+            }
+            for (const char *rest = text;; rest++)
+            {
+                if (matchFrom(pattern, rest))
+                {
+                    return true;
+                }
+                if (!*rest)
+                {
+                    return false;
+                }
+            }
+        }
+        if (*pattern == '*')
+        {
+            pattern++;
+            for (const char *rest = text;; rest++)
+            {
+                if (matchFrom(pattern, rest))
+                {
+                    return true;
+                }
+                if (!*rest || *rest == '/')
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (!*text)
+        {
+            return false;
+        }
+        if (*pattern == '?')
+        {
+            if (*text == '/')
+            {
+                return false;
+            }
+        }
+        else if (std::tolower(static_cast<unsigned char>(*pattern)) != std::tolower(static_cast<unsigned char>(*text)))
+        {
+            return false;
+        }
+        pattern++;
+        text++;
+    }
+    return *text == '\0';
+}
+
+bool TreeWalker::globMatch(const char *pattern, const char *text)
+{
+    return matchFrom(pattern, text);
+}
+
+bool TreeWalker::matchesAny(const std::vector<std::string> &patterns, const std::string &path, const char *name)
+{
+    for (const auto &pattern : patterns)
+    {
+        const char *subject = pattern.find('/') == std::string::npos ? name : path.c_str();
+        if (matchFrom(pattern.c_str(), subject))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+TreeWalker::TreeWalker(const Options &options)
+    : options_(options), active_(0), workers_(0), root_status_(0), stopping_(false)
+{
+    options_.max_sessions = std::max<size_t>(1, options_.max_sessions);
+    options_.batch_size = std::max<size_t>(1, options_.batch_size);
+}
+
+bool TreeWalker::cancelRequested() const
+{
+    return options_.cancel && *options_.cancel != 0;
+}
+
+// Caller must hold mutex_
+bool TreeWalker::finished() const
+{
+    return stopping_ || workers_ == 0 || (pending_.empty() && active_ == 0);
+}
+
+int TreeWalker::run(const std::shared_ptr<Smb2ClientWrapper> &client, const std::string &root,
+                    const SessionFactory &acquire_session, const BatchCallback &on_batch)
+{
+    root_ = root;
+    while (!root_.empty() && root_.back() == '/')
+    {
+        root_.pop_back();
+    }
+    pending_.clear();
+    pending_.push_back({std::string(), 0});
+    active_ = 0;
+    output_.clear();
+    root_status_ = 0;
+    stopping_ = false;
+    workers_ = options_.max_sessions;
+
+    std::vector<std::thread> threads;
+    threads.emplace_back([this, client]
+                         { workerLoop(client); });
+    for (size_t i = 1; i < options_.max_sessions; i++)
+    {
+        threads.emplace_back([this, &acquire_session]
+                             {
+                                 std::shared_ptr<Smb2ClientWrapper> session;
+                                 if (acquire_session)
+                                 {
+                                     session = acquire_session();
+                                 }
+                                 workerLoop(session); });
+    }
+
+    bool cancelled = false;
+    std::vector<WalkEntry> entries;
+    std::vector<WalkEntry> batch;
+    while (true)
+    {
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            output_cv_.wait_for(lock, std::chrono::milliseconds(kCancelPollMs), [this]
+                                { return output_.size() >= options_.batch_size || finished(); });
+            if (cancelRequested())
+            {
+                cancelled = true;
+                stopping_ = true;
+            }
+            done = finished();
+            if (output_.size() >= options_.batch_size || (done && !output_.empty()))
+            {
+                entries.swap(output_);
+            }
+        }
+        work_cv_.notify_all();
+
+        for (size_t start = 0; start < entries.size() && !cancelled; start += options_.batch_size)
+        {
+            if (cancelRequested())
+            {
+                // Picked up under the lock on the next turn
+                cancelled = true;
+                break;
+            }
+            size_t end = std::min(entries.size(), start + options_.batch_size);
+            batch.assign(std::make_move_iterator(entries.begin() + start), std::make_move_iterator(entries.begin() + end));
+            on_batch(batch);
+        }
+        entries.clear();
+
+        if (done)
+        {
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        if (!cancelled && root_status_ == 0 && !(pending_.empty() && active_ == 0))
+        {
+            // Every session was lost with directories left to list
+            root_status_ = -ECONNRESET;
+        }
+    }
+    work_cv_.notify_all();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    return cancelled ? -ECANCELED : root_status_;
+}
+
+void TreeWalker::workerLoop(const std::shared_ptr<Smb2ClientWrapper> &client)
+{
+    const size_t max_buffered = options_.batch_size * kBufferedBatches;
+    std::vector<Directory> taken;
+    std::vector<std::string> paths;
+    std::vector<Directory> found;
+    std::vector<WalkEntry> entries;
+    bool lost = !client;
+
+    while (!lost)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this, max_buffered]
+                          { return stopping_ || (pending_.empty() && active_ == 0) ||
+                                   (!pending_.empty() && output_.size() < max_buffered); });
+            if (stopping_ || pending_.empty())
+            {
+                break;
+            }
+
+            taken.clear();
+            while (!pending_.empty() && taken.size() < kListingsPerSession)
+            {
+                taken.push_back(std::move(pending_.front()));
+                pending_.pop_front();
+            }
+            active_ += taken.size();
+        }
+
+        paths.clear();
+        for (const auto &directory : taken)
+        {
+            if (directory.path.empty())
+            {
+                paths.push_back(root_);
+            }
+            else
+            {
+                paths.push_back(root_.empty() ? directory.path : root_ + "/" + directory.path);
+            }
+        }
+
+        found.clear();
+        entries.clear();
+        std::vector<bool> requeue(taken.size(), false);
+        int root_status = 0;
+        client->listDirectories(
+            paths, kListingsPerSession,
+            [&](size_t index, int status, const std::vector<DirEntryRef> &listing)
+            {
+                const Directory &directory = taken[index];
+                if (status < 0)
+                {
+                    if (status == -ENOTCONN || status == -ECONNRESET)
+                    {
+                        // Another session lists it
+                        lost = true;
+                        requeue[index] = true;
+                    }
+                    else if (directory.depth == 0)
+                    {
+                        root_status = status;
+                    }
+                    return;
+                }
+
+                for (const auto &entry : listing)
+                {
+                    if (strcmp(entry.name, ".") == 0 || strcmp(entry.name, "..") == 0)
+                    {
+                        continue;
+                    }
+
+                    std::string path = directory.path.empty() ? std::string(entry.name)
+                                                              : directory.path + "/" + entry.name;
+                    if (matchesAny(options_.exclude, path, entry.name))
+                    {
+                        continue;
+                    }
+                    if (entry.is_directory && (options_.max_depth == 0 || directory.depth + 1 < options_.max_depth))
+                    {
+                        found.push_back({path, directory.depth + 1});
+                    }
+                    if (options_.include.empty() || matchesAny(options_.include, path, entry.name))
+                    {
+                        entries.push_back({std::move(path), entry.size, entry.modified_time, entry.is_directory});
+                    }
+                }
+            });
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < taken.size(); i++)
+            {
+                if (requeue[i])
+                {
+                    pending_.push_back(std::move(taken[i]));
+                }
+            }
+            for (auto &directory : found)
+            {
+                pending_.push_back(std::move(directory));
+            }
+            active_ -= taken.size();
+            if (root_status < 0)
+            {
+                root_status_ = root_status;
+            }
+            if (output_.empty())
+            {
+                output_.swap(entries);
+            }
+            else
+            {
+                output_.insert(output_.end(), std::make_move_iterator(entries.begin()),
+                               std::make_move_iterator(entries.end()));
+            }
+        }
+        work_cv_.notify_all();
+        output_cv_.notify_one();
+
+        if (cancelRequested())
+        {
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        workers_--;
+    }
+    work_cv_.notify_all();
+    output_cv_.notify_one();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "smb_client.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Entry found by TreeWalker; path is relative to the walk root
+struct WalkEntry
+{
+    std::string path;
+    uint64_t size;
+    uint64_t modified_time;
+    bool is_directory;
+};
+
+// Recursive listing of a directory tree. Several sessions list directories
+// at once, each keeping a few smb2_opendir_async requests in flight, and
+// entries reach the caller in batches on the thread that called run().
+//
+// Globs match the path relative to the root, ignoring ASCII case as SMB
+// does; a pattern without '/' matches the entry name at any depth. '*' and
+// '?' stay within one path component and '**' spans any number of them.
+// Include patterns select the entries reported; exclude patterns drop
+// entries and keep excluded directories from being entered.
+class TreeWalker
+{
+public:
+    using SessionFactory = std::function<std::shared_ptr<Smb2ClientWrapper>()>;
+    using BatchCallback = std::function<void(std::vector<WalkEntry> &batch)>;
+
+    static constexpr size_t kDefaultSessions = 4;
+    static constexpr size_t kDefaultBatchSize = 1024;
+    // Directories each session keeps in flight
+    static constexpr size_t kListingsPerSession = 8;
+
+    struct Options
+    {
+        size_t max_sessions = kDefaultSessions;
+        uint32_t max_depth = 0; // 0 walks the whole tree; 1 lists root only
+        size_t batch_size = kDefaultBatchSize;
+        std::vector<std::string> include;
+        std::vector<std::string> exclude;
+        const volatile int32_t *cancel = nullptr; // Checked between listings
+    };
+
+    explicit TreeWalker(const Options &options);
+
+    // Walks root on client, plus up to max_sessions - 1 sessions taken from
+    // acquire_session on the worker threads (it may return nullptr). Returns
+    // 0, -ECANCELED, or the error listing root; unreadable subdirectories
+    // are skipped.
+    int run(const std::shared_ptr<Smb2ClientWrapper> &client, const std::string &root,
+            const SessionFactory &acquire_session, const BatchCallback &on_batch);
+
+    static bool globMatch(const char *pattern, const char *text);
+
+private:
+    struct Directory
+    {
+        std::string path; // Relative to the root
+        uint32_t depth;
+    };
+
+    void workerLoop(const std::shared_ptr<Smb2ClientWrapper> &client);
+    bool finished() const;
+    bool cancelRequested() const;
+    static bool matchesAny(const std::vector<std::string> &patterns, const std::string &path,
+                           const char *name);
+
+    Options options_;
+    std::string root_;
+
+    // Guards everything below. Workers wait on work_cv_ for directories (or
+    // for room in output_); run() waits on output_cv_ for entries.
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable output_cv_;
+    std::deque<Directory> pending_;
+    size_t active_; // Directories being listed
+    size_t workers_;
+    std::vector<WalkEntry> output_;
+    int root_status_;
+    bool stopping_;
+};
@@ -0,0 +1,178 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+#include "connection_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+// Three shares on one server. The pool is process-wide, so each test puts
+// back the default limits and drops its idle sessions.
+class ConnectionPoolTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(server_.addShare("share2"));
+        ASSERT_TRUE(server_.addShare("share3"));
+        ASSERT_TRUE(server_.writeFile("video.bin", fake_smb2::makeData(4096)));
+    }
+
+    void TearDown() override
+    {
+        smb_configure_connection_pool(ConnectionPool::kDefaultMaxConnections,
+                                      ConnectionPool::kDefaultIdleTimeoutSeconds);
+        smb_close_idle_connections();
+    }
+
+    static SmbContext *connect(const char *share = "share", const char *password = "password")
+    {
+        return smb_connect("server", share, "user", password);
+    }
+
+    fake_smb2::Server server_;
+};
+
+TEST_F(ConnectionPoolTest, ReleasedSessionIsReused)
+{
+    SmbContext *first = connect();
+    ASSERT_NE(first, nullptr);
+    smb_disconnect(first);
+
+    SmbContext *second = connect();
+    ASSERT_NE(second, nullptr);
+    EXPECT_TRUE(smb_is_connected(second));
+    EXPECT_EQ(fake_smb2::connects, 1);
+
+    // Another password is another session
+    SmbContext *other = connect("share", "other");
+    ASSERT_NE(other, nullptr);
+    EXPECT_EQ(fake_smb2::connects, 2);
+
+    smb_disconnect(other);
+    smb_disconnect(second);
+}
+
+TEST_F(ConnectionPoolTest, CapEvictsIdleThenSharesOrGoesUnpooled)
+{
+    ASSERT_EQ(smb_configure_connection_pool(2, 60), SMB_SUCCESS);
+    SmbContext *busy = connect();
+    ASSERT_NE(busy, nullptr);
+    SmbContext *idle = connect("share", "other");
+    ASSERT_NE(idle, nullptr);
+    smb_disconnect(idle);
+    ASSERT_EQ(fake_smb2::connects, 2);
+
+    // The idle session makes room
+    SmbContext *evicting = connect("share2");
+    ASSERT_NE(evicting, nullptr);
+    EXPECT_EQ(fake_smb2::connects, 3);
+
+    // Every pooled session is busy: a new key connects outside the pool...
+    SmbContext *unpooled = connect("share3");
+    ASSERT_NE(unpooled, nullptr);
+    EXPECT_TRUE(smb_is_connected(unpooled));
+    EXPECT_EQ(fake_smb2::connects, 4);
+
+    // ...and a known key shares its busy session
+    SmbContext *shared = connect();
+    ASSERT_NE(shared, nullptr);
+    EXPECT_EQ(fake_smb2::connects, 4);
+
+    smb_disconnect(shared);
+    smb_disconnect(unpooled);
+    smb_disconnect(evicting);
+    smb_disconnect(busy);
+}
+
+TEST_F(ConnectionPoolTest, ReturnedLeaseResetsSessionSettings)
+{
+    ASSERT_EQ(smb_configure_connection_pool(1, 60), SMB_SUCCESS);
+    SmbContext *context = connect();
+    ASSERT_NE(context, nullptr);
+    ASSERT_EQ(smb_set_metadata_cache_ttl(context, 0), SMB_SUCCESS);
+    smb_disconnect(context);
+
+    context = connect();
+    ASSERT_NE(context, nullptr);
+    ASSERT_EQ(fake_smb2::connects, 1);
+    uint64_t size = 0;
+    ASSERT_EQ(smb_stat(context, "video.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    int stats_before = fake_smb2::stats;
+    ASSERT_EQ(smb_stat(context, "video.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(fake_smb2::stats, stats_before) << "metadata cache was left disabled";
+    smb_disconnect(context);
+}
+
+TEST_F(ConnectionPoolTest, SharedSessionSharesSettingsUntilLastLease)
+{
+    ASSERT_EQ(smb_configure_connection_pool(1, 60), SMB_SUCCESS);
+    SmbContext *first = connect();
+    ASSERT_NE(first, nullptr);
+    SmbContext *second = connect();
+    ASSERT_NE(second, nullptr);
+    ASSERT_EQ(fake_smb2::connects, 1);
+
+    // Turning the cache off through one context turns it off for both
+    ASSERT_EQ(smb_set_metadata_cache_ttl(first, 0), SMB_SUCCESS);
+    uint64_t size = 0;
+    ASSERT_EQ(smb_stat(second, "video.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    int stats_before = fake_smb2::stats;
+    ASSERT_EQ(smb_stat(second, "video.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(fake_smb2::stats, stats_before + 1);
+
+    // Still shared, so still off
+    smb_disconnect(first);
+    stats_before = fake_smb2::stats;
+    ASSERT_EQ(smb_stat(second, "video.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(fake_smb2::stats, stats_before + 1);
+    smb_disconnect(second);
+}
+
+TEST_F(ConnectionPoolTest, OpenFileKeepsSessionFromReaper)
+{
+    ASSERT_EQ(smb_configure_connection_pool(8, 1), SMB_SUCCESS);
+    SmbContext *context = connect();
+    ASSERT_NE(context, nullptr);
+    SmbFileHandle *file = smb_open_file(context, "video.bin");
+    ASSERT_NE(file, nullptr);
+    smb_disconnect(context);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    uint8_t buffer[4];
+    size_t bytes_read = 0;
+    ASSERT_EQ(smb_read_chunk(file, buffer, sizeof(buffer), &bytes_read), SMB_SUCCESS);
+    EXPECT_EQ(bytes_read, sizeof(buffer));
+    smb_close_file(file);
+
+    // Once the file is closed the session idles out
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+    context = connect();
+    ASSERT_NE(context, nullptr);
+    EXPECT_EQ(fake_smb2::connects, 2);
+    smb_disconnect(context);
+}
+
+TEST_F(ConnectionPoolTest, ConcurrentLeases)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([] {
+            for (int i = 0; i < 200; i++)
+            {
+                SmbContext *context = connect();
+                if (context)
+                {
+                    smb_disconnect(context);
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_LE(fake_smb2::connects, static_cast<int>(ConnectionPool::kDefaultMaxConnections));
+}
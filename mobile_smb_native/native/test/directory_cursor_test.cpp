@@ -0,0 +1,121 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+
+// dir/ holds f1.txt..f50.txt of 1..50 bytes and a subdirectory "sub"
+class DirectoryCursorTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(server_.makeDirectory("dir"));
+        ASSERT_TRUE(server_.makeDirectory("dir/sub"));
+        for (int i = 1; i <= 50; i++)
+        {
+            std::string name = "dir/f" + std::to_string(i) + ".txt";
+            ASSERT_TRUE(server_.writeFile(name, fake_smb2::makeData(static_cast<size_t>(i))));
+        }
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    fake_smb2::Server server_;
+    SmbContext *context_ = nullptr;
+};
+
+TEST_F(DirectoryCursorTest, BatchesCoverDirectoryOnce)
+{
+    SmbDirectory *dir = smb_opendir(context_, "dir");
+    ASSERT_NE(dir, nullptr);
+
+    // An arena that holds only a few names at a time
+    std::map<std::string, SmbDirEntry> seen;
+    SmbDirEntry entries[8];
+    char arena[40];
+    size_t count = 0;
+    int batches = 0;
+    do
+    {
+        ASSERT_EQ(smb_readdir_batch(dir, entries, 8, arena, sizeof(arena), &count), SMB_SUCCESS);
+        for (size_t i = 0; i < count; i++)
+        {
+            EXPECT_TRUE(seen.emplace(entries[i].name, entries[i]).second) << entries[i].name;
+        }
+        batches++;
+    } while (count > 0);
+    smb_closedir(dir);
+
+    // 50 files, "sub", "." and ".."
+    EXPECT_EQ(seen.size(), 53u);
+    EXPECT_GT(batches, 53 / 8);
+    ASSERT_TRUE(seen.count("f17.txt"));
+    EXPECT_EQ(seen["f17.txt"].size, 17u);
+    EXPECT_EQ(seen["f17.txt"].is_directory, 0);
+    ASSERT_TRUE(seen.count("sub"));
+    EXPECT_EQ(seen["sub"].is_directory, 1);
+}
+
+TEST_F(DirectoryCursorTest, NameTooLargeForArenaIsKept)
+{
+    SmbDirectory *dir = smb_opendir(context_, "dir");
+    ASSERT_NE(dir, nullptr);
+
+    SmbDirEntry entry;
+    char arena[64];
+    size_t count = 0;
+    size_t total = 0;
+    while (true)
+    {
+        int result = smb_readdir_batch(dir, &entry, 1, arena, 2, &count);
+        if (result == SMB_ERROR_MEMORY_ALLOCATION)
+        {
+            // Too long for two bytes: the same entry comes back with room for it
+            ASSERT_EQ(smb_readdir_batch(dir, &entry, 1, arena, sizeof(arena), &count), SMB_SUCCESS);
+            ASSERT_EQ(count, 1u);
+            EXPECT_GT(strlen(entry.name), 1u);
+        }
+        else
+        {
+            ASSERT_EQ(result, SMB_SUCCESS);
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        total += count;
+    }
+    smb_closedir(dir);
+    EXPECT_EQ(total, 53u);
+}
+
+TEST_F(DirectoryCursorTest, MissingDirectory)
+{
+    EXPECT_EQ(smb_opendir(context_, "nope"), nullptr);
+}
+
+TEST_F(DirectoryCursorTest, ClosedCursorIsRejected)
+{
+    SmbDirectory *dir = smb_opendir(context_, "dir");
+    ASSERT_NE(dir, nullptr);
+    smb_closedir(dir);
+
+    SmbDirEntry entry;
+    char arena[64];
+    size_t count = 1;
+    EXPECT_NE(smb_readdir_batch(dir, &entry, 1, arena, sizeof(arena), &count), SMB_SUCCESS);
+    EXPECT_EQ(count, 0u);
+}
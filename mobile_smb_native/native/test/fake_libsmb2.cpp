@@ -0,0 +1,579 @@
+// Local-filesystem implementation of the libsmb2 subset smb_bridge uses, so
+// the bridge can be tested without a server. See fake_libsmb2.h.
+
+#include "fake_libsmb2.h"
+
+#include <smb2/smb2.h>
+#include <smb2/libsmb2.h>
+#include <smb2/libsmb2-raw.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fake_smb2
+{
+    std::atomic<int> connects{0};
+    std::atomic<int> stats{0};
+    std::atomic<int> async_reads{0};
+    std::atomic<int> max_in_flight{0};
+    std::atomic<uint32_t> max_read{0};
+    std::atomic<int> copychunk_writes{0};
+
+    std::atomic<bool> notify_supported{false};
+    std::atomic<bool> copychunk_supported{true};
+    std::atomic<uint32_t> copychunk_limit{1024 * 1024};
+
+    static std::mutex g_root_mutex;
+    static std::string g_root;
+
+    void setRoot(const std::string &root)
+    {
+        std::lock_guard<std::mutex> lock(g_root_mutex);
+        g_root = root;
+    }
+
+    void reset()
+    {
+        connects = 0;
+        stats = 0;
+        async_reads = 0;
+        max_in_flight = 0;
+        max_read = 0;
+        copychunk_writes = 0;
+        notify_supported = false;
+        copychunk_supported = true;
+        copychunk_limit = 1024 * 1024;
+    }
+
+    static std::string root()
+    {
+        std::lock_guard<std::mutex> lock(g_root_mutex);
+        return g_root;
+    }
+
+    static int removeEntry(const char *path, const struct stat *, int, struct FTW *)
+    {
+        return remove(path);
+    }
+
+    Server::Server()
+    {
+        char root[] = "/tmp/smb_bridge_test.XXXXXX";
+        if (!mkdtemp(root))
+        {
+            perror("mkdtemp");
+            abort();
+        }
+        root_ = root;
+        reset();
+        setRoot(root_);
+        addShare("share");
+    }
+
+    Server::~Server()
+    {
+        setRoot("");
+        nftw(root_.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    std::string Server::path(const std::string &relative, const std::string &share) const
+    {
+        return root_ + "/" + share + "/" + relative;
+    }
+
+    bool Server::addShare(const std::string &share)
+    {
+        return mkdir((root_ + "/" + share).c_str(), 0755) == 0;
+    }
+
+    bool Server::makeDirectory(const std::string &relative, const std::string &share)
+    {
+        return mkdir(path(relative, share).c_str(), 0755) == 0;
+    }
+
+    bool Server::writeFile(const std::string &relative, const std::vector<uint8_t> &data,
+                           const std::string &share)
+    {
+        std::ofstream out(path(relative, share), std::ios::binary);
+        out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        return out.good();
+    }
+
+    std::vector<uint8_t> Server::readFile(const std::string &relative, const std::string &share) const
+    {
+        std::ifstream in(path(relative, share), std::ios::binary | std::ios::ate);
+        std::vector<uint8_t> data(in ? static_cast<size_t>(in.tellg()) : 0);
+        in.seekg(0);
+        in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        return data;
+    }
+
+    bool Server::exists(const std::string &relative, const std::string &share) const
+    {
+        struct stat st;
+        return stat(path(relative, share).c_str(), &st) == 0;
+    }
+
+    std::vector<uint8_t> makeData(size_t size, uint32_t seed)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            data[i] = static_cast<uint8_t>(i * 131 + i / 9973 + seed);
+        }
+        return data;
+    }
+}
+
+namespace
+{
+    const uint32_t kFsctlSrvRequestResumeKey = 0x00140078;
+    const uint32_t kFsctlSrvCopyChunkWrite = 0x001480F2;
+    const int kNtStatusInvalidParameter = static_cast<int>(0xC000000D);
+    const int kNtStatusInvalidDeviceRequest = static_cast<int>(0xC0000010);
+
+    typedef std::function<void(struct smb2_context *)> Completion;
+
+    void fillStat(const struct stat &st, struct smb2_stat_64 *out)
+    {
+        memset(out, 0, sizeof(*out));
+        out->smb2_type = S_ISDIR(st.st_mode) ? SMB2_TYPE_DIRECTORY : SMB2_TYPE_FILE;
+        out->smb2_size = st.st_size;
+        out->smb2_mtime = st.st_mtime;
+        out->smb2_ino = st.st_ino;
+    }
+
+    uint32_t readLe32(const uint8_t *data)
+    {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint64_t readLe64(const uint8_t *data)
+    {
+        uint64_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+}
+
+struct smb2_context
+{
+    std::string share;
+    std::string error;
+    std::deque<Completion> queue;
+    int wake[2];
+};
+
+struct smb2fh
+{
+    int fd;
+    uint64_t offset;
+    smb2_file_id id;
+};
+
+struct smb2dir
+{
+    std::vector<std::string> names;
+    std::vector<struct smb2dirent> entries;
+    size_t position;
+};
+
+struct smb2_pdu
+{
+    Completion run;
+};
+
+static std::string fullPath(struct smb2_context *smb2, const char *path)
+{
+    std::string relative = path;
+    if (relative.empty() || relative[0] != '/')
+    {
+        relative = "/" + relative;
+    }
+    return fake_smb2::root() + "/" + smb2->share + relative;
+}
+
+// Queue a reply and make the context's fd readable
+static void enqueue(struct smb2_context *smb2, Completion completion)
+{
+    smb2->queue.push_back(std::move(completion));
+    char byte = 1;
+    if (write(smb2->wake[1], &byte, 1) < 0)
+    {
+        // The pipe is full, so the fd is readable already
+    }
+}
+
+extern "C"
+{
+
+struct smb2_context *smb2_init_context(void)
+{
+    struct smb2_context *smb2 = new smb2_context;
+    if (pipe(smb2->wake) < 0)
+    {
+        delete smb2;
+        return nullptr;
+    }
+    fcntl(smb2->wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(smb2->wake[1], F_SETFL, O_NONBLOCK);
+    return smb2;
+}
+
+void smb2_destroy_context(struct smb2_context *smb2)
+{
+    // Pending requests are dropped without their callbacks
+    close(smb2->wake[0]);
+    close(smb2->wake[1]);
+    delete smb2;
+}
+
+void smb2_set_user(struct smb2_context *, const char *) {}
+void smb2_set_password(struct smb2_context *, const char *) {}
+void smb2_set_domain(struct smb2_context *, const char *) {}
+void smb2_set_timeout(struct smb2_context *, int) {}
+
+int smb2_connect_share(struct smb2_context *smb2, const char *, const char *share, const char *)
+{
+    fake_smb2::connects++;
+    smb2->share = share;
+    struct stat st;
+    if (stat(fullPath(smb2, "").c_str(), &st) < 0)
+    {
+        smb2->error = "share not found";
+        return -ENOENT;
+    }
+    return 0;
+}
+
+int smb2_disconnect_share(struct smb2_context *)
+{
+    return 0;
+}
+
+const char *smb2_get_error(struct smb2_context *smb2)
+{
+    return smb2->error.c_str();
+}
+
+t_socket smb2_get_fd(struct smb2_context *smb2)
+{
+    return smb2->wake[0];
+}
+
+int smb2_which_events(struct smb2_context *)
+{
+    return POLLIN;
+}
+
+int smb2_service(struct smb2_context *smb2, int)
+{
+    char drain[256];
+    while (read(smb2->wake[0], drain, sizeof(drain)) > 0)
+    {
+    }
+
+    std::deque<Completion> completions;
+    completions.swap(smb2->queue);
+    int count = static_cast<int>(completions.size());
+    int previous = fake_smb2::max_in_flight.load();
+    while (count > previous && !fake_smb2::max_in_flight.compare_exchange_weak(previous, count))
+    {
+    }
+    for (Completion &completion : completions)
+    {
+        completion(smb2);
+    }
+    return 0;
+}
+
+uint16_t smb2_which_dialect(struct smb2_context *)
+{
+    return SMB2_VERSION_0311;
+}
+
+uint32_t smb2_get_max_read_size(struct smb2_context *)
+{
+    return 8 * 1024 * 1024;
+}
+
+uint32_t smb2_get_max_write_size(struct smb2_context *)
+{
+    return 8 * 1024 * 1024;
+}
+
+struct smb2fh *smb2_open(struct smb2_context *smb2, const char *path, int flags)
+{
+    int fd = open(fullPath(smb2, path).c_str(), flags, 0644);
+    if (fd < 0)
+    {
+        smb2->error = strerror(errno);
+        return nullptr;
+    }
+    struct smb2fh *fh = new smb2fh;
+    fh->fd = fd;
+    fh->offset = 0;
+    // The file id carries the handle so copychunk can find the source
+    memset(fh->id, 0, sizeof(fh->id));
+    memcpy(fh->id, &fh, sizeof(fh));
+    return fh;
+}
+
+int smb2_close(struct smb2_context *, struct smb2fh *fh)
+{
+    close(fh->fd);
+    delete fh;
+    return 0;
+}
+
+int smb2_read(struct smb2_context *, struct smb2fh *fh, uint8_t *buf, uint32_t count)
+{
+    ssize_t result = pread(fh->fd, buf, count, fh->offset);
+    if (result < 0)
+    {
+        return -errno;
+    }
+    fh->offset += result;
+    return static_cast<int>(result);
+}
+
+int smb2_pread_async(struct smb2_context *smb2, struct smb2fh *fh, uint8_t *buf, uint32_t count,
+                     uint64_t offset, smb2_command_cb cb, void *cb_data)
+{
+    fake_smb2::async_reads++;
+    uint32_t previous = fake_smb2::max_read.load();
+    while (count > previous && !fake_smb2::max_read.compare_exchange_weak(previous, count))
+    {
+    }
+    enqueue(smb2, [=](struct smb2_context *context) {
+        ssize_t result = pread(fh->fd, buf, count, offset);
+        cb(context, result < 0 ? -errno : static_cast<int>(result), nullptr, cb_data);
+    });
+    return 0;
+}
+
+int smb2_pwrite_async(struct smb2_context *smb2, struct smb2fh *fh, const uint8_t *buf, uint32_t count,
+                      uint64_t offset, smb2_command_cb cb, void *cb_data)
+{
+    enqueue(smb2, [=](struct smb2_context *context) {
+        ssize_t result = pwrite(fh->fd, buf, count, offset);
+        cb(context, result < 0 ? -errno : static_cast<int>(result), nullptr, cb_data);
+    });
+    return 0;
+}
+
+int64_t smb2_lseek(struct smb2_context *, struct smb2fh *fh, int64_t offset, int whence,
+                   uint64_t *current_offset)
+{
+    if (whence == SEEK_SET)
+    {
+        fh->offset = offset;
+    }
+    else if (whence == SEEK_CUR)
+    {
+        fh->offset += offset;
+    }
+    else
+    {
+        return -EINVAL;
+    }
+    if (current_offset)
+    {
+        *current_offset = fh->offset;
+    }
+    return static_cast<int64_t>(fh->offset);
+}
+
+int smb2_stat(struct smb2_context *smb2, const char *path, struct smb2_stat_64 *st)
+{
+    fake_smb2::stats++;
+    struct stat local;
+    if (stat(fullPath(smb2, path).c_str(), &local) < 0)
+    {
+        return -errno;
+    }
+    fillStat(local, st);
+    return 0;
+}
+
+int smb2_fstat(struct smb2_context *, struct smb2fh *fh, struct smb2_stat_64 *st)
+{
+    struct stat local;
+    if (fstat(fh->fd, &local) < 0)
+    {
+        return -errno;
+    }
+    fillStat(local, st);
+    return 0;
+}
+
+int smb2_unlink(struct smb2_context *smb2, const char *path)
+{
+    return unlink(fullPath(smb2, path).c_str()) < 0 ? -errno : 0;
+}
+
+struct smb2dir *smb2_opendir(struct smb2_context *smb2, const char *path)
+{
+    std::string base = fullPath(smb2, path);
+    DIR *local = opendir(base.c_str());
+    if (!local)
+    {
+        smb2->error = strerror(errno);
+        return nullptr;
+    }
+    struct smb2dir *dir = new smb2dir;
+    dir->position = 0;
+    while (struct dirent *entry = readdir(local))
+    {
+        dir->names.push_back(entry->d_name);
+    }
+    closedir(local);
+
+    dir->entries.resize(dir->names.size());
+    for (size_t i = 0; i < dir->names.size(); i++)
+    {
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        stat((base + "/" + dir->names[i]).c_str(), &st);
+        fillStat(st, &dir->entries[i].st);
+        dir->entries[i].name = dir->names[i].c_str();
+    }
+    return dir;
+}
+
+int smb2_opendir_async(struct smb2_context *smb2, const char *path, smb2_command_cb cb, void *cb_data)
+{
+    std::string copy = path;
+    enqueue(smb2, [=](struct smb2_context *context) {
+        struct smb2dir *dir = smb2_opendir(context, copy.c_str());
+        cb(context, dir ? 0 : -ENOENT, dir, cb_data);
+    });
+    return 0;
+}
+
+void smb2_closedir(struct smb2_context *, struct smb2dir *dir)
+{
+    delete dir;
+}
+
+struct smb2dirent *smb2_readdir(struct smb2_context *, struct smb2dir *dir)
+{
+    if (dir->position >= dir->entries.size())
+    {
+        return nullptr;
+    }
+    return &dir->entries[dir->position++];
+}
+
+smb2_file_id *smb2_get_file_id(struct smb2fh *fh)
+{
+    return &fh->id;
+}
+
+int smb2_notify_change_async(struct smb2_context *smb2, const char *, uint16_t, uint32_t, int,
+                             smb2_command_cb cb, void *cb_data)
+{
+    if (!fake_smb2::notify_supported)
+    {
+        return -ENOTSUP;
+    }
+    enqueue(smb2, [=](struct smb2_context *context) { cb(context, 0, nullptr, cb_data); });
+    return 0;
+}
+
+// Only the resume key and copychunk FSCTLs are implemented. A copychunk
+// reply's output is ChunksWritten, ChunkBytesWritten, TotalBytesWritten.
+struct smb2_pdu *smb2_cmd_ioctl_async(struct smb2_context *, struct smb2_ioctl_request *req,
+                                      smb2_command_cb cb, void *cb_data)
+{
+    struct smb2fh *target;
+    memcpy(&target, req->file_id, sizeof(target));
+    const uint8_t *input = static_cast<const uint8_t *>(req->input);
+    std::vector<uint8_t> in(input, input + req->input_count);
+    uint32_t code = req->ctl_code;
+
+    struct smb2_pdu *pdu = new smb2_pdu;
+    pdu->run = [=](struct smb2_context *context) {
+        if (!fake_smb2::copychunk_supported)
+        {
+            cb(context, kNtStatusInvalidDeviceRequest, nullptr, cb_data);
+            return;
+        }
+
+        std::vector<uint8_t> out;
+        if (code == kFsctlSrvRequestResumeKey)
+        {
+            out.resize(32);
+            memcpy(out.data(), &target, sizeof(target));
+        }
+        else if (code == kFsctlSrvCopyChunkWrite)
+        {
+            struct smb2fh *source;
+            memcpy(&source, in.data(), sizeof(source));
+            uint32_t count = readLe32(in.data() + 24);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (readLe32(in.data() + 48 + 24 * i) > fake_smb2::copychunk_limit)
+                {
+                    cb(context, kNtStatusInvalidParameter, nullptr, cb_data);
+                    return;
+                }
+            }
+
+            uint32_t total = 0;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const uint8_t *chunk = in.data() + 32 + 24 * i;
+                uint64_t source_offset = readLe64(chunk);
+                uint64_t target_offset = readLe64(chunk + 8);
+                uint32_t length = readLe32(chunk + 16);
+                std::vector<uint8_t> data(length);
+                ssize_t got = pread(source->fd, data.data(), length, source_offset);
+                if (got > 0 && pwrite(target->fd, data.data(), got, target_offset) == got)
+                {
+                    total += static_cast<uint32_t>(got);
+                }
+            }
+            fake_smb2::copychunk_writes++;
+            out.resize(12);
+            memcpy(out.data(), &count, 4);
+            memcpy(out.data() + 8, &total, 4);
+        }
+        else
+        {
+            cb(context, kNtStatusInvalidDeviceRequest, nullptr, cb_data);
+            return;
+        }
+
+        struct smb2_ioctl_reply reply;
+        memset(&reply, 0, sizeof(reply));
+        reply.output = out.data();
+        reply.output_count = static_cast<uint32_t>(out.size());
+        cb(context, 0, &reply, cb_data);
+    };
+    return pdu;
+}
+
+void smb2_queue_pdu(struct smb2_context *smb2, struct smb2_pdu *pdu)
+{
+    std::shared_ptr<smb2_pdu> owned(pdu);
+    enqueue(smb2, [owned](struct smb2_context *context) { owned->run(context); });
+}
+
+} // extern "C"
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// In-process stand-in for the libsmb2 calls smb_bridge makes. Share "name"
+// is served from the local directory <root>/name. Async requests are queued
+// and all complete on the next smb2_service call, as if their replies came
+// back together one round trip later.
+namespace fake_smb2
+{
+    // Directory holding one subdirectory per share
+    void setRoot(const std::string &root);
+    // Zero the counters and restore the default behaviour
+    void reset();
+
+    // Counters
+    extern std::atomic<int> connects;
+    extern std::atomic<int> stats;
+    extern std::atomic<int> async_reads;
+    extern std::atomic<int> max_in_flight;  // Most requests completed by one smb2_service
+    extern std::atomic<uint32_t> max_read;  // Largest read request
+    extern std::atomic<int> copychunk_writes;
+
+    // Behaviour
+    extern std::atomic<bool> notify_supported;
+    extern std::atomic<bool> copychunk_supported;
+    extern std::atomic<uint32_t> copychunk_limit; // Largest chunk the server accepts
+
+    // A server for one test: a new temporary root holding an empty share
+    // "share", with reset() applied. The root is removed on destruction, so
+    // sessions connected to it should be closed first.
+    class Server
+    {
+    public:
+        Server();
+        ~Server();
+        Server(const Server &) = delete;
+        Server &operator=(const Server &) = delete;
+
+        // Local path of a file on a share
+        std::string path(const std::string &relative, const std::string &share = "share") const;
+
+        bool addShare(const std::string &share);
+        bool makeDirectory(const std::string &relative, const std::string &share = "share");
+        bool writeFile(const std::string &relative, const std::vector<uint8_t> &data,
+                       const std::string &share = "share");
+        std::vector<uint8_t> readFile(const std::string &relative, const std::string &share = "share") const;
+        bool exists(const std::string &relative, const std::string &share = "share") const;
+
+    private:
+        std::string root_;
+    };
+
+    // Deterministic contents whose bytes differ from their neighbours
+    std::vector<uint8_t> makeData(size_t size, uint32_t seed = 1);
+}
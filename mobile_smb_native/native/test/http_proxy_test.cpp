@@ -0,0 +1,212 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+#include "connection_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    struct Response
+    {
+        int status = 0;
+        std::string headers;
+        std::string body;
+    };
+
+    // One request on its own connection. The status is 0 if the connection
+    // fails.
+    Response httpGet(const std::string &url, const std::string &extra_headers = "")
+    {
+        Response response;
+        const std::string prefix = "http://127.0.0.1:";
+        if (url.compare(0, prefix.size(), prefix) != 0)
+        {
+            return response;
+        }
+        size_t path_start = url.find('/', prefix.size());
+        int port = atoi(url.substr(prefix.size(), path_start - prefix.size()).c_str());
+
+        int socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(socket_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            close(socket_fd);
+            return response;
+        }
+
+        std::string request = "GET " + url.substr(path_start) + " HTTP/1.1\r\nHost: 127.0.0.1\r\n" +
+                              extra_headers + "Connection: close\r\n\r\n";
+        if (send(socket_fd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size()))
+        {
+            close(socket_fd);
+            return response;
+        }
+
+        std::string raw;
+        char buffer[65536];
+        ssize_t received;
+        while ((received = recv(socket_fd, buffer, sizeof(buffer), 0)) > 0)
+        {
+            raw.append(buffer, static_cast<size_t>(received));
+        }
+        close(socket_fd);
+
+        size_t header_end = raw.find("\r\n\r\n");
+        if (raw.compare(0, 9, "HTTP/1.1 ") != 0 || header_end == std::string::npos)
+        {
+            return response;
+        }
+        response.status = atoi(raw.c_str() + 9);
+        response.headers = raw.substr(0, header_end);
+        response.body = raw.substr(header_end + 4);
+        return response;
+    }
+}
+
+// A running proxy and one session to a share holding video.bin
+class HttpProxyTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        data_ = fake_smb2::makeData(3000017);
+        ASSERT_TRUE(server_.writeFile("video.bin", data_));
+        ASSERT_EQ(smb_start_http_proxy(0, &port_), SMB_SUCCESS);
+        EXPECT_NE(port_, 0);
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_stop_http_proxy();
+        smb_configure_connection_pool(ConnectionPool::kDefaultMaxConnections,
+                                      ConnectionPool::kDefaultIdleTimeoutSeconds);
+        smb_close_idle_connections();
+    }
+
+    std::string urlFor(const char *path)
+    {
+        char *url = smb_proxy_url_for(context_, path);
+        std::string result = url ? url : "";
+        smb_free_string(url);
+        return result;
+    }
+
+    std::string bytes(size_t offset, size_t length) const
+    {
+        return std::string(reinterpret_cast<const char *>(data_.data()) + offset, length);
+    }
+
+    fake_smb2::Server server_;
+    std::vector<uint8_t> data_;
+    uint16_t port_ = 0;
+    SmbContext *context_ = nullptr;
+};
+
+TEST_F(HttpProxyTest, ServesWholeFile)
+{
+    std::string url = urlFor("video.bin");
+    ASSERT_FALSE(url.empty());
+    EXPECT_EQ(url.compare(0, 17, "http://127.0.0.1:"), 0);
+
+    Response response = httpGet(url);
+    ASSERT_EQ(response.status, 200);
+    EXPECT_NE(response.headers.find("Accept-Ranges: bytes"), std::string::npos);
+    ASSERT_EQ(response.body.size(), data_.size());
+    EXPECT_TRUE(response.body == bytes(0, data_.size()));
+}
+
+TEST_F(HttpProxyTest, ServesRanges)
+{
+    std::string url = urlFor("video.bin");
+
+    Response response = httpGet(url, "Range: bytes=1000-1999\r\n");
+    ASSERT_EQ(response.status, 206);
+    EXPECT_NE(response.headers.find("Content-Range: bytes 1000-1999/3000017"), std::string::npos);
+    EXPECT_TRUE(response.body == bytes(1000, 1000));
+
+    // The tail of the file, as players probe it for an index
+    response = httpGet(url, "Range: bytes=-17\r\n");
+    ASSERT_EQ(response.status, 206);
+    EXPECT_TRUE(response.body == bytes(data_.size() - 17, 17));
+
+    response = httpGet(url, "Range: bytes=3000017-\r\n");
+    EXPECT_EQ(response.status, 416);
+}
+
+TEST_F(HttpProxyTest, SamePathSameUrl)
+{
+    EXPECT_EQ(urlFor("video.bin"), urlFor("video.bin"));
+}
+
+TEST_F(HttpProxyTest, UnknownTokenIsNotFound)
+{
+    std::string url = urlFor("video.bin");
+    size_t token_end = url.find('/', 17 + 1);
+    ASSERT_NE(token_end, std::string::npos);
+    std::string forged = "http://127.0.0.1:" + std::to_string(port_) + "/not-a-token" + url.substr(token_end);
+    EXPECT_EQ(httpGet(forged).status, 404);
+}
+
+TEST_F(HttpProxyTest, UrlOutlivesDisconnect)
+{
+    std::string url = urlFor("video.bin");
+    smb_disconnect(context_);
+    context_ = nullptr;
+
+    Response response = httpGet(url, "Range: bytes=0-9\r\n");
+    ASSERT_EQ(response.status, 206);
+    EXPECT_TRUE(response.body == bytes(0, 10));
+}
+
+TEST_F(HttpProxyTest, IdleStreamGivesBackItsSession)
+{
+    ASSERT_EQ(smb_configure_connection_pool(8, 1), SMB_SUCCESS);
+    std::string url = urlFor("video.bin");
+    std::string other = urlFor("other.bin");
+    smb_disconnect(context_);
+    context_ = nullptr;
+
+    // The proxy lets go after a second idle, then the pool's reaper closes it
+    std::this_thread::sleep_for(std::chrono::milliseconds(3500));
+    EXPECT_EQ(ConnectionPool::instance().connectionCount(), 0u);
+    ASSERT_EQ(fake_smb2::connects, 1);
+
+    // A request leases a session again
+    Response response = httpGet(url, "Range: bytes=10-19\r\n");
+    ASSERT_EQ(response.status, 206);
+    EXPECT_TRUE(response.body == bytes(10, 10));
+    EXPECT_EQ(fake_smb2::connects, 2);
+
+    // So does registering the path again, keeping its URL
+    context_ = smb_connect("server", "share", "user", "password");
+    ASSERT_NE(context_, nullptr);
+    EXPECT_EQ(fake_smb2::connects, 3);
+    EXPECT_EQ(urlFor("other.bin"), other);
+}
+
+TEST_F(HttpProxyTest, StopInvalidatesUrls)
+{
+    std::string url = urlFor("video.bin");
+    smb_stop_http_proxy();
+    EXPECT_EQ(httpGet(url).status, 0);
+    EXPECT_TRUE(urlFor("video.bin").empty());
+}
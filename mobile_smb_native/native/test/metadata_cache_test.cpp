@@ -0,0 +1,180 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+#include "metadata_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+TEST(MetadataCache, LookupIgnoresCaseAndSeparators)
+{
+    MetadataCache cache;
+    MetadataCache::ListingToken token = cache.beginListing();
+    cache.store("Dir/foo.mp4", CachedStat{true, 5, 1, false});
+    cache.markListed("dir", token);
+
+    CachedStat stat;
+    ASSERT_TRUE(cache.lookup("DIR\\Foo.MP4", &stat));
+    EXPECT_TRUE(stat.exists);
+    EXPECT_EQ(stat.size, 5u);
+
+    // Not in the listed directory, so known not to exist
+    ASSERT_TRUE(cache.lookup("dir/bar.mp4", &stat));
+    EXPECT_FALSE(stat.exists);
+
+    // Only ASCII is folded; a name that differs beyond it is not answered
+    EXPECT_FALSE(cache.lookup("dir/\xc3\x89t\xc3\xa9.mp4", &stat));
+}
+
+TEST(MetadataCache, NormalizeCollapsesSeparators)
+{
+    EXPECT_EQ(MetadataCache::normalize("/a//b/"), MetadataCache::normalize("a\\b"));
+    EXPECT_EQ(MetadataCache::parentOf(MetadataCache::normalize("a/b/c")), MetadataCache::normalize("a/b"));
+}
+
+TEST(MetadataCache, FullCacheEvictsOldestFirst)
+{
+    MetadataCache cache;
+    MetadataCache::ListingToken token = cache.beginListing();
+    cache.store("old/a", CachedStat{true, 1, 1, false});
+    cache.markListed("old", token);
+    cache.store("keep", CachedStat{true, 2, 1, false});
+    for (size_t i = 0; i < MetadataCache::kMaxEntries; i++)
+    {
+        cache.store("dir/f" + std::to_string(i), CachedStat{true, i, 1, false});
+        if (i % 1000 == 0)
+        {
+            // Storing again makes an entry the newest
+            cache.store("keep", CachedStat{true, 2, 1, false});
+        }
+    }
+    EXPECT_EQ(cache.size(), MetadataCache::kMaxEntries);
+
+    CachedStat stat;
+    EXPECT_FALSE(cache.lookup("old/a", &stat));
+    // The listing of old/ went with its child
+    EXPECT_FALSE(cache.lookup("old/b", &stat));
+    EXPECT_TRUE(cache.lookup("keep", &stat));
+    EXPECT_FALSE(cache.lookup("dir/f0", &stat));
+    ASSERT_TRUE(cache.lookup("dir/f" + std::to_string(MetadataCache::kMaxEntries - 1), &stat));
+    EXPECT_EQ(stat.size, MetadataCache::kMaxEntries - 1);
+}
+
+TEST(MetadataCache, EvictionStopsListingInProgress)
+{
+    MetadataCache cache;
+    MetadataCache::ListingToken token = cache.beginListing();
+    for (size_t i = 0; i <= MetadataCache::kMaxEntries; i++)
+    {
+        cache.store("big/f" + std::to_string(i), CachedStat{true, i, 1, false});
+    }
+    cache.markListed("big", token);
+
+    // big/f0 was evicted, so the listing must not call it missing
+    CachedStat stat;
+    EXPECT_FALSE(cache.lookup("big/f0", &stat));
+}
+
+class MetadataCacheBridgeTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(server_.writeFile("video.bin", fake_smb2::makeData(5000123)));
+        ASSERT_TRUE(server_.makeDirectory("dir"));
+        for (int i = 1; i <= 50; i++)
+        {
+            std::string name = "dir/f" + std::to_string(i) + ".txt";
+            ASSERT_TRUE(server_.writeFile(name, fake_smb2::makeData(static_cast<size_t>(i))));
+        }
+    }
+
+    void TearDown() override
+    {
+        smb_close_idle_connections();
+    }
+
+    fake_smb2::Server server_;
+};
+
+TEST_F(MetadataCacheBridgeTest, ListingAnswersStats)
+{
+    SmbContext *context = smb_connect("server", "share", "user", "password");
+    ASSERT_NE(context, nullptr);
+    SmbDirectoryResult listing = smb_list_directory(context, "dir");
+    ASSERT_EQ(listing.error_code, SMB_SUCCESS);
+    smb_free_directory_result(&listing);
+
+    int stats_before = fake_smb2::stats;
+    uint64_t size = 0;
+    int is_directory = 1;
+    ASSERT_EQ(smb_stat(context, "dir/f1.txt", &size, nullptr, &is_directory), SMB_SUCCESS);
+    EXPECT_EQ(size, 1u);
+    EXPECT_FALSE(is_directory);
+    ASSERT_EQ(smb_stat(context, "/dir//f2.txt", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(size, 2u);
+    EXPECT_EQ(smb_stat(context, "dir/missing.txt", &size, nullptr, nullptr), SMB_ERROR_FILE_NOT_FOUND);
+    EXPECT_EQ(fake_smb2::stats, stats_before);
+
+    smb_disconnect(context);
+}
+
+TEST_F(MetadataCacheBridgeTest, StatResultIsCached)
+{
+    SmbContext *context = smb_connect("server", "share", "user", "password");
+    ASSERT_NE(context, nullptr);
+
+    uint64_t size = 0;
+    ASSERT_EQ(smb_stat(context, "video.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(size, 5000123u);
+    int stats_before = fake_smb2::stats;
+    ASSERT_EQ(smb_stat(context, "VIDEO.BIN", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(fake_smb2::stats, stats_before);
+
+    smb_disconnect(context);
+}
+
+TEST_F(MetadataCacheBridgeTest, BatchedListingFillsCacheUntilItExpires)
+{
+    SmbContext *context = smb_connect("server", "share", "user", "password");
+    ASSERT_NE(context, nullptr);
+    ASSERT_EQ(smb_set_metadata_cache_ttl(context, 150), SMB_SUCCESS);
+
+    SmbDirectory *dir = smb_opendir(context, "dir");
+    ASSERT_NE(dir, nullptr);
+    SmbDirEntry entries[64];
+    char arena[4096];
+    size_t count = 0;
+    while (smb_readdir_batch(dir, entries, 64, arena, sizeof(arena), &count) == SMB_SUCCESS && count)
+    {
+    }
+    smb_closedir(dir);
+
+    int stats_before = fake_smb2::stats;
+    EXPECT_EQ(smb_stat(context, "dir/nothere", nullptr, nullptr, nullptr), SMB_ERROR_FILE_NOT_FOUND);
+    EXPECT_EQ(fake_smb2::stats, stats_before);
+
+    ASSERT_TRUE(server_.writeFile("dir/nothere", fake_smb2::makeData(1)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    uint64_t size = 0;
+    ASSERT_EQ(smb_stat(context, "dir/nothere", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(size, 1u);
+    EXPECT_EQ(fake_smb2::stats, stats_before + 1);
+
+    smb_disconnect(context);
+}
+
+TEST_F(MetadataCacheBridgeTest, ZeroTtlDisablesCache)
+{
+    SmbContext *context = smb_connect("server", "share", "user", "password");
+    ASSERT_NE(context, nullptr);
+    ASSERT_EQ(smb_set_metadata_cache_ttl(context, 0), SMB_SUCCESS);
+
+    ASSERT_EQ(smb_stat(context, "video.bin", nullptr, nullptr, nullptr), SMB_SUCCESS);
+    int stats_before = fake_smb2::stats;
+    ASSERT_EQ(smb_stat(context, "video.bin", nullptr, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(fake_smb2::stats, stats_before + 1);
+
+    smb_disconnect(context);
+}
@@ -0,0 +1,102 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+
+namespace
+{
+    // Name -> record of a packed listing, checking its layout on the way
+    std::map<std::string, SmbPackedEntry> unpack(const uint8_t *buffer, size_t size)
+    {
+        std::map<std::string, SmbPackedEntry> entries;
+        SmbPackedListingHeader header;
+        memcpy(&header, buffer, sizeof(header));
+        EXPECT_EQ(header.version, static_cast<uint32_t>(SMB_PACKED_LISTING_VERSION));
+        EXPECT_EQ(header.record_size, sizeof(SmbPackedEntry));
+        EXPECT_EQ(header.total_size, size);
+        EXPECT_GE(header.records_offset, sizeof(SmbPackedListingHeader));
+        EXPECT_GE(header.strings_offset, header.records_offset + header.count * header.record_size);
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            SmbPackedEntry entry;
+            memcpy(&entry, buffer + header.records_offset + i * header.record_size, sizeof(entry));
+            EXPECT_LE(entry.name_offset + entry.name_length + 1, size);
+            EXPECT_EQ(buffer[entry.name_offset + entry.name_length], 0);
+            std::string name(reinterpret_cast<const char *>(buffer) + entry.name_offset, entry.name_length);
+            entries[name] = entry;
+        }
+        return entries;
+    }
+}
+
+// dir/ holds f1.txt..f20.txt of 1..20 bytes and a subdirectory "sub"
+class PackedListingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(server_.makeDirectory("dir"));
+        ASSERT_TRUE(server_.makeDirectory("dir/sub"));
+        for (int i = 1; i <= 20; i++)
+        {
+            std::string name = "dir/f" + std::to_string(i) + ".txt";
+            ASSERT_TRUE(server_.writeFile(name, fake_smb2::makeData(static_cast<size_t>(i))));
+        }
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    fake_smb2::Server server_;
+    SmbContext *context_ = nullptr;
+};
+
+TEST_F(PackedListingTest, OneBufferHoldsEveryEntry)
+{
+    uint8_t *buffer = nullptr;
+    size_t size = 0;
+    ASSERT_EQ(smb_list_directory_packed(context_, "dir", &buffer, &size), SMB_SUCCESS);
+    ASSERT_NE(buffer, nullptr);
+
+    std::map<std::string, SmbPackedEntry> entries = unpack(buffer, size);
+    smb_free_packed_listing(buffer);
+
+    // 20 files, "sub", "." and ".."
+    EXPECT_EQ(entries.size(), 23u);
+    ASSERT_TRUE(entries.count("f9.txt"));
+    EXPECT_EQ(entries["f9.txt"].size, 9u);
+    EXPECT_EQ(entries["f9.txt"].flags & SMB_PACKED_ENTRY_DIRECTORY, 0u);
+    ASSERT_TRUE(entries.count("sub"));
+    EXPECT_EQ(entries["sub"].flags & SMB_PACKED_ENTRY_DIRECTORY, static_cast<uint32_t>(SMB_PACKED_ENTRY_DIRECTORY));
+}
+
+TEST_F(PackedListingTest, EmptyDirectory)
+{
+    uint8_t *buffer = nullptr;
+    size_t size = 0;
+    ASSERT_EQ(smb_list_directory_packed(context_, "dir/sub", &buffer, &size), SMB_SUCCESS);
+    std::map<std::string, SmbPackedEntry> entries = unpack(buffer, size);
+    smb_free_packed_listing(buffer);
+    EXPECT_EQ(entries.size(), 2u);
+}
+
+TEST_F(PackedListingTest, MissingDirectory)
+{
+    uint8_t *buffer = reinterpret_cast<uint8_t *>(1);
+    size_t size = 1;
+    EXPECT_EQ(smb_list_directory_packed(context_, "nope", &buffer, &size), SMB_ERROR_FILE_NOT_FOUND);
+    EXPECT_EQ(buffer, nullptr);
+    EXPECT_EQ(size, 0u);
+}
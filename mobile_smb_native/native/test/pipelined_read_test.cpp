@@ -0,0 +1,122 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    struct Completion
+    {
+        std::atomic<bool> done{false};
+        int error_code = 1;
+        size_t bytes_read = 0;
+    };
+
+    void onReadComplete(SmbFileHandle *, int error_code, size_t bytes_read, void *user_data)
+    {
+        Completion *completion = static_cast<Completion *>(user_data);
+        completion->error_code = error_code;
+        completion->bytes_read = bytes_read;
+        completion->done = true;
+    }
+
+    bool waitFor(const Completion &completion)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!completion.done)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+// One open file on a fresh server
+class PipelinedReadTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        data_ = fake_smb2::makeData(5000123);
+        ASSERT_TRUE(server_.writeFile("video.bin", data_));
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+        file_ = smb_open_file(context_, "video.bin");
+        ASSERT_NE(file_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (file_)
+        {
+            smb_close_file(file_);
+        }
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    fake_smb2::Server server_;
+    std::vector<uint8_t> data_;
+    SmbContext *context_ = nullptr;
+    SmbFileHandle *file_ = nullptr;
+};
+
+TEST_F(PipelinedReadTest, RangeKeepsSeveralReadsInFlight)
+{
+    std::vector<uint8_t> buffer(3000000);
+    size_t bytes_read = 0;
+    ASSERT_EQ(smb_read_range_async(file_, buffer.data(), buffer.size(), 1000, 1000 + 2500000, &bytes_read),
+              SMB_SUCCESS);
+    ASSERT_EQ(bytes_read, 2500000u);
+    EXPECT_EQ(memcmp(buffer.data(), data_.data() + 1000, bytes_read), 0);
+    EXPECT_GT(fake_smb2::max_in_flight.load(), 1);
+}
+
+TEST_F(PipelinedReadTest, RangeStopsAtEndOfFile)
+{
+    std::vector<uint8_t> buffer(3000000);
+    size_t bytes_read = 0;
+    ASSERT_EQ(smb_read_range_async(file_, buffer.data(), buffer.size(), 4000000, 7000000, &bytes_read),
+              SMB_SUCCESS);
+    ASSERT_EQ(bytes_read, data_.size() - 4000000);
+    EXPECT_EQ(memcmp(buffer.data(), data_.data() + 4000000, bytes_read), 0);
+}
+
+TEST_F(PipelinedReadTest, CallbackDeliversRange)
+{
+    ASSERT_EQ(smb_set_read_pipeline_depth(file_, 3), SMB_SUCCESS);
+
+    std::vector<uint8_t> buffer(3000000);
+    Completion completion;
+    ASSERT_EQ(smb_read_range_async_cb(file_, buffer.data(), buffer.size(), 7, 7 + 1234567, onReadComplete,
+                                      &completion),
+              SMB_SUCCESS);
+    ASSERT_TRUE(waitFor(completion));
+    EXPECT_EQ(completion.error_code, SMB_SUCCESS);
+    ASSERT_EQ(completion.bytes_read, 1234567u);
+    EXPECT_EQ(memcmp(buffer.data(), data_.data() + 7, completion.bytes_read), 0);
+}
+
+TEST_F(PipelinedReadTest, CloseWithQueuedReadStillCompletesIt)
+{
+    std::vector<uint8_t> buffer(100000);
+    Completion completion;
+    ASSERT_EQ(smb_read_range_async_cb(file_, buffer.data(), buffer.size(), 0, buffer.size(), onReadComplete,
+                                      &completion),
+              SMB_SUCCESS);
+    smb_close_file(file_);
+    file_ = nullptr;
+    EXPECT_TRUE(waitFor(completion));
+}
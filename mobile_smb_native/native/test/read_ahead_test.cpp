@@ -0,0 +1,110 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+
+class ReadAheadTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        data_ = fake_smb2::makeData(5000123);
+        ASSERT_TRUE(server_.writeFile("video.bin", data_));
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+        file_ = smb_open_file_for_streaming(context_, "video.bin");
+        ASSERT_NE(file_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (file_)
+        {
+            smb_close_file(file_);
+        }
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    fake_smb2::Server server_;
+    std::vector<uint8_t> data_;
+    SmbContext *context_ = nullptr;
+    SmbFileHandle *file_ = nullptr;
+};
+
+TEST_F(ReadAheadTest, SequentialReadsAreServedFromTheWindow)
+{
+    std::vector<uint8_t> received;
+    std::vector<uint8_t> buffer(65536 + 13);
+    int served_from_window = 0;
+    while (true)
+    {
+        int reads_before = fake_smb2::async_reads;
+        size_t bytes_read = 0;
+        ASSERT_EQ(smb_read_chunk(file_, buffer.data(), buffer.size(), &bytes_read), SMB_SUCCESS);
+        if (bytes_read == 0)
+        {
+            break;
+        }
+        if (fake_smb2::async_reads == reads_before)
+        {
+            served_from_window++;
+        }
+        received.insert(received.end(), buffer.begin(), buffer.begin() + bytes_read);
+        // Give the background prefetch a chance to run ahead of the reader
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    EXPECT_TRUE(received == data_);
+    EXPECT_GT(served_from_window, 10);
+}
+
+TEST_F(ReadAheadTest, RandomRangesMatchTheFile)
+{
+    std::mt19937 random(1);
+    std::vector<uint8_t> buffer(65536 + 13);
+    for (int i = 0; i < 300; i++)
+    {
+        uint64_t start = random() % data_.size();
+        size_t length = 1 + random() % 300000;
+        size_t bytes_read = 0;
+        ASSERT_EQ(smb_read_range(file_, buffer.data(), buffer.size(), start, start + length, &bytes_read),
+                  SMB_SUCCESS);
+        size_t expected = std::min<size_t>({length, buffer.size(), static_cast<size_t>(data_.size() - start)});
+        ASSERT_EQ(bytes_read, expected) << "start " << start << " length " << length;
+        ASSERT_EQ(memcmp(buffer.data(), data_.data() + start, bytes_read), 0) << "start " << start;
+    }
+}
+
+TEST_F(ReadAheadTest, PrefetchedRangeNeedsNoNewReads)
+{
+    ASSERT_EQ(smb_prefetch_range(file_, 3000000, 4000000), SMB_SUCCESS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<uint8_t> buffer(60000);
+    int reads_before = fake_smb2::async_reads;
+    size_t bytes_read = 0;
+    ASSERT_EQ(smb_read_range(file_, buffer.data(), buffer.size(), 3000000, 3060000, &bytes_read), SMB_SUCCESS);
+    ASSERT_EQ(bytes_read, 60000u);
+    EXPECT_EQ(memcmp(buffer.data(), data_.data() + 3000000, bytes_read), 0);
+    EXPECT_EQ(fake_smb2::async_reads, reads_before);
+}
+
+TEST_F(ReadAheadTest, DisabledWindowStillReads)
+{
+    ASSERT_EQ(smb_set_read_ahead(file_, 0), SMB_SUCCESS);
+
+    uint8_t buffer[10];
+    size_t bytes_read = 0;
+    ASSERT_EQ(smb_read_range(file_, buffer, sizeof(buffer), 10, 20, &bytes_read), SMB_SUCCESS);
+    ASSERT_EQ(bytes_read, 10u);
+    EXPECT_EQ(memcmp(buffer, data_.data() + 10, bytes_read), 0);
+}
@@ -0,0 +1,155 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+#include "read_size_tuner.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace
+{
+    // Feed the tuner pipelines of eight requests over a link with the given
+    // throughput (bytes per microsecond) and round trip
+    void simulate(ReadSizeTuner &tuner, uint64_t bytes_per_us, uint64_t round_trip_us)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            size_t request_size = tuner.requestSize();
+            uint64_t first = round_trip_us + request_size / bytes_per_us;
+            tuner.noteTransfer(request_size, 8, request_size * 8, first, first + request_size * 7 / bytes_per_us);
+        }
+    }
+}
+
+TEST(ReadSizeTuner, StartsAtInitialSize)
+{
+    ReadSizeTuner tuner;
+    tuner.setServerLimit(4 * 1024 * 1024);
+    EXPECT_EQ(tuner.requestSize(), ReadSizeTuner::kInitialRequestSize);
+}
+
+TEST(ReadSizeTuner, FastLinkGrowsToServerLimit)
+{
+    ReadSizeTuner tuner;
+    tuner.setServerLimit(4 * 1024 * 1024);
+    simulate(tuner, 1000, 200);
+    EXPECT_EQ(tuner.requestSize(), 4u * 1024 * 1024);
+}
+
+TEST(ReadSizeTuner, SlowLinkShrinksToMinimum)
+{
+    ReadSizeTuner tuner;
+    simulate(tuner, 2, 2000);
+    EXPECT_EQ(tuner.requestSize(), ReadSizeTuner::kMinRequestSize);
+}
+
+TEST(ReadSizeTuner, SmallServerLimitWins)
+{
+    ReadSizeTuner tuner;
+    tuner.setServerLimit(65536);
+    EXPECT_EQ(tuner.requestSize(), 65536u);
+    EXPECT_EQ(tuner.clamp(1), 65536u);
+
+    tuner.setServerLimit(32768);
+    EXPECT_EQ(tuner.requestSize(), 32768u);
+}
+
+class ReadSizingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        data_ = fake_smb2::makeData(48 * 1024 * 1024 + 12345, 5);
+        ASSERT_TRUE(server_.writeFile("big.bin", data_));
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+        file_ = smb_open_file_for_streaming(context_, "big.bin");
+        ASSERT_NE(file_, nullptr);
+        buffer_.resize(data_.size() + 100);
+    }
+
+    void TearDown() override
+    {
+        if (file_)
+        {
+            smb_close_file(file_);
+        }
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    void readWholeFile()
+    {
+        size_t bytes_read = 0;
+        ASSERT_EQ(smb_read_range_async(file_, buffer_.data(), buffer_.size(), 0, buffer_.size(), &bytes_read),
+                  SMB_SUCCESS);
+        ASSERT_EQ(bytes_read, data_.size());
+        ASSERT_EQ(memcmp(buffer_.data(), data_.data(), bytes_read), 0);
+    }
+
+    fake_smb2::Server server_;
+    std::vector<uint8_t> data_;
+    std::vector<uint8_t> buffer_;
+    SmbContext *context_ = nullptr;
+    SmbFileHandle *file_ = nullptr;
+};
+
+TEST_F(ReadSizingTest, RequestsGrowOnFastLink)
+{
+    for (int pass = 0; pass < 6; pass++)
+    {
+        readWholeFile();
+    }
+    EXPECT_GT(fake_smb2::max_read, ReadSizeTuner::kInitialRequestSize);
+}
+
+TEST_F(ReadSizingTest, FixedChunkSize)
+{
+    ASSERT_EQ(smb_set_streaming_options(file_, 128 * 1024, 4 * 1024 * 1024, 1), SMB_SUCCESS);
+    readWholeFile();
+    EXPECT_EQ(fake_smb2::max_read, 128u * 1024);
+}
+
+TEST_F(ReadSizingTest, LargeChunkReadsArePipelined)
+{
+    ASSERT_EQ(smb_set_streaming_options(file_, 0, 0, 0), SMB_SUCCESS);
+    ASSERT_EQ(smb_seek_file(file_, 0), SMB_SUCCESS);
+
+    const size_t first = 20 * 1024 * 1024;
+    size_t bytes_read = 0;
+    ASSERT_EQ(smb_read_chunk(file_, buffer_.data(), first, &bytes_read), SMB_SUCCESS);
+    ASSERT_EQ(bytes_read, first);
+    EXPECT_EQ(memcmp(buffer_.data(), data_.data(), bytes_read), 0);
+
+    ASSERT_EQ(smb_read_chunk(file_, buffer_.data(), buffer_.size(), &bytes_read), SMB_SUCCESS);
+    ASSERT_EQ(bytes_read, data_.size() - first);
+    EXPECT_EQ(memcmp(buffer_.data(), data_.data() + first, bytes_read), 0);
+
+    ASSERT_EQ(smb_read_range(file_, buffer_.data(), buffer_.size(), 1000, 9000000, &bytes_read), SMB_SUCCESS);
+    ASSERT_EQ(bytes_read, 9000000u - 1000);
+    EXPECT_EQ(memcmp(buffer_.data(), data_.data() + 1000, bytes_read), 0);
+}
+
+TEST_F(ReadSizingTest, ReadAheadWithTunedRequests)
+{
+    ASSERT_EQ(smb_set_streaming_options(file_, 0, 8 * 1024 * 1024, 1), SMB_SUCCESS);
+    ASSERT_EQ(smb_seek_file(file_, 0), SMB_SUCCESS);
+
+    std::vector<uint8_t> chunk(1 << 20);
+    size_t total = 0;
+    while (true)
+    {
+        size_t bytes_read = 0;
+        ASSERT_EQ(smb_read_chunk(file_, chunk.data(), chunk.size(), &bytes_read), SMB_SUCCESS);
+        if (bytes_read == 0)
+        {
+            break;
+        }
+        ASSERT_EQ(memcmp(chunk.data(), data_.data() + total, bytes_read), 0) << "offset " << total;
+        total += bytes_read;
+    }
+    EXPECT_EQ(total, data_.size());
+}
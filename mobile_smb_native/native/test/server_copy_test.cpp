@@ -0,0 +1,109 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    struct Progress
+    {
+        uint64_t copied = 0;
+        uint64_t total = 0;
+        int calls = 0;
+        bool went_backwards = false;
+    };
+
+    void onCopyProgress(uint64_t bytes_copied, uint64_t total_bytes, void *user_data)
+    {
+        Progress *progress = static_cast<Progress *>(user_data);
+        if (bytes_copied < progress->copied)
+        {
+            progress->went_backwards = true;
+        }
+        progress->copied = bytes_copied;
+        progress->total = total_bytes;
+        progress->calls++;
+    }
+}
+
+class ServerCopyTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // More than one round of copychunk requests
+        data_ = fake_smb2::makeData((70 << 20) + 12345, 3);
+        ASSERT_TRUE(server_.writeFile("source.bin", data_));
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    fake_smb2::Server server_;
+    std::vector<uint8_t> data_;
+    SmbContext *context_ = nullptr;
+};
+
+TEST_F(ServerCopyTest, CopiesOnTheServer)
+{
+    Progress progress;
+    ASSERT_EQ(smb_server_copy(context_, "source.bin", "copy.bin", onCopyProgress, &progress), SMB_SUCCESS);
+    EXPECT_GT(fake_smb2::copychunk_writes, 0);
+    EXPECT_EQ(progress.copied, data_.size());
+    EXPECT_EQ(progress.total, data_.size());
+    EXPECT_FALSE(progress.went_backwards);
+    EXPECT_TRUE(server_.readFile("copy.bin") == data_);
+}
+
+TEST_F(ServerCopyTest, ShrinksChunksToServerLimit)
+{
+    fake_smb2::copychunk_limit = 65536;
+    Progress progress;
+    ASSERT_EQ(smb_server_copy(context_, "source.bin", "copy.bin", onCopyProgress, &progress), SMB_SUCCESS);
+    EXPECT_GT(fake_smb2::copychunk_writes, 0);
+    EXPECT_EQ(progress.copied, data_.size());
+    EXPECT_FALSE(progress.went_backwards);
+    EXPECT_TRUE(server_.readFile("copy.bin") == data_);
+}
+
+TEST_F(ServerCopyTest, FallsBackWhenChunksStayTooLarge)
+{
+    fake_smb2::copychunk_limit = 4096;
+    Progress progress;
+    ASSERT_EQ(smb_server_copy(context_, "source.bin", "copy.bin", onCopyProgress, &progress), SMB_SUCCESS);
+    EXPECT_EQ(fake_smb2::copychunk_writes, 0);
+    EXPECT_EQ(progress.copied, data_.size());
+    EXPECT_TRUE(server_.readFile("copy.bin") == data_);
+}
+
+TEST_F(ServerCopyTest, FallsBackWithoutCopychunk)
+{
+    fake_smb2::copychunk_supported = false;
+    ASSERT_EQ(smb_server_copy(context_, "source.bin", "copy.bin", nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(fake_smb2::copychunk_writes, 0);
+    EXPECT_TRUE(server_.readFile("copy.bin") == data_);
+}
+
+TEST_F(ServerCopyTest, RejectsBadPaths)
+{
+    EXPECT_EQ(smb_server_copy(context_, "source.bin", "/source.bin", nullptr, nullptr), SMB_ERROR_INVALID_PARAMETER);
+    EXPECT_EQ(smb_server_copy(context_, "missing.bin", "copy.bin", nullptr, nullptr), SMB_ERROR_FILE_NOT_FOUND);
+    EXPECT_FALSE(server_.exists("copy.bin"));
+}
+
+TEST_F(ServerCopyTest, CopiesEmptyFile)
+{
+    ASSERT_TRUE(server_.writeFile("empty.bin", std::vector<uint8_t>()));
+    ASSERT_EQ(smb_server_copy(context_, "empty.bin", "copy.bin", nullptr, nullptr), SMB_SUCCESS);
+    uint64_t size = 1;
+    ASSERT_EQ(smb_stat(context_, "copy.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(size, 0u);
+}
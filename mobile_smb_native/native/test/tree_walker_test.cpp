@@ -0,0 +1,174 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+#include "tree_walker.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <thread>
+
+namespace
+{
+    // Paths seen by a walk, directories with a trailing '/'
+    struct WalkResult
+    {
+        std::set<std::string> paths;
+        int batches = 0;
+        uint32_t largest_batch = 0;
+        int duplicates = 0;
+        bool off_thread = false;
+        bool bad_size = false;
+        std::thread::id caller = std::this_thread::get_id();
+        volatile int32_t *cancel = nullptr;
+    };
+
+    void onBatch(uint8_t *batch, size_t size, void *user_data)
+    {
+        WalkResult *result = static_cast<WalkResult *>(user_data);
+        SmbPackedListingHeader header;
+        memcpy(&header, batch, sizeof(header));
+        result->batches++;
+        result->largest_batch = std::max(result->largest_batch, header.count);
+        result->bad_size |= header.total_size != size;
+        result->off_thread |= std::this_thread::get_id() != result->caller;
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            SmbPackedEntry entry;
+            memcpy(&entry, batch + header.records_offset + i * header.record_size, sizeof(entry));
+            std::string path(reinterpret_cast<const char *>(batch) + entry.name_offset, entry.name_length);
+            if (entry.flags & SMB_PACKED_ENTRY_DIRECTORY)
+            {
+                path += "/";
+            }
+            if (!result->paths.insert(path).second)
+            {
+                result->duplicates++;
+            }
+        }
+        if (result->cancel)
+        {
+            *result->cancel = 1;
+        }
+        smb_free_packed_listing(batch);
+    }
+}
+
+TEST(TreeWalker, GlobMatch)
+{
+    EXPECT_TRUE(TreeWalker::globMatch("*.JPG", "a.jpg"));
+    EXPECT_FALSE(TreeWalker::globMatch("*.jpg", "d/a.jpg"));
+    EXPECT_TRUE(TreeWalker::globMatch("**/*.jpg", "a.jpg"));
+    EXPECT_TRUE(TreeWalker::globMatch("**/*.jpg", "x/y/a.jpg"));
+    EXPECT_TRUE(TreeWalker::globMatch("x/**", "x/y/z"));
+    EXPECT_FALSE(TreeWalker::globMatch("x/*", "x/y/z"));
+    EXPECT_TRUE(TreeWalker::globMatch("a?c", "abc"));
+    EXPECT_FALSE(TreeWalker::globMatch("a?c", "a/c"));
+}
+
+// tree/d0..d11/e0..e9/f0..f14, a third of them .txt and the rest .jpg,
+// plus tree/d0/@eaDir/thumb.jpg
+class TreeWalkTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        ASSERT_TRUE(server_.makeDirectory("tree"));
+        for (int a = 0; a < 12; a++)
+        {
+            std::string top = "tree/d" + std::to_string(a);
+            ASSERT_TRUE(server_.makeDirectory(top));
+            for (int b = 0; b < 10; b++)
+            {
+                std::string dir = top + "/e" + std::to_string(b);
+                ASSERT_TRUE(server_.makeDirectory(dir));
+                for (int f = 0; f < 15; f++)
+                {
+                    std::string name = "/f" + std::to_string(f) + (f % 3 ? ".jpg" : ".txt");
+                    ASSERT_TRUE(server_.writeFile(dir + name, fake_smb2::makeData(1)));
+                }
+            }
+        }
+        ASSERT_TRUE(server_.makeDirectory("tree/d0/@eaDir"));
+        ASSERT_TRUE(server_.writeFile("tree/d0/@eaDir/thumb.jpg", std::vector<uint8_t>()));
+
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+        memset(&options_, 0, sizeof(options_));
+    }
+
+    void TearDown() override
+    {
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    static constexpr size_t kDirectories = 12 + 12 * 10 + 1;
+    static constexpr size_t kFiles = 12 * 10 * 15 + 1;
+
+    fake_smb2::Server server_;
+    SmbContext *context_ = nullptr;
+    SmbWalkOptions options_;
+};
+
+TEST_F(TreeWalkTest, WalksWholeTreeInBatches)
+{
+    options_.batch_size = 100;
+    WalkResult result;
+    ASSERT_EQ(smb_walk_tree(context_, "tree", &options_, onBatch, &result), SMB_SUCCESS);
+    EXPECT_EQ(result.paths.size(), kDirectories + kFiles);
+    EXPECT_EQ(result.duplicates, 0);
+    EXPECT_LE(result.largest_batch, 100u);
+    EXPECT_FALSE(result.off_thread);
+    EXPECT_FALSE(result.bad_size);
+    EXPECT_TRUE(result.paths.count("d3/e4/f1.jpg"));
+    EXPECT_TRUE(result.paths.count("d3/e4/"));
+}
+
+TEST_F(TreeWalkTest, IncludeAndExcludeGlobs)
+{
+    options_.include = "*.jpg";
+    options_.exclude = "@eaDir\nd1";
+    WalkResult result;
+    ASSERT_EQ(smb_walk_tree(context_, "tree/", &options_, onBatch, &result), SMB_SUCCESS);
+    EXPECT_EQ(result.paths.size(), 11u * 10 * 10);
+    EXPECT_FALSE(result.paths.count("d0/@eaDir/thumb.jpg"));
+    EXPECT_FALSE(result.paths.count("d1/e0/f1.jpg"));
+}
+
+TEST_F(TreeWalkTest, MaxDepth)
+{
+    options_.max_depth = 2;
+    WalkResult result;
+    ASSERT_EQ(smb_walk_tree(context_, "tree", &options_, onBatch, &result), SMB_SUCCESS);
+    EXPECT_EQ(result.paths.size(), kDirectories);
+}
+
+TEST_F(TreeWalkTest, IncludeWithDirectoryPattern)
+{
+    options_.include = "d2/**/*.txt";
+    WalkResult result;
+    ASSERT_EQ(smb_walk_tree(context_, "tree", &options_, onBatch, &result), SMB_SUCCESS);
+    EXPECT_EQ(result.paths.size(), 10u * 5);
+}
+
+TEST_F(TreeWalkTest, MissingRoot)
+{
+    WalkResult result;
+    EXPECT_EQ(smb_walk_tree(context_, "nope", nullptr, onBatch, &result), SMB_ERROR_FILE_NOT_FOUND);
+}
+
+TEST_F(TreeWalkTest, CancelStopsAfterBatch)
+{
+    volatile int32_t cancel = 0;
+    options_.batch_size = 10;
+    options_.cancel = &cancel;
+    WalkResult result;
+    result.cancel = &cancel;
+    EXPECT_NE(smb_walk_tree(context_, "tree", &options_, onBatch, &result), SMB_SUCCESS);
+    EXPECT_EQ(result.batches, 1);
+}
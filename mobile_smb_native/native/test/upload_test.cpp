@@ -0,0 +1,109 @@
+#include "fake_libsmb2.h"
+#include "smb_bridge.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+    struct Progress
+    {
+        std::atomic<uint64_t> bytes_written{0};
+        std::atomic<int> calls{0};
+        std::atomic<int> errors{0};
+    };
+
+    void onWriteProgress(SmbFileHandle *, int error_code, uint64_t bytes_written, void *user_data)
+    {
+        Progress *progress = static_cast<Progress *>(user_data);
+        if (error_code != SMB_SUCCESS)
+        {
+            progress->errors++;
+        }
+        progress->bytes_written = bytes_written;
+        progress->calls++;
+    }
+}
+
+class UploadTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        data_ = fake_smb2::makeData(40 * 1024 * 1024 + 777, 7);
+        context_ = smb_connect("server", "share", "user", "password");
+        ASSERT_NE(context_, nullptr);
+    }
+
+    void TearDown() override
+    {
+        if (context_)
+        {
+            smb_disconnect(context_);
+        }
+        smb_close_idle_connections();
+    }
+
+    static constexpr size_t kChunk = 4 * 1024 * 1024;
+
+    fake_smb2::Server server_;
+    std::vector<uint8_t> data_;
+    SmbContext *context_ = nullptr;
+};
+
+TEST_F(UploadTest, WriteRangeStoresWholeFile)
+{
+    SmbFileHandle *file = smb_open_file_for_writing(context_, "upload.bin");
+    ASSERT_NE(file, nullptr);
+    size_t bytes_written = 0;
+    ASSERT_EQ(smb_write_range(file, data_.data(), data_.size(), 0, &bytes_written), SMB_SUCCESS);
+    EXPECT_EQ(bytes_written, data_.size());
+    smb_close_file(file);
+
+    uint64_t size = 0;
+    ASSERT_EQ(smb_stat(context_, "upload.bin", &size, nullptr, nullptr), SMB_SUCCESS);
+    EXPECT_EQ(size, data_.size());
+    EXPECT_TRUE(server_.readFile("upload.bin") == data_);
+}
+
+TEST_F(UploadTest, QueuedWritesReportProgressAndFlush)
+{
+    SmbFileHandle *file = smb_open_file_for_writing(context_, "upload.bin");
+    ASSERT_NE(file, nullptr);
+    Progress progress;
+    ASSERT_EQ(smb_set_write_progress_callback(file, onWriteProgress, &progress), SMB_SUCCESS);
+
+    for (size_t offset = 0; offset < data_.size(); offset += kChunk)
+    {
+        size_t size = std::min(kChunk, data_.size() - offset);
+        ASSERT_EQ(smb_write_range_async(file, data_.data() + offset, size, offset), SMB_SUCCESS);
+    }
+    ASSERT_EQ(smb_flush_writes(file), SMB_SUCCESS);
+    EXPECT_EQ(progress.bytes_written, data_.size());
+    EXPECT_GT(progress.calls, 0);
+    EXPECT_EQ(progress.errors, 0);
+
+    // Closing flushes what is still queued
+    ASSERT_EQ(smb_set_write_progress_callback(file, nullptr, nullptr), SMB_SUCCESS);
+    ASSERT_EQ(smb_write_range_async(file, data_.data(), 100, data_.size()), SMB_SUCCESS);
+    smb_close_file(file);
+
+    std::vector<uint8_t> stored = server_.readFile("upload.bin");
+    ASSERT_EQ(stored.size(), data_.size() + 100);
+    EXPECT_TRUE(std::equal(data_.begin(), data_.end(), stored.begin()));
+    EXPECT_TRUE(std::equal(data_.begin(), data_.begin() + 100, stored.begin() + data_.size()));
+}
+
+TEST_F(UploadTest, DisconnectWithQueuedWritesReturns)
+{
+    SmbFileHandle *file = smb_open_file_for_writing(context_, "upload.bin");
+    ASSERT_NE(file, nullptr);
+    for (size_t i = 0; i < 8; i++)
+    {
+        smb_write_range_async(file, data_.data(), kChunk, i * kChunk);
+    }
+    smb_disconnect(context_);
+    context_ = nullptr;
+}